@@ -376,7 +376,7 @@ bool CotestWatcher<R(Args...)>::UpdateCardinality(const UntypedFunctionMockerBas
     }
     *what << "call matches " << Base::source_text() << "...\n";
 
-    const int count = Base::call_count();
+    const int count = this->call_count();
     COTEST_ASSERT(count >= 1);
     //"call_count() is <= 0 when UpdateCardinality() is "
     //"called - this should never happen.");
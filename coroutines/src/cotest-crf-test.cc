@@ -201,6 +201,7 @@ std::shared_ptr<InteriorEventSession> TestCoroutine::NextEvent(const char *file,
         return launch_result_event;
     } else {
         COTEST_ASSERT(!"Unhandled payload type in NextEvent()");
+        return nullptr;
     }
 }
 
@@ -330,6 +331,7 @@ void InteriorMockCallSession::Return() { ReturnImpl(nullptr); }
 
 UntypedReturnValuePointer InteriorMockCallSession::GetUntypedLaunchResult() const {
     COTEST_ASSERT(!"Cannot get return value from a mock call session");
+    return nullptr;
 }
 
 void InteriorMockCallSession::ReturnImpl(UntypedReturnValuePointer return_value) {
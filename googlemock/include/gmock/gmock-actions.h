@@ -135,9 +135,11 @@
 #endif
 
 #include <algorithm>
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <memory>
+#include <new>
 #include <string>
 #include <tuple>
 #include <type_traits>
@@ -725,10 +727,8 @@ class Action;
 
 // An Action<R(Args...)> is a copyable and IMMUTABLE (except by assignment)
 // object that represents an action to be taken when a mock function of type
-// R(Args...) is called. The implementation of Action<T> is just a
-// std::shared_ptr to const ActionInterface<T>. Don't inherit from Action! You
-// can view an object implementing ActionInterface<F> as a concrete action
-// (including its current state), and an Action<F> object as a handle to it.
+// R(Args...) is called. Action<T> owns a type-erased copy of the callable it
+// was created from, held inline when it is small. Don't inherit from Action!
 template <typename R, typename... Args>
 class Action<R(Args...)> {
  private:
@@ -737,7 +737,7 @@ class Action<R(Args...)> {
   // Adapter class to allow constructing Action from a legacy ActionInterface.
   // New code should create Actions from functors instead.
   struct ActionAdapter {
-    // Adapter must be copyable to satisfy std::function requirements.
+    // Adapter must be copyable, since the Action holding it is.
     ::std::shared_ptr<ActionInterface<F>> impl_;
 
     template <typename... InArgs>
@@ -755,8 +755,9 @@ class Action<R(Args...)> {
   typedef typename internal::Function<F>::ArgumentTuple ArgumentTuple;
 
   // Constructs a null Action.  Needed for storing Action objects in
-  // STL containers.
-  Action() = default;
+  // STL containers.  It is user-provided so that a const Action can be
+  // default-initialized although buffer_ is left uninitialized.
+  Action() {}  // NOLINT
 
   // Construct an Action from a specified callable.
   // This cannot take std::function directly, because then Action would not be
@@ -770,10 +771,14 @@ class Action<R(Args...)> {
     Init(::std::forward<G>(fun), IsCompatibleFunctor<G>());
   }
 
+  // Constructs a null Action, as from an empty std::function.
+  Action(std::nullptr_t) {}  // NOLINT
+
   // Constructs an Action from shared pointer.
-  explicit Action(::std::shared_ptr<ActionInterface<F>> impl)
-      : fun_(ActionAdapter{impl}) {}
-      
+  explicit Action(::std::shared_ptr<ActionInterface<F>> impl) {
+    Store(ActionAdapter{::std::move(impl)});
+  }
+
   // Constructs an Action from its implementation (now delegating).
   explicit Action(ActionInterface<F>* impl)
       : Action{::std::shared_ptr<ActionInterface<F>>(impl)} {}
@@ -782,11 +787,41 @@ class Action<R(Args...)> {
   // Action<F>, as long as F's arguments can be implicitly converted
   // to Func's and Func's return type can be implicitly converted to F's.
   template <typename Func>
-  Action(const Action<Func>& action)  // NOLINT
-      : fun_(action.fun_) {}
+  Action(const Action<Func>& action) {  // NOLINT
+    if (!action.IsDoDefault()) Store(ConvertedAction<Func>{action});
+  }
+
+  Action(const Action& other) : vtable_(other.vtable_) {
+    if (vtable_ != nullptr) vtable_->copy(other.buffer_, &buffer_);
+  }
+
+  Action(Action&& other) noexcept : vtable_(other.vtable_) {
+    if (vtable_ != nullptr) vtable_->move(&other.buffer_, &buffer_);
+    other.vtable_ = nullptr;
+  }
+
+  Action& operator=(const Action& other) {
+    if (this != &other) {
+      Action copy(other);
+      *this = ::std::move(copy);
+    }
+    return *this;
+  }
+
+  Action& operator=(Action&& other) noexcept {
+    if (this != &other) {
+      Destroy();
+      vtable_ = other.vtable_;
+      if (vtable_ != nullptr) vtable_->move(&other.buffer_, &buffer_);
+      other.vtable_ = nullptr;
+    }
+    return *this;
+  }
+
+  ~Action() { Destroy(); }
 
   // Returns true if and only if this is the DoDefault() action.
-  bool IsDoDefault() const { return fun_ == nullptr; }
+  bool IsDoDefault() const { return vtable_ == nullptr; }
 
   // Performs the action.  Note that this method is const even though
   // the corresponding method in ActionInterface is not.  The reason
@@ -798,15 +833,15 @@ class Action<R(Args...)> {
     if (IsDoDefault()) {
       internal::IllegalDoDefault(__FILE__, __LINE__);
     }
-    return internal::Apply(fun_, ::std::move(args));
+    return vtable_->perform(&buffer_, ::std::move(args));
   }
 
   // An action can be used as a OnceAction, since it's obviously safe to call it
   // once.
   operator OnceAction<F>() const {  // NOLINT
     // Return a OnceAction-compatible callable that calls Perform with the
-    // arguments it is provided. We could instead just return fun_, but then
-    // we'd need to handle the IsDoDefault() case separately.
+    // arguments it is provided. We could instead just return the stored
+    // callable, but then we'd need to handle the IsDoDefault() case separately.
     struct OA {
       Action<F> action;
 
@@ -823,14 +858,140 @@ class Action<R(Args...)> {
   template <typename G>
   friend class Action;
 
+  // Storage for the callable.  Callables that fit and can be moved without
+  // throwing live in the buffer itself, so that the common actions (Return(),
+  // Invoke(), lambdas with a few captures) cost no allocation; anything else
+  // is allocated and `ptr` points to it.  Either way an Action owns its
+  // callable and copying an Action copies it, so stateful callables are never
+  // shared between copies.
+  union Buffer {
+    char bytes[4 * sizeof(void*)];
+    void* ptr;
+    double d;
+    int64_t i;
+  };
+
+  template <typename G>
+  using IsInlined = std::integral_constant<
+      bool, sizeof(G) <= sizeof(Buffer) && alignof(G) <= alignof(Buffer) &&
+                std::is_nothrow_move_constructible<G>::value>;
+
+  struct VTable {
+    Result (*perform)(Buffer*, ArgumentTuple&&);
+    void (*copy)(const Buffer&, Buffer*);
+    void (*move)(Buffer*, Buffer*);
+    void (*destroy)(Buffer*);
+  };
+
+  template <typename G, bool = IsInlined<G>::value>
+  struct StoragePolicy {
+    static G& Get(Buffer* b) { return *reinterpret_cast<G*>(b->bytes); }
+    static const G& Get(const Buffer& b) {
+      return *reinterpret_cast<const G*>(b.bytes);
+    }
+
+    template <typename Arg>
+    static void Create(Buffer* b, Arg&& arg) {
+      new (b->bytes) G(::std::forward<Arg>(arg));
+    }
+    static void Copy(const Buffer& from, Buffer* to) { Create(to, Get(from)); }
+    static void Move(Buffer* from, Buffer* to) {
+      Create(to, ::std::move(Get(from)));
+      Destroy(from);
+    }
+    static void Destroy(Buffer* b) { Get(b).~G(); }
+  };
+
+  template <typename G>
+  struct StoragePolicy<G, false> {
+    static G& Get(Buffer* b) { return *static_cast<G*>(b->ptr); }
+    static const G& Get(const Buffer& b) { return *static_cast<G*>(b.ptr); }
+
+    template <typename Arg>
+    static void Create(Buffer* b, Arg&& arg) {
+      b->ptr = new G(::std::forward<Arg>(arg));
+    }
+    static void Copy(const Buffer& from, Buffer* to) { Create(to, Get(from)); }
+    static void Move(Buffer* from, Buffer* to) { to->ptr = from->ptr; }
+    static void Destroy(Buffer* b) { delete static_cast<G*>(b->ptr); }
+  };
+
+  // Calls the callable, discarding its result when Result is void, as
+  // std::function<void(...)> does.
+  template <typename G>
+  static Result Call(G& g, ArgumentTuple&& args, ::std::false_type) {
+    return internal::Apply(g, ::std::move(args));
+  }
+
+  template <typename G>
+  static void Call(G& g, ArgumentTuple&& args, ::std::true_type) {
+    internal::Apply(g, ::std::move(args));
+  }
+
+  template <typename G>
+  static Result PerformImpl(Buffer* b, ArgumentTuple&& args) {
+    return Call(StoragePolicy<G>::Get(b), ::std::move(args),
+                ::std::is_void<Result>());
+  }
+
+  template <typename G>
+  static const VTable* GetVTable() {
+    static constexpr VTable kVTable = {
+        &PerformImpl<G>, &StoragePolicy<G>::Copy, &StoragePolicy<G>::Move,
+        &StoragePolicy<G>::Destroy};
+    return &kVTable;
+  }
+
+  template <typename G>
+  void Store(G&& g) {
+    using Stored = typename ::std::decay<G>::type;
+    StoragePolicy<Stored>::Create(&buffer_, ::std::forward<G>(g));
+    vtable_ = GetVTable<Stored>();
+  }
+
+  // Null function pointers and empty std::functions make a DoDefault()
+  // action, as they did when Action was a std::function.
+  template <typename G>
+  static bool IsEmpty(const G&) {
+    return false;
+  }
+  template <typename G>
+  static bool IsEmpty(G* p) {
+    return p == nullptr;
+  }
+  template <typename G, typename C>
+  static bool IsEmpty(G C::*p) {
+    return p == nullptr;
+  }
+  template <typename Sig>
+  static bool IsEmpty(const ::std::function<Sig>& f) {
+    return !f;
+  }
+
   template <typename G>
   void Init(G&& g, ::std::true_type) {
-    fun_ = ::std::forward<G>(g);
+    if (IsEmpty(g)) return;
+    Init(::std::forward<G>(g), ::std::true_type(),
+         ::std::is_member_pointer<typename ::std::decay<G>::type>());
+  }
+
+  template <typename G>
+  void Init(G&& g, ::std::true_type, ::std::false_type) {
+    Store(::std::forward<G>(g));
+  }
+
+  template <typename G>
+  void Init(G g, ::std::true_type, ::std::true_type) {
+    Store(::std::mem_fn(g));
   }
 
   template <typename G>
   void Init(G&& g, ::std::false_type) {
-    fun_ = IgnoreArgs<typename ::std::decay<G>::type>{::std::forward<G>(g)};
+    Store(IgnoreArgs<typename ::std::decay<G>::type>{::std::forward<G>(g)});
+  }
+
+  void Destroy() {
+    if (vtable_ != nullptr) vtable_->destroy(&buffer_);
   }
 
   template <typename FunctionImpl>
@@ -843,8 +1004,25 @@ class Action<R(Args...)> {
     FunctionImpl function_impl;
   };
 
-  // fun_ is an empty function if and only if this is the DoDefault() action.
-  ::std::function<F> fun_;
+  // Adapts an Action of another function type, converting the arguments to
+  // its argument types when called.  It holds a whole Action, which is one
+  // pointer larger than Buffer, so a converted action is always allocated;
+  // no fixed buffer size could hold an Action of its own size.
+  template <typename Func>
+  struct ConvertedAction {
+    template <typename... InArgs>
+    typename Action<Func>::Result operator()(InArgs&&... args) const {
+      return action.Perform(
+          typename Action<Func>::ArgumentTuple(::std::forward<InArgs>(args)...));
+    }
+
+    Action<Func> action;
+  };
+
+  // vtable_ is null if and only if this is the DoDefault() action.
+  const VTable* vtable_ = nullptr;
+  // Mutable because Perform() is const but the callable may change state.
+  mutable Buffer buffer_;
 };
 
 // The PolymorphicAction class template makes it easy to implement a
@@ -121,8 +121,18 @@ using internal::FunctionMocker;
 #define GMOCK_INTERNAL_MOCK_METHOD_ARG_2(...) \
   GMOCK_INTERNAL_WRONG_ARITY(__VA_ARGS__)
 
-#define GMOCK_INTERNAL_MOCK_METHOD_ARG_3(_Ret, _MethodName, _Args) \
-  GMOCK_INTERNAL_MOCK_METHOD_ARG_4(_Ret, _MethodName, _Args, ())
+// Without a _Spec there is nothing to validate or detect, so this common case
+// goes straight to the implementation instead of running the modifier
+// detection machinery over an empty tuple.
+#define GMOCK_INTERNAL_MOCK_METHOD_ARG_3(_Ret, _MethodName, _Args)      \
+  GMOCK_INTERNAL_ASSERT_PARENTHESIS(_Args);                             \
+  GMOCK_INTERNAL_MOCK_METHOD_ARG_3_I(GMOCK_PP_NARG0 _Args, _MethodName, \
+                                     GMOCK_INTERNAL_SIGNATURE(_Ret, _Args))
+
+#define GMOCK_INTERNAL_MOCK_METHOD_ARG_3_I(_N, _MethodName, ...)  \
+  GMOCK_INTERNAL_ASSERT_VALID_SIGNATURE(_N, __VA_ARGS__);         \
+  GMOCK_INTERNAL_MOCK_METHOD_IMPL(_N, _MethodName, 0, 0, 0, , , , \
+                                  (__VA_ARGS__))
 
 #define GMOCK_INTERNAL_MOCK_METHOD_ARG_4(_Ret, _MethodName, _Args, _Spec)  \
   GMOCK_INTERNAL_ASSERT_PARENTHESIS(_Args);                                \
@@ -529,6 +539,29 @@ using internal::FunctionMocker;
       args_num, Method, GMOCK_PP_NARG0(constness), 0, 0, , ct, ,          \
       (::testing::internal::identity_t<__VA_ARGS__>))
 
+// Explicit instantiation of the function mockers behind mock methods.
+//
+// Every translation unit that uses a mock class normally instantiates the
+// FunctionMocker, expectation and ON_CALL machinery of each of its mock
+// method signatures.  Declaring a signature with
+// GMOCK_DECLARE_FUNCTION_MOCKER() in the header that defines the mock class,
+// and instantiating it with GMOCK_INSTANTIATE_FUNCTION_MOCKER() in exactly one
+// .cc file, makes the compiler emit that code only once.  Both macros take the
+// function type of the mock method (e.g. `int(const std::string&)`) and must
+// be used at global namespace scope.
+#define GMOCK_DECLARE_FUNCTION_MOCKER(...) \
+  GMOCK_INTERNAL_FUNCTION_MOCKER_CLASSES(extern template, __VA_ARGS__)
+
+#define GMOCK_INSTANTIATE_FUNCTION_MOCKER(...) \
+  GMOCK_INTERNAL_FUNCTION_MOCKER_CLASSES(template, __VA_ARGS__)
+
+#define GMOCK_INTERNAL_FUNCTION_MOCKER_CLASSES(_Kind, ...)          \
+  _Kind class ::testing::internal::FunctionMocker<__VA_ARGS__>;     \
+  _Kind class ::testing::internal::TypedExpectation<__VA_ARGS__>;   \
+  _Kind class ::testing::internal::OnCallSpec<__VA_ARGS__>;         \
+  _Kind class ::testing::internal::DefaultSpecFactory<__VA_ARGS__>; \
+  _Kind class ::testing::internal::MockSpec<__VA_ARGS__>
+
 #define GMOCK_MOCKER_(arity, constness, Method) \
   GTEST_CONCAT_TOKEN_(gmock##constness##arity##_##Method##_, __LINE__)
 
@@ -257,6 +257,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <exception>
 #include <functional>
 #include <initializer_list>
@@ -959,22 +960,36 @@ class StrEqualityMatcher {
   const bool case_sensitive_;
 };
 
-// Implements the polymorphic HasSubstr(substring) matcher, which
-// can be used as a Matcher<T> as long as T can be converted to a
-// string.
-template <typename StringType>
-class HasSubstrMatcher {
+// Returns the position of the first occurrence of needle in haystack, or
+// std::string::npos.  Narrow strings are searched with the C library's
+// memmem() or memchr(), which are vectorised on the common platforms.
+GTEST_API_ size_t FindSubstring(const char* haystack, size_t haystack_size,
+                                const char* needle, size_t needle_size);
+
+template <typename CharType>
+size_t FindSubstring(const CharType* haystack, size_t haystack_size,
+                     const CharType* needle, size_t needle_size) {
+  const CharType* const end = haystack + haystack_size;
+  const CharType* const pos =
+      std::search(haystack, end, needle, needle + needle_size);
+  return pos == end && needle_size != 0
+             ? std::string::npos
+             : static_cast<size_t>(pos - haystack);
+}
+
+// The base of the matchers that examine a string's characters in place:
+// HasSubstr(), StartsWith() and EndsWith().  Derived supplies
+// MatchesChars(const Char* s, size_t size), which is given the matchee's
+// characters without copying them when it is a StringType or a C string.
+template <typename Derived, typename StringType>
+class InPlaceStringMatcherBase {
  public:
-  explicit HasSubstrMatcher(const StringType& substring)
-      : substring_(substring) {}
-
 #if GTEST_INTERNAL_HAS_STRING_VIEW
   bool MatchAndExplain(const internal::StringView& s,
-                       MatchResultListener* listener) const {
+                       MatchResultListener* /* listener */) const {
     // This should fail to compile if StringView is used with wide
     // strings.
-    const StringType& str = std::string(s);
-    return MatchAndExplain(str, listener);
+    return derived().MatchesChars(s.data(), s.size());
   }
 #endif  // GTEST_INTERNAL_HAS_STRING_VIEW
 
@@ -984,8 +999,16 @@ class HasSubstrMatcher {
   //   const wchar_t*
   //   wchar_t*
   template <typename CharType>
-  bool MatchAndExplain(CharType* s, MatchResultListener* listener) const {
-    return s != nullptr && MatchAndExplain(StringType(s), listener);
+  bool MatchAndExplain(CharType* s, MatchResultListener* /* listener */) const {
+    return s != nullptr &&
+           derived().MatchesChars(
+               s, std::char_traits<typename std::remove_const<
+                      CharType>::type>::length(s));
+  }
+
+  bool MatchAndExplain(const StringType& s,
+                       MatchResultListener* /* listener */) const {
+    return derived().MatchesChars(s.data(), s.size());
   }
 
   // Matches anything that can convert to StringType.
@@ -994,8 +1017,29 @@ class HasSubstrMatcher {
   // because StringView has some interfering non-explicit constructors.
   template <typename MatcheeStringType>
   bool MatchAndExplain(const MatcheeStringType& s,
-                       MatchResultListener* /* listener */) const {
-    return StringType(s).find(substring_) != StringType::npos;
+                       MatchResultListener* listener) const {
+    return MatchAndExplain(StringType(s), listener);
+  }
+
+ private:
+  const Derived& derived() const { return static_cast<const Derived&>(*this); }
+};
+
+// Implements the polymorphic HasSubstr(substring) matcher, which
+// can be used as a Matcher<T> as long as T can be converted to a
+// string.
+template <typename StringType>
+class HasSubstrMatcher
+    : public InPlaceStringMatcherBase<HasSubstrMatcher<StringType>,
+                                      StringType> {
+ public:
+  explicit HasSubstrMatcher(const StringType& substring)
+      : substring_(substring) {}
+
+  bool MatchesChars(const typename StringType::value_type* s,
+                    size_t size) const {
+    return FindSubstring(s, size, substring_.data(), substring_.size()) !=
+           std::string::npos;
   }
 
   // Describes what this matcher matches.
@@ -1017,40 +1061,17 @@ class HasSubstrMatcher {
 // can be used as a Matcher<T> as long as T can be converted to a
 // string.
 template <typename StringType>
-class StartsWithMatcher {
+class StartsWithMatcher
+    : public InPlaceStringMatcherBase<StartsWithMatcher<StringType>,
+                                      StringType> {
  public:
   explicit StartsWithMatcher(const StringType& prefix) : prefix_(prefix) {}
 
-#if GTEST_INTERNAL_HAS_STRING_VIEW
-  bool MatchAndExplain(const internal::StringView& s,
-                       MatchResultListener* listener) const {
-    // This should fail to compile if StringView is used with wide
-    // strings.
-    const StringType& str = std::string(s);
-    return MatchAndExplain(str, listener);
-  }
-#endif  // GTEST_INTERNAL_HAS_STRING_VIEW
-
-  // Accepts pointer types, particularly:
-  //   const char*
-  //   char*
-  //   const wchar_t*
-  //   wchar_t*
-  template <typename CharType>
-  bool MatchAndExplain(CharType* s, MatchResultListener* listener) const {
-    return s != nullptr && MatchAndExplain(StringType(s), listener);
-  }
-
-  // Matches anything that can convert to StringType.
-  //
-  // This is a template, not just a plain function with const StringType&,
-  // because StringView has some interfering non-explicit constructors.
-  template <typename MatcheeStringType>
-  bool MatchAndExplain(const MatcheeStringType& s,
-                       MatchResultListener* /* listener */) const {
-    const StringType s2(s);
-    return s2.length() >= prefix_.length() &&
-           s2.substr(0, prefix_.length()) == prefix_;
+  bool MatchesChars(const typename StringType::value_type* s,
+                    size_t size) const {
+    return size >= prefix_.length() &&
+           StringType::traits_type::compare(s, prefix_.data(),
+                                            prefix_.length()) == 0;
   }
 
   void DescribeTo(::std::ostream* os) const {
@@ -1071,54 +1092,126 @@ class StartsWithMatcher {
 // can be used as a Matcher<T> as long as T can be converted to a
 // string.
 template <typename StringType>
-class EndsWithMatcher {
+class EndsWithMatcher
+    : public InPlaceStringMatcherBase<EndsWithMatcher<StringType>,
+                                      StringType> {
  public:
   explicit EndsWithMatcher(const StringType& suffix) : suffix_(suffix) {}
 
+  bool MatchesChars(const typename StringType::value_type* s,
+                    size_t size) const {
+    return size >= suffix_.length() &&
+           StringType::traits_type::compare(s + (size - suffix_.length()),
+                                            suffix_.data(),
+                                            suffix_.length()) == 0;
+  }
+
+  void DescribeTo(::std::ostream* os) const {
+    *os << "ends with ";
+    UniversalPrint(suffix_, os);
+  }
+
+  void DescribeNegationTo(::std::ostream* os) const {
+    *os << "doesn't end with ";
+    UniversalPrint(suffix_, os);
+  }
+
+ private:
+  const StringType suffix_;
+};
+
+// An Aho-Corasick automaton over a set of substrings, which finds the ones
+// that occur in a text in a single pass over it, however many there are.
+class GTEST_API_ SubstringSet {
+ public:
+  explicit SubstringSet(const std::vector<std::string>& substrings);
+
+  // Scans text, setting (*found)[i] if substring i occurs in it.  Stops at
+  // the first occurrence of any substring if stop_at_first is true, and
+  // otherwise once all of them have been seen.  Returns the number found.
+  size_t FindIn(const char* text, size_t size, bool stop_at_first,
+                std::vector<bool>* found) const;
+
+ private:
+  // Bytes that don't occur in any substring share one column of the
+  // transition table.
+  unsigned char column_of_byte_[256];
+  size_t column_count_;
+  // transitions_[state * column_count_ + column] is the next state.
+  std::vector<uint32_t> transitions_;
+  // The substrings that end at each state, including via suffix links.
+  std::vector<std::vector<size_t>> matches_;
+  size_t substring_count_;
+};
+
+// Implements HasAllSubstrs() and HasAnySubstr().
+class MultiSubstrMatcher {
+ public:
+  MultiSubstrMatcher(std::vector<std::string> substrings, bool match_all)
+      : substrings_(std::move(substrings)),
+        set_(std::make_shared<SubstringSet>(substrings_)),
+        match_all_(match_all) {}
+
 #if GTEST_INTERNAL_HAS_STRING_VIEW
   bool MatchAndExplain(const internal::StringView& s,
                        MatchResultListener* listener) const {
-    // This should fail to compile if StringView is used with wide
-    // strings.
-    const StringType& str = std::string(s);
-    return MatchAndExplain(str, listener);
+    return MatchChars(s.data(), s.size(), listener);
   }
 #endif  // GTEST_INTERNAL_HAS_STRING_VIEW
 
-  // Accepts pointer types, particularly:
-  //   const char*
-  //   char*
-  //   const wchar_t*
-  //   wchar_t*
   template <typename CharType>
   bool MatchAndExplain(CharType* s, MatchResultListener* listener) const {
-    return s != nullptr && MatchAndExplain(StringType(s), listener);
+    return s != nullptr && MatchChars(s, strlen(s), listener);
+  }
+
+  bool MatchAndExplain(const std::string& s,
+                       MatchResultListener* listener) const {
+    return MatchChars(s.data(), s.size(), listener);
   }
 
-  // Matches anything that can convert to StringType.
-  //
-  // This is a template, not just a plain function with const StringType&,
-  // because StringView has some interfering non-explicit constructors.
   template <typename MatcheeStringType>
   bool MatchAndExplain(const MatcheeStringType& s,
-                       MatchResultListener* /* listener */) const {
-    const StringType s2(s);
-    return s2.length() >= suffix_.length() &&
-           s2.substr(s2.length() - suffix_.length()) == suffix_;
+                       MatchResultListener* listener) const {
+    return MatchAndExplain(std::string(s), listener);
   }
 
   void DescribeTo(::std::ostream* os) const {
-    *os << "ends with ";
-    UniversalPrint(suffix_, os);
+    *os << (match_all_ ? "has all of the substrings "
+                       : "has at least one of the substrings ");
+    UniversalPrint(substrings_, os);
   }
 
   void DescribeNegationTo(::std::ostream* os) const {
-    *os << "doesn't end with ";
-    UniversalPrint(suffix_, os);
+    *os << (match_all_ ? "doesn't have all of the substrings "
+                       : "has none of the substrings ");
+    UniversalPrint(substrings_, os);
   }
 
  private:
-  const StringType suffix_;
+  bool MatchChars(const char* s, size_t size,
+                  MatchResultListener* listener) const {
+    std::vector<bool> found;
+    const size_t count = set_->FindIn(s, size, !match_all_, &found);
+    const bool matched = match_all_ ? count == substrings_.size() : count > 0;
+    if (listener->IsInterested() && (match_all_ ? !matched : matched)) {
+      // Lists the missing substrings, or the one that was found.
+      *listener << (matched ? "which contains " : "which is missing ");
+      const char* sep = "";
+      for (size_t i = 0; i < substrings_.size(); ++i) {
+        if (found[i] == matched) {
+          *listener << sep;
+          UniversalPrint(substrings_[i], listener->stream());
+          sep = ", ";
+        }
+      }
+    }
+    return matched;
+  }
+
+  std::vector<std::string> substrings_;
+  // Shared by the copies of the matcher, as it can be large.
+  std::shared_ptr<const SubstringSet> set_;
+  bool match_all_;
 };
 
 // Implements the polymorphic WhenBase64Unescaped(matcher) matcher, which can be
@@ -1667,6 +1760,31 @@ class FloatingEqMatcher {
         << ", where max_abs_error is" << max_abs_error;
   }
 
+  // Returns true if and only if 'value' matches 'expected' under the rules
+  // described above; a negative max_abs_error selects ULP-based comparison.
+  static bool Matches(FloatType expected_value, FloatType value,
+                      bool nan_eq_nan, FloatType max_abs_error) {
+    const FloatingPoint<FloatType> actual(value), expected(expected_value);
+
+    // Compares NaNs first, if nan_eq_nan is true.
+    if (actual.is_nan() || expected.is_nan()) {
+      if (actual.is_nan() && expected.is_nan()) {
+        return nan_eq_nan;
+      }
+      // One is nan; the other is not nan.
+      return false;
+    }
+    if (max_abs_error >= 0) {
+      // We perform an equality check so that inf will match inf, regardless
+      // of error bounds.  If the result of value - expected would result in
+      // overflow or if either value is inf, the default result is infinity,
+      // which should only match if max_abs_error is also infinity.
+      return value == expected_value ||
+             ::std::fabs(value - expected_value) <= max_abs_error;
+    }
+    return actual.AlmostEquals(expected);
+  }
+
   // Implements floating point equality matcher as a Matcher<T>.
   template <typename T>
   class Impl : public MatcherInterface<T> {
@@ -1678,37 +1796,17 @@ class FloatingEqMatcher {
 
     bool MatchAndExplain(T value,
                          MatchResultListener* listener) const override {
-      const FloatingPoint<FloatType> actual(value), expected(expected_);
-
-      // Compares NaNs first, if nan_eq_nan_ is true.
-      if (actual.is_nan() || expected.is_nan()) {
-        if (actual.is_nan() && expected.is_nan()) {
-          return nan_eq_nan_;
-        }
-        // One is nan; the other is not nan.
-        return false;
+      if (Matches(expected_, value, nan_eq_nan_, max_abs_error_)) {
+        return true;
       }
-      if (HasMaxAbsError()) {
-        // We perform an equality check so that inf will match inf, regardless
-        // of error bounds.  If the result of value - expected_ would result in
-        // overflow or if either value is inf, the default result is infinity,
-        // which should only match if max_abs_error_ is also infinity.
-        if (value == expected_) {
-          return true;
-        }
-
-        const FloatType diff = value - expected_;
-        if (::std::fabs(diff) <= max_abs_error_) {
-          return true;
-        }
 
-        if (listener->IsInterested()) {
-          *listener << "which is " << diff << " from " << expected_;
-        }
-        return false;
-      } else {
-        return actual.AlmostEquals(expected);
+      const FloatingPoint<FloatType> actual(value), expected(expected_);
+      if (HasMaxAbsError() && !actual.is_nan() && !expected.is_nan() &&
+          listener->IsInterested()) {
+        *listener << "which is " << (value - expected_) << " from "
+                  << expected_;
       }
+      return false;
     }
 
     void DescribeTo(::std::ostream* os) const override {
@@ -1806,6 +1904,13 @@ class FloatingEq2Matcher {
     Init(max_abs_error, nan_eq_nan);
   }
 
+  // Returns true if and only if (lhs, rhs) is an almost-equal pair.  Lets
+  // Pointwise() check whole containers without a matcher per element.
+  bool MatchesPair(FloatType lhs, FloatType rhs) const {
+    return FloatingEqMatcher<FloatType>::Matches(lhs, rhs, nan_eq_nan_,
+                                                 max_abs_error_);
+  }
+
   template <typename T1, typename T2>
   operator Matcher<::std::tuple<T1, T2>>() const {
     return MakeMatcher(
@@ -2570,6 +2675,77 @@ class WhenSortedByMatcher {
   const ContainerMatcher matcher_;
 };
 
+// The following helpers let ElementsAreArray() and Pointwise() check a
+// whole container with an inline predicate, instead of going through one
+// type-erased matcher call per element.  The matchers themselves are only
+// consulted to explain a mismatch.
+
+// Compares two elements with operator==, like Eq() and Eq2Matcher.
+struct ElementsEqual {
+  template <typename Lhs, typename Rhs>
+  bool operator()(const Lhs& lhs, const Rhs& rhs) const {
+    return lhs == rhs;
+  }
+};
+
+// Returns a pointer to the first element of an STL-style container view if
+// its storage is known to be contiguous, or its begin() iterator otherwise.
+template <typename Container>
+auto ContiguousBegin(const Container& container, int)
+    -> decltype(container.data()) {
+  return container.data();
+}
+template <typename Container>
+auto ContiguousBegin(const Container& container, long)  // NOLINT
+    -> decltype(container.begin()) {
+  return container.begin();
+}
+
+// Returns true if and only if pred(lhs[i], rhs[i]) holds for all i in
+// [0, size).
+template <typename LhsIter, typename RhsIter, typename Pred>
+bool AllElementsMatch(LhsIter lhs, RhsIter rhs, size_t size, const Pred& pred) {
+  for (size_t i = 0; i != size; ++i, ++lhs, ++rhs) {
+    if (!pred(*lhs, *rhs)) return false;
+  }
+  return true;
+}
+
+// Contiguous integers or enums of the same type are equal if and only if
+// their object representations are.
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value,
+                        bool>::type
+AllElementsMatch(const T* lhs, const T* rhs, size_t size,
+                 const ElementsEqual& /* pred */) {
+  return size == 0 || memcmp(lhs, rhs, size * sizeof(T)) == 0;
+}
+
+// Returns true if every pair of elements is known to match the tuple
+// matcher.  A false result means "unknown" for tuple matchers without an
+// inline equivalent, so the caller must then use the tuple matcher.
+template <typename LhsContainer, typename RhsContainer, typename TupleMatcher>
+bool AllPairsMatchInline(const LhsContainer& /* lhs */,
+                         const RhsContainer& /* rhs */,
+                         const TupleMatcher& /* tuple_matcher */) {
+  return false;
+}
+template <typename LhsContainer, typename RhsContainer>
+bool AllPairsMatchInline(const LhsContainer& lhs, const RhsContainer& rhs,
+                         const Eq2Matcher& /* tuple_matcher */) {
+  return AllElementsMatch(ContiguousBegin(lhs, 0), ContiguousBegin(rhs, 0),
+                          lhs.size(), ElementsEqual());
+}
+template <typename LhsContainer, typename RhsContainer, typename FloatType>
+bool AllPairsMatchInline(const LhsContainer& lhs, const RhsContainer& rhs,
+                         const FloatingEq2Matcher<FloatType>& tuple_matcher) {
+  return AllElementsMatch(ContiguousBegin(lhs, 0), ContiguousBegin(rhs, 0),
+                          lhs.size(),
+                          [&tuple_matcher](FloatType l, FloatType r) {
+                            return tuple_matcher.MatchesPair(l, r);
+                          });
+}
+
 // Implements Pointwise(tuple_matcher, rhs_container).  tuple_matcher
 // must be able to be safely cast to Matcher<std::tuple<const T1&, const
 // T2&> >, where T1 and T2 are the types of elements in the LHS
@@ -2622,7 +2798,8 @@ class PointwiseMatcher {
 
     Impl(const TupleMatcher& tuple_matcher, const RhsStlContainer& rhs)
         // mono_tuple_matcher_ holds a monomorphic version of the tuple matcher.
-        : mono_tuple_matcher_(SafeMatcherCast<InnerMatcherArg>(tuple_matcher)),
+        : tuple_matcher_(tuple_matcher),
+          mono_tuple_matcher_(SafeMatcherCast<InnerMatcherArg>(tuple_matcher)),
           rhs_(rhs) {}
 
     void DescribeTo(::std::ostream* os) const override {
@@ -2650,6 +2827,12 @@ class PointwiseMatcher {
         return false;
       }
 
+      // Matching pairs need no explanation, so only a mismatch needs the
+      // element-by-element walk below.
+      if (AllPairsMatchInline(lhs_stl_container, rhs_, tuple_matcher_)) {
+        return true;
+      }
+
       auto left = lhs_stl_container.begin();
       auto right = rhs_.begin();
       for (size_t i = 0; i != actual_size; ++i, ++left, ++right) {
@@ -2682,6 +2865,7 @@ class PointwiseMatcher {
     }
 
    private:
+    const TupleMatcher tuple_matcher_;
     const Matcher<InnerMatcherArg> mono_tuple_matcher_;
     const RhsStlContainer rhs_;
   };
@@ -3508,6 +3692,48 @@ class ElementsAreMatcherImpl : public MatcherInterface<Container> {
   ::std::vector<Matcher<const Element&>> matchers_;
 };
 
+// Implements ElementsAreArray() for an array of plain arithmetic or enum
+// values and a container with contiguous storage of the same type.  Rather
+// than one Eq() matcher per element, it keeps the values and compares them
+// in bulk; the per-element matchers are only built to describe the matcher
+// or to explain a mismatch.
+template <typename Container, typename T>
+class ElementsAreValuesMatcherImpl : public MatcherInterface<Container> {
+ public:
+  typedef GTEST_REMOVE_REFERENCE_AND_CONST_(Container) RawContainer;
+  typedef internal::StlContainerView<RawContainer> View;
+  typedef typename View::const_reference StlContainerReference;
+
+  explicit ElementsAreValuesMatcherImpl(const ::std::vector<T>& values)
+      : values_(values) {}
+
+  void DescribeTo(::std::ostream* os) const override {
+    ElementsAreMatcherImpl<Container>(values_.begin(), values_.end())
+        .DescribeTo(os);
+  }
+
+  void DescribeNegationTo(::std::ostream* os) const override {
+    ElementsAreMatcherImpl<Container>(values_.begin(), values_.end())
+        .DescribeNegationTo(os);
+  }
+
+  bool MatchAndExplain(Container container,
+                       MatchResultListener* listener) const override {
+    StlContainerReference stl_container = View::ConstReference(container);
+    if (stl_container.size() == values_.size() &&
+        AllElementsMatch(ContiguousBegin(stl_container, 0), values_.data(),
+                         values_.size(), ElementsEqual())) {
+      // Eq() has nothing to say about matching elements.
+      return true;
+    }
+    return ElementsAreMatcherImpl<Container>(values_.begin(), values_.end())
+        .MatchAndExplain(container, listener);
+  }
+
+ private:
+  const ::std::vector<T> values_;
+};
+
 // Connectivity matrix of (elements X matchers), in element-major order.
 // Initially, there are no edges.
 // Use NextGraph() to iterate over all possible edge configurations.
@@ -3785,11 +4011,33 @@ class ElementsAreArrayMatcher {
         !IsHashTable<GTEST_REMOVE_REFERENCE_AND_CONST_(Container)>::value,
         "use UnorderedElementsAreArray with hash tables");
 
+    typedef GTEST_REMOVE_REFERENCE_AND_CONST_(Container) RawContainer;
+    typedef typename internal::StlContainerView<RawContainer>::type View;
+    return MakeImpl<Container>(
+        std::integral_constant<
+            bool,
+            (std::is_arithmetic<T>::value || std::is_enum<T>::value) &&
+                std::is_same<typename View::value_type, T>::value &&
+                std::is_same<decltype(ContiguousBegin(
+                                 std::declval<const View&>(), 0)),
+                             const T*>::value>());
+  }
+
+ private:
+  // Used when the expected elements are plain values that can be compared
+  // in bulk with the container's contiguous storage.
+  template <typename Container>
+  Matcher<Container> MakeImpl(std::true_type /* bulk comparable */) const {
+    return Matcher<Container>(
+        new ElementsAreValuesMatcherImpl<const Container&, T>(matchers_));
+  }
+
+  template <typename Container>
+  Matcher<Container> MakeImpl(std::false_type /* bulk comparable */) const {
     return Matcher<Container>(new ElementsAreMatcherImpl<const Container&>(
         matchers_.begin(), matchers_.end()));
   }
 
- private:
   const ::std::vector<T> matchers_;
 };
 
@@ -4526,6 +4774,35 @@ PolymorphicMatcher<internal::EndsWithMatcher<std::string>> EndsWith(
       internal::EndsWithMatcher<std::string>(std::string(suffix)));
 }
 
+// Matches a string that contains every one of the given substrings.  The
+// string is scanned once, however many substrings there are.
+template <typename Container>
+PolymorphicMatcher<internal::MultiSubstrMatcher> HasAllSubstrs(
+    const Container& substrings) {
+  return MakePolymorphicMatcher(internal::MultiSubstrMatcher(
+      std::vector<std::string>(std::begin(substrings), std::end(substrings)),
+      true));
+}
+
+inline PolymorphicMatcher<internal::MultiSubstrMatcher> HasAllSubstrs(
+    std::initializer_list<std::string> substrings) {
+  return HasAllSubstrs<std::initializer_list<std::string>>(substrings);
+}
+
+// Matches a string that contains at least one of the given substrings.
+template <typename Container>
+PolymorphicMatcher<internal::MultiSubstrMatcher> HasAnySubstr(
+    const Container& substrings) {
+  return MakePolymorphicMatcher(internal::MultiSubstrMatcher(
+      std::vector<std::string>(std::begin(substrings), std::end(substrings)),
+      false));
+}
+
+inline PolymorphicMatcher<internal::MultiSubstrMatcher> HasAnySubstr(
+    std::initializer_list<std::string> substrings) {
+  return HasAnySubstr<std::initializer_list<std::string>>(substrings);
+}
+
 #if GTEST_HAS_STD_WSTRING
 // Wide string matchers.
 
@@ -97,6 +97,9 @@ class Expectation;
 // A set of expectation handles.
 class ExpectationSet;
 
+// Backs the expectations created while it is alive.
+class ExpectationArena;
+
 // Anything inside the 'internal' namespace IS INTERNAL IMPLEMENTATION
 // and MUST NOT BE USED IN USER CODE!!!
 namespace internal {
@@ -115,6 +118,9 @@ class TypedExpectation;
 // Helper class for testing the Expectation class template.
 class ExpectationTester;
 
+// The memory behind an ExpectationArena.
+class ArenaBlocks;
+
 // Helper classes for implementing NiceMock, StrictMock, and NaggyMock.
 template <typename MockClass>
 class NiceMockImpl;
@@ -136,6 +142,50 @@ class NaggyMockImpl;
 // calls to ensure the integrity of the mock objects' states.
 GTEST_API_ GTEST_DECLARE_STATIC_MUTEX_(g_gmock_mutex);
 
+// Returns size bytes aligned at alignment (which must not exceed that of
+// std::max_align_t) from the ExpectationArena installed in the current
+// thread, or from the heap if there is none.
+GTEST_API_ void* AllocateFromArena(size_t size, size_t alignment);
+
+// Returns memory obtained from AllocateFromArena() with the same size and
+// alignment.  This may happen in any thread, and after the ExpectationArena
+// object is gone.
+GTEST_API_ void DeallocateToArena(void* p, size_t size, size_t alignment);
+
+// A standard allocator for Google Mock's bookkeeping.  It draws from the
+// ExpectationArena installed in the current thread at the time of each
+// allocation.  The memory remembers where it came from, so all instances
+// are interchangeable.
+template <typename T>
+class ArenaAllocator {
+ public:
+  typedef T value_type;
+
+  ArenaAllocator() = default;
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>&) {}  // NOLINT
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(AllocateFromArena(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T* p, size_t n) {
+    DeallocateToArena(p, n * sizeof(T), alignof(T));
+  }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>&) const {
+    return false;
+  }
+};
+
+// A string allocated like the rest of the bookkeeping.
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>
+    ArenaString;
+
 // Abstract base class of FunctionMocker.  This is the
 // type-agnostic part of the function mocker interface.  Its pure
 // virtual methods are implemented by FunctionMocker.
@@ -204,7 +254,9 @@ class GTEST_API_ UntypedFunctionMockerBase {
   const char* NameLocked() const GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex);
   
   // Get a pointer to the vector of expectations for this mocker
-  using UntypedExpectations = std::vector<std::shared_ptr<ExpectationBase>>;
+  using UntypedExpectations =
+      std::vector<std::shared_ptr<ExpectationBase>,
+                  ArenaAllocator<std::shared_ptr<ExpectationBase>>>;
   const UntypedExpectations *GetMockHandlerScheme() const
   {
 	  return &untyped_expectations_;
@@ -257,7 +309,9 @@ class GTEST_API_ UntypedFunctionMockerBase {
 // priority order.
 class AlternateMockCallManager {
  protected:
-  using UntypedExpectations = std::vector<std::shared_ptr<ExpectationBase>>;
+  using UntypedExpectations =
+      std::vector<std::shared_ptr<ExpectationBase>,
+                  ArenaAllocator<std::shared_ptr<ExpectationBase>>>;
 
  public:
   typedef uint64_t Priority;
@@ -570,7 +624,8 @@ class GTEST_API_ Expectation {
     }
   };
 
-  typedef ::std::set<Expectation, Less> Set;
+  typedef ::std::set<Expectation, Less, internal::ArenaAllocator<Expectation>>
+      Set;
 
   Expectation(
       const std::shared_ptr<internal::ExpectationBase>& expectation_base);
@@ -708,6 +763,50 @@ namespace internal {
 // object (if any) in the current thread or NULL.
 GTEST_API_ extern ThreadLocal<Sequence*> g_gmock_implicit_sequence;
 
+}  // namespace internal
+
+// While an ExpectationArena object is alive, the memory that Google Mock
+// allocates in the same thread for EXPECT_CALL() comes from a shared arena
+// of 16 KiB blocks instead of one piece at a time from the heap.  This
+// covers the expectation objects, their source text, actions and
+// prerequisites, the contents of ExpectationSets, each mock function's list
+// of expectations and the mock object registry's entries.  A block whose
+// contents have all been freed, e.g. by Mock::VerifyAndClearExpectations(),
+// is reused for later allocations.  The blocks go back to the heap once the
+// arena and everything allocated from it are gone, typically when the mocks
+// are destroyed at the end of the test.  Make it a member of a fixture whose
+// tests set many expectations:
+//
+//   class FooTest : public ::testing::Test {
+//    protected:
+//     ExpectationArena arena_;  // Declare before the mocks.
+//     MockFoo foo_;
+//   };
+//
+// As with InSequence, only the outermost of nested ExpectationArena objects
+// has any effect.
+class GTEST_API_ ExpectationArena {
+ public:
+  ExpectationArena();
+  ~ExpectationArena();
+
+  // Returns the number of blocks this arena has taken from the heap.
+  size_t block_count() const;
+
+  // Returns the number of bytes allocated from this arena and not yet freed.
+  size_t bytes_in_use() const;
+
+ private:
+  // Co-owned by everything allocated from it.
+  internal::ArenaBlocks* blocks_;
+  bool arena_installed_;
+
+  ExpectationArena(const ExpectationArena&) = delete;
+  ExpectationArena& operator=(const ExpectationArena&) = delete;
+};
+
+namespace internal {
+
 // Base class for implementing expectations.
 //
 // There are two reasons for having a type-agnostic base class for
@@ -776,7 +875,7 @@ class GTEST_API_ ExpectationBase {
     kRetiresOnSaturation
   };
 
-  typedef std::vector<const void*> UntypedActions;
+  typedef std::vector<const void*, ArenaAllocator<const void*>> UntypedActions;
 
   // Returns an Expectation object that references and co-owns this
   // expectation.
@@ -917,7 +1016,7 @@ protected:
   // an EXPECT_CALL() statement finishes.
   const char* file_;               // The file that contains the expectation.
   int line_;                       // The line number of the expectation.
-  const std::string source_text_;  // The EXPECT_CALL(...) source text.
+  const ArenaString source_text_;  // The EXPECT_CALL(...) source text.
   std::string description_;        // User-readable name for the expectation.
   // True if and only if the cardinality is specified explicitly.
   bool cardinality_specified_;
@@ -974,9 +1073,13 @@ class TypedExpectation<R(Args...)> : public ExpectationBase {
     // Check the validity of the action count if it hasn't been done
     // yet (for example, if the expectation was never used).
     CheckActionCountIfNotDone();
+    ArenaAllocator<Action<F>> allocator;
     for (UntypedActions::const_iterator it = untyped_actions_.begin();
          it != untyped_actions_.end(); ++it) {
-      delete static_cast<const Action<F>*>(*it);
+      Action<F>* const action =
+          const_cast<Action<F>*>(static_cast<const Action<F>*>(*it));
+      action->~Action<F>();
+      allocator.deallocate(action, 1);
     }
   }
 
@@ -1095,7 +1198,9 @@ class TypedExpectation<R(Args...)> : public ExpectationBase {
                        ".WillRepeatedly() or .RetiresOnSaturation().");
     last_clause_ = kWillOnce;
 
-    untyped_actions_.push_back(new Action<F>(std::move(action)));
+    ArenaAllocator<Action<F>> allocator;
+    untyped_actions_.push_back(new (allocator.allocate(1))
+                                   Action<F>(std::move(action)));
 
     if (!cardinality_specified()) {
       set_cardinality(Exactly(static_cast<int>(untyped_actions_.size())));
@@ -1399,7 +1504,9 @@ class DefaultSpecFactory<R(Args...)> : public SpecFactory<R(Args...)> {
   std::shared_ptr<TypedExpectation<F>> CreateExpectation(
       FunctionMocker<F>* owner, const char* a_file, int a_line,
       const std::string& a_source_text, const ArgumentMatcherTuple& m ) final {
-    return std::make_shared<TypedExpectation<F>>(owner, a_file, a_line, a_source_text, m);
+    return std::allocate_shared<TypedExpectation<F>>(
+        ArenaAllocator<TypedExpectation<F>>(), owner, a_file, a_line,
+        a_source_text, m);
   }
 };
 
@@ -36,7 +36,9 @@
 
 #include <string.h>
 
+#include <cstdint>
 #include <iostream>
+#include <queue>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -59,6 +61,129 @@ GTEST_API_ std::string FormatMatcherDescription(
   return negation ? "not (" + result + ")" : result;
 }
 
+GTEST_API_ size_t FindSubstring(const char* haystack, size_t haystack_size,
+                                const char* needle, size_t needle_size) {
+  if (needle_size == 0) return 0;
+  if (needle_size > haystack_size) return std::string::npos;
+#ifdef __GLIBC__
+  // glibc's memmem() is linear in the worst case and vectorised.
+  const void* const pos = memmem(haystack, haystack_size, needle, needle_size);
+  return pos == nullptr ? std::string::npos
+                        : static_cast<size_t>(
+                              static_cast<const char*>(pos) - haystack);
+#else
+  // Candidates are found with memchr() on the first byte and filtered on
+  // the last byte before comparing the rest.
+  const char* const last_start = haystack + (haystack_size - needle_size);
+  const char last = needle[needle_size - 1];
+  for (const char* p = haystack; p <= last_start; ++p) {
+    p = static_cast<const char*>(
+        memchr(p, needle[0], static_cast<size_t>(last_start - p) + 1));
+    if (p == nullptr) break;
+    if (p[needle_size - 1] == last && memcmp(p, needle, needle_size) == 0) {
+      return static_cast<size_t>(p - haystack);
+    }
+  }
+  return std::string::npos;
+#endif  // __GLIBC__
+}
+
+SubstringSet::SubstringSet(const std::vector<std::string>& substrings)
+    : substring_count_(substrings.size()) {
+  // Gives each byte that occurs in a substring a column of its own.
+  memset(column_of_byte_, 0, sizeof(column_of_byte_));
+  column_count_ = 1;
+  for (const std::string& substring : substrings) {
+    for (char c : substring) {
+      unsigned char& column = column_of_byte_[static_cast<unsigned char>(c)];
+      if (column == 0) column = static_cast<unsigned char>(column_count_++);
+    }
+  }
+  // If every byte occurs there are no others, and the columns can simply be
+  // the bytes themselves.
+  if (column_count_ > 256) {
+    for (int b = 0; b < 256; ++b) {
+      column_of_byte_[b] = static_cast<unsigned char>(b);
+    }
+    column_count_ = 256;
+  }
+
+  // Builds the trie.  A transition of 0 means "none" until the failure
+  // links are filled in, as no edge leads back to the root.
+  transitions_.assign(column_count_, 0);
+  matches_.resize(1);
+  for (size_t i = 0; i < substrings.size(); ++i) {
+    uint32_t state = 0;
+    for (char c : substrings[i]) {
+      uint32_t& next =
+          transitions_[state * column_count_ +
+                       column_of_byte_[static_cast<unsigned char>(c)]];
+      if (next == 0) {
+        next = static_cast<uint32_t>(matches_.size());
+        matches_.emplace_back();
+        transitions_.resize(transitions_.size() + column_count_, 0);
+      }
+      // transitions_ may have been reallocated.
+      state = transitions_[state * column_count_ +
+                           column_of_byte_[static_cast<unsigned char>(c)]];
+    }
+    matches_[state].push_back(i);
+  }
+
+  // Turns the trie into a DFA breadth-first: a missing transition from a
+  // state goes where its failure link's transition goes, and each state
+  // inherits the matches of its failure link.
+  std::vector<uint32_t> failure(matches_.size(), 0);
+  std::queue<uint32_t> queue;
+  for (size_t column = 0; column < column_count_; ++column) {
+    if (transitions_[column] != 0) queue.push(transitions_[column]);
+  }
+  while (!queue.empty()) {
+    const uint32_t state = queue.front();
+    queue.pop();
+    const std::vector<size_t>& inherited = matches_[failure[state]];
+    matches_[state].insert(matches_[state].end(), inherited.begin(),
+                           inherited.end());
+    for (size_t column = 0; column < column_count_; ++column) {
+      uint32_t& next = transitions_[state * column_count_ + column];
+      const uint32_t fallback =
+          transitions_[failure[state] * column_count_ + column];
+      if (next == 0) {
+        next = fallback;
+      } else {
+        failure[next] = fallback;
+        queue.push(next);
+      }
+    }
+  }
+}
+
+size_t SubstringSet::FindIn(const char* text, size_t size, bool stop_at_first,
+                            std::vector<bool>* found) const {
+  found->assign(substring_count_, false);
+  size_t count = 0;
+  // The empty string is in every text.
+  for (size_t i : matches_[0]) {
+    (*found)[i] = true;
+    ++count;
+  }
+  if (count == substring_count_ || (stop_at_first && count > 0)) return count;
+
+  uint32_t state = 0;
+  for (size_t pos = 0; pos < size; ++pos) {
+    state = transitions_[state * column_count_ +
+                         column_of_byte_[static_cast<unsigned char>(text[pos])]];
+    for (size_t i : matches_[state]) {
+      if (!(*found)[i]) {
+        (*found)[i] = true;
+        ++count;
+      }
+    }
+    if (count == substring_count_ || (stop_at_first && count > 0)) break;
+  }
+  return count;
+}
+
 // FindMaxBipartiteMatching and its helper class.
 //
 // Uses the well-known Ford-Fulkerson max flow method to find a maximum
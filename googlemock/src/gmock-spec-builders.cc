@@ -36,6 +36,9 @@
 
 #include <stdlib.h>
 
+#include <atomic>
+#include <cstddef>
+#include <cstring>
 #include <iostream>  // NOLINT
 #include <map>
 #include <memory>
@@ -84,7 +87,7 @@ ExpectationBase::ExpectationBase(const char* a_file, int a_line,
                                  const std::string& a_source_text)
     : file_(a_file),
       line_(a_line),
-      source_text_(a_source_text),
+      source_text_(a_source_text.data(), a_source_text.size()),
       cardinality_specified_(false),
       cardinality_(Exactly(1)),
       call_count_(0),
@@ -311,6 +314,143 @@ bool ExpectationBase::VerifyExpectationLocked()
 // object (if any) in the current thread or NULL.
 GTEST_API_ ThreadLocal<Sequence*> g_gmock_implicit_sequence;
 
+// The memory behind an ExpectationArena: blocks of kBlockSize bytes,
+// handed out by bumping an offset.  Every allocation is preceded by a
+// pointer to its block, which counts the allocations it still holds; that
+// way memory can be returned from any thread, and an emptied block can be
+// reused.  The object deletes itself once the ExpectationArena and every
+// allocation are gone.
+class ArenaBlocks {
+ public:
+  static constexpr size_t kBlockSize = 16 * 1024;
+
+  struct Block {
+    explicit Block(ArenaBlocks* an_owner)
+        : owner(an_owner), memory(new char[kBlockSize]) {}
+
+    ArenaBlocks* const owner;
+    std::atomic<size_t> live_allocations{0};
+    const std::unique_ptr<char[]> memory;
+  };
+
+  ArenaBlocks() = default;
+
+  // Returns nullptr if the request doesn't fit in a block.  Must be called
+  // in the thread the arena is installed in.
+  void* Allocate(size_t size, size_t alignment);
+
+  // Gives back an allocation of the given size from block.
+  static void Deallocate(Block* block, size_t size);
+
+  // Drops the reference held by the ExpectationArena object.
+  void Release() { Unref(); }
+
+  size_t block_count() const { return blocks_.size(); }
+  size_t bytes_in_use() const {
+    return bytes_in_use_.load(std::memory_order_acquire);
+  }
+
+ private:
+  // Returns a block that holds no allocations, taking a new one from the
+  // heap if there is none.
+  Block* GetEmptyBlock();
+
+  void Unref() {
+    if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+  }
+
+  std::vector<std::unique_ptr<Block>> blocks_;
+  Block* current_ = nullptr;  // The block allocations are taken from.
+  size_t used_ = 0;           // Bytes of current_ handed out so far.
+  // One for the ExpectationArena object, plus one per live allocation.
+  std::atomic<size_t> references_{1};
+  std::atomic<size_t> bytes_in_use_{0};
+
+  ArenaBlocks(const ArenaBlocks&) = delete;
+  ArenaBlocks& operator=(const ArenaBlocks&) = delete;
+};
+
+constexpr size_t ArenaBlocks::kBlockSize;
+
+// Points to the arena introduced by a living ExpectationArena object (if
+// any) in the current thread or NULL.
+static ThreadLocal<ArenaBlocks*> g_gmock_expectation_arena;
+
+// Rounds n up to a multiple of alignment.
+static size_t AlignUp(size_t n, size_t alignment) {
+  return (n + alignment - 1) / alignment * alignment;
+}
+
+ArenaBlocks::Block* ArenaBlocks::GetEmptyBlock() {
+  for (const std::unique_ptr<Block>& block : blocks_) {
+    if (block->live_allocations.load(std::memory_order_acquire) == 0) {
+      return block.get();
+    }
+  }
+  blocks_.emplace_back(new Block(this));
+  return blocks_.back().get();
+}
+
+void* ArenaBlocks::Allocate(size_t size, size_t alignment) {
+  if (sizeof(Block*) + alignment + size > kBlockSize) return nullptr;
+
+  // Start the current block over if everything in it has been freed.
+  if (current_ != nullptr &&
+      current_->live_allocations.load(std::memory_order_acquire) == 0) {
+    used_ = 0;
+  }
+  size_t offset = AlignUp(used_ + sizeof(Block*), alignment);
+  if (current_ == nullptr || offset + size > kBlockSize) {
+    current_ = GetEmptyBlock();
+    offset = AlignUp(sizeof(Block*), alignment);
+  }
+  used_ = offset + size;
+
+  current_->live_allocations.fetch_add(1, std::memory_order_relaxed);
+  references_.fetch_add(1, std::memory_order_relaxed);
+  bytes_in_use_.fetch_add(size, std::memory_order_relaxed);
+
+  char* const result = current_->memory.get() + offset;
+  std::memcpy(result - sizeof(Block*), &current_, sizeof(Block*));
+  return result;
+}
+
+void ArenaBlocks::Deallocate(Block* block, size_t size) {
+  ArenaBlocks* const owner = block->owner;
+  owner->bytes_in_use_.fetch_sub(size, std::memory_order_relaxed);
+  block->live_allocations.fetch_sub(1, std::memory_order_release);
+  owner->Unref();
+}
+
+void* AllocateFromArena(size_t size, size_t alignment) {
+  GTEST_CHECK_(alignment <= alignof(std::max_align_t))
+      << "Over-aligned types can't be allocated from an ExpectationArena.";
+  ArenaBlocks* const arena = g_gmock_expectation_arena.get();
+  if (arena != nullptr) {
+    void* const result = arena->Allocate(size, alignment);
+    if (result != nullptr) return result;
+  }
+
+  // The heap's allocations get a null block pointer.
+  const size_t header_size = AlignUp(sizeof(ArenaBlocks::Block*), alignment);
+  char* const result =
+      static_cast<char*>(::operator new(header_size + size)) + header_size;
+  ArenaBlocks::Block* const no_block = nullptr;
+  std::memcpy(result - sizeof(no_block), &no_block, sizeof(no_block));
+  return result;
+}
+
+void DeallocateToArena(void* p, size_t size, size_t alignment) {
+  char* const memory = static_cast<char*>(p);
+  ArenaBlocks::Block* block;
+  std::memcpy(&block, memory - sizeof(block), sizeof(block));
+  if (block == nullptr) {
+    ::operator delete(memory - AlignUp(sizeof(block), alignment));
+  } else {
+    ArenaBlocks::Deallocate(block, size);
+  }
+}
+
 // Reports an uninteresting call (whose description is in msg) in the
 // manner specified by 'reaction'.
 void ReportUninterestingCall(CallReaction reaction, const std::string& msg) {
@@ -533,7 +673,10 @@ static CallReaction intToCallReaction(int mock_behavior) {
 
 namespace {
 
-typedef std::set<internal::UntypedFunctionMockerBase*> FunctionMockers;
+typedef std::set<internal::UntypedFunctionMockerBase*,
+                 std::less<internal::UntypedFunctionMockerBase*>,
+                 internal::ArenaAllocator<internal::UntypedFunctionMockerBase*>>
+    FunctionMockers;
 
 // The current state of a mock object.  Such information is needed for
 // detecting leaked mock objects and explicitly verifying a mock's
@@ -559,7 +702,10 @@ struct MockObjectState {
 class MockObjectRegistry {
  public:
   // Maps a mock object (identified by its address) to its state.
-  typedef std::map<const void*, MockObjectState> StateMap;
+  typedef std::map<
+      const void*, MockObjectState, std::less<const void*>,
+      internal::ArenaAllocator<std::pair<const void* const, MockObjectState>>>
+      StateMap;
 
   // This destructor will be called when a program exits, after all
   // tests in it have been run.  By then, there should be no mock
@@ -862,6 +1008,31 @@ InSequence::~InSequence() {
   }
 }
 
+// Installs this arena unless one is already installed in this thread.
+ExpectationArena::ExpectationArena() : blocks_(new internal::ArenaBlocks) {
+  if (internal::g_gmock_expectation_arena.get() == nullptr) {
+    internal::g_gmock_expectation_arena.set(blocks_);
+    arena_installed_ = true;
+  } else {
+    arena_installed_ = false;
+  }
+}
+
+// Uninstalls the arena.  Its memory stays alive until everything
+// allocated from it is gone.
+ExpectationArena::~ExpectationArena() {
+  if (arena_installed_) {
+    internal::g_gmock_expectation_arena.set(nullptr);
+  }
+  blocks_->Release();
+}
+
+size_t ExpectationArena::block_count() const { return blocks_->block_count(); }
+
+size_t ExpectationArena::bytes_in_use() const {
+  return blocks_->bytes_in_use();
+}
+
 }  // namespace testing
 
 #if defined(_MSC_VER) && (_MSC_VER == 1900)
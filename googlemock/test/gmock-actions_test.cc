@@ -34,9 +34,11 @@
 #include "gmock/gmock-actions.h"
 
 #include <algorithm>
+#include <array>
 #include <functional>
 #include <iterator>
 #include <memory>
+#include <numeric>
 #include <sstream>
 #include <string>
 #include <tuple>
@@ -592,6 +594,45 @@ TEST(ActionTest, CanBeConvertedToOtherActionType) {
   EXPECT_EQ(0, a2.Perform(std::make_tuple('\0')));
 }
 
+TEST(ActionTest, ConvertingDoDefaultGivesDoDefault) {
+  const Action<bool(int)> a1;
+  const Action<int(char)> a2 = Action<int(char)>(a1);
+  EXPECT_TRUE(a2.IsDoDefault());
+}
+
+// Tests that copies of an Action do not share the state of its callable.
+TEST(ActionTest, CopiesOwnTheirCallable) {
+  Action<int()> a1 = [n = 0]() mutable { return ++n; };
+  EXPECT_EQ(1, a1.Perform(std::make_tuple()));
+
+  Action<int()> a2 = a1;
+  EXPECT_EQ(2, a1.Perform(std::make_tuple()));
+  EXPECT_EQ(2, a2.Perform(std::make_tuple()));
+  EXPECT_EQ(3, a2.Perform(std::make_tuple()));
+
+  a1 = a2;
+  EXPECT_EQ(4, a1.Perform(std::make_tuple()));
+  EXPECT_EQ(4, a2.Perform(std::make_tuple()));
+}
+
+// Tests callables too large to be stored inside the Action.
+TEST(ActionTest, WorksWithLargeCallables) {
+  std::array<int, 64> table;
+  std::iota(table.begin(), table.end(), 0);
+
+  Action<int(size_t)> a1 = [table](size_t i) { return table[i]; };
+  Action<int(size_t)> a2 = a1;
+  Action<int(size_t)> a3 = std::move(a1);
+  EXPECT_TRUE(a1.IsDoDefault());  // NOLINT
+  EXPECT_EQ(5, a2.Perform(std::make_tuple(5)));
+  EXPECT_EQ(63, a3.Perform(std::make_tuple(63)));
+
+  a3 = Return(7);
+  EXPECT_EQ(7, a3.Perform(std::make_tuple(63)));
+  a2 = std::move(a3);
+  EXPECT_EQ(7, a2.Perform(std::make_tuple(0)));
+}
+
 // The following two classes are for testing MakePolymorphicAction().
 
 // Implements a polymorphic action that returns the second of the
@@ -2118,6 +2159,30 @@ TEST(FunctorActionTest, TypeConversion) {
   Action<void(int)>(nullptr);
 }
 
+TEST(FunctorActionTest, NullCallableGivesDoDefault) {
+  EXPECT_TRUE(Action<void(int)>(nullptr).IsDoDefault());
+
+  int (*fp)(int, int&, int*) = nullptr;
+  Action<int(int, int&, int*)> a1 = fp;
+  EXPECT_TRUE(a1.IsDoDefault());
+
+  std::function<int()> f;
+  Action<int()> a2 = f;
+  EXPECT_TRUE(a2.IsDoDefault());
+}
+
+struct Counter {
+  int Next() { return ++count; }
+  int count = 0;
+};
+
+TEST(FunctorActionTest, ActionFromMemberFunctionPointer) {
+  Action<int(Counter*)> a = &Counter::Next;
+  Counter counter;
+  EXPECT_EQ(1, a.Perform(std::make_tuple(&counter)));
+  EXPECT_EQ(2, a.Perform(std::make_tuple(&counter)));
+}
+
 TEST(FunctorActionTest, UnusedArguments) {
   // Verify that users can ignore uninteresting arguments.
   Action<int(int, double y, double z)> a = [](int i, Unused, Unused) {
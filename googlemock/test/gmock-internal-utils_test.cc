@@ -474,6 +474,42 @@ TEST(LogTest, NoSkippingStackFrameInOptMode) {
   GetUnitTestImpl()->set_os_stack_trace_getter(nullptr);
 }
 
+struct CountingStackTraceGetter
+    : testing::internal::OsStackTraceGetterInterface {
+  std::string CurrentStackTrace(int, int) override {
+    ++traces;
+    return "";
+  }
+  void UponLeavingGTest() override {}
+
+  int traces = 0;
+};
+
+// Tests that Log() only asks for a stack trace when the message is printed,
+// so hidden messages never pay for unwinding or symbolizing.
+TEST(LogTest, StackTraceIsOnlyRequestedWhenPrinted) {
+  CountingStackTraceGetter* counting_stack_trace_getter =
+      new CountingStackTraceGetter;
+  GetUnitTestImpl()->set_os_stack_trace_getter(counting_stack_trace_getter);
+  const std::string saved_flag = GMOCK_FLAG_GET(verbose);
+
+  GMOCK_FLAG_SET(verbose, kWarningVerbosity);
+  CaptureStdout();
+  Log(kInfo, "Test log.\n", 0);
+  EXPECT_STREQ("", GetCapturedStdout().c_str());
+  EXPECT_EQ(0, counting_stack_trace_getter->traces);
+
+  GMOCK_FLAG_SET(verbose, kInfoVerbosity);
+  CaptureStdout();
+  Log(kInfo, "Test log.\n", 0);
+  GetCapturedStdout();
+  EXPECT_EQ(1, counting_stack_trace_getter->traces);
+
+  GMOCK_FLAG_SET(verbose, saved_flag);
+  // Restores the default OS stack trace getter.
+  GetUnitTestImpl()->set_os_stack_trace_getter(nullptr);
+}
+
 // Tests that all logs are printed when the value of the
 // --gmock_verbose flag is "info".
 TEST(LogTest, AllLogsArePrintedWhenVerbosityIsInfo) {
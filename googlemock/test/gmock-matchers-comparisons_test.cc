@@ -1364,6 +1364,75 @@ TEST(HasSubstrTest, CanDescribeSelf) {
   EXPECT_EQ("has substring \"foo\\n\\\"\"", Describe(m));
 }
 
+// Tests that HasSubstr() finds needles anywhere in long strings, including
+// ones with many near-misses and embedded NULs.
+TEST(HasSubstrTest, WorksForLongStrings) {
+  std::string haystack(1 << 20, 'a');
+  const Matcher<const std::string&> m = HasSubstr("aaab");
+  EXPECT_FALSE(m.Matches(haystack));
+  haystack.back() = 'b';
+  EXPECT_TRUE(m.Matches(haystack));
+  haystack[10] = '\0';
+  EXPECT_TRUE(m.Matches(haystack));
+  EXPECT_THAT(haystack, HasSubstr(std::string("a\0a", 3)));
+  EXPECT_THAT("a", Not(HasSubstr("ab")));
+}
+
+TEST(HasAllSubstrsTest, MatchesStringContainingEverySubstring) {
+  const Matcher<const std::string&> m =
+      HasAllSubstrs({"error", "warn", "rning", ""});
+  EXPECT_TRUE(m.Matches("warning: error"));
+  EXPECT_TRUE(m.Matches("errorwarning"));
+  EXPECT_FALSE(m.Matches("warning: err"));
+  EXPECT_FALSE(m.Matches(""));
+  EXPECT_EQ("which is missing \"error\"", Explain(m, "warning: err"));
+  EXPECT_EQ("which is missing \"error\", \"warn\", \"rning\"",
+            Explain(m, "nothing"));
+  EXPECT_EQ("", Explain(m, "error warning"));
+
+  const std::vector<std::string> none;
+  EXPECT_TRUE(Matcher<const char*>(HasAllSubstrs(none)).Matches(""));
+}
+
+TEST(HasAllSubstrsTest, WorksForOverlappingSubstrings) {
+  // "she" ends inside "hers", and "he" inside "she"; the automaton must
+  // report them through its failure links.
+  const std::vector<const char*> words = {"he", "she", "his", "hers"};
+  const Matcher<const char*> m = HasAllSubstrs(words);
+  EXPECT_TRUE(m.Matches("ushers his"));
+  EXPECT_FALSE(m.Matches("ushers"));
+  EXPECT_FALSE(m.Matches(nullptr));
+
+  std::string log(1 << 20, '.');
+  log.replace(100, 3, "his");
+  log.replace(500000, 4, "hers");
+  log.replace(1000000, 3, "she");
+  EXPECT_TRUE(m.Matches(log.c_str()));
+}
+
+TEST(HasAnySubstrTest, MatchesStringContainingSomeSubstring) {
+  const Matcher<std::string> m = HasAnySubstr({"FATAL", "panic"});
+  EXPECT_TRUE(m.Matches("kernel panic"));
+  EXPECT_TRUE(m.Matches("FATAL: x"));
+  EXPECT_FALSE(m.Matches("fatal"));
+  EXPECT_EQ("which contains \"panic\"", Explain(m, "kernel panic"));
+  EXPECT_EQ("", Explain(m, "ok"));
+  EXPECT_FALSE(Matcher<std::string>(HasAnySubstr(std::vector<std::string>()))
+                   .Matches("x"));
+}
+
+TEST(HasAnySubstrTest, CanDescribeSelf) {
+  const Matcher<std::string> any = HasAnySubstr({"a", "b"});
+  EXPECT_EQ("has at least one of the substrings { \"a\", \"b\" }",
+            Describe(any));
+  EXPECT_EQ("has none of the substrings { \"a\", \"b\" }",
+            DescribeNegation(any));
+  const Matcher<std::string> all = HasAllSubstrs({"a", "b"});
+  EXPECT_EQ("has all of the substrings { \"a\", \"b\" }", Describe(all));
+  EXPECT_EQ("doesn't have all of the substrings { \"a\", \"b\" }",
+            DescribeNegation(all));
+}
+
 INSTANTIATE_GTEST_MATCHER_TEST_P(KeyTest);
 
 TEST(KeyTest, CanDescribeSelf) {
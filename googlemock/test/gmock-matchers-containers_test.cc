@@ -2357,6 +2357,36 @@ TEST(PointwiseTest, AllowsMonomorphicInnerMatcher) {
   EXPECT_EQ("", Explain(Pointwise(m2, rhs), lhs));
 }
 
+TEST(PointwiseTest, ComparesLargeContainersWithEq) {
+  vector<int64_t> lhs(100000, 7);
+  const vector<int64_t> rhs = lhs;
+  EXPECT_THAT(lhs, Pointwise(Eq(), rhs));
+  lhs[500] = 8;
+  EXPECT_EQ("where the value pair (8, 7) at index #500 don't match",
+            Explain(Pointwise(Eq(), rhs), lhs));
+  list<int> rhs_list(3, 7);
+  EXPECT_THAT(vector<int>({7, 7, 7}), Pointwise(Eq(), rhs_list));
+  EXPECT_THAT(vector<int>({7, 8, 7}), Not(Pointwise(Eq(), rhs_list)));
+}
+
+TEST(PointwiseTest, ComparesContainersWithFloatEq) {
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const float close_to_one = 1.0f + std::numeric_limits<float>::epsilon();
+  const vector<float> rhs = {1.0f, 2.0f, nan};
+  EXPECT_THAT(vector<float>({close_to_one, 2.0f, nan}),
+              Pointwise(NanSensitiveFloatEq(), rhs));
+  EXPECT_THAT(vector<float>({close_to_one, 2.0f, nan}),
+              Not(Pointwise(FloatEq(), rhs)));
+  EXPECT_THAT(vector<float>({1.1f, 2.0f, nan}),
+              Pointwise(NanSensitiveFloatNear(0.2f), rhs));
+  EXPECT_EQ(
+      "where the value pair (1.5, 1) at index #0 don't match, "
+      "which is -0.5 from 1.5",
+      Explain(Pointwise(FloatNear(0.2f), rhs), vector<float>({1.5f, 2.0f, 3.0f})));
+  EXPECT_THAT(vector<double>({1.0, 2.5}),
+              Not(Pointwise(DoubleEq(), vector<double>({1.0, 2.0}))));
+}
+
 MATCHER(PointeeEquals, "Points to an equal value") {
   return ExplainMatchResult(::testing::Pointee(::testing::get<1>(arg)),
                             ::testing::get<0>(arg), result_listener);
@@ -2996,6 +3026,48 @@ TEST(ElementsAreArrayTest, SourceLifeSpan) {
   EXPECT_THAT(test_vector, Not(matcher_maker));
 }
 
+// The following tests cover the bulk comparison used for arrays of plain
+// values matched against contiguous containers of the same type.
+
+TEST(ElementsAreArrayTest, MatchesLargeContiguousContainerOfValues) {
+  vector<int> expected(1000000);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    expected[i] = static_cast<int>(i);
+  }
+  vector<int> actual = expected;
+  EXPECT_THAT(actual, ElementsAreArray(expected));
+  EXPECT_EQ("", Explain(ElementsAreArray(expected), actual));
+
+  actual[999998] = -1;
+  EXPECT_THAT(actual, Not(ElementsAreArray(expected)));
+  EXPECT_EQ("whose element #999998 doesn't match",
+            Explain(ElementsAreArray(expected), actual));
+}
+
+TEST(ElementsAreArrayTest, ExplainsMismatchOfContiguousValues) {
+  const int a[] = {1, 2, 3};
+  const int expected[] = {1, 2, 4};
+  EXPECT_THAT(a, Not(ElementsAreArray(expected)));
+  EXPECT_EQ("whose element #2 doesn't match",
+            Explain(ElementsAreArray(expected), a));
+  EXPECT_EQ("which has 3 elements",
+            Explain(ElementsAreArray(expected, 2), vector<int>(a, a + 3)));
+  EXPECT_EQ(
+      "has 3 elements where\n"
+      "element #0 is equal to 1,\n"
+      "element #1 is equal to 2,\n"
+      "element #2 is equal to 4",
+      Describe<const vector<int>&>(ElementsAreArray(expected)));
+}
+
+TEST(ElementsAreArrayTest, UsesOperatorEqualsForContiguousFloatingPoint) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THAT(vector<double>({0.0, 1.5}), ElementsAreArray({-0.0, 1.5}));
+  EXPECT_THAT(vector<double>({nan}), Not(ElementsAreArray({nan})));
+  EXPECT_THAT(vector<bool>({true, false}), ElementsAreArray({true, false}));
+  EXPECT_THAT(vector<bool>({true, false}), Not(ElementsAreArray({true, true})));
+}
+
 // Tests Contains().
 
 INSTANTIATE_GTEST_MATCHER_TEST_P(ContainsTest);
@@ -1384,6 +1384,158 @@ TEST(SequenceTest, Retirement) {
   a.DoA(1);
 }
 
+// Tests ExpectationArena.
+
+TEST(ExpectationArenaTest, ExpectationsWorkAsUsual) {
+  ExpectationArena arena;
+  MockA a;
+  Sequence s;
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_CALL(a, ReturnInt(i, _)).InSequence(s).WillOnce(Return(i * 2));
+  }
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(i * 2, a.ReturnInt(i, 0));
+  }
+}
+
+TEST(ExpectationArenaTest, ExpectationsMayOutliveTheArena) {
+  MockA a;
+  Expectation e;
+  {
+    ExpectationArena arena;
+    e = EXPECT_CALL(a, DoA(1));
+  }
+  EXPECT_CALL(a, DoA(2)).After(e);
+
+  a.DoA(1);
+  a.DoA(2);
+}
+
+TEST(ExpectationArenaTest, OnlyOutermostArenaIsInstalled) {
+  MockA a;
+  ExpectationArena outer;
+  {
+    ExpectationArena inner;
+    EXPECT_CALL(a, DoA(1));
+    EXPECT_EQ(0u, inner.block_count());
+  }
+  EXPECT_CALL(a, DoA(2));
+  EXPECT_EQ(1u, outer.block_count());
+
+  a.DoA(1);
+  a.DoA(2);
+}
+
+// The expectations compared below are set on mocks in the same state, so
+// that the lists of expectations grow alike.
+TEST(ExpectationArenaTest, HoldsSourceText) {
+  MockA a1;
+  MockA a2;
+  ExpectationArena arena;
+  EXPECT_CALL(a1, DoA(1)).Times(AnyNumber());
+  EXPECT_CALL(a2, DoA(1)).Times(AnyNumber());
+
+  size_t before = arena.bytes_in_use();
+  EXPECT_CALL(a1, DoA(2 + 0)).Times(AnyNumber());
+  const size_t short_expectation = arena.bytes_in_use() - before;
+
+  before = arena.bytes_in_use();
+  EXPECT_CALL(a2, DoA(2 + 0 + 0 + 0 + 0 + 0)).Times(AnyNumber());
+  const size_t long_expectation = arena.bytes_in_use() - before;
+
+  // Both texts are too long for the small string optimization.
+  EXPECT_EQ(short_expectation + sizeof(" + 0 + 0 + 0 + 0") - 1,
+            long_expectation);
+}
+
+TEST(ExpectationArenaTest, HoldsActions) {
+  MockA a1;
+  MockA a2;
+  ExpectationArena arena;
+  EXPECT_CALL(a1, ReturnInt(_, _)).Times(AnyNumber());
+  EXPECT_CALL(a2, ReturnInt(_, _)).Times(AnyNumber());
+
+  size_t before = arena.bytes_in_use();
+  EXPECT_CALL(a1, ReturnInt(_, _)).Times(3);
+  const size_t without_actions = arena.bytes_in_use() - before;
+
+  before = arena.bytes_in_use();
+  EXPECT_CALL(a2, ReturnInt(_, _))
+      .WillOnce(Return(1))
+      .WillOnce(Return(2))
+      .WillOnce(Return(3));
+  const size_t with_actions = arena.bytes_in_use() - before;
+
+  EXPECT_GE(with_actions, without_actions + 3 * sizeof(void*) +
+                              3 * sizeof(Action<int(int, int)>));
+
+  for (int i = 0; i < 3; i++) {
+    a1.ReturnInt(0, 0);
+    a2.ReturnInt(0, 0);
+  }
+}
+
+TEST(ExpectationArenaTest, HoldsExpectationSets) {
+  MockA a;
+  Expectation e1 = EXPECT_CALL(a, DoA(1));
+  Expectation e2 = EXPECT_CALL(a, DoA(2));
+  ExpectationArena arena;
+  {
+    ExpectationSet es;
+    es += e1;
+    const size_t one_element = arena.bytes_in_use();
+    EXPECT_GE(one_element, sizeof(Expectation));
+
+    es += e2;
+    EXPECT_EQ(2 * one_element, arena.bytes_in_use());
+  }
+  EXPECT_EQ(0u, arena.bytes_in_use());
+
+  a.DoA(1);
+  a.DoA(2);
+}
+
+TEST(ExpectationArenaTest, HoldsTheMockObjectRegistry) {
+  ExpectationArena arena;
+  {
+    MockA a;
+    EXPECT_CALL(a, DoA(1)).Times(AnyNumber());
+    Mock::VerifyAndClearExpectations(&a);
+    EXPECT_GT(arena.bytes_in_use(), 0u);
+  }
+  EXPECT_EQ(0u, arena.bytes_in_use());
+}
+
+TEST(ExpectationArenaTest, ReusesBlocksAfterVerifyAndClear) {
+  // The mock method is registered before the arena exists, so that clearing
+  // its expectations leaves the arena empty.
+  MockA a;
+  EXPECT_CALL(a, ReturnInt(_, _)).Times(AnyNumber());
+  Mock::VerifyAndClearExpectations(&a);
+
+  ExpectationArena arena;
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_CALL(a, ReturnInt(i, _)).WillRepeatedly(Return(i));
+  }
+  const size_t bytes_in_use = arena.bytes_in_use();
+  const size_t block_count = arena.block_count();
+  EXPECT_GT(block_count, 1u);
+
+  for (int round = 0; round < 3; round++) {
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(&a));
+    EXPECT_EQ(0u, arena.bytes_in_use());
+    EXPECT_EQ(block_count, arena.block_count());
+
+    for (int i = 0; i < 1000; i++) {
+      EXPECT_CALL(a, ReturnInt(i, _)).WillRepeatedly(Return(i));
+    }
+    EXPECT_EQ(bytes_in_use, arena.bytes_in_use());
+    EXPECT_EQ(block_count, arena.block_count());
+  }
+  EXPECT_EQ(999, a.ReturnInt(999, 0));
+}
+
 // Tests Expectation.
 
 TEST(ExpectationTest, ConstrutorsWork) {
@@ -36,3 +36,8 @@
 #define LinkTest LinkTest1
 
 #include "test/gmock_link_test.h"
+
+GMOCK_INSTANTIATE_FUNCTION_MOCKER(void(char*));
+GMOCK_INSTANTIATE_FUNCTION_MOCKER(int(char*));
+GMOCK_INSTANTIATE_FUNCTION_MOCKER(int&(char*));
+GMOCK_INSTANTIATE_FUNCTION_MOCKER(void(const std::vector<int>&));
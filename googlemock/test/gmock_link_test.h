@@ -97,6 +97,10 @@
 //      Not
 //      MatcherCast<T>
 //
+// c. Function mockers declared with GMOCK_DECLARE_FUNCTION_MOCKER() in a
+//    header link against the single GMOCK_INSTANTIATE_FUNCTION_MOCKER()
+//    in gmock_link_test.cc.
+//
 //  Please note: this test does not verify the functioning of these
 //  constructs, only that the programs using them will link successfully.
 //
@@ -226,6 +230,11 @@ class Mock : public Interface {
   Mock& operator=(const Mock&) = delete;
 };
 
+GMOCK_DECLARE_FUNCTION_MOCKER(void(char*));
+GMOCK_DECLARE_FUNCTION_MOCKER(int(char*));
+GMOCK_DECLARE_FUNCTION_MOCKER(int&(char*));
+GMOCK_DECLARE_FUNCTION_MOCKER(void(const std::vector<int>&));
+
 class InvokeHelper {
  public:
   static void StaticVoidFromVoid() {}
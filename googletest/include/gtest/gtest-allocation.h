@@ -0,0 +1,119 @@
+// Copyright 2024, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// The Google C++ Testing and Mocking Framework (Google Test)
+//
+// This header file defines the public API for checking heap allocations.
+// It is #included by gtest.h so a user doesn't need to include this
+// directly.
+//
+// Allocations are only counted when the test program is linked with the
+// gtest_alloc library, which replaces the global operator new and
+// operator delete.
+
+// IWYU pragma: private, include "gtest/gtest.h"
+// IWYU pragma: friend gtest/.*
+// IWYU pragma: friend gmock/.*
+
+#ifndef GOOGLETEST_INCLUDE_GTEST_GTEST_ALLOCATION_H_
+#define GOOGLETEST_INCLUDE_GTEST_GTEST_ALLOCATION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "gtest/internal/gtest-port.h"
+
+namespace testing {
+namespace internal {
+
+// The heap allocations made by one thread.
+struct AllocationCounters {
+  int64_t allocations = 0;
+  int64_t bytes = 0;
+};
+
+// Returns the heap allocations the calling thread has made so far.
+GTEST_API_ AllocationCounters GetThreadAllocationCounters();
+
+// Returns true if and only if heap allocations are being counted, i.e.
+// the program is linked with the gtest_alloc library.
+GTEST_API_ bool AllocationCountingEnabled();
+
+// Called by the gtest_alloc library when it is loaded, and on each
+// allocation made through its operator new.  These must not allocate.
+GTEST_API_ void EnableAllocationCounting();
+GTEST_API_ void CountAllocation(size_t size);
+
+// Checks the heap allocations made by the calling thread while an
+// EXPECT_ALLOCATIONS_AT_MOST() block runs.  Don't use this directly.
+class GTEST_API_ AllocationScope {
+ public:
+  AllocationScope(int64_t max_allocations, const char* file, int line);
+  ~AllocationScope();
+
+  // Returns true the first time it's called, so that the block runs once.
+  // The second call checks the allocations the block made and returns false.
+  bool Enter();
+
+ private:
+  void Check();
+
+  const int64_t max_allocations_;
+  const char* const file_;
+  const int line_;
+  const AllocationCounters start_;
+  bool entered_ = false;
+  bool checked_ = false;
+
+  AllocationScope(const AllocationScope&) = delete;
+  AllocationScope& operator=(const AllocationScope&) = delete;
+};
+
+}  // namespace internal
+}  // namespace testing
+
+// Asserts that the statements in the following block make at most n heap
+// allocations on the calling thread, for example:
+//
+//   EXPECT_ALLOCATIONS_AT_MOST(1) {
+//     queue.Push(message);
+//   }
+//
+// EXPECT_NO_ALLOCATIONS is the same as EXPECT_ALLOCATIONS_AT_MOST(0).  A
+// failure is non-fatal and is reported at the line of the macro.  The test
+// program must be linked with the gtest_alloc library, or the check fails.
+#define EXPECT_ALLOCATIONS_AT_MOST(n)                               \
+  for (::testing::internal::AllocationScope gtest_allocation_scope( \
+           (n), __FILE__, __LINE__);                                \
+       gtest_allocation_scope.Enter();)
+
+#define EXPECT_NO_ALLOCATIONS EXPECT_ALLOCATIONS_AT_MOST(0)
+
+#endif  // GOOGLETEST_INCLUDE_GTEST_GTEST_ALLOCATION_H_
@@ -301,6 +301,68 @@ struct ConvertibleToAbslStringifyPrinter {
 };
 #endif  // GTEST_HAS_ABSL
 
+// True for the built-in integer types other than bool and the character
+// types, which have printers of their own.
+template <typename T>
+struct IsPlainInteger : std::false_type {};
+template <>
+struct IsPlainInteger<short> : std::true_type {};  // NOLINT
+template <>
+struct IsPlainInteger<unsigned short> : std::true_type {};  // NOLINT
+template <>
+struct IsPlainInteger<int> : std::true_type {};
+template <>
+struct IsPlainInteger<unsigned int> : std::true_type {};
+template <>
+struct IsPlainInteger<long> : std::true_type {};  // NOLINT
+template <>
+struct IsPlainInteger<unsigned long> : std::true_type {};  // NOLINT
+template <>
+struct IsPlainInteger<long long> : std::true_type {};  // NOLINT
+template <>
+struct IsPlainInteger<unsigned long long> : std::true_type {};  // NOLINT
+
+// Appends the decimal representation of value to *buf.  The digits are
+// produced directly rather than through std::ostream's num_put facet.
+GTEST_API_ void AppendDecimal(long long value, ::std::string* buf);  // NOLINT
+GTEST_API_ void AppendDecimal(unsigned long long value,              // NOLINT
+                              ::std::string* buf);
+
+// Appends value to *buf the way an ostream with default flags and the
+// given precision would print it.
+GTEST_API_ void AppendFloatingPoint(double value, int precision,
+                                    ::std::string* buf);
+
+// When os uses the default numeric formatting (decimal base, no width, the
+// classic locale), writes the digits of value in one call instead of going
+// through operator<< and returns true.  Otherwise writes nothing and returns
+// false, so that the caller can stream the value at its original type:
+// with std::hex, a short -1 must still print as ffff.
+GTEST_API_ bool TryPrintDecimalTo(long long value,  // NOLINT
+                                  ::std::ostream* os);
+GTEST_API_ bool TryPrintDecimalTo(unsigned long long value,  // NOLINT
+                                  ::std::ostream* os);
+GTEST_API_ void PrintFloatingPointTo(double value, int precision,
+                                     ::std::ostream* os);
+
+// Widens a plain integer to the type taken by AppendDecimal() and
+// TryPrintDecimalTo().
+template <typename T>
+using WidestIntegerOf =
+    typename std::conditional<std::is_signed<T>::value,
+                              long long,                   // NOLINT
+                              unsigned long long>::type;  // NOLINT
+
+struct IntegerPrinter {
+  template <typename T, typename = typename std::enable_if<
+                            IsPlainInteger<T>::value>::type>
+  static void PrintValue(T value, ::std::ostream* os) {
+    if (!TryPrintDecimalTo(static_cast<WidestIntegerOf<T>>(value), os)) {
+      *os << value;
+    }
+  }
+};
+
 // Prints the given number of bytes in the given object to the given
 // ostream.
 GTEST_API_ void PrintBytesInObjectTo(const unsigned char* obj_bytes,
@@ -340,6 +402,7 @@ struct FindFirstPrinter<
 //  - Print function pointers.
 //  - Print object pointers.
 //  - Print protocol buffers.
+//  - Print built-in integers.
 //  - Use the stream operator, if available.
 //  - Print types convertible to BiggestInt.
 //  - Print types convertible to StringView, if available.
@@ -348,7 +411,7 @@ template <typename T>
 void PrintWithFallback(const T& value, ::std::ostream* os) {
   using Printer = typename FindFirstPrinter<
       T, void, ContainerPrinter, FunctionPointerPrinter, PointerPrinter,
-      ProtobufPrinter,
+      ProtobufPrinter, IntegerPrinter,
 #ifdef GTEST_HAS_ABSL
       ConvertibleToAbslStringifyPrinter,
 #endif  // GTEST_HAS_ABSL
@@ -613,17 +676,11 @@ int AppropriateResolution(FloatType val) {
 }
 
 inline void PrintTo(float f, ::std::ostream* os) {
-  auto old_precision = os->precision();
-  os->precision(AppropriateResolution(f));
-  *os << f;
-  os->precision(old_precision);
+  internal::PrintFloatingPointTo(f, AppropriateResolution(f), os);
 }
 
 inline void PrintTo(double d, ::std::ostream* os) {
-  auto old_precision = os->precision();
-  os->precision(AppropriateResolution(d));
-  *os << d;
-  os->precision(old_precision);
+  internal::PrintFloatingPointTo(d, AppropriateResolution(d), os);
 }
 
 // Overloads for C strings.
@@ -1178,15 +1235,47 @@ Strings UniversalTersePrintTupleFieldsToStrings(const Tuple& value) {
   return result;
 }
 
-}  // namespace internal
+// PrintToString() formats integers and floating-point numbers straight
+// into the result string; everything else is printed through a
+// stringstream so that user-defined PrintTo() and operator<< are honoured.
+template <typename T>
+struct IsDirectlyFormattable
+    : std::integral_constant<bool, IsPlainInteger<T>::value ||
+                                       std::is_same<T, float>::value ||
+                                       std::is_same<T, double>::value> {};
 
 template <typename T>
-::std::string PrintToString(const T& value) {
+void AppendNumber(T value, ::std::string* buf, std::true_type /* integer */) {
+  AppendDecimal(static_cast<WidestIntegerOf<T>>(value), buf);
+}
+
+template <typename T>
+void AppendNumber(T value, ::std::string* buf, std::false_type /* float */) {
+  AppendFloatingPoint(value, AppropriateResolution(value), buf);
+}
+
+template <typename T>
+::std::string PrintToStringImpl(const T& value, std::true_type) {
+  ::std::string result;
+  AppendNumber(value, &result, IsPlainInteger<T>());
+  return result;
+}
+
+template <typename T>
+::std::string PrintToStringImpl(const T& value, std::false_type) {
   ::std::stringstream ss;
-  internal::UniversalTersePrinter<T>::Print(value, &ss);
+  UniversalTersePrinter<T>::Print(value, &ss);
   return ss.str();
 }
 
+}  // namespace internal
+
+template <typename T>
+::std::string PrintToString(const T& value) {
+  return internal::PrintToStringImpl(value,
+                                     internal::IsDirectlyFormattable<T>());
+}
+
 }  // namespace testing
 
 // Include any custom printer added by the local installation.
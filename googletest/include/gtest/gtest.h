@@ -57,9 +57,11 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 
+#include "gtest/gtest-allocation.h"
 #include "gtest/gtest-assertion-result.h"
 #include "gtest/gtest-death-test.h"
 #include "gtest/gtest-matchers.h"
@@ -97,6 +99,10 @@ GTEST_DECLARE_string_(color);
 // first failure.
 GTEST_DECLARE_bool_(fail_fast);
 
+// This flag makes the tests that failed in the previous run, as recorded in
+// the report named by --gtest_rerun_failed or --gtest_output, run first.
+GTEST_DECLARE_bool_(failed_first);
+
 // This flag sets up the filter to select by name using a glob pattern
 // the tests to run. If the filter is not given all tests are executed.
 GTEST_DECLARE_string_(filter);
@@ -105,14 +111,29 @@ GTEST_DECLARE_string_(filter);
 // debugging information when fatal signals are raised.
 GTEST_DECLARE_bool_(install_failure_signal_handler);
 
+// This flag makes Google Test run each test in a child process forked after
+// the global and test suite set-up, so that tests see pristine state and a
+// crashing test does not take the rest of the run down with it.
+GTEST_DECLARE_bool_(isolate_tests);
+
 // This flag causes the Google Test to list tests. None of the tests listed
 // are actually run if the flag is provided.
 GTEST_DECLARE_bool_(list_tests);
 
+// This flag names a JSON file, or a directory for one file per program, that
+// Google Test keeps up to date with the list of all tests, so that tools can
+// discover them without running the program.
+GTEST_DECLARE_string_(manifest);
+
 // This flag controls whether Google Test emits a detailed XML report to a file
 // in addition to its normal textual output.
 GTEST_DECLARE_string_(output);
 
+// This flag controls whether Google Test counts each test's instructions,
+// cycles, cache and branch misses and other events with perf_event_open(),
+// and records them as test properties.
+GTEST_DECLARE_bool_(perf_counters);
+
 // This flags control whether Google Test prints only test failures.
 GTEST_DECLARE_bool_(brief);
 
@@ -126,16 +147,28 @@ GTEST_DECLARE_bool_(print_utf8);
 // This flag specifies the random number seed.
 GTEST_DECLARE_int32_(random_seed);
 
+// This flag makes Google Test record the CPU time, memory, context switches
+// and page faults of each test, and add them to the reports.
+GTEST_DECLARE_bool_(record_resource_usage);
+
 // This flag sets how many times the tests are repeated. The default value
 // is 1. If the value is -1 the tests are repeating forever.
 GTEST_DECLARE_int32_(repeat);
 
+// This flag names a previous XML or JSON report. Only the tests that failed
+// in it are run, unless --gtest_failed_first is also given.
+GTEST_DECLARE_string_(rerun_failed);
+
 // This flag controls whether Google Test Environments are recreated for each
 // repeat of the tests. The default value is true. If set to false the global
 // test Environment objects are only set up once, for the first iteration, and
 // only torn down once, for the last.
 GTEST_DECLARE_bool_(recreate_environments_when_repeating);
 
+// When this flag is specified, the benchmarks defined with BENCHMARK_TEST()
+// run along with the tests.  Otherwise they are left out.
+GTEST_DECLARE_bool_(run_benchmarks);
+
 // This flag controls whether Google Test includes Google Test internal
 // stack frames in failure stack traces.
 GTEST_DECLARE_bool_(show_internal_stack_frames);
@@ -147,6 +180,10 @@ GTEST_DECLARE_bool_(shuffle);
 // printed in a failure message.
 GTEST_DECLARE_int32_(stack_trace_depth);
 
+// This flag sets how many milliseconds each test may run before it is
+// reported as timed out and the test program is aborted.  0 means no limit.
+GTEST_DECLARE_int32_(test_timeout_ms);
+
 // When this flag is specified, a failed assertion will throw an
 // exception if exceptions are enabled, or exit the program with a
 // non-zero code otherwise. For use with an external test framework.
@@ -242,6 +279,7 @@ class UnitTest;
 class GTEST_API_ Test {
  public:
   friend class TestInfo;
+  friend class TestSuite;
 
   // The d'tor is virtual as we intend to inherit from Test.
   virtual ~Test();
@@ -304,6 +342,12 @@ class GTEST_API_ Test {
     RecordProperty(key, (Message() << value).GetString());
   }
 
+  // Sets how many milliseconds the current test may run, counted from the
+  // moment its constructor starts, in place of --gtest_test_timeout_ms.  0
+  // means no limit.  Has no effect outside of a test, or where Google Test
+  // is not thread-safe.
+  static void SetTestTimeoutMs(int timeout_ms);
+
  protected:
   // Creates a Test object.
   Test();
@@ -360,6 +404,38 @@ class GTEST_API_ Test {
   Test& operator=(const Test&) = delete;
 };
 
+// A test fixture that also derives from PooledFixture lets tests reuse its
+// objects.  Instead of deleting a test object when its test ends, Google Test
+// keeps it until the end of the test suite, and runs the next test of the
+// same class in it after calling Reset() instead of the constructor.  Tests
+// of the same class are the instances of one TEST_P (every TEST_F defines a
+// class of its own), so this mostly pays off for value-parameterized tests
+// whose fixture is expensive to construct.  For example:
+//
+//   class ParserTest : public testing::TestWithParam<std::string>,
+//                      public testing::PooledFixture {
+//    protected:
+//     ParserTest() : index_(BuildLargeIndex()) {}
+//     void Reset() override { index_.ClearQueryCache(); }
+//
+//     Index index_;
+//   };
+//
+// SetUp() and TearDown() are still called for every test, GetParam()
+// returns the current test's parameter, and flags set with GTEST_FLAG_SET()
+// are restored after every test.  Mock objects kept in a pooled fixture are
+// only verified when it is deleted, at the end of the test suite, so verify
+// them in TearDown() with testing::Mock::VerifyAndClearExpectations() or
+// don't keep them in the fixture.
+class PooledFixture {
+ public:
+  virtual ~PooledFixture() = default;
+
+  // Returns the fixture to the state its constructor left it in, before it
+  // is reused for another test.
+  virtual void Reset() = 0;
+};
+
 typedef internal::TimeInMillis TimeInMillis;
 
 // A copyable object representing a user specified test property which can be
@@ -390,6 +466,46 @@ class TestProperty {
   std::string value_;
 };
 
+// The resources used by a single Test, from the start of its constructor to
+// the end of its destructor, as recorded with --gtest_record_resource_usage.
+// Counts cover the whole process, including any threads the test starts.
+struct TestResourceUsage {
+  // CPU time spent in user mode, in microseconds.
+  int64_t user_time_us = 0;
+  // CPU time spent in the kernel, in microseconds.
+  int64_t system_time_us = 0;
+  // How far the test raised the peak resident set size of the process, in
+  // KiB.  This is 0 for a test that stays below an earlier peak.
+  int64_t peak_rss_delta_kb = 0;
+  int64_t voluntary_context_switches = 0;
+  int64_t involuntary_context_switches = 0;
+  // Page faults served without and with I/O.
+  int64_t minor_page_faults = 0;
+  int64_t major_page_faults = 0;
+  // Heap allocations made through operator new by the thread running the
+  // test, and their total size in bytes.  These are only counted when the
+  // program is linked with the gtest_alloc library.
+  int64_t allocations = 0;
+  int64_t allocated_bytes = 0;
+};
+
+// The statistics of a benchmark defined with BENCHMARK_TEST(), over the
+// time one iteration of its body took, in nanoseconds.
+struct BenchmarkResult {
+  // How many samples were taken, each timing a run of iterations_per_sample
+  // iterations.  This is 0 for a test that isn't a benchmark, or that failed
+  // or was skipped before its samples were taken.
+  int64_t samples = 0;
+  int64_t iterations_per_sample = 0;
+  double min_ns = 0;
+  double median_ns = 0;
+  // The median absolute deviation from the median.
+  double mad_ns = 0;
+  double p90_ns = 0;
+  double p99_ns = 0;
+  double max_ns = 0;
+};
+
 // The result of a single Test.  This includes a list of
 // TestPartResults, a list of TestProperties, a count of how many
 // death tests there are in the Test, and how much time it took to run
@@ -433,6 +549,13 @@ class GTEST_API_ TestResult {
   // UNIX epoch.
   TimeInMillis start_timestamp() const { return start_timestamp_; }
 
+  // Returns the resources used by the test.  All zero unless
+  // --gtest_record_resource_usage is given on a platform that supports it.
+  const TestResourceUsage& resource_usage() const { return resource_usage_; }
+
+  // Returns the statistics of the benchmark, if this is the result of one.
+  const BenchmarkResult& benchmark_result() const { return benchmark_result_; }
+
   // Returns the i-th test part result among all the results. i can range from 0
   // to total_part_count() - 1. If i is not in that range, aborts the program.
   const TestPartResult& GetTestPartResult(int i) const;
@@ -469,13 +592,24 @@ class GTEST_API_ TestResult {
   // Sets the elapsed time.
   void set_elapsed_time(TimeInMillis elapsed) { elapsed_time_ = elapsed; }
 
+  // Sets the resources used by the test.
+  void set_resource_usage(const TestResourceUsage& usage) {
+    resource_usage_ = usage;
+  }
+
+  // Sets the statistics of the benchmark.
+  void set_benchmark_result(const BenchmarkResult& result) {
+    benchmark_result_ = result;
+  }
+
   // Adds a test property to the list. The property is validated and may add
   // a non-fatal failure if invalid (e.g., if it conflicts with reserved
   // key names). If a property is already recorded for the same key, the
   // value will be updated, rather than storing multiple values for the same
   // key.  xml_element specifies the element for which the property is being
-  // recorded and is used for validation.
-  void RecordProperty(const std::string& xml_element,
+  // recorded and is used for validation.  Returns true if the property was
+  // valid and has been recorded.
+  bool RecordProperty(const std::string& xml_element,
                       const TestProperty& test_property);
 
   // Adds a failure if the key is a reserved attribute of Google Test
@@ -513,6 +647,10 @@ class GTEST_API_ TestResult {
   TimeInMillis start_timestamp_;
   // The elapsed time, in milliseconds.
   TimeInMillis elapsed_time_;
+  // The resources used, if they were recorded.
+  TestResourceUsage resource_usage_;
+  // The statistics, if this is the result of a benchmark.
+  BenchmarkResult benchmark_result_;
 
   // We disallow copying TestResult.
   TestResult(const TestResult&) = delete;
@@ -595,6 +733,10 @@ class GTEST_API_ TestInfo {
     return matches_filter_ && !is_in_another_shard_;
   }
 
+  // Returns true if and only if this is a benchmark defined with
+  // BENCHMARK_TEST() or BENCHMARK_TEST_F().
+  bool is_benchmark() const { return is_benchmark_; }
+
   // Returns the result of the test.
   const TestResult* result() const { return &result_; }
 
@@ -612,6 +754,7 @@ class GTEST_API_ TestInfo {
       internal::TypeId fixture_class_id, internal::SetUpTestSuiteFunc set_up_tc,
       internal::TearDownTestSuiteFunc tear_down_tc,
       internal::TestFactoryBase* factory);
+  friend TestInfo* internal::MarkAsBenchmark(TestInfo* test_info);
 
   // Constructs a TestInfo object. The newly constructed instance assumes
   // ownership of the factory object.
@@ -655,6 +798,7 @@ class GTEST_API_ TestInfo {
   bool matches_filter_;       // True if this test matches the
                               // user-specified filter.
   bool is_in_another_shard_;  // Will be run in another shard.
+  bool is_benchmark_;         // True if and only if this is a benchmark.
   internal::TestFactoryBase* const factory_;  // The factory that creates
                                               // the test object
 
@@ -752,6 +896,7 @@ class GTEST_API_ TestSuite {
 
  private:
   friend class Test;
+  friend class TestInfo;
   friend class internal::UnitTestImpl;
 
   // Gets the (mutable) vector of TestInfos in this TestSuite.
@@ -787,6 +932,17 @@ class GTEST_API_ TestSuite {
   // Skips the execution of tests under this TestSuite
   void Skip();
 
+  // Removes the test object with the given fixture pool ID from the pool and
+  // returns it, or returns nullptr if there is none.
+  Test* TakePooledFixture(internal::TypeId pool_id);
+
+  // Keeps a test object for reuse by the next test with the same fixture pool
+  // ID.
+  void ReturnPooledFixture(internal::TypeId pool_id, Test* test);
+
+  // Deletes the test objects kept for reuse.
+  void DeletePooledFixtures();
+
   // Runs SetUpTestSuite() for this TestSuite.  This wrapper is needed
   // for catching exceptions thrown from SetUpTestSuite().
   void RunSetUpTestSuite() {
@@ -870,6 +1026,9 @@ class GTEST_API_ TestSuite {
   // Holds test properties recorded during execution of SetUpTestSuite and
   // TearDownTestSuite.
   TestResult ad_hoc_test_result_;
+  // The test objects kept for reuse while the test suite runs, with their
+  // fixture pool IDs.
+  std::vector<std::pair<internal::TypeId, Test*>> fixture_pool_;
 
   // We disallow copying TestSuites.
   TestSuite(const TestSuite&) = delete;
@@ -1100,11 +1259,23 @@ class GTEST_API_ TestEventListeners {
   TestEventListeners& operator=(const TestEventListeners&) = delete;
 };
 
+// Converts the result stream that --gtest_output=bin:input_path wrote into
+// the report that --gtest_output=output would have written, output being
+// "xml:output_path" or "json:output_path".  If the tests were repeated, the
+// last iteration is converted.  A stream cut short by a crash is converted up
+// to where it ends: the test that was running, or the run as a whole if none
+// was, gets a fatal failure, and the tests that never started are not run.
+// Returns false if input_path can't be read as a result stream or the output
+// format is not recognized.
+GTEST_API_ bool ConvertBinaryTestResults(const std::string& input_path,
+                                         const std::string& output);
+
 // A UnitTest consists of a vector of TestSuites.
 //
 // This is a singleton class.  The only instance of UnitTest is
 // created when UnitTest::GetInstance() is first called.  This
-// instance is never deleted.
+// instance is never deleted.  ConvertBinaryTestResults() creates a
+// short-lived instance of its own to hold the results it reads.
 //
 // UnitTest is not copyable.
 //
@@ -1241,6 +1412,13 @@ class GTEST_API_ UnitTest {
   // This method can only be called from the main thread.
   Environment* AddEnvironment(Environment* env);
 
+  // Like AddEnvironment(), but declares that the environment doesn't depend
+  // on the environments registered next to it, so that its SetUp() and
+  // TearDown() may run on a thread of their own, concurrently with theirs.
+  //
+  // This method can only be called from the main thread.
+  Environment* AddIndependentEnvironment(Environment* env);
+
   // Adds a TestPartResult to the current TestResult object.  All
   // Google Test assertion macros (e.g. ASSERT_TRUE, EXPECT_EQ, etc)
   // eventually call this to report their results.  The user code
@@ -1274,8 +1452,11 @@ class GTEST_API_ UnitTest {
   friend class internal::StreamingListenerTest;
   friend class internal::UnitTestRecordPropertyTestHelper;
   friend Environment* AddGlobalTestEnvironment(Environment* env);
+  friend Environment* AddIndependentGlobalTestEnvironment(Environment* env);
   friend std::set<std::string>* internal::GetIgnoredParameterizedTestSuites();
   friend internal::UnitTestImpl* internal::GetUnitTestImpl();
+  friend bool ConvertBinaryTestResults(const std::string& input_path,
+                                       const std::string& output);
   friend void internal::ReportFailureInUnknownLocation(
       TestPartResult::Type result_type, const std::string& message);
 
@@ -1330,6 +1511,25 @@ inline Environment* AddGlobalTestEnvironment(Environment* env) {
   return UnitTest::GetInstance()->AddEnvironment(env);
 }
 
+// Like AddGlobalTestEnvironment(), but for an environment that neither
+// depends on nor is depended on by the environments registered right before
+// and after it.  The SetUp() and TearDown() of consecutively registered
+// independent environments run concurrently, each on a thread of its own, so
+// that setting them all up takes as long as the slowest one.  Their failures
+// are reported in the order the environments were registered, once all of
+// them are done.  For example:
+//
+//   testing::AddIndependentGlobalTestEnvironment(new DatabaseEnvironment);
+//   testing::AddIndependentGlobalTestEnvironment(new NetworkEnvironment);
+//   testing::AddGlobalTestEnvironment(new UsesBothEnvironment);
+//
+// sets up the database and the network concurrently, and the third
+// environment once both are set up.  Where Google Test isn't thread-safe,
+// this is the same as AddGlobalTestEnvironment().
+inline Environment* AddIndependentGlobalTestEnvironment(Environment* env) {
+  return UnitTest::GetInstance()->AddIndependentEnvironment(env);
+}
+
 // Initializes Google Test.  This must be called before calling
 // RUN_ALL_TESTS().  In particular, it parses a command line for the
 // flags that Google Test recognizes.  Whenever a Google Test flag is
@@ -1594,6 +1794,221 @@ GTEST_API_ AssertionResult DoubleNearPredFormat(const char* expr1,
                                                 double val1, double val2,
                                                 double abs_error);
 
+// Helpers for the {ASSERT|EXPECT}_RANGE_* assertions, which compare two
+// contiguous ranges (C arrays, or containers with data() and size()) element
+// by element and report all mismatches as a single failure.
+//
+// INTERNAL IMPLEMENTATION - DO NOT USE IN A USER PROGRAM.
+
+// The number of mismatching positions listed in a range failure message.
+constexpr size_t kMaxRangeMismatchesToPrint = 10;
+
+template <typename T, size_t N>
+const T* RangeData(const T (&array)[N]) {
+  return array;
+}
+template <typename T, size_t N>
+size_t RangeSize(const T (&)[N]) {
+  return N;
+}
+template <typename Container>
+auto RangeData(const Container& container) -> decltype(container.data()) {
+  return container.data();
+}
+template <typename Container>
+auto RangeSize(const Container& container)
+    -> decltype(static_cast<size_t>(container.size())) {
+  return static_cast<size_t>(container.size());
+}
+
+// Returns the positions in [0, size) at which 'matches' does not hold for
+// the corresponding elements, keeping at most kMaxRangeMismatchesToPrint of
+// them in 'first', and returns the total number of such positions.  The work
+// is done in blocks with a branch-free inner loop, which compilers can
+// vectorise for arithmetic element types; a block is only rescanned if it
+// contains a mismatch.
+template <typename T1, typename T2, typename Pred>
+size_t FindRangeMismatches(const T1* lhs, const T2* rhs, size_t size,
+                           const Pred& matches, std::vector<size_t>* first) {
+  const size_t kBlockSize = 256;
+  size_t mismatches = 0;
+  for (size_t begin = 0; begin < size; begin += kBlockSize) {
+    const size_t end = size - begin < kBlockSize ? size : begin + kBlockSize;
+    size_t block_mismatches = 0;
+    for (size_t i = begin; i < end; ++i) {
+      block_mismatches += matches(lhs[i], rhs[i]) ? 0 : 1;
+    }
+    if (block_mismatches == 0) continue;
+
+    mismatches += block_mismatches;
+    for (size_t i = begin;
+         i < end && first->size() < kMaxRangeMismatchesToPrint; ++i) {
+      if (!matches(lhs[i], rhs[i])) first->push_back(i);
+    }
+  }
+  return mismatches;
+}
+
+// Builds the failure for two ranges of different sizes.
+GTEST_API_ AssertionResult RangeSizeFailure(const char* lhs_expression,
+                                            const char* rhs_expression,
+                                            size_t lhs_size, size_t rhs_size);
+
+// Builds the failure for two ranges with 'mismatches' differing elements.
+// 'summary' describes the comparison and 'details' lists the first few
+// mismatching elements, one per line.
+GTEST_API_ AssertionResult RangeMismatchFailure(
+    const char* summary, const char* lhs_expression, const char* rhs_expression,
+    size_t size, size_t mismatches, const std::string& details);
+
+template <typename T1, typename T2>
+std::string FormatRangeMismatches(const T1* lhs, const T2* rhs,
+                                  const std::vector<size_t>& positions) {
+  Message details;
+  for (size_t i : positions) {
+    details << "\n  [" << i << "]: " << PrintToString(lhs[i]) << " vs "
+            << PrintToString(rhs[i]);
+  }
+  return details.GetString();
+}
+
+// Element types for which operator== is the same as comparing object
+// representations, so that two ranges can be compared with memcmp().
+template <typename T1, typename T2>
+struct IsBitwiseComparable
+    : std::integral_constant<bool, std::is_same<T1, T2>::value &&
+                                       (std::is_integral<T1>::value ||
+                                        std::is_enum<T1>::value ||
+                                        std::is_pointer<T1>::value)> {};
+
+// Returns true if the size bytes at lhs and rhs are the same.  Kept out of
+// line so that this header needn't include <cstring>.
+GTEST_API_ bool BytesAreEqual(const void* lhs, const void* rhs, size_t size);
+
+template <typename T1, typename T2>
+bool RangesAreBitwiseEqual(const T1* lhs, const T2* rhs, size_t size,
+                           std::true_type /* bitwise comparable */) {
+  return BytesAreEqual(lhs, rhs, size * sizeof(T1));
+}
+
+template <typename T1, typename T2>
+bool RangesAreBitwiseEqual(const T1*, const T2*, size_t,
+                           std::false_type /* bitwise comparable */) {
+  return false;
+}
+
+struct RangeElementsEqual {
+  template <typename T1, typename T2>
+  bool operator()(const T1& lhs, const T2& rhs) const {
+    return lhs == rhs;
+  }
+};
+
+// The helper function for {ASSERT|EXPECT}_RANGE_EQ.
+template <typename R1, typename R2>
+AssertionResult CmpHelperRangeEQ(const char* lhs_expression,
+                                 const char* rhs_expression, const R1& lhs,
+                                 const R2& rhs) {
+  const size_t size = RangeSize(lhs);
+  if (size != RangeSize(rhs)) {
+    return RangeSizeFailure(lhs_expression, rhs_expression, size,
+                            RangeSize(rhs));
+  }
+
+  const auto* lhs_data = RangeData(lhs);
+  const auto* rhs_data = RangeData(rhs);
+  using T1 = typename std::remove_cv<
+      typename std::remove_pointer<decltype(lhs_data)>::type>::type;
+  using T2 = typename std::remove_cv<
+      typename std::remove_pointer<decltype(rhs_data)>::type>::type;
+  if (RangesAreBitwiseEqual(lhs_data, rhs_data, size,
+                            IsBitwiseComparable<T1, T2>())) {
+    return AssertionSuccess();
+  }
+
+  std::vector<size_t> first;
+  const size_t mismatches = FindRangeMismatches(
+      lhs_data, rhs_data, size, RangeElementsEqual(), &first);
+  if (mismatches == 0) return AssertionSuccess();
+  return RangeMismatchFailure("Expected equality of these ranges:",
+                              lhs_expression, rhs_expression, size, mismatches,
+                              FormatRangeMismatches(lhs_data, rhs_data, first));
+}
+
+template <typename RawType>
+struct RangeElementsAlmostEqual {
+  bool operator()(RawType lhs, RawType rhs) const {
+    return FloatingPoint<RawType>(lhs).AlmostEquals(FloatingPoint<RawType>(rhs));
+  }
+};
+
+// The helper function for {ASSERT|EXPECT}_RANGE_{FLOAT|DOUBLE}_EQ.
+template <typename RawType, typename R1, typename R2>
+AssertionResult CmpHelperRangeFloatingPointEQ(const char* lhs_expression,
+                                              const char* rhs_expression,
+                                              const R1& lhs, const R2& rhs) {
+  const size_t size = RangeSize(lhs);
+  if (size != RangeSize(rhs)) {
+    return RangeSizeFailure(lhs_expression, rhs_expression, size,
+                            RangeSize(rhs));
+  }
+
+  const RawType* lhs_data = RangeData(lhs);
+  const RawType* rhs_data = RangeData(rhs);
+  std::vector<size_t> first;
+  const size_t mismatches =
+      FindRangeMismatches(lhs_data, rhs_data, size,
+                          RangeElementsAlmostEqual<RawType>(), &first);
+  if (mismatches == 0) return AssertionSuccess();
+  return RangeMismatchFailure(
+      "Expected almost equality (within 4 ULPs) of these ranges:",
+      lhs_expression, rhs_expression, size, mismatches,
+      FormatRangeMismatches(lhs_data, rhs_data, first));
+}
+
+struct RangeElementsNear {
+  explicit RangeElementsNear(double abs_error) : abs_error_(abs_error) {}
+
+  template <typename T1, typename T2>
+  bool operator()(T1 lhs, T2 rhs) const {
+    // Spelled out rather than using std::fabs() to keep <cmath> out of this
+    // header.  As with std::fabs(), a NaN difference is never near.
+    const double diff = static_cast<double>(lhs) - static_cast<double>(rhs);
+    return (diff < 0 ? -diff : diff) <= abs_error_;
+  }
+
+  double abs_error_;
+};
+
+// The helper function for {ASSERT|EXPECT}_RANGE_NEAR.
+template <typename R1, typename R2>
+AssertionResult CmpHelperRangeNear(const char* lhs_expression,
+                                   const char* rhs_expression,
+                                   const char* abs_error_expression,
+                                   const R1& lhs, const R2& rhs,
+                                   double abs_error) {
+  const size_t size = RangeSize(lhs);
+  if (size != RangeSize(rhs)) {
+    return RangeSizeFailure(lhs_expression, rhs_expression, size,
+                            RangeSize(rhs));
+  }
+
+  const auto* lhs_data = RangeData(lhs);
+  const auto* rhs_data = RangeData(rhs);
+  std::vector<size_t> first;
+  const size_t mismatches = FindRangeMismatches(
+      lhs_data, rhs_data, size, RangeElementsNear(abs_error), &first);
+  if (mismatches == 0) return AssertionSuccess();
+  const std::string summary =
+      (Message() << "Expected the elements of these ranges to differ by at "
+                    "most "
+                 << abs_error_expression << " (" << abs_error << "):")
+          .GetString();
+  return RangeMismatchFailure(summary.c_str(), lhs_expression, rhs_expression,
+                              size, mismatches,
+                              FormatRangeMismatches(lhs_data, rhs_data, first));
+}
+
 // INTERNAL IMPLEMENTATION - DO NOT USE IN USER CODE.
 // A class that enables one to stream messages to assertion macros
 class GTEST_API_ AssertHelper {
@@ -1990,6 +2405,56 @@ class TestWithParam : public Test, public WithParamInterface<T> {};
   ASSERT_PRED_FORMAT3(::testing::internal::DoubleNearPredFormat, val1, val2, \
                       abs_error)
 
+// Macros for comparing contiguous ranges element by element.
+//
+//    * {ASSERT|EXPECT}_RANGE_EQ(range1, range2):
+//         Tests that range1 and range2 have the same size and equal elements.
+//    * {ASSERT|EXPECT}_RANGE_FLOAT_EQ(range1, range2):
+//    * {ASSERT|EXPECT}_RANGE_DOUBLE_EQ(range1, range2):
+//         Like *_FLOAT_EQ and *_DOUBLE_EQ, applied to each pair of elements.
+//    * {ASSERT|EXPECT}_RANGE_NEAR(range1, range2, abs_error):
+//         Like *_NEAR, applied to each pair of elements.
+//
+// A range is a C array or a container with contiguous storage that has
+// data() and size() members, such as std::vector, std::array or
+// std::string.  A failing assertion reports the number of mismatching
+// elements and the first few of them, instead of one failure per element.
+// Ranges of integers, enums or pointers are compared with memcmp().
+
+#define EXPECT_RANGE_EQ(range1, range2) \
+  EXPECT_PRED_FORMAT2(::testing::internal::CmpHelperRangeEQ, range1, range2)
+
+#define ASSERT_RANGE_EQ(range1, range2) \
+  ASSERT_PRED_FORMAT2(::testing::internal::CmpHelperRangeEQ, range1, range2)
+
+#define EXPECT_RANGE_FLOAT_EQ(range1, range2)                              \
+  EXPECT_PRED_FORMAT2(                                                     \
+      ::testing::internal::CmpHelperRangeFloatingPointEQ<float>, range1, \
+      range2)
+
+#define EXPECT_RANGE_DOUBLE_EQ(range1, range2)                              \
+  EXPECT_PRED_FORMAT2(                                                      \
+      ::testing::internal::CmpHelperRangeFloatingPointEQ<double>, range1, \
+      range2)
+
+#define ASSERT_RANGE_FLOAT_EQ(range1, range2)                              \
+  ASSERT_PRED_FORMAT2(                                                     \
+      ::testing::internal::CmpHelperRangeFloatingPointEQ<float>, range1, \
+      range2)
+
+#define ASSERT_RANGE_DOUBLE_EQ(range1, range2)                              \
+  ASSERT_PRED_FORMAT2(                                                      \
+      ::testing::internal::CmpHelperRangeFloatingPointEQ<double>, range1, \
+      range2)
+
+#define EXPECT_RANGE_NEAR(range1, range2, abs_error)                   \
+  EXPECT_PRED_FORMAT3(::testing::internal::CmpHelperRangeNear, range1, \
+                      range2, abs_error)
+
+#define ASSERT_RANGE_NEAR(range1, range2, abs_error)                   \
+  ASSERT_PRED_FORMAT3(::testing::internal::CmpHelperRangeNear, range1, \
+                      range2, abs_error)
+
 // These predicate format functions work on floating-point values, and
 // can be used in {ASSERT|EXPECT}_PRED_FORMAT2*(), e.g.
 //
@@ -2042,6 +2507,36 @@ GTEST_API_ AssertionResult DoubleLE(const char* expr1, const char* expr2,
 #define EXPECT_NO_FATAL_FAILURE(statement) \
   GTEST_TEST_NO_FATAL_FAILURE_(statement, GTEST_NONFATAL_FAILURE_)
 
+namespace internal {
+
+// A trace message that is only formatted if a failure is reported while the
+// trace is active.  'values' points to a std::tuple owned by the enclosing
+// scope and 'format' streams its elements into a Message.
+struct LazyTraceMessage {
+  void (*format)(const void* values, Message* message);
+  const void* values;
+};
+
+template <typename Tuple, size_t... I>
+void StreamTraceValues(const Tuple& values, Message* message,
+                       IndexSequence<I...>) {
+  int dummy[] = {0, ((*message << std::get<I>(values)), 0)...};
+  static_cast<void>(dummy);
+}
+
+template <typename... T>
+void FormatLazyTraceValues(const void* values, Message* message) {
+  StreamTraceValues(*static_cast<const std::tuple<T...>*>(values), message,
+                    IndexSequenceFor<T...>());
+}
+
+template <typename... T>
+LazyTraceMessage MakeLazyTraceMessage(const std::tuple<T...>& values) {
+  return {&FormatLazyTraceValues<T...>, &values};
+}
+
+}  // namespace internal
+
 // Causes a trace (including the given source file path and line number,
 // and the given message) to be included in every test failure message generated
 // by code in the scope of the lifetime of an instance of this class. The effect
@@ -2073,6 +2568,13 @@ class GTEST_API_ ScopedTrace {
     PushTrace(file, line, message);
   }
 
+  // Defers formatting until a failure is reported; see SCOPED_TRACE_LAZY.
+  // The values referenced by 'message' must outlive this object.
+  ScopedTrace(const char* file, int line,
+              const internal::LazyTraceMessage& message) {
+    PushTrace(file, line, message);
+  }
+
   // The d'tor pops the info pushed by the c'tor.
   //
   // Note that the d'tor is not virtual in order to be efficient.
@@ -2081,6 +2583,8 @@ class GTEST_API_ ScopedTrace {
 
  private:
   void PushTrace(const char* file, int line, std::string message);
+  void PushTrace(const char* file, int line,
+                 const internal::LazyTraceMessage& message);
 
   ScopedTrace(const ScopedTrace&) = delete;
   ScopedTrace& operator=(const ScopedTrace&) = delete;
@@ -2105,6 +2609,26 @@ class GTEST_API_ ScopedTrace {
   const ::testing::ScopedTrace GTEST_CONCAT_TOKEN_(gtest_trace_, __LINE__)( \
       __FILE__, __LINE__, (message))
 
+// Like SCOPED_TRACE(), but takes the message as a list of values that are
+// copied and only streamed to std::ostream, one after another, if a failure
+// is actually reported in the current scope.  This keeps traces cheap in hot
+// loops of passing tests:
+//
+//   for (int i = 0; i < n; ++i) {
+//     SCOPED_TRACE_LAZY("i = ", i, ", input = ", std::cref(inputs[i]));
+//     ...
+//   }
+//
+// Use std::cref() to avoid copying large values; the referenced object must
+// then stay alive and unchanged for the rest of the scope.
+#define SCOPED_TRACE_LAZY(...)                                              \
+  const auto GTEST_CONCAT_TOKEN_(gtest_trace_values_, __LINE__) =           \
+      ::std::make_tuple(__VA_ARGS__);                                       \
+  const ::testing::ScopedTrace GTEST_CONCAT_TOKEN_(gtest_trace_, __LINE__)( \
+      __FILE__, __LINE__,                                                   \
+      ::testing::internal::MakeLazyTraceMessage(                            \
+          GTEST_CONCAT_TOKEN_(gtest_trace_values_, __LINE__)))
+
 // Compile-time assertion for type equality.
 // StaticAssertTypeEq<type1, type2>() compiles if and only if type1 and type2
 // are the same type.  The value it returns is not interesting.
@@ -2208,6 +2732,43 @@ constexpr bool StaticAssertTypeEq() noexcept {
 #define TEST_F(test_fixture, test_name) GTEST_TEST_F(test_fixture, test_name)
 #endif
 
+// Defines a micro-benchmark, optionally using a test fixture.  They are
+// named, registered and filtered like TEST() and TEST_F(), but only run
+// when --gtest_run_benchmarks is given.  Example:
+//
+//   BENCHMARK_TEST_F(StringTest, Concatenates) {
+//     testing::DoNotOptimize(prefix_ + suffix_);
+//   }
+//
+// The fixture is set up once, and the body then runs in a loop: first to
+// warm up and to find how many iterations take long enough to time, then
+// for a series of timed samples.  The median, median absolute deviation and
+// percentiles of the time per iteration are printed and reported through
+// TestResult::benchmark_result() and the XML and JSON reports.  A fatal
+// failure or GTEST_SKIP() in the body stops the benchmark.
+#define GTEST_BENCHMARK_TEST(test_suite_name, test_name)             \
+  GTEST_BENCHMARK_TEST_(test_suite_name, test_name, ::testing::Test, \
+                        ::testing::internal::GetTestTypeId())
+#define BENCHMARK_TEST(test_suite_name, test_name) \
+  GTEST_BENCHMARK_TEST(test_suite_name, test_name)
+
+#define GTEST_BENCHMARK_TEST_F(test_fixture, test_name)        \
+  GTEST_BENCHMARK_TEST_(test_fixture, test_name, test_fixture, \
+                        ::testing::internal::GetTypeId<test_fixture>())
+#define BENCHMARK_TEST_F(test_fixture, test_name) \
+  GTEST_BENCHMARK_TEST_F(test_fixture, test_name)
+
+// Keeps the compiler from optimizing away the computation of value in a
+// benchmark whose result is otherwise unused.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  internal::UseCharPointer(&reinterpret_cast<const volatile char&>(value));
+#endif  // defined(__GNUC__)
+}
+
 // Returns a path to a temporary directory, which should be writable. It is
 // implementation-dependent whether or not the path is terminated by the
 // directory-separator character.
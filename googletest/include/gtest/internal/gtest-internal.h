@@ -104,6 +104,7 @@ namespace testing {
 
 class AssertionResult;  // Result of an assertion.
 class Message;          // Represents a failure message.
+class PooledFixture;    // A test fixture that tests may reuse.
 class Test;             // Represents a test.
 class TestInfo;         // Information about a test.
 class TestPartResult;   // Result of a test part.
@@ -170,6 +171,8 @@ namespace edit_distance {
 // add/remove.
 // Simple implementation of the Wagner-Fischer algorithm.
 // See https://en.wikipedia.org/wiki/Wagner-Fischer_algorithm
+// Takes O(left * right) time and memory; see CalculateMyersEdits() below
+// for large inputs.
 enum EditType { kMatch, kAdd, kRemove, kReplace };
 GTEST_API_ std::vector<EditType> CalculateOptimalEdits(
     const std::vector<size_t>& left, const std::vector<size_t>& right);
@@ -179,7 +182,22 @@ GTEST_API_ std::vector<EditType> CalculateOptimalEdits(
     const std::vector<std::string>& left,
     const std::vector<std::string>& right);
 
+// Returns a shortest edit script from 'left' to 'right' made of adds and
+// removes only.  Myers' O(ND) algorithm with linear-space refinement, so
+// unlike CalculateOptimalEdits() it is usable on very large inputs.  Once a
+// sub-problem costs more than 'max_cost' edits a heuristic split is taken and
+// the result may not be minimal; 0 picks a bound from the input size.
+GTEST_API_ std::vector<EditType> CalculateMyersEdits(
+    const std::vector<size_t>& left, const std::vector<size_t>& right,
+    size_t max_cost = 0);
+
+// Same as above, but the input is represented as strings.
+GTEST_API_ std::vector<EditType> CalculateMyersEdits(
+    const std::vector<std::string>& left,
+    const std::vector<std::string>& right, size_t max_cost = 0);
+
 // Create a diff of the input strings in Unified diff format.
+// Inputs too large for CalculateOptimalEdits() use CalculateMyersEdits().
 GTEST_API_ std::string CreateUnifiedDiff(const std::vector<std::string>& left,
                                          const std::vector<std::string>& right,
                                          size_t context = 2);
@@ -440,6 +458,16 @@ class TestFactoryBase {
   // within TestInfoImpl::Run()
   virtual Test* CreateTest() = 0;
 
+  // Returns an ID shared by the factories whose tests may reuse one
+  // another's test objects (see PooledFixture), or nullptr if each test gets
+  // a new one.
+  virtual TypeId GetFixturePoolId() const { return nullptr; }
+
+  // Prepares a test object, created by a factory with the same fixture pool
+  // ID, to run this factory's test, and returns it as the PooledFixture whose
+  // Reset() must be called next.
+  virtual PooledFixture* PrepareForReuse(Test* /* test */) { return nullptr; }
+
  protected:
   TestFactoryBase() {}
 
@@ -448,10 +476,34 @@ class TestFactoryBase {
   TestFactoryBase& operator=(const TestFactoryBase&) = delete;
 };
 
+// Implements the fixture pooling part of TestFactoryBase for the factories
+// that create TestClass objects.
+template <class TestClass>
+class TestClassFactoryBase : public TestFactoryBase {
+ public:
+  TypeId GetFixturePoolId() const override {
+    return IsPooled::value ? GetTypeId<TestClass>() : nullptr;
+  }
+
+  PooledFixture* PrepareForReuse(Test* test) override {
+    return ToPooledFixture(test, IsPooled());
+  }
+
+ private:
+  using IsPooled = std::is_base_of<PooledFixture, TestClass>;
+
+  static PooledFixture* ToPooledFixture(Test* test, std::true_type) {
+    return static_cast<TestClass*>(test);
+  }
+  static PooledFixture* ToPooledFixture(Test*, std::false_type) {
+    return nullptr;
+  }
+};
+
 // This class provides implementation of TestFactoryBase interface.
 // It is used in TEST and TEST_F macros.
 template <class TestClass>
-class TestFactoryImpl : public TestFactoryBase {
+class TestFactoryImpl : public TestClassFactoryBase<TestClass> {
  public:
   Test* CreateTest() override { return new TestClass; }
 };
@@ -492,6 +544,14 @@ inline SetUpTearDownSuiteFuncType GetNotDefaultOrNull(
   return a == def ? nullptr : a;
 }
 
+// Returns whichever of the legacy and the current function is defined, and
+// fails with the given message, followed by the location, if both are.  It
+// isn't a template, so that the check isn't compiled again for every test.
+GTEST_API_ SetUpTearDownSuiteFuncType ResolveSuiteApiFunc(
+    SetUpTearDownSuiteFuncType test_case_fp,
+    SetUpTearDownSuiteFuncType test_suite_fp, const char* message,
+    const char* filename, int line_num);
+
 template <typename T>
 //  Note that SuiteApiResolver inherits from T because
 //  SetUpTestSuite()/TearDownTestSuite() could be protected. This way
@@ -505,17 +565,12 @@ struct SuiteApiResolver : T {
   static SetUpTearDownSuiteFuncType GetSetUpCaseOrSuite(const char* filename,
                                                         int line_num) {
 #ifndef GTEST_REMOVE_LEGACY_TEST_CASEAPI_
-    SetUpTearDownSuiteFuncType test_case_fp =
-        GetNotDefaultOrNull(&T::SetUpTestCase, &Test::SetUpTestCase);
-    SetUpTearDownSuiteFuncType test_suite_fp =
-        GetNotDefaultOrNull(&T::SetUpTestSuite, &Test::SetUpTestSuite);
-
-    GTEST_CHECK_(!test_case_fp || !test_suite_fp)
-        << "Test can not provide both SetUpTestSuite and SetUpTestCase, please "
-           "make sure there is only one present at "
-        << filename << ":" << line_num;
-
-    return test_case_fp != nullptr ? test_case_fp : test_suite_fp;
+    return ResolveSuiteApiFunc(
+        GetNotDefaultOrNull(&T::SetUpTestCase, &Test::SetUpTestCase),
+        GetNotDefaultOrNull(&T::SetUpTestSuite, &Test::SetUpTestSuite),
+        "Test can not provide both SetUpTestSuite and SetUpTestCase, please "
+        "make sure there is only one present at ",
+        filename, line_num);
 #else
     (void)(filename);
     (void)(line_num);
@@ -526,17 +581,12 @@ struct SuiteApiResolver : T {
   static SetUpTearDownSuiteFuncType GetTearDownCaseOrSuite(const char* filename,
                                                            int line_num) {
 #ifndef GTEST_REMOVE_LEGACY_TEST_CASEAPI_
-    SetUpTearDownSuiteFuncType test_case_fp =
-        GetNotDefaultOrNull(&T::TearDownTestCase, &Test::TearDownTestCase);
-    SetUpTearDownSuiteFuncType test_suite_fp =
-        GetNotDefaultOrNull(&T::TearDownTestSuite, &Test::TearDownTestSuite);
-
-    GTEST_CHECK_(!test_case_fp || !test_suite_fp)
-        << "Test can not provide both TearDownTestSuite and TearDownTestCase,"
-           " please make sure there is only one present at"
-        << filename << ":" << line_num;
-
-    return test_case_fp != nullptr ? test_case_fp : test_suite_fp;
+    return ResolveSuiteApiFunc(
+        GetNotDefaultOrNull(&T::TearDownTestCase, &Test::TearDownTestCase),
+        GetNotDefaultOrNull(&T::TearDownTestSuite, &Test::TearDownTestSuite),
+        "Test can not provide both TearDownTestSuite and TearDownTestCase,"
+        " please make sure there is only one present at",
+        filename, line_num);
 #else
     (void)(filename);
     (void)(line_num);
@@ -569,6 +619,30 @@ GTEST_API_ TestInfo* MakeAndRegisterTestInfo(
     TypeId fixture_class_id, SetUpTestSuiteFunc set_up_tc,
     TearDownTestSuiteFunc tear_down_tc, TestFactoryBase* factory);
 
+// Creates and registers the TestInfo of a typed or type-parameterized test
+// for one of its types, named after the first of the comma-separated
+// test_names.  Everything that doesn't depend on the type is done here,
+// rather than in the template code instantiated for each type.
+GTEST_API_ TestInfo* RegisterTypedTestInfo(
+    const char* prefix, const char* case_name, const std::string& type_name,
+    const char* test_names, const std::string& type_param,
+    CodeLocation code_location, TypeId fixture_class_id,
+    SetUpTestSuiteFunc set_up_tc, TearDownTestSuiteFunc tear_down_tc,
+    TestFactoryBase* factory);
+
+// Marks the test as a benchmark, which only runs with --gtest_run_benchmarks,
+// and returns it.
+GTEST_API_ TestInfo* MarkAsBenchmark(TestInfo* test_info);
+
+// Runs the body of a benchmark, with run_iterations(test, n) running it n
+// times, and records its statistics in the current test's result.
+GTEST_API_ void RunBenchmark(void (*run_iterations)(void* test,
+                                                    int64_t iterations),
+                             void* test);
+
+// Does nothing, but can't be optimized away, for DoNotOptimize().
+GTEST_API_ void UseCharPointer(const volatile char* p);
+
 // If *pstr starts with the given prefix, modifies *pstr to be right
 // past the prefix and returns true; otherwise leaves *pstr unchanged
 // and returns false.  None of pstr, *pstr, and prefix can be NULL.
@@ -655,6 +729,40 @@ inline std::string GetPrefixUntilComma(const char* str) {
 void SplitString(const ::std::string& str, char delimiter,
                  ::std::vector<::std::string>* dest);
 
+// Backport of std::index_sequence.
+template <size_t... Is>
+struct IndexSequence {
+  using type = IndexSequence;
+};
+
+// Double the IndexSequence, and one if plus_one is true.
+template <bool plus_one, typename T, size_t sizeofT>
+struct DoubleSequence;
+template <size_t... I, size_t sizeofT>
+struct DoubleSequence<true, IndexSequence<I...>, sizeofT> {
+  using type = IndexSequence<I..., (sizeofT + I)..., 2 * sizeofT>;
+};
+template <size_t... I, size_t sizeofT>
+struct DoubleSequence<false, IndexSequence<I...>, sizeofT> {
+  using type = IndexSequence<I..., (sizeofT + I)...>;
+};
+
+// Backport of std::make_index_sequence.
+// It uses O(ln(N)) instantiation depth.
+template <size_t N>
+struct MakeIndexSequenceImpl
+    : DoubleSequence<N % 2 == 1, typename MakeIndexSequenceImpl<N / 2>::type,
+                     N / 2>::type {};
+
+template <>
+struct MakeIndexSequenceImpl<0> : IndexSequence<> {};
+
+template <size_t N>
+using MakeIndexSequence = typename MakeIndexSequenceImpl<N>::type;
+
+template <typename... T>
+using IndexSequenceFor = typename MakeIndexSequence<sizeof...(T)>::type;
+
 // The default argument to the template below for the case when the user does
 // not provide a name generator.
 struct DefaultNameGenerator {
@@ -669,21 +777,22 @@ struct NameGeneratorSelector {
   typedef Provided type;
 };
 
-template <typename NameGenerator>
-void GenerateNamesRecursively(internal::None, std::vector<std::string>*, int) {}
+template <typename NameGenerator, typename... Ts, size_t... Is>
+std::vector<std::string> GenerateNamesForTypes(internal::Types<Ts...>,
+                                               IndexSequence<Is...>) {
+  return {NameGenerator::template GetName<Ts>(static_cast<int>(Is))...};
+}
 
-template <typename NameGenerator, typename Types>
-void GenerateNamesRecursively(Types, std::vector<std::string>* result, int i) {
-  result->push_back(NameGenerator::template GetName<typename Types::Head>(i));
-  GenerateNamesRecursively<NameGenerator>(typename Types::Tail(), result,
-                                          i + 1);
+template <typename NameGenerator, typename... Ts>
+std::vector<std::string> GenerateNamesForTypes(internal::Types<Ts...> types) {
+  return GenerateNamesForTypes<NameGenerator>(types, IndexSequenceFor<Ts...>());
 }
 
+// Returns the names that NameGenerator gives the types in the type list
+// Types, in order.
 template <typename NameGenerator, typename Types>
 std::vector<std::string> GenerateNames() {
-  std::vector<std::string> result;
-  GenerateNamesRecursively<NameGenerator>(Types(), &result, 0);
-  return result;
+  return GenerateNamesForTypes<NameGenerator>(Types());
 }
 
 // TypeParameterizedTest<Fixture, TestSel, Types>::Register()
@@ -691,6 +800,10 @@ std::vector<std::string> GenerateNames() {
 // return value is insignificant - we just need to return something
 // such that we can call this function in a namespace scope.
 //
+// The types are registered by expanding the type list as a parameter pack,
+// rather than by recursing on its tail, so that a list of N types costs N
+// instantiations of RegisterType() and not N nested class templates.
+//
 // Implementation note: The GTEST_TEMPLATE_ macro declares a template
 // template parameter.  It's defined in gtest-type-util.h.
 template <GTEST_TEMPLATE_ Fixture, class TestSel, typename Types>
@@ -704,46 +817,45 @@ class TypeParameterizedTest {
                        const char* case_name, const char* test_names, int index,
                        const std::vector<std::string>& type_names =
                            GenerateNames<DefaultNameGenerator, Types>()) {
-    typedef typename Types::Head Type;
+    return RegisterTypes(prefix, code_location, case_name, test_names, index,
+                         type_names, Types());
+  }
+
+ private:
+  template <typename... Ts>
+  static bool RegisterTypes(const char* prefix,
+                            const CodeLocation& code_location,
+                            const char* case_name, const char* test_names,
+                            int index,
+                            const std::vector<std::string>& type_names,
+                            internal::Types<Ts...> /* types */) {
+    // The elements of a braced-init-list are evaluated in order, so the
+    // tests are registered in the order of the type list.
+    const bool registered[] = {
+        true, RegisterType<Ts>(prefix, code_location, case_name, test_names,
+                               index++, type_names)...};
+    static_cast<void>(registered);
+    return true;
+  }
+
+  // Registers the test for one type of the type list.
+  template <typename Type>
+  static bool RegisterType(const char* prefix,
+                           const CodeLocation& code_location,
+                           const char* case_name, const char* test_names,
+                           int index,
+                           const std::vector<std::string>& type_names) {
     typedef Fixture<Type> FixtureClass;
     typedef typename GTEST_BIND_(TestSel, Type) TestClass;
 
-    // First, registers the first type-parameterized test in the type
-    // list.
-    MakeAndRegisterTestInfo(
-        (std::string(prefix) + (prefix[0] == '\0' ? "" : "/") + case_name +
-         "/" + type_names[static_cast<size_t>(index)])
-            .c_str(),
-        StripTrailingSpaces(GetPrefixUntilComma(test_names)).c_str(),
-        GetTypeName<Type>().c_str(),
-        nullptr,  // No value parameter.
-        code_location, GetTypeId<FixtureClass>(),
+    RegisterTypedTestInfo(
+        prefix, case_name, type_names[static_cast<size_t>(index)], test_names,
+        GetTypeName<Type>(), code_location, GetTypeId<FixtureClass>(),
         SuiteApiResolver<TestClass>::GetSetUpCaseOrSuite(
             code_location.file.c_str(), code_location.line),
         SuiteApiResolver<TestClass>::GetTearDownCaseOrSuite(
             code_location.file.c_str(), code_location.line),
         new TestFactoryImpl<TestClass>);
-
-    // Next, recurses (at compile time) with the tail of the type list.
-    return TypeParameterizedTest<Fixture, TestSel,
-                                 typename Types::Tail>::Register(prefix,
-                                                                 code_location,
-                                                                 case_name,
-                                                                 test_names,
-                                                                 index + 1,
-                                                                 type_names);
-  }
-};
-
-// The base case for the compile time recursion.
-template <GTEST_TEMPLATE_ Fixture, class TestSel>
-class TypeParameterizedTest<Fixture, TestSel, internal::None> {
- public:
-  static bool Register(const char* /*prefix*/, const CodeLocation&,
-                       const char* /*case_name*/, const char* /*test_names*/,
-                       int /*index*/,
-                       const std::vector<std::string>& =
-                           std::vector<std::string>() /*type_names*/) {
     return true;
   }
 };
@@ -766,8 +878,38 @@ class TypeParameterizedTestSuite {
                        const std::vector<std::string>& type_names =
                            GenerateNames<DefaultNameGenerator, Types>()) {
     RegisterTypeParameterizedTestSuiteInstantiation(case_name);
+    return RegisterTests(prefix, code_location, state, case_name, test_names,
+                         type_names, Tests());
+  }
+
+ private:
+  template <GTEST_TEMPLATE_... TestTmpls>
+  static bool RegisterTests(const char* prefix,
+                            const CodeLocation& code_location,
+                            const TypedTestSuitePState* state,
+                            const char* case_name, const char* test_names,
+                            const std::vector<std::string>& type_names,
+                            Templates<TestTmpls...> /* tests */) {
+    // test_names lists the tests in the order of Tests; each call consumes
+    // the first name.
+    const bool registered[] = {
+        true, RegisterTest<TemplateSel<TestTmpls>>(
+                  prefix, code_location, state, case_name, &test_names,
+                  type_names)...};
+    static_cast<void>(registered);
+    return true;
+  }
+
+  // Registers the test selected by TestSel, whose name starts *test_names,
+  // for each type in 'Types', and moves *test_names to the next name.
+  template <class TestSel>
+  static bool RegisterTest(const char* prefix,
+                           const CodeLocation& code_location,
+                           const TypedTestSuitePState* state,
+                           const char* case_name, const char** test_names,
+                           const std::vector<std::string>& type_names) {
     std::string test_name =
-        StripTrailingSpaces(GetPrefixUntilComma(test_names));
+        StripTrailingSpaces(GetPrefixUntilComma(*test_names));
     if (!state->TestExists(test_name)) {
       fprintf(stderr, "Failed to get code location for test %s.%s at %s.",
               case_name, test_name.c_str(),
@@ -778,30 +920,9 @@ class TypeParameterizedTestSuite {
     }
     const CodeLocation& test_location = state->GetCodeLocation(test_name);
 
-    typedef typename Tests::Head Head;
-
-    // First, register the first test in 'Test' for each type in 'Types'.
-    TypeParameterizedTest<Fixture, Head, Types>::Register(
-        prefix, test_location, case_name, test_names, 0, type_names);
-
-    // Next, recurses (at compile time) with the tail of the test list.
-    return TypeParameterizedTestSuite<Fixture, typename Tests::Tail,
-                                      Types>::Register(prefix, code_location,
-                                                       state, case_name,
-                                                       SkipComma(test_names),
-                                                       type_names);
-  }
-};
-
-// The base case for the compile time recursion.
-template <GTEST_TEMPLATE_ Fixture, typename Types>
-class TypeParameterizedTestSuite<Fixture, internal::None, Types> {
- public:
-  static bool Register(const char* /*prefix*/, const CodeLocation&,
-                       const TypedTestSuitePState* /*state*/,
-                       const char* /*case_name*/, const char* /*test_names*/,
-                       const std::vector<std::string>& =
-                           std::vector<std::string>() /*type_names*/) {
+    TypeParameterizedTest<Fixture, TestSel, Types>::Register(
+        prefix, test_location, case_name, *test_names, 0, type_names);
+    *test_names = SkipComma(*test_names);
     return true;
   }
 };
@@ -1142,40 +1263,6 @@ class NativeArray {
   void (NativeArray::*clone_)(const Element*, size_t);
 };
 
-// Backport of std::index_sequence.
-template <size_t... Is>
-struct IndexSequence {
-  using type = IndexSequence;
-};
-
-// Double the IndexSequence, and one if plus_one is true.
-template <bool plus_one, typename T, size_t sizeofT>
-struct DoubleSequence;
-template <size_t... I, size_t sizeofT>
-struct DoubleSequence<true, IndexSequence<I...>, sizeofT> {
-  using type = IndexSequence<I..., (sizeofT + I)..., 2 * sizeofT>;
-};
-template <size_t... I, size_t sizeofT>
-struct DoubleSequence<false, IndexSequence<I...>, sizeofT> {
-  using type = IndexSequence<I..., (sizeofT + I)...>;
-};
-
-// Backport of std::make_index_sequence.
-// It uses O(ln(N)) instantiation depth.
-template <size_t N>
-struct MakeIndexSequenceImpl
-    : DoubleSequence<N % 2 == 1, typename MakeIndexSequenceImpl<N / 2>::type,
-                     N / 2>::type {};
-
-template <>
-struct MakeIndexSequenceImpl<0> : IndexSequence<> {};
-
-template <size_t N>
-using MakeIndexSequence = typename MakeIndexSequenceImpl<N>::type;
-
-template <typename... T>
-using IndexSequenceFor = typename MakeIndexSequence<sizeof...(T)>::type;
-
 template <size_t>
 struct Ignore {
   Ignore(...);  // NOLINT
@@ -1556,4 +1643,57 @@ class NeverThrown {
               test_suite_name, test_name)>);                                   \
   void GTEST_TEST_CLASS_NAME_(test_suite_name, test_name)::TestBody()
 
+// Helper macro for defining benchmarks.  The body becomes BenchmarkBody(),
+// which TestBody() runs through RunBenchmark().
+#define GTEST_BENCHMARK_TEST_(test_suite_name, test_name, parent_class,        \
+                              parent_id)                                       \
+  static_assert(sizeof(GTEST_STRINGIFY_(test_suite_name)) > 1,                 \
+                "test_suite_name must not be empty");                          \
+  static_assert(sizeof(GTEST_STRINGIFY_(test_name)) > 1,                       \
+                "test_name must not be empty");                                \
+  class GTEST_TEST_CLASS_NAME_(test_suite_name, test_name)                     \
+      : public parent_class {                                                  \
+   public:                                                                     \
+    GTEST_TEST_CLASS_NAME_(test_suite_name, test_name)() = default;            \
+    ~GTEST_TEST_CLASS_NAME_(test_suite_name, test_name)() override = default;  \
+    GTEST_TEST_CLASS_NAME_(test_suite_name, test_name)                         \
+    (const GTEST_TEST_CLASS_NAME_(test_suite_name, test_name) &) = delete;     \
+    GTEST_TEST_CLASS_NAME_(test_suite_name, test_name) & operator=(            \
+        const GTEST_TEST_CLASS_NAME_(test_suite_name,                          \
+                                     test_name) &) = delete; /* NOLINT */      \
+    GTEST_TEST_CLASS_NAME_(test_suite_name, test_name)                         \
+    (GTEST_TEST_CLASS_NAME_(test_suite_name, test_name) &&) noexcept = delete; \
+    GTEST_TEST_CLASS_NAME_(test_suite_name, test_name) & operator=(            \
+        GTEST_TEST_CLASS_NAME_(test_suite_name,                                \
+                               test_name) &&) noexcept = delete; /* NOLINT */  \
+                                                                               \
+   private:                                                                    \
+    void TestBody() override {                                                 \
+      ::testing::internal::RunBenchmark(&RunIterations, this);                 \
+    }                                                                          \
+    static void RunIterations(void* test, int64_t iterations) {                \
+      for (; iterations > 0; --iterations) {                                   \
+        static_cast<GTEST_TEST_CLASS_NAME_(test_suite_name, test_name)*>(test) \
+            ->BenchmarkBody();                                                 \
+      }                                                                        \
+    }                                                                          \
+    void BenchmarkBody();                                                      \
+    static ::testing::TestInfo* const test_info_ GTEST_ATTRIBUTE_UNUSED_;      \
+  };                                                                           \
+                                                                               \
+  ::testing::TestInfo* const GTEST_TEST_CLASS_NAME_(test_suite_name,           \
+                                                    test_name)::test_info_ =   \
+      ::testing::internal::MarkAsBenchmark(                                    \
+          ::testing::internal::MakeAndRegisterTestInfo(                        \
+              #test_suite_name, #test_name, nullptr, nullptr,                  \
+              ::testing::internal::CodeLocation(__FILE__, __LINE__),           \
+              (parent_id),                                                     \
+              ::testing::internal::SuiteApiResolver<                           \
+                  parent_class>::GetSetUpCaseOrSuite(__FILE__, __LINE__),      \
+              ::testing::internal::SuiteApiResolver<                           \
+                  parent_class>::GetTearDownCaseOrSuite(__FILE__, __LINE__),   \
+              new ::testing::internal::TestFactoryImpl<GTEST_TEST_CLASS_NAME_( \
+                  test_suite_name, test_name)>));                              \
+  void GTEST_TEST_CLASS_NAME_(test_suite_name, test_name)::BenchmarkBody()
+
 #endif  // GOOGLETEST_INCLUDE_GTEST_INTERNAL_GTEST_INTERNAL_H_
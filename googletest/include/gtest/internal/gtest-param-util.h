@@ -396,7 +396,7 @@ void TestNotEmpty(const T&) {}
 // Stores a parameter value and later creates tests parameterized with that
 // value.
 template <class TestClass>
-class ParameterizedTestFactory : public TestFactoryBase {
+class ParameterizedTestFactory : public TestClassFactoryBase<TestClass> {
  public:
   typedef typename TestClass::ParamType ParamType;
   explicit ParameterizedTestFactory(ParamType parameter)
@@ -405,6 +405,10 @@ class ParameterizedTestFactory : public TestFactoryBase {
     TestClass::SetParam(&parameter_);
     return new TestClass();
   }
+  PooledFixture* PrepareForReuse(Test* test) override {
+    TestClass::SetParam(&parameter_);
+    return TestClassFactoryBase<TestClass>::PrepareForReuse(test);
+  }
 
  private:
   const ParamType parameter_;
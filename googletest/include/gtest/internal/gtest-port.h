@@ -219,6 +219,9 @@
 //   GTEST_USE_OWN_FLAGFILE_FLAG_ - Always defined to 0 or 1.
 //   GTEST_HAS_CXXABI_H_ - Always defined to 0 or 1.
 //   GTEST_CAN_STREAM_RESULTS_ - Always defined to 0 or 1.
+//   GTEST_CAN_ISOLATE_TESTS_ - Always defined to 0 or 1.
+//   GTEST_CAN_RECORD_RESOURCE_USAGE_ - Always defined to 0 or 1.
+//   GTEST_CAN_COUNT_PERF_EVENTS_ - Always defined to 0 or 1.
 //   GTEST_HAS_ALT_PATH_SEP_ - Always defined to 0 or 1.
 //   GTEST_WIDE_STRING_USES_UTF16_ - Always defined to 0 or 1.
 //   GTEST_HAS_MUTEX_AND_THREAD_LOCAL_ - Always defined to 0 or 1.
@@ -714,6 +717,33 @@ typedef struct _RTL_CRITICAL_SECTION GTEST_CRITICAL_SECTION;
 #define GTEST_CAN_STREAM_RESULTS_ 0
 #endif
 
+// Determines whether tests can be run in forked child processes.
+#if defined(GTEST_HAS_DEATH_TEST) && !defined(GTEST_OS_WINDOWS) && \
+    !defined(GTEST_OS_FUCHSIA)
+#define GTEST_CAN_ISOLATE_TESTS_ 1
+#else
+#define GTEST_CAN_ISOLATE_TESTS_ 0
+#endif
+
+// Determines whether the resources used by a test can be measured with
+// getrusage().
+#if defined(GTEST_OS_LINUX) || defined(GTEST_OS_MAC) ||         \
+    defined(GTEST_OS_FREEBSD) || defined(GTEST_OS_NETBSD) ||    \
+    defined(GTEST_OS_OPENBSD) || defined(GTEST_OS_DRAGONFLY) || \
+    defined(GTEST_OS_GNU_HURD)
+#define GTEST_CAN_RECORD_RESOURCE_USAGE_ 1
+#else
+#define GTEST_CAN_RECORD_RESOURCE_USAGE_ 0
+#endif
+
+// Determines whether each test's hardware and software events can be counted
+// with perf_event_open().
+#ifdef GTEST_OS_LINUX
+#define GTEST_CAN_COUNT_PERF_EVENTS_ 1
+#else
+#define GTEST_CAN_COUNT_PERF_EVENTS_ 0
+#endif
+
 // Defines some utility macros.
 
 // The GNU compiler emits a warning if nested "if" statements are followed by
@@ -982,6 +1012,11 @@ GTEST_DISABLE_MSC_WARNINGS_PUSH_(4251 \
 
 // A simple C++ wrapper for <regex.h>.  It uses the POSIX Extended
 // Regular Expression syntax.
+//
+// Patterns are matched by a built-in Thompson NFA, which runs in time
+// linear in the length of the string, falling back to <regex.h> (or to the
+// backtracking simple matcher) for constructs the NFA doesn't support.
+// Compiled patterns are cached by their text and shared between REs.
 class GTEST_API_ RE {
  public:
   // A copy constructor is required by the Standard to initialize object
@@ -1011,21 +1046,14 @@ class GTEST_API_ RE {
   static bool FullMatch(const char* str, const RE& re);
   static bool PartialMatch(const char* str, const RE& re);
 
+  // The compiled form of a pattern; defined in gtest-port.cc.
+  class Program;
+
  private:
   void Init(const char* regex);
   std::string pattern_;
   bool is_valid_;
-
-#ifdef GTEST_USES_POSIX_RE
-
-  regex_t full_regex_;     // For FullMatch().
-  regex_t partial_regex_;  // For PartialMatch().
-
-#else  // GTEST_USES_SIMPLE_RE
-
-  std::string full_pattern_;  // For FullMatch();
-
-#endif
+  std::shared_ptr<const Program> program_;
 };
 GTEST_DISABLE_MSC_WARNINGS_POP_()  // 4251
 #endif  // ::testing::internal::RE implementation
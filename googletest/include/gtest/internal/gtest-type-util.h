@@ -134,9 +134,6 @@ std::string GetTypeName() {
 #endif  // GTEST_HAS_RTTI
 }
 
-// A unique type indicating an empty node
-struct None {};
-
 #define GTEST_TEMPLATE_ \
   template <typename T> \
   class
@@ -159,30 +156,14 @@ struct TemplateSel {
 
 #define GTEST_BIND_(TmplSel, T) TmplSel::template Bind<T>::type
 
-template <GTEST_TEMPLATE_ Head_, GTEST_TEMPLATE_... Tail_>
-struct Templates {
-  using Head = TemplateSel<Head_>;
-  using Tail = Templates<Tail_...>;
-};
-
-template <GTEST_TEMPLATE_ Head_>
-struct Templates<Head_> {
-  using Head = TemplateSel<Head_>;
-  using Tail = None;
-};
-
-// Tuple-like type lists
-template <typename Head_, typename... Tail_>
-struct Types {
-  using Head = Head_;
-  using Tail = Types<Tail_...>;
-};
+// Lists of templates and of types.  They are flat: the code that walks them
+// expands them as parameter packs, so that a list of N elements doesn't
+// instantiate N nested lists.
+template <GTEST_TEMPLATE_... Tmpls>
+struct Templates {};
 
-template <typename Head_>
-struct Types<Head_> {
-  using Head = Head_;
-  using Tail = None;
-};
+template <typename... Ts>
+struct Types {};
 
 // Helper metafunctions to tell apart a single type from types
 // generated by ::testing::Types
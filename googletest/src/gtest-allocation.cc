@@ -0,0 +1,115 @@
+// Copyright 2024, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+//
+// The Google C++ Testing and Mocking Framework (Google Test)
+//
+// This file implements the heap allocation counters behind
+// EXPECT_ALLOCATIONS_AT_MOST().  The counting itself is done by the
+// gtest_alloc library (gtest_alloc.cc).
+
+#include "gtest/gtest-allocation.h"
+
+#include <atomic>
+
+#include "gtest/gtest.h"
+
+namespace testing {
+namespace internal {
+
+namespace {
+
+// These are read from operator new, so they can't be gtest's own
+// ThreadLocal, which allocates.  Both are constant-initialized.
+thread_local AllocationCounters g_thread_allocation_counters;
+std::atomic<bool> g_allocation_counting_enabled(false);
+
+}  // namespace
+
+AllocationCounters GetThreadAllocationCounters() {
+  return g_thread_allocation_counters;
+}
+
+bool AllocationCountingEnabled() {
+  return g_allocation_counting_enabled.load(std::memory_order_relaxed);
+}
+
+void EnableAllocationCounting() {
+  g_allocation_counting_enabled.store(true, std::memory_order_relaxed);
+}
+
+void CountAllocation(size_t size) {
+  ++g_thread_allocation_counters.allocations;
+  g_thread_allocation_counters.bytes += static_cast<int64_t>(size);
+}
+
+AllocationScope::AllocationScope(int64_t max_allocations, const char* file,
+                                 int line)
+    : max_allocations_(max_allocations),
+      file_(file),
+      line_(line),
+      start_(GetThreadAllocationCounters()) {}
+
+// Checks the block if it was left early, e.g. by a break or return.
+AllocationScope::~AllocationScope() {
+  if (!checked_) Check();
+}
+
+bool AllocationScope::Enter() {
+  if (!entered_) {
+    entered_ = true;
+    return true;
+  }
+  Check();
+  return false;
+}
+
+void AllocationScope::Check() {
+  const AllocationCounters end = GetThreadAllocationCounters();
+  checked_ = true;
+
+  Message message;
+  if (!AllocationCountingEnabled()) {
+    message << "Heap allocations can't be checked because the test program "
+               "isn't linked with the gtest_alloc library.";
+  } else {
+    const int64_t allocations = end.allocations - start_.allocations;
+    if (allocations <= max_allocations_) return;
+    message << "Expected: the block makes at most " << max_allocations_
+            << " heap allocation(s)\n"
+            << "  Actual: it made " << allocations << ", totalling "
+            << end.bytes - start_.bytes << " bytes";
+  }
+  AssertHelper(TestPartResult::kNonFatalFailure, file_, line_,
+               message.GetString().c_str()) = Message();
+}
+
+}  // namespace internal
+}  // namespace testing
@@ -43,13 +43,22 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "gtest/internal/gtest-port.h"
 
+#ifdef GTEST_IS_THREADSAFE
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#endif             // GTEST_IS_THREADSAFE
+
 #if GTEST_CAN_STREAM_RESULTS_
 #include <arpa/inet.h>  // NOLINT
 #include <netdb.h>      // NOLINT
@@ -148,20 +157,28 @@ class GTestFlagSaver {
     death_test_style_ = GTEST_FLAG_GET(death_test_style);
     death_test_use_fork_ = GTEST_FLAG_GET(death_test_use_fork);
     fail_fast_ = GTEST_FLAG_GET(fail_fast);
+    failed_first_ = GTEST_FLAG_GET(failed_first);
     filter_ = GTEST_FLAG_GET(filter);
     internal_run_death_test_ = GTEST_FLAG_GET(internal_run_death_test);
+    isolate_tests_ = GTEST_FLAG_GET(isolate_tests);
     list_tests_ = GTEST_FLAG_GET(list_tests);
+    manifest_ = GTEST_FLAG_GET(manifest);
     output_ = GTEST_FLAG_GET(output);
+    perf_counters_ = GTEST_FLAG_GET(perf_counters);
     brief_ = GTEST_FLAG_GET(brief);
     print_time_ = GTEST_FLAG_GET(print_time);
     print_utf8_ = GTEST_FLAG_GET(print_utf8);
     random_seed_ = GTEST_FLAG_GET(random_seed);
+    record_resource_usage_ = GTEST_FLAG_GET(record_resource_usage);
     repeat_ = GTEST_FLAG_GET(repeat);
+    rerun_failed_ = GTEST_FLAG_GET(rerun_failed);
     recreate_environments_when_repeating_ =
         GTEST_FLAG_GET(recreate_environments_when_repeating);
+    run_benchmarks_ = GTEST_FLAG_GET(run_benchmarks);
     shuffle_ = GTEST_FLAG_GET(shuffle);
     stack_trace_depth_ = GTEST_FLAG_GET(stack_trace_depth);
     stream_result_to_ = GTEST_FLAG_GET(stream_result_to);
+    test_timeout_ms_ = GTEST_FLAG_GET(test_timeout_ms);
     throw_on_failure_ = GTEST_FLAG_GET(throw_on_failure);
   }
 
@@ -175,19 +192,27 @@ class GTestFlagSaver {
     GTEST_FLAG_SET(death_test_use_fork, death_test_use_fork_);
     GTEST_FLAG_SET(filter, filter_);
     GTEST_FLAG_SET(fail_fast, fail_fast_);
+    GTEST_FLAG_SET(failed_first, failed_first_);
     GTEST_FLAG_SET(internal_run_death_test, internal_run_death_test_);
+    GTEST_FLAG_SET(isolate_tests, isolate_tests_);
     GTEST_FLAG_SET(list_tests, list_tests_);
+    GTEST_FLAG_SET(manifest, manifest_);
     GTEST_FLAG_SET(output, output_);
+    GTEST_FLAG_SET(perf_counters, perf_counters_);
     GTEST_FLAG_SET(brief, brief_);
     GTEST_FLAG_SET(print_time, print_time_);
     GTEST_FLAG_SET(print_utf8, print_utf8_);
     GTEST_FLAG_SET(random_seed, random_seed_);
+    GTEST_FLAG_SET(record_resource_usage, record_resource_usage_);
     GTEST_FLAG_SET(repeat, repeat_);
+    GTEST_FLAG_SET(rerun_failed, rerun_failed_);
     GTEST_FLAG_SET(recreate_environments_when_repeating,
                    recreate_environments_when_repeating_);
+    GTEST_FLAG_SET(run_benchmarks, run_benchmarks_);
     GTEST_FLAG_SET(shuffle, shuffle_);
     GTEST_FLAG_SET(stack_trace_depth, stack_trace_depth_);
     GTEST_FLAG_SET(stream_result_to, stream_result_to_);
+    GTEST_FLAG_SET(test_timeout_ms, test_timeout_ms_);
     GTEST_FLAG_SET(throw_on_failure, throw_on_failure_);
   }
 
@@ -200,19 +225,27 @@ class GTestFlagSaver {
   std::string death_test_style_;
   bool death_test_use_fork_;
   bool fail_fast_;
+  bool failed_first_;
   std::string filter_;
   std::string internal_run_death_test_;
+  bool isolate_tests_;
   bool list_tests_;
+  std::string manifest_;
   std::string output_;
+  bool perf_counters_;
   bool brief_;
   bool print_time_;
   bool print_utf8_;
   int32_t random_seed_;
+  bool record_resource_usage_;
   int32_t repeat_;
+  std::string rerun_failed_;
   bool recreate_environments_when_repeating_;
+  bool run_benchmarks_;
   bool shuffle_;
   int32_t stack_trace_depth_;
   std::string stream_result_to_;
+  int32_t test_timeout_ms_;
   bool throw_on_failure_;
 };
 
@@ -433,6 +466,28 @@ class OsStackTraceGetterInterface {
       delete;
 };
 
+// Maps PCs to their symbolized names, symbolizing each PC only the first
+// time it is looked up.  Symbolizing dominates the cost of a stack trace, and
+// with --gmock_verbose=info the same few call sites are traced over and over.
+// Not thread-safe; OsStackTraceGetter guards it with its own mutex.
+class GTEST_API_ SymbolCache {
+ public:
+  // Has the signature of absl::Symbolize().
+  typedef bool (*Symbolizer)(const void* pc, char* out, int out_size);
+
+  explicit SymbolCache(Symbolizer symbolizer) : symbolizer_(symbolizer) {}
+
+  // Returns the symbol for pc, or "(unknown)" if it can't be symbolized.
+  const std::string& Lookup(const void* pc);
+
+ private:
+  const Symbolizer symbolizer_;
+  std::unordered_map<const void*, std::string> symbols_;
+
+  SymbolCache(const SymbolCache&) = delete;
+  SymbolCache& operator=(const SymbolCache&) = delete;
+};
+
 // A working implementation of the OsStackTraceGetterInterface interface.
 class OsStackTraceGetter : public OsStackTraceGetterInterface {
  public:
@@ -450,6 +505,12 @@ class OsStackTraceGetter : public OsStackTraceGetterInterface {
   // the user code changes between the call to UponLeavingGTest()
   // and any calls to the stack trace code from within the user code.
   void* caller_frame_ = nullptr;
+
+  // Symbolized names of the frames seen so far.
+  SymbolCache symbol_cache_{&OsStackTraceGetter::Symbolize};
+
+  // Forwards to absl::Symbolize(), which this header can't name.
+  static bool Symbolize(const void* pc, char* out, int out_size);
 #endif  // GTEST_HAS_ABSL
 
   OsStackTraceGetter(const OsStackTraceGetter&) = delete;
@@ -461,6 +522,8 @@ struct TraceInfo {
   const char* file;
   int line;
   std::string message;
+  // If 'format' is set, the message is produced from this instead.
+  LazyTraceMessage lazy_message = {nullptr, nullptr};
 };
 
 // This is the default global test part result reporter used in UnitTestImpl.
@@ -501,6 +564,58 @@ class DefaultPerThreadTestPartResultReporter
       const DefaultPerThreadTestPartResultReporter&) = delete;
 };
 
+// Holds the lock on the current test's results (see
+// UnitTestImpl::LockTestResults()) for its lifetime.  Does nothing where
+// Google Test isn't thread-safe, as there is no watchdog to race with then.
+class TestResultsLock {
+ public:
+  TestResultsLock();
+  ~TestResultsLock();
+
+ private:
+  TestResultsLock(const TestResultsLock&) = delete;
+  TestResultsLock& operator=(const TestResultsLock&) = delete;
+};
+
+#ifdef GTEST_IS_THREADSAFE
+// Enforces the time limit of one test for --gtest_test_timeout_ms and
+// Test::SetTestTimeoutMs().  A thread waits for the limit to pass; if the
+// test is still running by then, it stops the test from recording results
+// (see UnitTestImpl::ClaimTestResults()), records a fatal failure, ends the
+// run so that the reports are written, and aborts the thread running the
+// test so that a failure signal handler or a core dump shows where it was
+// stuck.
+// In a child process of --gtest_isolate_tests or of a death test, the report
+// is left to the parent.
+class TestWatchdog {
+ public:
+  // Starts timing test_info.  A timeout_ms of 0 means no limit.
+  TestWatchdog(TestInfo* test_info, int timeout_ms);
+  ~TestWatchdog();
+
+  // Replaces the limit, still counted from the start of the test.
+  void SetTimeoutMs(int timeout_ms);
+
+ private:
+  void Watch();
+  [[noreturn]] void Expire(int timeout_ms);
+
+  TestInfo* const test_info_;
+  const std::chrono::steady_clock::time_point start_;
+  std::mutex mutex_;  // Protects timeout_ms_ and done_.
+  std::condition_variable timeout_changed_;
+  int timeout_ms_;
+  bool done_ = false;
+#if GTEST_HAS_PTHREAD
+  const pthread_t test_thread_;
+#endif  // GTEST_HAS_PTHREAD
+  std::thread thread_;  // Started the first time there is a limit.
+
+  TestWatchdog(const TestWatchdog&) = delete;
+  TestWatchdog& operator=(const TestWatchdog&) = delete;
+};
+#endif  // GTEST_IS_THREADSAFE
+
 // The private implementation of the UnitTest class.  We don't protect
 // the methods under a mutex, as this class is not accessible by a
 // user and the UnitTest class that delegates work to this class does
@@ -749,6 +864,15 @@ class GTEST_API_ UnitTestImpl {
   // updated.
   void RecordProperty(const TestProperty& test_property);
 
+  // Sets a function that is called with each property once it has been
+  // recorded for the current test, or clears it if forwarder is empty.  The
+  // child process of --gtest_isolate_tests uses it to send the properties to
+  // its parent as they are recorded.
+  void set_test_property_forwarder(
+      std::function<void(const TestProperty&)> forwarder) {
+    test_property_forwarder_ = std::move(forwarder);
+  }
+
   enum ReactionToSharding { HONOR_SHARDING_PROTOCOL, IGNORE_SHARDING_PROTOCOL };
 
   // Matches the full name of each test against the user-specified
@@ -762,13 +886,61 @@ class GTEST_API_ UnitTestImpl {
   // Prints the names of the tests matching the user-specified filter flag.
   void ListTestsMatchingFilter();
 
+  // Writes the list of all tests to the --gtest_manifest file if it is
+  // missing or older than the test program.  Must be called before
+  // FilterTests(), so that the manifest is not affected by the filter or
+  // by sharding.
+  void WriteManifestIfStale();
+
+  // Reads the report named by --gtest_rerun_failed, or by --gtest_output if
+  // --gtest_failed_first is given alone, and records which tests failed in
+  // it.  Must be called before FilterTests().
+  void LoadPreviouslyFailedTests();
+
+  // Moves the tests that failed in the previous report, and the test suites
+  // containing them, to the front of the current order, keeping death test
+  // suites first.
+  void MoveFailedTestsFirst();
+
+  TestSuite* current_test_suite() { return current_test_suite_; }
   const TestSuite* current_test_suite() const { return current_test_suite_; }
   TestInfo* current_test_info() { return current_test_info_; }
   const TestInfo* current_test_info() const { return current_test_info_; }
 
+  // Returns the number of the iteration of --gtest_repeat being run.
+  int current_iteration() const { return current_iteration_; }
+
+#ifdef GTEST_IS_THREADSAFE
+  // Gets and sets the watchdog timing the current test, or nullptr if there
+  // is none.
+  TestWatchdog* test_watchdog() const { return test_watchdog_; }
+  void set_test_watchdog(TestWatchdog* watchdog) { test_watchdog_ = watchdog; }
+
+  // Sends the events that end the run after test_info has timed out, so that
+  // the listeners write their reports before the program is aborted.
+  void EndRunAfterTimeout(TestInfo* test_info, TimeInMillis elapsed_time);
+
+  // Lock and unlock the results of the current test.  A TestWatchdog reports
+  // a timed-out test from its own thread while the test is still running,
+  // so everything that records or reads a test's results from the test's
+  // thread holds this lock.  The lock is recursive, as recording a result
+  // may run listeners that record more.
+  void LockTestResults();
+  void UnlockTestResults() { test_results_mutex_.unlock(); }
+
+  // Takes the lock on the test results for the calling thread for good: any
+  // other thread that then tries to lock them waits until the program is
+  // aborted.  Returns false if a thread holding the lock doesn't release it
+  // within timeout_ms.
+  bool ClaimTestResults(int timeout_ms);
+#endif  // GTEST_IS_THREADSAFE
+
   // Returns the vector of environments that need to be set-up/torn-down
   // before/after the tests are run.
   std::vector<Environment*>& environments() { return environments_; }
+  std::set<const Environment*>& independent_environments() {
+    return independent_environments_;
+  }
 
   // Getters for the per-thread Google Test trace stack.
   std::vector<TraceInfo>& gtest_trace_stack() {
@@ -804,6 +976,16 @@ class GTEST_API_ UnitTestImpl {
   // UnitTestOptions. Must not be called before InitGoogleTest.
   void ConfigureXmlOutput();
 
+#if GTEST_HAS_FILE_SYSTEM
+  // Fills this empty object with the test suites, tests and results of the
+  // iteration that starts at offset pos of data, a stream written by
+  // --gtest_output=bin.  strings holds the stream's interned strings.  Also
+  // sets the flags that the XML and JSON printers consult to the values the
+  // tests ran with.
+  void LoadBinaryTestResults(const std::string& data, size_t pos,
+                             const std::vector<std::string>& strings);
+#endif  // GTEST_HAS_FILE_SYSTEM
+
 #if GTEST_CAN_STREAM_RESULTS_
   // Initializes the event listener for streaming test results to a socket.
   // Must not be called before InitGoogleTest.
@@ -865,9 +1047,14 @@ class GTEST_API_ UnitTestImpl {
   internal::ThreadLocal<TestPartResultReporterInterface*>
       per_thread_test_part_result_reporter_;
 
+  // Called with each property recorded for the current test, if set.
+  std::function<void(const TestProperty&)> test_property_forwarder_;
+
   // The vector of environments that need to be set-up/torn-down
   // before/after the tests are run.
   std::vector<Environment*> environments_;
+  // The environments in environments_ that were registered as independent.
+  std::set<const Environment*> independent_environments_;
 
   // The vector of TestSuites in their original order.  It owns the
   // elements in the vector.
@@ -895,6 +1082,11 @@ class GTEST_API_ UnitTestImpl {
   // Index of the last death test suite registered.  Initially -1.
   int last_death_test_suite_;
 
+  // The full names of the tests that failed in the previous report, and
+  // whether FilterTests() should run only those.
+  std::set<std::string> previously_failed_tests_;
+  bool run_only_failed_tests_;
+
   // This points to the TestSuite for the currently running test.  It
   // changes as Google Test goes through one test suite after another.
   // When no test is running, this is set to NULL and Google Test
@@ -907,6 +1099,19 @@ class GTEST_API_ UnitTestImpl {
   // assertion results in ad_hoc_test_result_.  Initially NULL.
   TestInfo* current_test_info_;
 
+  // The iteration of --gtest_repeat being run, starting from 0.
+  int current_iteration_;
+
+#ifdef GTEST_IS_THREADSAFE
+  // The watchdog timing the test that's currently running, if any.
+  TestWatchdog* test_watchdog_;
+
+  // See LockTestResults() and ClaimTestResults().
+  std::recursive_timed_mutex test_results_mutex_;
+  std::atomic<bool> test_results_claimed_{false};
+  std::thread::id test_results_claimant_;  // Set before test_results_claimed_.
+#endif  // GTEST_IS_THREADSAFE
+
   // Normally, a user only writes assertions inside a TEST or TEST_F,
   // or inside a function called by a TEST or TEST_F.  Since Google
   // Test keeps track of which test is current running, it can
@@ -967,6 +1172,23 @@ inline UnitTestImpl* GetUnitTestImpl() {
   return UnitTest::GetInstance()->impl();
 }
 
+// Adds the full names ("Suite.Name") of the tests that failed in an XML or
+// JSON report written by XmlUnitTestResultPrinter or
+// JsonUnitTestResultPrinter to *failed.  Returns false if the report is in
+// neither format.
+GTEST_API_ bool ParseFailedTestsFromReport(const std::string& report,
+                                           std::set<std::string>* failed);
+
+#if GTEST_HAS_FILE_SYSTEM
+// The escaping done by XmlUnitTestResultPrinter and
+// JsonUnitTestResultPrinter, exposed for testing.
+GTEST_API_ std::string EscapeXmlForTesting(const std::string& str,
+                                           bool is_attribute);
+GTEST_API_ std::string RemoveInvalidXmlCharactersForTesting(
+    const std::string& str);
+GTEST_API_ std::string EscapeJsonForTesting(const std::string& str);
+#endif  // GTEST_HAS_FILE_SYSTEM
+
 #ifdef GTEST_USES_SIMPLE_RE
 
 // Internal helper functions for implementing the simple regular
@@ -1054,6 +1276,16 @@ class TestResultAccessor {
       const TestResult& test_result) {
     return test_result.test_part_results();
   }
+
+  static void set_resource_usage(TestResult* test_result,
+                                 const TestResourceUsage& usage) {
+    test_result->set_resource_usage(usage);
+  }
+
+  static void set_benchmark_result(TestResult* test_result,
+                                   const BenchmarkResult& result) {
+    test_result->set_benchmark_result(result);
+  }
 };
 
 #if GTEST_CAN_STREAM_RESULTS_
@@ -29,13 +29,17 @@
 
 #include "gtest/internal/gtest-port.h"
 
+#include <ctype.h>
 #include <limits.h>
+#include <locale.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <bitset>
 #include <cstdint>
 #include <fstream>
+#include <map>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -661,80 +665,7 @@ void ThreadLocalRegistry::OnThreadLocalDestroyed(
 
 #endif  // GTEST_IS_THREADSAFE && GTEST_OS_WINDOWS
 
-#ifdef GTEST_USES_POSIX_RE
-
-// Implements RE.  Currently only needed for death tests.
-
-RE::~RE() {
-  if (is_valid_) {
-    // regfree'ing an invalid regex might crash because the content
-    // of the regex is undefined. Since the regex's are essentially
-    // the same, one cannot be valid (or invalid) without the other
-    // being so too.
-    regfree(&partial_regex_);
-    regfree(&full_regex_);
-  }
-}
-
-// Returns true if and only if regular expression re matches the entire str.
-bool RE::FullMatch(const char* str, const RE& re) {
-  if (!re.is_valid_) return false;
-
-  regmatch_t match;
-  return regexec(&re.full_regex_, str, 1, &match, 0) == 0;
-}
-
-// Returns true if and only if regular expression re matches a substring of
-// str (including str itself).
-bool RE::PartialMatch(const char* str, const RE& re) {
-  if (!re.is_valid_) return false;
-
-  regmatch_t match;
-  return regexec(&re.partial_regex_, str, 1, &match, 0) == 0;
-}
-
-// Initializes an RE from its string representation.
-void RE::Init(const char* regex) {
-  pattern_ = regex;
-
-  // NetBSD (and Android, which takes its regex implemntation from NetBSD) does
-  // not include the GNU regex extensions (such as Perl style character classes
-  // like \w) in REG_EXTENDED. REG_EXTENDED is only specified to include the
-  // [[:alpha:]] style character classes. Enable REG_GNU wherever it is defined
-  // so users can use those extensions.
-#if defined(REG_GNU)
-  constexpr int reg_flags = REG_EXTENDED | REG_GNU;
-#else
-  constexpr int reg_flags = REG_EXTENDED;
-#endif
-
-  // Reserves enough bytes to hold the regular expression used for a
-  // full match.
-  const size_t full_regex_len = strlen(regex) + 10;
-  char* const full_pattern = new char[full_regex_len];
-
-  snprintf(full_pattern, full_regex_len, "^(%s)$", regex);
-  is_valid_ = regcomp(&full_regex_, full_pattern, reg_flags) == 0;
-  // We want to call regcomp(&partial_regex_, ...) even if the
-  // previous expression returns false.  Otherwise partial_regex_ may
-  // not be properly initialized can may cause trouble when it's
-  // freed.
-  //
-  // Some implementation of POSIX regex (e.g. on at least some
-  // versions of Cygwin) doesn't accept the empty string as a valid
-  // regex.  We change it to an equivalent form "()" to be safe.
-  if (is_valid_) {
-    const char* const partial_regex = (*regex == '\0') ? "()" : regex;
-    is_valid_ = regcomp(&partial_regex_, partial_regex, reg_flags) == 0;
-  }
-  EXPECT_TRUE(is_valid_)
-      << "Regular expression \"" << regex
-      << "\" is not a valid POSIX Extended regular expression.";
-
-  delete[] full_pattern;
-}
-
-#elif defined(GTEST_USES_SIMPLE_RE)
+#ifdef GTEST_USES_SIMPLE_RE
 
 // Returns true if and only if ch appears anywhere in str (excluding the
 // terminating '\0' character).
@@ -934,36 +865,669 @@ bool MatchRegexAnywhere(const char* regex, const char* str) {
   return false;
 }
 
-// Implements the RE class.
+#endif  // GTEST_USES_SIMPLE_RE
 
-RE::~RE() = default;
+#if defined(GTEST_USES_POSIX_RE) || defined(GTEST_USES_SIMPLE_RE)
 
-// Returns true if and only if regular expression re matches the entire str.
-bool RE::FullMatch(const char* str, const RE& re) {
-  return re.is_valid_ && MatchRegexAnywhere(re.full_pattern_.c_str(), str);
+// A regular expression compiled to a Thompson NFA.  Matching advances every
+// live NFA state one byte at a time (Pike's VM without captures), so it
+// takes O(pattern length * string length) time whatever the pattern, unlike
+// a backtracking matcher.
+//
+// The engine handles the simple regex syntax in full, and of the POSIX
+// Extended syntax: literals, '.', bracket expressions with ranges and
+// character classes, grouping, alternation, the *, +, ? and {m,n}
+// repetitions, the ^ and $ anchors, and the \w, \W, \s and \S extensions.
+// Compile() returns null for anything else so that the caller can fall back
+// to another implementation.
+class RegexNfa {
+ public:
+  enum Syntax { kSimpleSyntax, kExtendedSyntax };
+
+  static std::unique_ptr<RegexNfa> Compile(const char* regex, Syntax syntax);
+
+  bool FullMatch(const char* str) const { return Run(str, true); }
+  bool PartialMatch(const char* str) const { return Run(str, false); }
+
+ private:
+  typedef std::bitset<256> ByteSet;
+
+  enum OpCode { kByte, kSplit, kJump, kLineBegin, kLineEnd, kMatch };
+
+  // kByte consumes a byte in byte_sets_[x]; kSplit continues at both x and
+  // y; kJump continues at x.
+  struct Instruction {
+    OpCode op;
+    size_t x;
+    size_t y;
+  };
+
+  // The parse tree, from which the program is emitted.  Bounded
+  // repetitions are expanded by emitting their operand several times.
+  struct Node {
+    enum Kind { kEmpty, kBytes, kBegin, kEnd, kConcat, kAlternation, kRepeat };
+    Kind kind;
+    size_t byte_set;
+    int min;
+    int max;  // kUnbounded for *, + and {m,}.
+    std::vector<int> children;
+  };
+
+  class Parser;
+
+  static constexpr int kUnbounded = -1;
+  // Larger programs (e.g. from deeply nested bounds) are left to the
+  // fallback implementation.
+  static constexpr size_t kMaxInstructions = 1 << 16;
+
+  RegexNfa() = default;
+
+  size_t Add(OpCode op, size_t x = 0, size_t y = 0) {
+    program_.push_back(Instruction{op, x, y});
+    return program_.size() - 1;
+  }
+  bool Emit(const std::vector<Node>& nodes, int index);
+  void ComputeStartBytes();
+
+  // Adds the states reachable from pc without consuming input to *states,
+  // marking them with stamp.  Returns true if that reaches an accepting
+  // state at position at.
+  bool AddStates(size_t pc, const char* at, bool at_begin, bool full,
+                 size_t stamp, std::vector<size_t>* states,
+                 std::vector<size_t>* visited,
+                 std::vector<size_t>* stack) const;
+  bool Run(const char* str, bool full) const;
+
+  std::vector<Instruction> program_;
+  std::vector<ByteSet> byte_sets_;
+
+  // When every match has to start by consuming a byte in start_bytes_, a
+  // partial match can skip over the bytes that aren't in it.
+  bool can_skip_ = false;
+  ByteSet start_bytes_;
+};
+
+class RegexNfa::Parser {
+ public:
+  Parser(const char* regex, Syntax syntax, RegexNfa* nfa)
+      : p_(regex), syntax_(syntax), nfa_(nfa) {}
+
+  // Parses the whole pattern into nodes_ and returns the root, or -1.
+  int Parse() {
+    const int root = syntax_ == kSimpleSyntax ? ParseSimple()
+                                              : ParseAlternation();
+    if (root < 0) return -1;
+    return *p_ == '\0' ? root : -1;
+  }
+
+  const std::vector<Node>& nodes() const { return nodes_; }
+
+ private:
+  int AddNode(Node::Kind kind) {
+    nodes_.push_back(Node{kind, 0, 0, 0, {}});
+    return static_cast<int>(nodes_.size()) - 1;
+  }
+
+  int AddBytes(const ByteSet& bytes) {
+    const int node = AddNode(Node::kBytes);
+    nodes_[static_cast<size_t>(node)].byte_set = nfa_->byte_sets_.size();
+    nfa_->byte_sets_.push_back(bytes);
+    return node;
+  }
+
+  int AddRepeat(int operand, int min, int max) {
+    const int node = AddNode(Node::kRepeat);
+    Node& repeat = nodes_[static_cast<size_t>(node)];
+    repeat.min = min;
+    repeat.max = max;
+    repeat.children.push_back(operand);
+    return node;
+  }
+
+  template <typename Predicate>
+  static ByteSet BytesWhere(Predicate predicate) {
+    ByteSet bytes;
+    // The string is NUL-terminated, so there's no point matching '\0'.
+    for (int c = 1; c < 256; ++c) bytes[static_cast<size_t>(c)] = predicate(c);
+    return bytes;
+  }
+
+  static ByteSet SingleByte(char c) {
+    ByteSet bytes;
+    bytes.set(static_cast<unsigned char>(c));
+    return bytes;
+  }
+
+#ifdef GTEST_USES_SIMPLE_RE
+  // The simple syntax has already been validated by ValidateRegex(), so
+  // this only needs to translate it, using AtomMatchesChar() to keep the
+  // meaning of each atom identical to the backtracking matcher's.
+  int ParseSimple() {
+    const int concat = AddNode(Node::kConcat);
+    while (*p_ != '\0') {
+      int atom;
+      if (*p_ == '^') {
+        atom = AddNode(Node::kBegin);
+        ++p_;
+      } else if (*p_ == '$') {
+        atom = AddNode(Node::kEnd);
+        ++p_;
+      } else {
+        const bool escaped = *p_ == '\\';
+        if (escaped) ++p_;
+        const char pattern_char = *p_++;
+        atom = AddBytes(BytesWhere([=](int c) {
+          return AtomMatchesChar(escaped, pattern_char, static_cast<char>(c));
+        }));
+        if (IsRepeat(*p_)) {
+          const char repeat = *p_++;
+          atom = AddRepeat(atom, repeat == '+' ? 1 : 0,
+                           repeat == '?' ? 1 : kUnbounded);
+        }
+      }
+      nodes_[static_cast<size_t>(concat)].children.push_back(atom);
+    }
+    return concat;
+  }
+#else
+  int ParseSimple() { return -1; }
+#endif  // GTEST_USES_SIMPLE_RE
+
+  int ParseAlternation() {
+    const int alternation = AddNode(Node::kAlternation);
+    for (;;) {
+      const int branch = ParseConcatenation();
+      if (branch < 0) return -1;
+      nodes_[static_cast<size_t>(alternation)].children.push_back(branch);
+      if (*p_ != '|') break;
+      ++p_;
+    }
+    // An empty branch such as "a|" or "(|b)" is treated differently by
+    // different libraries; leave it to the platform's.
+    const std::vector<int>& branches =
+        nodes_[static_cast<size_t>(alternation)].children;
+    if (branches.size() > 1) {
+      for (int branch : branches) {
+        if (nodes_[static_cast<size_t>(branch)].children.empty()) return -1;
+      }
+    }
+    return alternation;
+  }
+
+  int ParseConcatenation() {
+    const int concat = AddNode(Node::kConcat);
+    while (*p_ != '\0' && *p_ != '|' && !(*p_ == ')' && depth_ > 0)) {
+      const int piece = ParsePiece();
+      if (piece < 0) return -1;
+      nodes_[static_cast<size_t>(concat)].children.push_back(piece);
+    }
+    return concat;
+  }
+
+  // Parses an atom followed by any number of repetition operators.
+  int ParsePiece() {
+    int atom = ParseAtom();
+    while (atom >= 0 && (*p_ == '*' || *p_ == '+' || *p_ == '?' ||
+                         *p_ == '{')) {
+      const Node::Kind kind = nodes_[static_cast<size_t>(atom)].kind;
+      if (kind == Node::kBegin || kind == Node::kEnd) return -1;
+      int min = 0;
+      int max = kUnbounded;
+      const char op = *p_++;
+      if (op == '+') {
+        min = 1;
+      } else if (op == '?') {
+        max = 1;
+      } else if (op == '{' && !ParseBound(&min, &max)) {
+        return -1;
+      }
+      atom = AddRepeat(atom, min, max);
+    }
+    return atom;
+  }
+
+  // Parses the "m}", "m,}" or "m,n}" following a '{'.
+  bool ParseBound(int* min, int* max) {
+    if (!ParseNumber(min)) return false;
+    if (*p_ == ',') {
+      ++p_;
+      *max = kUnbounded;
+      if (*p_ != '}' && (!ParseNumber(max) || *max < *min)) return false;
+    } else {
+      *max = *min;
+    }
+    if (*p_ != '}') return false;
+    ++p_;
+    return true;
+  }
+
+  bool ParseNumber(int* value) {
+    if (!IsDigit(*p_)) return false;
+    *value = 0;
+    while (IsDigit(*p_)) {
+      *value = *value * 10 + (*p_++ - '0');
+      if (*value > 255) return false;
+    }
+    return true;
+  }
+
+  int ParseAtom() {
+    const char c = *p_++;
+    switch (c) {
+      case '(': {
+        ++depth_;
+        const int group = ParseAlternation();
+        --depth_;
+        if (group < 0 || *p_ != ')') return -1;
+        ++p_;
+        return group;
+      }
+      case '[':
+        return ParseBracket();
+      case '.':
+        return AddBytes(BytesWhere([](int) { return true; }));
+      case '^':
+        return AddNode(Node::kBegin);
+      case '$':
+        return AddNode(Node::kEnd);
+      case '\\':
+        return ParseEscape();
+      case ')':
+      case '*':
+      case '+':
+      case '?':
+      case '{':
+        return -1;
+      default:
+        return AddBytes(SingleByte(c));
+    }
+  }
+
+  int ParseEscape() {
+    // A trailing backslash leaves p_ on the NUL, never past it.
+    const char c = *p_;
+    if (c == '\0') return -1;
+    ++p_;
+    switch (c) {
+      case 'w':
+      case 'W':
+        return AddBytes(BytesWhere([=](int b) {
+          return (isalnum(b) != 0 || b == '_') == (c == 'w');
+        }));
+      case 's':
+      case 'S':
+        return AddBytes(
+            BytesWhere([=](int b) { return (isspace(b) != 0) == (c == 's'); }));
+      default:
+        // Other letters and digits are back-references or extensions.
+        if (!ispunct(static_cast<unsigned char>(c))) return -1;
+        return AddBytes(SingleByte(c));
+    }
+  }
+
+  // Parses a bracket expression after its '['.
+  int ParseBracket() {
+    const bool negated = *p_ == '^';
+    if (negated) ++p_;
+    ByteSet bytes;
+    for (bool first = true;; first = false) {
+      const char c = *p_;
+      if (c == '\0') return -1;
+      if (c == ']' && !first) {
+        ++p_;
+        break;
+      }
+      if (c == '[' && (p_[1] == '.' || p_[1] == '=')) return -1;
+      if (c == '[' && p_[1] == ':') {
+        const char* const name = p_ + 2;
+        const char* const end = strstr(name, ":]");
+        if (end == nullptr) return -1;
+        int (*predicate)(int) = ClassPredicate(std::string(name, end));
+        if (predicate == nullptr) return -1;
+        bytes |= BytesWhere(predicate);
+        p_ = end + 2;
+        continue;
+      }
+      ++p_;
+      unsigned char last = static_cast<unsigned char>(c);
+      if (*p_ == '-' && p_[1] != ']' && p_[1] != '\0') {
+        if (p_[1] == '[') return -1;
+        last = static_cast<unsigned char>(p_[1]);
+        p_ += 2;
+        if (last < static_cast<unsigned char>(c)) return -1;
+      }
+      for (int b = static_cast<unsigned char>(c); b <= last; ++b) {
+        bytes.set(static_cast<size_t>(b));
+      }
+    }
+    if (negated) bytes.flip();
+    bytes.reset(0);
+    return AddBytes(bytes);
+  }
+
+  static int (*ClassPredicate(const std::string& name))(int) {
+    static const struct {
+      const char* name;
+      int (*predicate)(int);
+    } kClasses[] = {
+        {"alnum", isalnum}, {"alpha", isalpha}, {"blank", isblank},
+        {"cntrl", iscntrl}, {"digit", isdigit}, {"graph", isgraph},
+        {"lower", islower}, {"print", isprint}, {"punct", ispunct},
+        {"space", isspace}, {"upper", isupper}, {"xdigit", isxdigit},
+    };
+    for (const auto& cls : kClasses) {
+      if (name == cls.name) return cls.predicate;
+    }
+    return nullptr;
+  }
+
+  const char* p_;
+  const Syntax syntax_;
+  RegexNfa* const nfa_;
+  int depth_ = 0;  // Number of open groups.
+  std::vector<Node> nodes_;
+};
+
+std::unique_ptr<RegexNfa> RegexNfa::Compile(const char* regex,
+                                            Syntax syntax) {
+  std::unique_ptr<RegexNfa> nfa(new RegexNfa);
+  Parser parser(regex, syntax, nfa.get());
+  const int root = parser.Parse();
+  if (root < 0 || !nfa->Emit(parser.nodes(), root)) return nullptr;
+  nfa->Add(kMatch);
+  nfa->ComputeStartBytes();
+  return nfa;
 }
 
-// Returns true if and only if regular expression re matches a substring of
-// str (including str itself).
-bool RE::PartialMatch(const char* str, const RE& re) {
-  return re.is_valid_ && MatchRegexAnywhere(re.pattern_.c_str(), str);
+bool RegexNfa::Emit(const std::vector<Node>& nodes, int index) {
+  if (program_.size() > kMaxInstructions) return false;
+  const Node& node = nodes[static_cast<size_t>(index)];
+  switch (node.kind) {
+    case Node::kEmpty:
+      return true;
+    case Node::kBytes:
+      Add(kByte, node.byte_set);
+      return true;
+    case Node::kBegin:
+      Add(kLineBegin);
+      return true;
+    case Node::kEnd:
+      Add(kLineEnd);
+      return true;
+    case Node::kConcat:
+      for (int child : node.children) {
+        if (!Emit(nodes, child)) return false;
+      }
+      return true;
+    case Node::kAlternation: {
+      std::vector<size_t> jumps;
+      for (size_t i = 0; i + 1 < node.children.size(); ++i) {
+        const size_t split = Add(kSplit, program_.size() + 1);
+        if (!Emit(nodes, node.children[i])) return false;
+        jumps.push_back(Add(kJump));
+        program_[split].y = program_.size();
+      }
+      if (!Emit(nodes, node.children.back())) return false;
+      for (size_t jump : jumps) program_[jump].x = program_.size();
+      return true;
+    }
+    case Node::kRepeat: {
+      const int operand = node.children[0];
+      for (int i = 0; i < node.min; ++i) {
+        if (!Emit(nodes, operand)) return false;
+      }
+      if (node.max == kUnbounded) {
+        const size_t loop = Add(kSplit, program_.size() + 1);
+        if (!Emit(nodes, operand)) return false;
+        Add(kJump, loop);
+        program_[loop].y = program_.size();
+      } else {
+        std::vector<size_t> splits;
+        for (int i = node.min; i < node.max; ++i) {
+          splits.push_back(Add(kSplit, program_.size() + 1));
+          if (!Emit(nodes, operand)) return false;
+        }
+        for (size_t split : splits) program_[split].y = program_.size();
+      }
+      return true;
+    }
+  }
+  return false;
 }
 
-// Initializes an RE from its string representation.
-void RE::Init(const char* regex) {
-  full_pattern_.clear();
-  pattern_.clear();
+void RegexNfa::ComputeStartBytes() {
+  std::vector<bool> visited(program_.size());
+  std::vector<size_t> stack(1, 0);
+  can_skip_ = true;
+  while (!stack.empty()) {
+    const size_t pc = stack.back();
+    stack.pop_back();
+    if (visited[pc]) continue;
+    visited[pc] = true;
+    const Instruction& inst = program_[pc];
+    switch (inst.op) {
+      case kByte:
+        start_bytes_ |= byte_sets_[inst.x];
+        break;
+      case kSplit:
+        stack.push_back(inst.y);
+        stack.push_back(inst.x);
+        break;
+      case kJump:
+        stack.push_back(inst.x);
+        break;
+      case kLineBegin:
+      case kLineEnd:
+      case kMatch:
+        can_skip_ = false;
+        break;
+    }
+  }
+}
 
-  if (regex != nullptr) {
-    pattern_ = regex;
+bool RegexNfa::AddStates(size_t pc, const char* at, bool at_begin, bool full,
+                         size_t stamp, std::vector<size_t>* states,
+                         std::vector<size_t>* visited,
+                         std::vector<size_t>* stack) const {
+  stack->push_back(pc);
+  while (!stack->empty()) {
+    pc = stack->back();
+    stack->pop_back();
+    if ((*visited)[pc] == stamp) continue;
+    (*visited)[pc] = stamp;
+    const Instruction& inst = program_[pc];
+    switch (inst.op) {
+      case kByte:
+        states->push_back(pc);
+        break;
+      case kSplit:
+        stack->push_back(inst.y);
+        stack->push_back(inst.x);
+        break;
+      case kJump:
+        stack->push_back(inst.x);
+        break;
+      case kLineBegin:
+        if (at_begin) stack->push_back(pc + 1);
+        break;
+      case kLineEnd:
+        if (*at == '\0') stack->push_back(pc + 1);
+        break;
+      case kMatch:
+        if (!full || *at == '\0') {
+          stack->clear();
+          return true;
+        }
+        break;
+    }
   }
+  return false;
+}
 
-  is_valid_ = ValidateRegex(regex);
-  if (!is_valid_) {
-    // No need to calculate the full pattern when the regex is invalid.
+bool RegexNfa::Run(const char* str, bool full) const {
+  std::vector<size_t> current;
+  std::vector<size_t> next;
+  std::vector<size_t> stack;
+  // visited[pc] is the stamp of the last position at which pc was added.
+  std::vector<size_t> visited(program_.size(), 0);
+  const bool single_start_byte = can_skip_ && start_bytes_.count() == 1;
+  char start_byte = '\0';
+  if (single_start_byte) {
+    while (!start_bytes_[static_cast<unsigned char>(start_byte)]) ++start_byte;
+  }
+
+  size_t stamp = 1;
+  for (const char* s = str;; ++s) {
+    // A match can start at the beginning of str, or anywhere for a
+    // partial match.
+    if (s == str || !full) {
+      if (!full && current.empty() && can_skip_) {
+        if (single_start_byte) {
+          s = strchr(s, start_byte);
+          if (s == nullptr) return false;
+        } else {
+          while (*s != '\0' && !start_bytes_[static_cast<unsigned char>(*s)]) {
+            ++s;
+          }
+        }
+      }
+      if (AddStates(0, s, s == str, full, stamp, &current, &visited, &stack)) {
+        return true;
+      }
+    }
+    if (*s == '\0' || (current.empty() && full)) return false;
+
+    ++stamp;
+    next.clear();
+    const size_t byte = static_cast<unsigned char>(*s);
+    for (size_t pc : current) {
+      if (byte_sets_[program_[pc].x][byte] &&
+          AddStates(pc + 1, s + 1, false, full, stamp, &next, &visited,
+                    &stack)) {
+        return true;
+      }
+    }
+    current.swap(next);
+  }
+}
+
+// The compiled form of a pattern.  It is immutable once built, so it can be
+// shared between REs and threads.
+class RE::Program {
+ public:
+  explicit Program(const char* regex);
+  ~Program();
+
+  bool is_valid() const { return is_valid_; }
+  bool FullMatch(const char* str) const;
+  bool PartialMatch(const char* str) const;
+
+ private:
+  std::unique_ptr<RegexNfa> nfa_;  // Null if the fallback is used.
+  bool is_valid_;
+
+#ifdef GTEST_USES_POSIX_RE
+
+  regex_t full_regex_;     // For FullMatch().
+  regex_t partial_regex_;  // For PartialMatch().
+
+#else  // GTEST_USES_SIMPLE_RE
+
+  std::string pattern_;       // For PartialMatch().
+  std::string full_pattern_;  // For FullMatch().
+
+#endif
+
+  Program(const Program&) = delete;
+  Program& operator=(const Program&) = delete;
+};
+
+#ifdef GTEST_USES_POSIX_RE
+
+// Returns true if the NFA would treat bytes the way <regex.h> does in the
+// current locale: one byte per character, ranges in byte order.
+static bool IsByteOrientedLocale() {
+  if (MB_CUR_MAX != 1) return false;
+  const char* const collate = setlocale(LC_COLLATE, nullptr);
+  return collate == nullptr || strcmp(collate, "C") == 0 ||
+         strcmp(collate, "POSIX") == 0;
+}
+
+RE::Program::Program(const char* regex) {
+  if (IsByteOrientedLocale()) {
+    nfa_ = RegexNfa::Compile(regex, RegexNfa::kExtendedSyntax);
+  }
+  if (nfa_ != nullptr) {
+    is_valid_ = true;
     return;
   }
 
+  // NetBSD (and Android, which takes its regex implemntation from NetBSD) does
+  // not include the GNU regex extensions (such as Perl style character classes
+  // like \w) in REG_EXTENDED. REG_EXTENDED is only specified to include the
+  // [[:alpha:]] style character classes. Enable REG_GNU wherever it is defined
+  // so users can use those extensions.
+#if defined(REG_GNU)
+  constexpr int reg_flags = REG_EXTENDED | REG_GNU;
+#else
+  constexpr int reg_flags = REG_EXTENDED;
+#endif
+
+  // Reserves enough bytes to hold the regular expression used for a
+  // full match.
+  const size_t full_regex_len = strlen(regex) + 10;
+  char* const full_pattern = new char[full_regex_len];
+
+  snprintf(full_pattern, full_regex_len, "^(%s)$", regex);
+  is_valid_ = regcomp(&full_regex_, full_pattern, reg_flags) == 0;
+  // We want to call regcomp(&partial_regex_, ...) even if the
+  // previous expression returns false.  Otherwise partial_regex_ may
+  // not be properly initialized can may cause trouble when it's
+  // freed.
+  //
+  // Some implementation of POSIX regex (e.g. on at least some
+  // versions of Cygwin) doesn't accept the empty string as a valid
+  // regex.  We change it to an equivalent form "()" to be safe.
+  if (is_valid_) {
+    const char* const partial_regex = (*regex == '\0') ? "()" : regex;
+    is_valid_ = regcomp(&partial_regex_, partial_regex, reg_flags) == 0;
+  }
+
+  delete[] full_pattern;
+}
+
+RE::Program::~Program() {
+  if (nfa_ == nullptr && is_valid_) {
+    // regfree'ing an invalid regex might crash because the content
+    // of the regex is undefined. Since the regex's are essentially
+    // the same, one cannot be valid (or invalid) without the other
+    // being so too.
+    regfree(&partial_regex_);
+    regfree(&full_regex_);
+  }
+}
+
+bool RE::Program::FullMatch(const char* str) const {
+  if (nfa_ != nullptr) return nfa_->FullMatch(str);
+  regmatch_t match;
+  return regexec(&full_regex_, str, 1, &match, 0) == 0;
+}
+
+bool RE::Program::PartialMatch(const char* str) const {
+  if (nfa_ != nullptr) return nfa_->PartialMatch(str);
+  regmatch_t match;
+  return regexec(&partial_regex_, str, 1, &match, 0) == 0;
+}
+
+#else  // GTEST_USES_SIMPLE_RE
+
+// regex must already have been validated by ValidateRegex().
+RE::Program::Program(const char* regex)
+    : nfa_(RegexNfa::Compile(regex, RegexNfa::kSimpleSyntax)),
+      is_valid_(true) {
+  if (nfa_ != nullptr) return;
+
+  pattern_ = regex;
   // Reserves enough bytes to hold the regular expression used for a
   // full match: we need space to prepend a '^' and append a '$'.
   full_pattern_.reserve(pattern_.size() + 2);
@@ -979,8 +1543,101 @@ void RE::Init(const char* regex) {
   }
 }
 
+RE::Program::~Program() = default;
+
+bool RE::Program::FullMatch(const char* str) const {
+  if (nfa_ != nullptr) return nfa_->FullMatch(str);
+  return MatchRegexAnywhere(full_pattern_.c_str(), str);
+}
+
+bool RE::Program::PartialMatch(const char* str) const {
+  if (nfa_ != nullptr) return nfa_->PartialMatch(str);
+  return MatchRegexAnywhere(pattern_.c_str(), str);
+}
+
+#endif  // GTEST_USES_POSIX_RE
+
+namespace {
+
+// Matchers and death tests construct an RE for the same few patterns over
+// and over, so compiled programs are kept, keyed by their text.  The cache
+// is simply emptied when it fills up.
+constexpr size_t kMaxCachedRegexes = 256;
+
+GTEST_DEFINE_STATIC_MUTEX_(g_regex_cache_mutex);
+
+std::shared_ptr<const RE::Program> GetCompiledRegex(const char* regex) {
+#ifdef GTEST_USES_POSIX_RE
+  // The meaning of a pattern may depend on the locale it was compiled in.
+  if (!IsByteOrientedLocale()) {
+    return std::make_shared<const RE::Program>(regex);
+  }
+#endif  // GTEST_USES_POSIX_RE
+
+  static auto* const cache =
+      new std::map<std::string, std::shared_ptr<const RE::Program>>;
+  MutexLock lock(&g_regex_cache_mutex);
+  auto it = cache->find(regex);
+  if (it == cache->end()) {
+    if (cache->size() >= kMaxCachedRegexes) cache->clear();
+    it = cache->emplace(regex, std::make_shared<const RE::Program>(regex))
+             .first;
+  }
+  return it->second;
+}
+
+}  // namespace
+
+// Implements the RE class.
+
+RE::~RE() = default;
+
+// Returns true if and only if regular expression re matches the entire str.
+bool RE::FullMatch(const char* str, const RE& re) {
+  return re.is_valid_ && re.program_->FullMatch(str);
+}
+
+// Returns true if and only if regular expression re matches a substring of
+// str (including str itself).
+bool RE::PartialMatch(const char* str, const RE& re) {
+  return re.is_valid_ && re.program_->PartialMatch(str);
+}
+
+#ifdef GTEST_USES_POSIX_RE
+
+// Initializes an RE from its string representation.
+void RE::Init(const char* regex) {
+  pattern_ = regex;
+  program_ = GetCompiledRegex(regex);
+  is_valid_ = program_->is_valid();
+  EXPECT_TRUE(is_valid_)
+      << "Regular expression \"" << regex
+      << "\" is not a valid POSIX Extended regular expression.";
+}
+
+#else  // GTEST_USES_SIMPLE_RE
+
+// Initializes an RE from its string representation.
+void RE::Init(const char* regex) {
+  pattern_.clear();
+  program_.reset();
+
+  if (regex != nullptr) {
+    pattern_ = regex;
+  }
+
+  // Syntax errors are reported by every RE, so the pattern is validated
+  // before the cache is consulted.
+  is_valid_ = ValidateRegex(regex);
+  if (is_valid_) {
+    program_ = GetCompiledRegex(regex);
+  }
+}
+
 #endif  // GTEST_USES_POSIX_RE
 
+#endif  // GTEST_USES_POSIX_RE || GTEST_USES_SIMPLE_RE
+
 const char kUnknownFile[] = "unknown file";
 
 // Formats a source file path and a line number as they would appear
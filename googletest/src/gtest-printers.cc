@@ -45,17 +45,25 @@
 #include <stdio.h>
 
 #include <cctype>
+#include <clocale>
 #include <cstdint>
 #include <cwchar>
 #include <iomanip>
 #include <ios>
+#include <locale>
 #include <ostream>  // NOLINT
+#include <sstream>
 #include <string>
 #include <type_traits>
 
 #include "gtest/internal/gtest-port.h"
 #include "src/gtest-internal-inl.h"
 
+#if GTEST_INTERNAL_CPLUSPLUS_LANG >= 201703L && \
+    GTEST_INTERNAL_HAS_INCLUDE(<charconv>)
+#include <charconv>
+#endif
+
 namespace testing {
 
 namespace {
@@ -118,10 +126,201 @@ char32_t ToChar32(CharType in) {
       static_cast<typename std::make_unsigned<CharType>::type>(in));
 }
 
+// Writes the decimal digits of value backwards, ending just before end, and
+// returns a pointer to the first digit.  Two digits are produced per
+// division.
+char* FormatDecimalBackwards(unsigned long long value, char* end) {  // NOLINT
+  static const char kDigitPairs[] =
+      "00010203040506070809"
+      "10111213141516171819"
+      "20212223242526272829"
+      "30313233343536373839"
+      "40414243444546474849"
+      "50515253545556575859"
+      "60616263646566676869"
+      "70717273747576777879"
+      "80818283848586878889"
+      "90919293949596979899";
+  char* p = end;
+  while (value >= 100) {
+    const size_t pair = static_cast<size_t>(value % 100) * 2;
+    value /= 100;
+    *--p = kDigitPairs[pair + 1];
+    *--p = kDigitPairs[pair];
+  }
+  if (value >= 10) {
+    const size_t pair = static_cast<size_t>(value) * 2;
+    *--p = kDigitPairs[pair + 1];
+    *--p = kDigitPairs[pair];
+  } else {
+    *--p = static_cast<char>('0' + value);
+  }
+  return p;
+}
+
+// Large enough for the digits of any 64-bit value and a sign.
+constexpr size_t kMaxDecimalLength = 21;
+
+// Formats value into buffer and returns the start of the digits; the
+// output ends at buffer + kMaxDecimalLength.
+char* FormatDecimal(long long value, char* buffer) {  // NOLINT
+  const bool negative = value < 0;
+  // Negating in the unsigned domain keeps the minimum value well-defined.
+  const unsigned long long magnitude =  // NOLINT
+      negative ? 0 - static_cast<unsigned long long>(value)  // NOLINT
+               : static_cast<unsigned long long>(value);     // NOLINT
+  char* p = FormatDecimalBackwards(magnitude, buffer + kMaxDecimalLength);
+  if (negative) *--p = '-';
+  return p;
+}
+
+// Formats value as "%.*g" would in the "C" locale and returns the number of
+// characters written, which is exactly what operator<< produces for a stream
+// with default flags, the classic locale and the given precision.  Where
+// std::to_chars() can't format floating-point numbers, printf() is used,
+// which follows LC_NUMERIC, so callers must check
+// FormatsFloatingPointLikeClassicLocale() first.
+int FormatFloatingPoint(double value, int precision, char* buffer,
+                        size_t size) {
+#ifdef __cpp_lib_to_chars
+  const std::to_chars_result result =
+      std::to_chars(buffer, buffer + size, value, std::chars_format::general,
+                    precision);
+  return static_cast<int>(result.ptr - buffer);
+#else
+  return GTEST_SNPRINTF_(buffer, size, "%.*g", precision, value);
+#endif  // __cpp_lib_to_chars
+}
+
+// Returns true if FormatFloatingPoint() writes what the classic locale
+// would, which it does unless it relies on printf() and the C locale uses
+// another decimal point.
+bool FormatsFloatingPointLikeClassicLocale() {
+#ifdef __cpp_lib_to_chars
+  return true;
+#else
+  const char* const decimal_point = localeconv()->decimal_point;
+  return decimal_point[0] == '.' && decimal_point[1] == '\0';
+#endif  // __cpp_lib_to_chars
+}
+
+// Large enough for "%.17g" of any double, e.g. "-2.2250738585072014e-308".
+constexpr size_t kMaxFloatingPointLength = 32;
+
+// What the iword() slot of ClassicLocaleSlot() says about a stream's locale.
+// A stream's slot starts as kLocaleNotChecked; once a callback that forgets
+// the answer when the locale changes is registered, it is never that again.
+enum ClassicLocaleState : long {  // NOLINT
+  kLocaleNotChecked = 0,
+  kLocaleChanged,
+  kLocaleIsClassic,
+  kLocaleIsNotClassic
+};
+
+// Returns the index of the iword() slot where a stream caches whether its
+// locale is the classic one, so that printing many numbers to a stream
+// copies and compares its locale once.
+int ClassicLocaleSlot() {
+  static const int slot = std::ios_base::xalloc();
+  return slot;
+}
+
+void ForgetClassicLocale(std::ios_base::event event, std::ios_base& stream,
+                         int slot) {
+  if (event == std::ios_base::imbue_event ||
+      event == std::ios_base::copyfmt_event) {
+    stream.iword(slot) = kLocaleChanged;
+  }
+}
+
+bool HasClassicLocale(ostream* os) {
+  const int slot = ClassicLocaleSlot();
+  long& state = os->iword(slot);  // NOLINT
+  if (state == kLocaleIsClassic || state == kLocaleIsNotClassic) {
+    return state == kLocaleIsClassic;
+  }
+  if (state == kLocaleNotChecked) {
+    os->register_callback(&ForgetClassicLocale, slot);
+  }
+  const bool is_classic = os->getloc() == std::locale::classic();
+  state = is_classic ? kLocaleIsClassic : kLocaleIsNotClassic;
+  return is_classic;
+}
+
+// Returns true if os formats numbers exactly as printf() does in the "C"
+// locale, so that they can be formatted without its num_put facet.
+bool HasDefaultNumericFormat(ostream* os) {
+  const ostream::fmtflags kFormatFlags =
+      std::ios_base::basefield | std::ios_base::floatfield |
+      std::ios_base::showbase | std::ios_base::showpoint |
+      std::ios_base::showpos | std::ios_base::uppercase;
+  return (os->flags() & kFormatFlags) == std::ios_base::dec &&
+         os->width() == 0 && HasClassicLocale(os);
+}
+
 }  // namespace
 
 namespace internal {
 
+void AppendDecimal(long long value, ::std::string* buf) {  // NOLINT
+  char buffer[kMaxDecimalLength];
+  const char* const begin = FormatDecimal(value, buffer);
+  buf->append(begin, static_cast<size_t>(buffer + kMaxDecimalLength - begin));
+}
+
+void AppendDecimal(unsigned long long value, ::std::string* buf) {  // NOLINT
+  char buffer[kMaxDecimalLength];
+  const char* const begin =
+      FormatDecimalBackwards(value, buffer + kMaxDecimalLength);
+  buf->append(begin, static_cast<size_t>(buffer + kMaxDecimalLength - begin));
+}
+
+void AppendFloatingPoint(double value, int precision, ::std::string* buf) {
+  if (!FormatsFloatingPointLikeClassicLocale()) {
+    ::std::ostringstream os;
+    os.imbue(std::locale::classic());
+    os.precision(precision);
+    os << value;
+    buf->append(os.str());
+    return;
+  }
+  char buffer[kMaxFloatingPointLength];
+  const int length =
+      FormatFloatingPoint(value, precision, buffer, sizeof(buffer));
+  buf->append(buffer, static_cast<size_t>(length));
+}
+
+bool TryPrintDecimalTo(long long value, ostream* os) {  // NOLINT
+  if (!HasDefaultNumericFormat(os)) return false;
+  char buffer[kMaxDecimalLength];
+  const char* const begin = FormatDecimal(value, buffer);
+  os->write(begin, buffer + kMaxDecimalLength - begin);
+  return true;
+}
+
+bool TryPrintDecimalTo(unsigned long long value, ostream* os) {  // NOLINT
+  if (!HasDefaultNumericFormat(os)) return false;
+  char buffer[kMaxDecimalLength];
+  const char* const begin =
+      FormatDecimalBackwards(value, buffer + kMaxDecimalLength);
+  os->write(begin, buffer + kMaxDecimalLength - begin);
+  return true;
+}
+
+void PrintFloatingPointTo(double value, int precision, ostream* os) {
+  if (!HasDefaultNumericFormat(os) ||
+      !FormatsFloatingPointLikeClassicLocale()) {
+    const std::streamsize old_precision = os->precision(precision);
+    *os << value;
+    os->precision(old_precision);
+    return;
+  }
+  char buffer[kMaxFloatingPointLength];
+  const int length =
+      FormatFloatingPoint(value, precision, buffer, sizeof(buffer));
+  os->write(buffer, length);
+}
+
 // Delegates to PrintBytesInObjectToImpl() to print the bytes in the
 // given object.  The delegation simplifies the implementation, which
 // uses the << operator and thus is easier done outside of the
@@ -144,69 +343,80 @@ enum CharFormat { kAsIs, kHexEscape, kSpecialEscape };
 // Windows Mobile.
 inline bool IsPrintableAscii(char32_t c) { return 0x20 <= c && c <= 0x7E; }
 
-// Prints c (of type char, char8_t, char16_t, char32_t, or wchar_t) as a
-// character literal without the quotes, escaping it when necessary; returns how
-// c was formatted.
+// Appends the hexadecimal digits of value, without leading zeros and in
+// upper case, to *buf.
+static void AppendHex(uint32_t value, std::string* buf) {
+  char buffer[8];
+  char* p = buffer + sizeof(buffer);
+  do {
+    *--p = "0123456789ABCDEF"[value & 0xF];
+    value >>= 4;
+  } while (value != 0);
+  buf->append(p, buffer + sizeof(buffer));
+}
+
+// Appends c (of type char, char8_t, char16_t, char32_t, or wchar_t) as a
+// character literal without the quotes, escaping it when necessary; returns
+// how c was formatted.
 template <typename Char>
-static CharFormat PrintAsCharLiteralTo(Char c, ostream* os) {
+static CharFormat AppendAsCharLiteral(Char c, std::string* buf) {
   const char32_t u_c = ToChar32(c);
   switch (u_c) {
     case L'\0':
-      *os << "\\0";
+      buf->append("\\0");
       break;
     case L'\'':
-      *os << "\\'";
+      buf->append("\\'");
       break;
     case L'\\':
-      *os << "\\\\";
+      buf->append("\\\\");
       break;
     case L'\a':
-      *os << "\\a";
+      buf->append("\\a");
       break;
     case L'\b':
-      *os << "\\b";
+      buf->append("\\b");
       break;
     case L'\f':
-      *os << "\\f";
+      buf->append("\\f");
       break;
     case L'\n':
-      *os << "\\n";
+      buf->append("\\n");
       break;
     case L'\r':
-      *os << "\\r";
+      buf->append("\\r");
       break;
     case L'\t':
-      *os << "\\t";
+      buf->append("\\t");
       break;
     case L'\v':
-      *os << "\\v";
+      buf->append("\\v");
       break;
     default:
       if (IsPrintableAscii(u_c)) {
-        *os << static_cast<char>(c);
+        buf->push_back(static_cast<char>(c));
         return kAsIs;
       } else {
-        ostream::fmtflags flags = os->flags();
-        *os << "\\x" << std::hex << std::uppercase << static_cast<int>(u_c);
-        os->flags(flags);
+        buf->append("\\x");
+        AppendHex(static_cast<uint32_t>(u_c), buf);
         return kHexEscape;
       }
   }
   return kSpecialEscape;
 }
 
-// Prints a char32_t c as if it's part of a string literal, escaping it when
+// Appends a char32_t c as if it's part of a string literal, escaping it when
 // necessary; returns how c was formatted.
-static CharFormat PrintAsStringLiteralTo(char32_t c, ostream* os) {
+static CharFormat AppendAsStringLiteral(char32_t c, std::string* buf) {
   switch (c) {
     case L'\'':
-      *os << "'";
+      buf->push_back('\'');
       return kAsIs;
     case L'"':
-      *os << "\\\"";
+      buf->append("\\\"");
       return kSpecialEscape;
     default:
-      return PrintAsCharLiteralTo(c, os);
+      return AppendAsCharLiteral(c, buf);
   }
 }
 
@@ -226,24 +436,24 @@ static const char* GetCharWidthPrefix(char32_t) { return "U"; }
 
 static const char* GetCharWidthPrefix(wchar_t) { return "L"; }
 
-// Prints a char c as if it's part of a string literal, escaping it when
+// Appends a char c as if it's part of a string literal, escaping it when
 // necessary; returns how c was formatted.
-static CharFormat PrintAsStringLiteralTo(char c, ostream* os) {
-  return PrintAsStringLiteralTo(ToChar32(c), os);
+static CharFormat AppendAsStringLiteral(char c, std::string* buf) {
+  return AppendAsStringLiteral(ToChar32(c), buf);
 }
 
 #ifdef __cpp_lib_char8_t
-static CharFormat PrintAsStringLiteralTo(char8_t c, ostream* os) {
-  return PrintAsStringLiteralTo(ToChar32(c), os);
+static CharFormat AppendAsStringLiteral(char8_t c, std::string* buf) {
+  return AppendAsStringLiteral(ToChar32(c), buf);
 }
 #endif
 
-static CharFormat PrintAsStringLiteralTo(char16_t c, ostream* os) {
-  return PrintAsStringLiteralTo(ToChar32(c), os);
+static CharFormat AppendAsStringLiteral(char16_t c, std::string* buf) {
+  return AppendAsStringLiteral(ToChar32(c), buf);
 }
 
-static CharFormat PrintAsStringLiteralTo(wchar_t c, ostream* os) {
-  return PrintAsStringLiteralTo(ToChar32(c), os);
+static CharFormat AppendAsStringLiteral(wchar_t c, std::string* buf) {
+  return AppendAsStringLiteral(ToChar32(c), buf);
 }
 
 // Prints a character c (of type char, char8_t, char16_t, char32_t, or wchar_t)
@@ -251,26 +461,32 @@ static CharFormat PrintAsStringLiteralTo(wchar_t c, ostream* os) {
 // also properly escaped using the standard C++ escape sequence.
 template <typename Char>
 void PrintCharAndCodeTo(Char c, ostream* os) {
+  std::string buf;
   // First, print c as a literal in the most readable form we can find.
-  *os << GetCharWidthPrefix(c) << "'";
-  const CharFormat format = PrintAsCharLiteralTo(c, os);
-  *os << "'";
+  buf.append(GetCharWidthPrefix(c));
+  buf.push_back('\'');
+  const CharFormat format = AppendAsCharLiteral(c, &buf);
+  buf.push_back('\'');
 
   // To aid user debugging, we also print c's code in decimal, unless
   // it's 0 (in which case c was printed as '\\0', making the code
   // obvious).
-  if (c == 0) return;
-  *os << " (" << static_cast<int>(c);
-
-  // For more convenience, we print c's code again in hexadecimal,
-  // unless c was already printed in the form '\x##' or the code is in
-  // [1, 9].
-  if (format == kHexEscape || (1 <= c && c <= 9)) {
-    // Do nothing.
-  } else {
-    *os << ", 0x" << String::FormatHexInt(static_cast<int>(c));
+  if (c != 0) {
+    buf.append(" (");
+    AppendDecimal(static_cast<long long>(static_cast<int>(c)), &buf);  // NOLINT
+
+    // For more convenience, we print c's code again in hexadecimal,
+    // unless c was already printed in the form '\x##' or the code is in
+    // [1, 9].
+    if (format == kHexEscape || (1 <= c && c <= 9)) {
+      // Do nothing.
+    } else {
+      buf.append(", 0x");
+      AppendHex(static_cast<uint32_t>(static_cast<int>(c)), &buf);
+    }
+    buf.push_back(')');
   }
-  *os << ")";
+  os->write(buf.data(), static_cast<std::streamsize>(buf.size()));
 }
 
 void PrintTo(unsigned char c, ::std::ostream* os) { PrintCharAndCodeTo(c, os); }
@@ -340,8 +556,14 @@ GTEST_ATTRIBUTE_NO_SANITIZE_MEMORY_ GTEST_ATTRIBUTE_NO_SANITIZE_ADDRESS_
     GTEST_ATTRIBUTE_NO_SANITIZE_HWADDRESS_
         GTEST_ATTRIBUTE_NO_SANITIZE_THREAD_ static CharFormat
         PrintCharsAsStringTo(const CharType* begin, size_t len, ostream* os) {
+  // The literal is escaped into a buffer and written with a single call, as
+  // streaming it one character at a time dominates the cost of printing long
+  // strings.
   const char* const quote_prefix = GetCharWidthPrefix(*begin);
-  *os << quote_prefix << "\"";
+  std::string buf;
+  buf.reserve(len + 2);
+  buf.append(quote_prefix);
+  buf.push_back('"');
   bool is_previous_hex = false;
   CharFormat print_format = kAsIs;
   for (size_t index = 0; index < len; ++index) {
@@ -350,15 +572,18 @@ GTEST_ATTRIBUTE_NO_SANITIZE_MEMORY_ GTEST_ATTRIBUTE_NO_SANITIZE_ADDRESS_
       // Previous character is of '\x..' form and this character can be
       // interpreted as another hexadecimal digit in its number. Break string to
       // disambiguate.
-      *os << "\" " << quote_prefix << "\"";
+      buf.append("\" ");
+      buf.append(quote_prefix);
+      buf.push_back('"');
     }
-    is_previous_hex = PrintAsStringLiteralTo(cur, os) == kHexEscape;
+    is_previous_hex = AppendAsStringLiteral(cur, &buf) == kHexEscape;
     // Remember if any characters required hex escaping.
     if (is_previous_hex) {
       print_format = kHexEscape;
     }
   }
-  *os << "\"";
+  buf.push_back('"');
+  os->write(buf.data(), static_cast<std::streamsize>(buf.size()));
   return print_format;
 }
 
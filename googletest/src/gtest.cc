@@ -41,12 +41,15 @@
 #include <wctype.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cmath>
 #include <csignal>  // NOLINT: raise(3) is used on some platforms
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <functional>
 #include <initializer_list>
 #include <iomanip>
 #include <ios>
@@ -58,6 +61,7 @@
 #include <ostream>  // NOLINT
 #include <set>
 #include <sstream>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -124,9 +128,31 @@
 
 #if GTEST_CAN_STREAM_RESULTS_
 #include <arpa/inet.h>   // NOLINT
+#include <fcntl.h>       // NOLINT
 #include <netdb.h>       // NOLINT
+#include <sys/mman.h>    // NOLINT
 #include <sys/socket.h>  // NOLINT
+#include <sys/stat.h>    // NOLINT
 #include <sys/types.h>   // NOLINT
+#include <sys/un.h>      // NOLINT
+#include <unistd.h>      // NOLINT
+#endif
+
+#if GTEST_CAN_ISOLATE_TESTS_
+#include <fcntl.h>     // NOLINT
+#include <sys/wait.h>  // NOLINT
+#include <unistd.h>    // NOLINT
+#endif
+
+#if GTEST_CAN_COUNT_PERF_EVENTS_
+#include <linux/perf_event.h>  // NOLINT
+#include <sys/ioctl.h>         // NOLINT
+#include <sys/syscall.h>       // NOLINT
+#include <unistd.h>            // NOLINT
+#endif
+
+#if GTEST_CAN_RECORD_RESOURCE_USAGE_
+#include <sys/resource.h>  // NOLINT
 #endif
 
 #include "src/gtest-internal-inl.h"
@@ -211,13 +237,14 @@ bool g_help_flag = false;
 
 #if GTEST_HAS_FILE_SYSTEM
 // Utility function to Open File for Writing
-static FILE* OpenFileForWriting(const std::string& output_file) {
+static FILE* OpenFileForWriting(const std::string& output_file,
+                                const char* mode = "w") {
   FILE* fileout = nullptr;
   FilePath output_file_path(output_file);
   FilePath output_dir(output_file_path.RemoveFileName());
 
   if (output_dir.CreateDirectoriesRecursively()) {
-    fileout = posix::FOpen(output_file.c_str(), "w");
+    fileout = posix::FOpen(output_file.c_str(), mode);
   }
   if (fileout == nullptr) {
     GTEST_LOG_(FATAL) << "Unable to open file \"" << output_file << "\"";
@@ -282,6 +309,13 @@ GTEST_DEFINE_string_(
     "being sent to a terminal and the TERM environment variable "
     "is set to a terminal type that supports colors.");
 
+GTEST_DEFINE_bool_(
+    failed_first, testing::internal::BoolFromGTestEnv("failed_first", false),
+    "True if and only if " GTEST_NAME_
+    " should run the tests that failed in the previous report first. The "
+    "report is the one named by --gtest_rerun_failed, or else the --gtest_output "
+    "file.");
+
 GTEST_DEFINE_string_(
     filter,
     testing::internal::StringFromGTestEnv("filter",
@@ -301,8 +335,22 @@ GTEST_DEFINE_bool_(
     "install a signal handler that dumps debugging information when fatal "
     "signals are raised.");
 
+GTEST_DEFINE_bool_(
+    isolate_tests, testing::internal::BoolFromGTestEnv("isolate_tests", false),
+    "True if and only if " GTEST_NAME_
+    " should run each test in its own child process, forked after the "
+    "environments and the test suite have been set up.");
+
 GTEST_DEFINE_bool_(list_tests, false, "List all tests without running them.");
 
+GTEST_DEFINE_string_(
+    manifest, testing::internal::StringFromGTestEnv("manifest", ""),
+    "Path to a JSON list of all the tests, in the format of "
+    "--gtest_list_tests --gtest_output=json. It is written when the test "
+    "program starts if it is missing or older than the program. A path "
+    "ending in a separator names a directory, in which the list goes to "
+    "<program name>.json.");
+
 // The net priority order after flag processing is thus:
 //   --gtest_output command line flag
 //   GTEST_OUTPUT environment variable
@@ -312,7 +360,8 @@ GTEST_DEFINE_string_(
     output,
     testing::internal::StringFromGTestEnv(
         "output", testing::internal::OutputFlagAlsoCheckEnvVar().c_str()),
-    "A format (defaults to \"xml\" but can be specified to be \"json\"), "
+    "A format (defaults to \"xml\" but can be specified to be \"json\" "
+    "or \"bin\"), "
     "optionally followed by a colon and an output file name or directory. "
     "A directory is indicated by a trailing pathname separator. "
     "Examples: \"xml:filename.xml\", \"xml::directoryname/\". "
@@ -321,6 +370,13 @@ GTEST_DEFINE_string_(
     "executable's name and, if necessary, made unique by adding "
     "digits.");
 
+GTEST_DEFINE_bool_(
+    perf_counters, testing::internal::BoolFromGTestEnv("perf_counters", false),
+    "True if and only if " GTEST_NAME_
+    " should count the instructions, cycles, cache misses, branch misses, "
+    "task clock, page faults and context switches of each test with "
+    "perf_event_open() and record them as test properties.");
+
 GTEST_DEFINE_bool_(
     brief, testing::internal::BoolFromGTestEnv("brief", false),
     "True if only test failures should be displayed in text output.");
@@ -340,11 +396,23 @@ GTEST_DEFINE_int32_(
     "Random number seed to use when shuffling test orders.  Must be in range "
     "[1, 99999], or 0 to use a seed based on the current time.");
 
+GTEST_DEFINE_bool_(
+    record_resource_usage,
+    testing::internal::BoolFromGTestEnv("record_resource_usage", false),
+    "True if and only if " GTEST_NAME_
+    " should record the CPU time, peak RSS growth, context switches and page "
+    "faults of each test in the XML and JSON reports and the test output.");
+
 GTEST_DEFINE_int32_(
     repeat, testing::internal::Int32FromGTestEnv("repeat", 1),
     "How many times to repeat each test.  Specify a negative number "
     "for repeating forever.  Useful for shaking out flaky tests.");
 
+GTEST_DEFINE_string_(
+    rerun_failed, testing::internal::StringFromGTestEnv("rerun_failed", ""),
+    "Path to an XML or JSON report written by an earlier run. Only the tests "
+    "that failed in it are run, unless --gtest_failed_first is given too.");
+
 GTEST_DEFINE_bool_(
     recreate_environments_when_repeating,
     testing::internal::BoolFromGTestEnv("recreate_environments_when_repeating",
@@ -357,6 +425,12 @@ GTEST_DEFINE_bool_(
     "there is no last run, the environments will always be recreated to avoid "
     "leaks.");
 
+GTEST_DEFINE_bool_(
+    run_benchmarks, testing::internal::BoolFromGTestEnv("run_benchmarks", false),
+    "True if and only if " GTEST_NAME_
+    " should run the benchmarks defined with BENCHMARK_TEST() along with the "
+    "tests.");
+
 GTEST_DEFINE_bool_(show_internal_stack_frames, false,
                    "True if and only if " GTEST_NAME_
                    " should include internal stack frames when "
@@ -374,12 +448,20 @@ GTEST_DEFINE_int32_(
     "The maximum number of stack frames to print when an "
     "assertion fails.  The valid range is 0 through 100, inclusive.");
 
+GTEST_DEFINE_int32_(
+    test_timeout_ms, testing::internal::Int32FromGTestEnv("test_timeout_ms", 0),
+    "How many milliseconds each test may run before it is reported as timed "
+    "out and the test program is aborted, or 0 for no limit.  With "
+    "--gtest_isolate_tests, only the test's child process is aborted.");
+
 GTEST_DEFINE_string_(
     stream_result_to,
     testing::internal::StringFromGTestEnv("stream_result_to", ""),
     "This flag specifies the host name and the port number on which to stream "
-    "test results. Example: \"localhost:555\". The flag is effective only on "
-    "Linux.");
+    "test results. Example: \"localhost:555\". It can instead be \"unix:\" "
+    "followed by the path of a Unix domain socket, or \"shm:\" followed by "
+    "the path of a shared memory ring, to stream the results in the "
+    "--gtest_output=bin format. The flag is effective only on Linux.");
 
 GTEST_DEFINE_bool_(
     throw_on_failure,
@@ -1387,6 +1469,235 @@ std::vector<EditType> CalculateOptimalEdits(const std::vector<size_t>& left,
 
 namespace {
 
+// Computes a shortest edit script with Myers' O(ND) difference algorithm,
+// using the linear-space "middle snake" refinement so that memory stays
+// proportional to the input size.  Sub-problems whose edit distance exceeds
+// max_cost are split at a heuristic point instead of searching further; the
+// script is still valid but may no longer be minimal.
+// See E. Myers, "An O(ND) Difference Algorithm and Its Variations" (1986).
+class MyersDiff {
+ public:
+  MyersDiff(const std::vector<size_t>& left, const std::vector<size_t>& right,
+            size_t max_cost)
+      : left_(left),
+        right_(right),
+        max_cost_(static_cast<ptrdiff_t>(max_cost)),
+        diag_offset_(static_cast<ptrdiff_t>(right.size()) + 1),
+        forward_(left.size() + right.size() + 3),
+        backward_(left.size() + right.size() + 3),
+        removed_(left.size()),
+        added_(right.size()) {}
+
+  std::vector<EditType> Run() {
+    Compare(0, static_cast<ptrdiff_t>(left_.size()), 0,
+            static_cast<ptrdiff_t>(right_.size()));
+
+    // Within a run of changes all removes are emitted before all adds, which
+    // is also how Hunk groups them.
+    std::vector<EditType> edits;
+    edits.reserve(left_.size() + right_.size());
+    for (size_t l_i = 0, r_i = 0; l_i < left_.size() || r_i < right_.size();) {
+      if (l_i < left_.size() && removed_[l_i]) {
+        edits.push_back(kRemove);
+        ++l_i;
+      } else if (r_i < right_.size() && added_[r_i]) {
+        edits.push_back(kAdd);
+        ++r_i;
+      } else {
+        edits.push_back(kMatch);
+        ++l_i;
+        ++r_i;
+      }
+    }
+    return edits;
+  }
+
+ private:
+  // Marks the changed elements of left_[l_begin, l_end) and
+  // right_[r_begin, r_end).
+  void Compare(ptrdiff_t l_begin, ptrdiff_t l_end, ptrdiff_t r_begin,
+               ptrdiff_t r_end) {
+    // Common prefixes and suffixes never take part in an edit.
+    while (l_begin < l_end && r_begin < r_end &&
+           Left(l_begin) == Right(r_begin)) {
+      ++l_begin;
+      ++r_begin;
+    }
+    while (l_begin < l_end && r_begin < r_end &&
+           Left(l_end - 1) == Right(r_end - 1)) {
+      --l_end;
+      --r_end;
+    }
+
+    if (l_begin == l_end) {
+      for (ptrdiff_t r_i = r_begin; r_i < r_end; ++r_i) {
+        added_[static_cast<size_t>(r_i)] = true;
+      }
+    } else if (r_begin == r_end) {
+      for (ptrdiff_t l_i = l_begin; l_i < l_end; ++l_i) {
+        removed_[static_cast<size_t>(l_i)] = true;
+      }
+    } else {
+      ptrdiff_t l_mid, r_mid;
+      FindSplit(l_begin, l_end, r_begin, r_end, &l_mid, &r_mid);
+      Compare(l_begin, l_mid, r_begin, r_mid);
+      Compare(l_mid, l_end, r_mid, r_end);
+    }
+  }
+
+  // Finds a point (l_mid, r_mid) on an optimal (or, once max_cost_ is
+  // exceeded, a good) edit path through the given sub-problem by searching
+  // forward from the top-left and backward from the bottom-right corner
+  // simultaneously.  Diagonal k holds the points with l - r == k.  Both
+  // sequences must be non-empty and must not share a prefix or suffix.
+  void FindSplit(ptrdiff_t l_begin, ptrdiff_t l_end, ptrdiff_t r_begin,
+                 ptrdiff_t r_end, ptrdiff_t* l_mid, ptrdiff_t* r_mid) {
+    const ptrdiff_t k_min = l_begin - r_end;
+    const ptrdiff_t k_max = l_end - r_begin;
+    const ptrdiff_t f_mid = l_begin - r_begin;
+    const ptrdiff_t b_mid = l_end - r_end;
+    const bool odd = ((f_mid - b_mid) & 1) != 0;
+    ptrdiff_t f_min = f_mid, f_max = f_mid;
+    ptrdiff_t b_min = b_mid, b_max = b_mid;
+    Forward(f_mid) = l_begin;
+    Backward(b_mid) = l_end;
+
+    for (ptrdiff_t cost = 1;; ++cost) {
+      // Extend the forward search by one edit.
+      if (f_min > k_min) {
+        Forward(--f_min - 1) = -1;
+      } else {
+        ++f_min;
+      }
+      if (f_max < k_max) {
+        Forward(++f_max + 1) = -1;
+      } else {
+        --f_max;
+      }
+      for (ptrdiff_t k = f_max; k >= f_min; k -= 2) {
+        const ptrdiff_t from_above = Forward(k - 1);
+        const ptrdiff_t from_left = Forward(k + 1);
+        ptrdiff_t l = from_above >= from_left ? from_above + 1 : from_left;
+        ptrdiff_t r = l - k;
+        while (l < l_end && r < r_end && Left(l) == Right(r)) {
+          ++l;
+          ++r;
+        }
+        Forward(k) = l;
+        if (odd && b_min <= k && k <= b_max && Backward(k) <= l) {
+          *l_mid = l;
+          *r_mid = r;
+          return;
+        }
+      }
+
+      // Extend the backward search by one edit.
+      if (b_min > k_min) {
+        Backward(--b_min - 1) = std::numeric_limits<ptrdiff_t>::max();
+      } else {
+        ++b_min;
+      }
+      if (b_max < k_max) {
+        Backward(++b_max + 1) = std::numeric_limits<ptrdiff_t>::max();
+      } else {
+        --b_max;
+      }
+      for (ptrdiff_t k = b_max; k >= b_min; k -= 2) {
+        const ptrdiff_t from_below = Backward(k - 1);
+        const ptrdiff_t from_right = Backward(k + 1);
+        ptrdiff_t l = from_below < from_right ? from_below : from_right - 1;
+        ptrdiff_t r = l - k;
+        while (l > l_begin && r > r_begin && Left(l - 1) == Right(r - 1)) {
+          --l;
+          --r;
+        }
+        Backward(k) = l;
+        if (!odd && f_min <= k && k <= f_max && l <= Forward(k)) {
+          *l_mid = l;
+          *r_mid = r;
+          return;
+        }
+      }
+
+      if (cost >= max_cost_) {
+        // Too expensive: give up on minimality and split at whichever of
+        // the two searches has made the most progress towards the other end.
+        ptrdiff_t f_best_sum = -1, f_best_l = 0;
+        for (ptrdiff_t k = f_max; k >= f_min; k -= 2) {
+          ptrdiff_t l = std::min(Forward(k), l_end);
+          ptrdiff_t r = l - k;
+          if (r > r_end) {
+            l = r_end + k;
+            r = r_end;
+          }
+          if (l + r > f_best_sum) {
+            f_best_sum = l + r;
+            f_best_l = l;
+          }
+        }
+        ptrdiff_t b_best_sum = std::numeric_limits<ptrdiff_t>::max();
+        ptrdiff_t b_best_l = 0;
+        for (ptrdiff_t k = b_max; k >= b_min; k -= 2) {
+          ptrdiff_t l = std::max(Backward(k), l_begin);
+          ptrdiff_t r = l - k;
+          if (r < r_begin) {
+            l = r_begin + k;
+            r = r_begin;
+          }
+          if (l + r < b_best_sum) {
+            b_best_sum = l + r;
+            b_best_l = l;
+          }
+        }
+        if ((l_end + r_end) - b_best_sum < f_best_sum - (l_begin + r_begin)) {
+          *l_mid = f_best_l;
+          *r_mid = f_best_sum - f_best_l;
+        } else {
+          *l_mid = b_best_l;
+          *r_mid = b_best_sum - b_best_l;
+        }
+        return;
+      }
+    }
+  }
+
+  size_t Left(ptrdiff_t i) const { return left_[static_cast<size_t>(i)]; }
+  size_t Right(ptrdiff_t i) const { return right_[static_cast<size_t>(i)]; }
+  ptrdiff_t& Forward(ptrdiff_t k) {
+    return forward_[static_cast<size_t>(k + diag_offset_)];
+  }
+  ptrdiff_t& Backward(ptrdiff_t k) {
+    return backward_[static_cast<size_t>(k + diag_offset_)];
+  }
+
+  const std::vector<size_t>& left_;
+  const std::vector<size_t>& right_;
+  const ptrdiff_t max_cost_;
+  const ptrdiff_t diag_offset_;
+  // Furthest reaching left index on each diagonal, for each search.
+  std::vector<ptrdiff_t> forward_, backward_;
+  std::vector<bool> removed_, added_;
+};
+
+}  // namespace
+
+std::vector<EditType> CalculateMyersEdits(const std::vector<size_t>& left,
+                                          const std::vector<size_t>& right,
+                                          size_t max_cost) {
+  if (max_cost == 0) {
+    // Roughly the square root of the input size, but never so small that
+    // typical assertion failures lose their minimal diff.
+    max_cost = 1;
+    for (size_t n = left.size() + right.size() + 3; n != 0; n >>= 2) {
+      max_cost <<= 1;
+    }
+    max_cost = std::max(max_cost, static_cast<size_t>(256));
+  }
+  return MyersDiff(left, right, max_cost).Run();
+}
+
+namespace {
+
 // Helper class to convert string into ids with deduplication.
 class InternalStrings {
  public:
@@ -1402,24 +1713,41 @@ class InternalStrings {
   IdMap ids_;
 };
 
+// Converts both line sequences into ids, so that lines can be compared
+// cheaply.
+void InternLines(const std::vector<std::string>& left,
+                 const std::vector<std::string>& right,
+                 std::vector<size_t>* left_ids,
+                 std::vector<size_t>* right_ids) {
+  InternalStrings intern_table;
+  left_ids->reserve(left.size());
+  for (size_t i = 0; i < left.size(); ++i) {
+    left_ids->push_back(intern_table.GetId(left[i]));
+  }
+  right_ids->reserve(right.size());
+  for (size_t i = 0; i < right.size(); ++i) {
+    right_ids->push_back(intern_table.GetId(right[i]));
+  }
+}
+
 }  // namespace
 
 std::vector<EditType> CalculateOptimalEdits(
     const std::vector<std::string>& left,
     const std::vector<std::string>& right) {
   std::vector<size_t> left_ids, right_ids;
-  {
-    InternalStrings intern_table;
-    for (size_t i = 0; i < left.size(); ++i) {
-      left_ids.push_back(intern_table.GetId(left[i]));
-    }
-    for (size_t i = 0; i < right.size(); ++i) {
-      right_ids.push_back(intern_table.GetId(right[i]));
-    }
-  }
+  InternLines(left, right, &left_ids, &right_ids);
   return CalculateOptimalEdits(left_ids, right_ids);
 }
 
+std::vector<EditType> CalculateMyersEdits(const std::vector<std::string>& left,
+                                          const std::vector<std::string>& right,
+                                          size_t max_cost) {
+  std::vector<size_t> left_ids, right_ids;
+  InternLines(left, right, &left_ids, &right_ids);
+  return CalculateMyersEdits(left_ids, right_ids, max_cost);
+}
+
 namespace {
 
 // Helper class that holds the state for one hunk and prints it out to the
@@ -1506,7 +1834,13 @@ class Hunk {
 std::string CreateUnifiedDiff(const std::vector<std::string>& left,
                               const std::vector<std::string>& right,
                               size_t context) {
-  const std::vector<EditType> edits = CalculateOptimalEdits(left, right);
+  // Small inputs keep the historical Wagner-Fischer output; past that its
+  // quadratic cost matrix gets prohibitive and Myers takes over.
+  const size_t kMaxOptimalEditsCells = 1 << 16;
+  const std::vector<EditType> edits =
+      (left.size() + 1) * (right.size() + 1) <= kMaxOptimalEditsCells
+          ? CalculateOptimalEdits(left, right)
+          : CalculateMyersEdits(left, right);
 
   size_t l_i = 0, r_i = 0, edit_i = 0;
   std::stringstream ss;
@@ -1697,6 +2031,41 @@ AssertionResult DoubleNearPredFormat(const char* expr1, const char* expr2,
          << abs_error_expr << " evaluates to " << abs_error << ".";
 }
 
+bool BytesAreEqual(const void* lhs, const void* rhs, size_t size) {
+  return size == 0 || std::memcmp(lhs, rhs, size) == 0;
+}
+
+// Builds the failure for {ASSERT|EXPECT}_RANGE_* on ranges of different
+// sizes.
+AssertionResult RangeSizeFailure(const char* lhs_expression,
+                                 const char* rhs_expression, size_t lhs_size,
+                                 size_t rhs_size) {
+  return AssertionFailure()
+         << "Expected ranges of the same size:\n  " << lhs_expression
+         << "\n    Which has " << lhs_size << " elements\n  "
+         << rhs_expression << "\n    Which has " << rhs_size << " elements";
+}
+
+// Builds the failure for {ASSERT|EXPECT}_RANGE_* on ranges with mismatching
+// elements.
+AssertionResult RangeMismatchFailure(const char* summary,
+                                     const char* lhs_expression,
+                                     const char* rhs_expression, size_t size,
+                                     size_t mismatches,
+                                     const std::string& details) {
+  Message msg;
+  msg << summary << "\n  " << lhs_expression << "\n  " << rhs_expression
+      << "\n"
+      << mismatches << " of " << size << " elements differ";
+  if (mismatches > kMaxRangeMismatchesToPrint) {
+    msg << ", the first " << kMaxRangeMismatchesToPrint << " being:";
+  } else {
+    msg << ":";
+  }
+  msg << details;
+  return AssertionFailure() << msg;
+}
+
 // Helper template for implementing FloatLE() and DoubleLE().
 template <typename RawType>
 AssertionResult FloatingPointLE(const char* expr1, const char* expr2,
@@ -2306,10 +2675,10 @@ void TestResult::AddTestPartResult(const TestPartResult& test_part_result) {
 // Adds a test property to the list. If a property with the same key as the
 // supplied property is already represented, the value of this test_property
 // replaces the old value for that key.
-void TestResult::RecordProperty(const std::string& xml_element,
+bool TestResult::RecordProperty(const std::string& xml_element,
                                 const TestProperty& test_property) {
   if (!ValidateTestProperty(xml_element, test_property)) {
-    return;
+    return false;
   }
   internal::MutexLock lock(&test_properties_mutex_);
   const std::vector<TestProperty>::iterator property_with_matching_key =
@@ -2317,9 +2686,10 @@ void TestResult::RecordProperty(const std::string& xml_element,
                    internal::TestPropertyKeyIs(test_property.key()));
   if (property_with_matching_key == test_properties_.end()) {
     test_properties_.push_back(test_property);
-    return;
+    return true;
   }
   property_with_matching_key->SetValue(test_property.value());
+  return true;
 }
 
 // The list of reserved attributes used in the <testsuites> element of XML
@@ -2342,8 +2712,33 @@ static const char* const kReservedTestCaseAttributes[] = {
 // Use a slightly different set for allowed output to ensure existing tests can
 // still RecordProperty("result") or "RecordProperty(timestamp")
 static const char* const kReservedOutputTestCaseAttributes[] = {
-    "classname",   "name", "status", "time",   "type_param",
-    "value_param", "file", "line",   "result", "timestamp"};
+    "classname",
+    "name",
+    "status",
+    "time",
+    "type_param",
+    "value_param",
+    "file",
+    "line",
+    "result",
+    "timestamp",
+    "user_time_us",
+    "system_time_us",
+    "peak_rss_delta_kb",
+    "voluntary_context_switches",
+    "involuntary_context_switches",
+    "minor_page_faults",
+    "major_page_faults",
+    "allocations",
+    "allocated_bytes",
+    "benchmark_samples",
+    "benchmark_iterations_per_sample",
+    "benchmark_min_ns",
+    "benchmark_median_ns",
+    "benchmark_mad_ns",
+    "benchmark_p90_ns",
+    "benchmark_p99_ns",
+    "benchmark_max_ns"};
 
 template <size_t kSize>
 std::vector<std::string> ArrayAsVector(const char* const (&array)[kSize]) {
@@ -2365,7 +2760,50 @@ static std::vector<std::string> GetReservedAttributesForElement(
   return std::vector<std::string>();
 }
 
+// Formats a benchmark time in nanoseconds.
+static std::string FormatBenchmarkNs(double ns) {
+  ::std::stringstream ss;
+  ss << std::fixed << std::setprecision(3) << ns;
+  return ss.str();
+}
+
 #if GTEST_HAS_FILE_SYSTEM
+// Returns the counts of a benchmark under the names they have in the XML and
+// JSON reports.
+static std::vector<std::pair<const char*, int64_t>> BenchmarkCountFields(
+    const BenchmarkResult& result) {
+  return {{"benchmark_samples", result.samples},
+          {"benchmark_iterations_per_sample", result.iterations_per_sample}};
+}
+
+// Returns the times of a benchmark under the names they have in the XML and
+// JSON reports.
+static std::vector<std::pair<const char*, std::string>> BenchmarkTimeFields(
+    const BenchmarkResult& result) {
+  return {
+      {"benchmark_min_ns", FormatBenchmarkNs(result.min_ns)},
+      {"benchmark_median_ns", FormatBenchmarkNs(result.median_ns)},
+      {"benchmark_mad_ns", FormatBenchmarkNs(result.mad_ns)},
+      {"benchmark_p90_ns", FormatBenchmarkNs(result.p90_ns)},
+      {"benchmark_p99_ns", FormatBenchmarkNs(result.p99_ns)},
+      {"benchmark_max_ns", FormatBenchmarkNs(result.max_ns)}};
+}
+
+// Returns the fields of usage under the names they have in the XML and JSON
+// reports.
+static std::vector<std::pair<const char*, int64_t>> ResourceUsageFields(
+    const TestResourceUsage& usage) {
+  return {{"user_time_us", usage.user_time_us},
+          {"system_time_us", usage.system_time_us},
+          {"peak_rss_delta_kb", usage.peak_rss_delta_kb},
+          {"voluntary_context_switches", usage.voluntary_context_switches},
+          {"involuntary_context_switches", usage.involuntary_context_switches},
+          {"minor_page_faults", usage.minor_page_faults},
+          {"major_page_faults", usage.major_page_faults},
+          {"allocations", usage.allocations},
+          {"allocated_bytes", usage.allocated_bytes}};
+}
+
 // TODO(jdesprez): Merge the two getReserved attributes once skip is improved
 // This function is only used when file systems are enabled.
 static std::vector<std::string> GetReservedOutputAttributesForElement(
@@ -2425,6 +2863,8 @@ void TestResult::Clear() {
   test_properties_.clear();
   death_test_count_ = 0;
   elapsed_time_ = 0;
+  resource_usage_ = TestResourceUsage();
+  benchmark_result_ = BenchmarkResult();
 }
 
 // Returns true off the test part was skipped.
@@ -2503,6 +2943,16 @@ void Test::RecordProperty(const std::string& key, const std::string& value) {
   UnitTest::GetInstance()->RecordProperty(key, value);
 }
 
+void Test::SetTestTimeoutMs(int timeout_ms) {
+#ifdef GTEST_IS_THREADSAFE
+  internal::TestWatchdog* const watchdog =
+      internal::GetUnitTestImpl()->test_watchdog();
+  if (watchdog != nullptr) watchdog->SetTimeoutMs(timeout_ms);
+#else
+  static_cast<void>(timeout_ms);
+#endif  // GTEST_IS_THREADSAFE
+}
+
 namespace internal {
 
 void ReportFailureInUnknownLocation(TestPartResult::Type result_type,
@@ -2721,11 +3171,13 @@ void Test::Run() {
 
 // Returns true if and only if the current test has a fatal failure.
 bool Test::HasFatalFailure() {
+  internal::TestResultsLock lock;
   return internal::GetUnitTestImpl()->current_test_result()->HasFatalFailure();
 }
 
 // Returns true if and only if the current test has a non-fatal failure.
 bool Test::HasNonfatalFailure() {
+  internal::TestResultsLock lock;
   return internal::GetUnitTestImpl()
       ->current_test_result()
       ->HasNonfatalFailure();
@@ -2733,6 +3185,7 @@ bool Test::HasNonfatalFailure() {
 
 // Returns true if and only if the current test was skipped.
 bool Test::IsSkipped() {
+  internal::TestResultsLock lock;
   return internal::GetUnitTestImpl()->current_test_result()->Skipped();
 }
 
@@ -2757,6 +3210,7 @@ TestInfo::TestInfo(const std::string& a_test_suite_name,
       is_disabled_(false),
       matches_filter_(false),
       is_in_another_shard_(false),
+      is_benchmark_(false),
       factory_(factory),
       result_() {}
 
@@ -2795,6 +3249,130 @@ TestInfo* MakeAndRegisterTestInfo(
   return test_info;
 }
 
+SetUpTearDownSuiteFuncType ResolveSuiteApiFunc(
+    SetUpTearDownSuiteFuncType test_case_fp,
+    SetUpTearDownSuiteFuncType test_suite_fp, const char* message,
+    const char* filename, int line_num) {
+  GTEST_CHECK_(!test_case_fp || !test_suite_fp)
+      << message << filename << ":" << line_num;
+  return test_case_fp != nullptr ? test_case_fp : test_suite_fp;
+}
+
+TestInfo* RegisterTypedTestInfo(
+    const char* prefix, const char* case_name, const std::string& type_name,
+    const char* test_names, const std::string& type_param,
+    CodeLocation code_location, TypeId fixture_class_id,
+    SetUpTestSuiteFunc set_up_tc, TearDownTestSuiteFunc tear_down_tc,
+    TestFactoryBase* factory) {
+  return MakeAndRegisterTestInfo(
+      (std::string(prefix) + (prefix[0] == '\0' ? "" : "/") + case_name + "/" +
+       type_name)
+          .c_str(),
+      StripTrailingSpaces(GetPrefixUntilComma(test_names)).c_str(),
+      type_param.c_str(),
+      nullptr,  // No value parameter.
+      std::move(code_location), fixture_class_id, set_up_tc, tear_down_tc,
+      factory);
+}
+
+TestInfo* MarkAsBenchmark(TestInfo* test_info) {
+  test_info->is_benchmark_ = true;
+  return test_info;
+}
+
+// How long a benchmark warms up for, at least, in nanoseconds.
+static const int64_t kBenchmarkWarmUpNs = 50 * 1000 * 1000;
+// How long a timed run of iterations must take, at least, in nanoseconds.
+static const int64_t kBenchmarkMinSampleNs = 1000 * 1000;
+// How long a benchmark takes samples for, unless it needs longer to take
+// kBenchmarkMinSamples, in nanoseconds.
+static const int64_t kBenchmarkSamplingNs = 250 * 1000 * 1000;
+static const size_t kBenchmarkMinSamples = 10;
+static const size_t kBenchmarkMaxSamples = 1000;
+// Stops the number of iterations growing when the body takes no time at all.
+static const int64_t kBenchmarkMaxIterations = int64_t{1} << 30;
+
+// Runs the body of a benchmark the given number of times, and returns how
+// long that took in nanoseconds.
+static int64_t TimeBenchmarkIterations(
+    void (*run_iterations)(void* test, int64_t iterations), void* test,
+    int64_t iterations) {
+  const auto start = std::chrono::steady_clock::now();
+  run_iterations(test, iterations);
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Returns the given quantile of the sorted values, interpolating between
+// neighbouring values.
+static double Quantile(const std::vector<double>& sorted, double quantile) {
+  const double position = quantile * static_cast<double>(sorted.size() - 1);
+  const size_t below = static_cast<size_t>(position);
+  if (below + 1 >= sorted.size()) return sorted.back();
+  const double fraction = position - static_cast<double>(below);
+  return sorted[below] + fraction * (sorted[below + 1] - sorted[below]);
+}
+
+void RunBenchmark(void (*run_iterations)(void* test, int64_t iterations),
+                  void* test) {
+  // A failing EXPECT_*() would otherwise be reported again on every
+  // iteration.
+  const auto stopped = [] { return Test::HasFailure() || Test::IsSkipped(); };
+
+  // Warms up, meanwhile growing the number of iterations until running them
+  // takes long enough to time.
+  int64_t iterations = 1;
+  const auto warm_up_end = std::chrono::steady_clock::now() +
+                           std::chrono::nanoseconds(kBenchmarkWarmUpNs);
+  for (;;) {
+    const int64_t elapsed_ns =
+        TimeBenchmarkIterations(run_iterations, test, iterations);
+    if (stopped()) return;
+    if (elapsed_ns < kBenchmarkMinSampleNs &&
+        iterations < kBenchmarkMaxIterations) {
+      iterations *= elapsed_ns < kBenchmarkMinSampleNs / 10 ? 10 : 2;
+    } else if (std::chrono::steady_clock::now() >= warm_up_end) {
+      break;
+    }
+  }
+
+  std::vector<double> samples_ns;
+  const auto sampling_end = std::chrono::steady_clock::now() +
+                            std::chrono::nanoseconds(kBenchmarkSamplingNs);
+  while (samples_ns.size() < kBenchmarkMinSamples ||
+         (samples_ns.size() < kBenchmarkMaxSamples &&
+          std::chrono::steady_clock::now() < sampling_end)) {
+    const int64_t elapsed_ns =
+        TimeBenchmarkIterations(run_iterations, test, iterations);
+    if (stopped()) return;
+    samples_ns.push_back(static_cast<double>(elapsed_ns) /
+                         static_cast<double>(iterations));
+  }
+
+  std::sort(samples_ns.begin(), samples_ns.end());
+  BenchmarkResult result;
+  result.samples = static_cast<int64_t>(samples_ns.size());
+  result.iterations_per_sample = iterations;
+  result.min_ns = samples_ns.front();
+  result.median_ns = Quantile(samples_ns, 0.5);
+  result.p90_ns = Quantile(samples_ns, 0.9);
+  result.p99_ns = Quantile(samples_ns, 0.99);
+  result.max_ns = samples_ns.back();
+
+  std::vector<double> deviations_ns;
+  for (double sample_ns : samples_ns) {
+    deviations_ns.push_back(std::fabs(sample_ns - result.median_ns));
+  }
+  std::sort(deviations_ns.begin(), deviations_ns.end());
+  result.mad_ns = Quantile(deviations_ns, 0.5);
+
+  TestResultAccessor::set_benchmark_result(
+      GetUnitTestImpl()->current_test_result(), result);
+}
+
+void UseCharPointer(const volatile char* /* p */) {}
+
 void ReportInvalidTestSuiteType(const char* test_suite_name,
                                 CodeLocation code_location) {
   Message errors;
@@ -2826,119 +3404,620 @@ void UnitTestImpl::RegisterParameterizedTests() {
 
 }  // namespace internal
 
-// Creates the test object, runs it, records its result, and then
-// deletes it.
-void TestInfo::Run() {
-  TestEventListener* repeater = UnitTest::GetInstance()->listeners().repeater();
-  if (!should_run_) {
-    if (is_disabled_ && matches_filter_) repeater->OnTestDisabled(*this);
-    return;
-  }
+#if GTEST_CAN_ISOLATE_TESTS_
+namespace internal {
 
-  // Tells UnitTest where to store test result.
-  internal::UnitTestImpl* const impl = internal::GetUnitTestImpl();
-  impl->set_current_test_info(this);
+// Runs tests in forked child processes for --gtest_isolate_tests.  The child
+// sends its test part results and properties back through a pipe as records
+// tagged with one of these bytes, and ends with kIsolatedEnd once the test
+// has finished.  Anything short of kIsolatedEnd means the child died.
+static const char kIsolatedPart = 'P';
+static const char kIsolatedProperty = 'R';
+static const char kIsolatedResourceUsage = 'U';
+static const char kIsolatedBenchmark = 'B';
+static const char kIsolatedEnd = 'E';
 
-  // Notifies the unit test event listeners that a test is about to start.
-  repeater->OnTestStart(*this);
-  result_.set_start_timestamp(internal::GetTimeInMillis());
-  internal::Timer timer;
-  impl->os_stack_trace_getter()->UponLeavingGTest();
+template <typename T>
+static void AppendIsolatedValue(T value, std::string* record) {
+  record->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
 
-  // Creates the test object.
-  Test* const test = internal::HandleExceptionsInMethodIfSupported(
-      factory_, &internal::TestFactoryBase::CreateTest,
-      "the test fixture's constructor");
+static void AppendIsolatedString(const char* str, std::string* record) {
+  const std::string value = str == nullptr ? "" : str;
+  AppendIsolatedValue(static_cast<int32_t>(value.size()), record);
+  record->append(value);
+}
 
-  // Runs the test if the constructor didn't generate a fatal failure or invoke
-  // GTEST_SKIP().
-  // Note that the object will not be null
-  if (!Test::HasFatalFailure() && !Test::IsSkipped()) {
-    // This doesn't throw as all user code that can throw are wrapped into
-    // exception handling code.
-    test->Run();
+static void WriteIsolatedRecord(int fd, const std::string& record) {
+  for (size_t written = 0; written < record.size();) {
+    const int n =
+        posix::Write(fd, record.data() + written,
+                     static_cast<unsigned int>(record.size() - written));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return;  // The parent has gone away; nothing left to do.
+    written += static_cast<size_t>(n);
   }
+}
 
-  if (test != nullptr) {
-    // Deletes the test object.
-    impl->os_stack_trace_getter()->UponLeavingGTest();
-    internal::HandleExceptionsInMethodIfSupported(
-        test, &Test::DeleteSelf_, "the test fixture's destructor");
+// Forwards the results reported and the properties recorded in the child to
+// the parent as they happen, so that they are not lost if the test crashes
+// later on.
+class IsolatedResultWriter : public TestPartResultReporterInterface {
+ public:
+  IsolatedResultWriter(int fd, TestPartResultReporterInterface* next)
+      : fd_(fd), next_(next) {}
+
+  void ReportTestPartResult(const TestPartResult& result) override {
+    std::string record(1, kIsolatedPart);
+    AppendIsolatedValue(static_cast<int32_t>(result.type()), &record);
+    AppendIsolatedValue(result.line_number(), &record);
+    AppendIsolatedString(result.file_name(), &record);
+    AppendIsolatedString(result.message(), &record);
+    {
+      MutexLock lock(&mutex_);
+      WriteIsolatedRecord(fd_, record);
+    }
+    next_->ReportTestPartResult(result);
   }
 
-  result_.set_elapsed_time(timer.Elapsed());
+  void WriteProperty(const TestProperty& property) {
+    std::string record(1, kIsolatedProperty);
+    AppendIsolatedString(property.key(), &record);
+    AppendIsolatedString(property.value(), &record);
+    MutexLock lock(&mutex_);
+    WriteIsolatedRecord(fd_, record);
+  }
+
+  void WriteResourceUsage(const TestResourceUsage& usage) {
+    std::string record(1, kIsolatedResourceUsage);
+    AppendIsolatedValue(usage.user_time_us, &record);
+    AppendIsolatedValue(usage.system_time_us, &record);
+    AppendIsolatedValue(usage.peak_rss_delta_kb, &record);
+    AppendIsolatedValue(usage.voluntary_context_switches, &record);
+    AppendIsolatedValue(usage.involuntary_context_switches, &record);
+    AppendIsolatedValue(usage.minor_page_faults, &record);
+    AppendIsolatedValue(usage.major_page_faults, &record);
+    AppendIsolatedValue(usage.allocations, &record);
+    AppendIsolatedValue(usage.allocated_bytes, &record);
+    MutexLock lock(&mutex_);
+    WriteIsolatedRecord(fd_, record);
+  }
+
+  void WriteBenchmarkResult(const BenchmarkResult& result) {
+    std::string record(1, kIsolatedBenchmark);
+    AppendIsolatedValue(result.samples, &record);
+    AppendIsolatedValue(result.iterations_per_sample, &record);
+    AppendIsolatedValue(result.min_ns, &record);
+    AppendIsolatedValue(result.median_ns, &record);
+    AppendIsolatedValue(result.mad_ns, &record);
+    AppendIsolatedValue(result.p90_ns, &record);
+    AppendIsolatedValue(result.p99_ns, &record);
+    AppendIsolatedValue(result.max_ns, &record);
+    MutexLock lock(&mutex_);
+    WriteIsolatedRecord(fd_, record);
+  }
 
-  // Notifies the unit test event listener that a test has just finished.
-  repeater->OnTestEnd(*this);
+  void WriteEnd() {
+    MutexLock lock(&mutex_);
+    WriteIsolatedRecord(fd_, std::string(1, kIsolatedEnd));
+  }
 
-  // Tells UnitTest to stop associating assertion results to this
-  // test.
-  impl->set_current_test_info(nullptr);
+ private:
+  const int fd_;
+  TestPartResultReporterInterface* const next_;
+  Mutex mutex_;  // Keeps records from different threads whole.
+};
+
+// Reads the records sent by the child and reports them as if the test had
+// run in this process.  Returns true if and only if the child got as far as
+// kIsolatedEnd.
+static bool ReplayIsolatedResult(const std::string& data) {
+  UnitTestImpl* const impl = GetUnitTestImpl();
+  size_t pos = 0;
+  const auto read_value = [&](auto* value) {
+    if (data.size() - pos < sizeof(*value)) return false;
+    memcpy(value, data.data() + pos, sizeof(*value));
+    pos += sizeof(*value);
+    return true;
+  };
+  const auto read_string = [&](std::string* value) {
+    int32_t size = 0;
+    if (!read_value(&size) || size < 0 ||
+        data.size() - pos < static_cast<size_t>(size)) {
+      return false;
+    }
+    value->assign(data, pos, static_cast<size_t>(size));
+    pos += static_cast<size_t>(size);
+    return true;
+  };
+
+  while (pos < data.size()) {
+    const char tag = data[pos++];
+    if (tag == kIsolatedEnd) return true;
+    if (tag == kIsolatedPart) {
+      int32_t type = 0;
+      int32_t line = 0;
+      std::string file;
+      std::string message;
+      if (!read_value(&type) || !read_value(&line) || !read_string(&file) ||
+          !read_string(&message)) {
+        return false;
+      }
+      impl->GetTestPartResultReporterForCurrentThread()->ReportTestPartResult(
+          TestPartResult(static_cast<TestPartResult::Type>(type),
+                         file.empty() ? nullptr : file.c_str(), line,
+                         message.c_str()));
+    } else if (tag == kIsolatedProperty) {
+      std::string key;
+      std::string value;
+      if (!read_string(&key) || !read_string(&value)) return false;
+      impl->RecordProperty(TestProperty(key, value));
+    } else if (tag == kIsolatedResourceUsage) {
+      TestResourceUsage usage;
+      if (!read_value(&usage.user_time_us) ||
+          !read_value(&usage.system_time_us) ||
+          !read_value(&usage.peak_rss_delta_kb) ||
+          !read_value(&usage.voluntary_context_switches) ||
+          !read_value(&usage.involuntary_context_switches) ||
+          !read_value(&usage.minor_page_faults) ||
+          !read_value(&usage.major_page_faults) ||
+          !read_value(&usage.allocations) ||
+          !read_value(&usage.allocated_bytes)) {
+        return false;
+      }
+      TestResultAccessor::set_resource_usage(impl->current_test_result(),
+                                             usage);
+    } else if (tag == kIsolatedBenchmark) {
+      BenchmarkResult result;
+      if (!read_value(&result.samples) ||
+          !read_value(&result.iterations_per_sample) ||
+          !read_value(&result.min_ns) || !read_value(&result.median_ns) ||
+          !read_value(&result.mad_ns) || !read_value(&result.p90_ns) ||
+          !read_value(&result.p99_ns) || !read_value(&result.max_ns)) {
+        return false;
+      }
+      TestResultAccessor::set_benchmark_result(impl->current_test_result(),
+                                               result);
+    } else {
+      return false;
+    }
+  }
+  return false;
 }
 
-// Skip and records a skipped test result for this object.
-void TestInfo::Skip() {
-  if (!should_run_) return;
+// Returns true if tests should run in child processes.  The child process of
+// a death test runs its single test directly.
+static bool ShouldIsolateTests() {
+  return GTEST_FLAG_GET(isolate_tests) &&
+         GetUnitTestImpl()->internal_run_death_test_flag() == nullptr;
+}
 
-  internal::UnitTestImpl* const impl = internal::GetUnitTestImpl();
-  impl->set_current_test_info(this);
+// Calls run_test in a child process forked from this one, and reports the
+// results it produced here.
+static void RunTestInChildProcess(const TestInfo& test_info,
+                                  const std::function<void()>& run_test) {
+  UnitTestImpl* const impl = GetUnitTestImpl();
 
-  TestEventListener* repeater = UnitTest::GetInstance()->listeners().repeater();
+  // Flushes the output so that the child doesn't print it a second time.
+  fflush(stdout);
+  fflush(stderr);
+
+  // The pipe is closed on exec, so that a process the test starts can't
+  // keep the parent waiting for it after the child has ended.
+  int pipe_fd[2];
+  GTEST_CHECK_(pipe(pipe_fd) != -1)
+      << "Unable to create a pipe for an isolated test: "
+      << posix::StrError(errno);
+  GTEST_CHECK_(fcntl(pipe_fd[0], F_SETFD, FD_CLOEXEC) != -1 &&
+               fcntl(pipe_fd[1], F_SETFD, FD_CLOEXEC) != -1)
+      << "Unable to set up a pipe for an isolated test: "
+      << posix::StrError(errno);
+  const pid_t child_pid = fork();
+  GTEST_CHECK_(child_pid != -1)
+      << "Unable to fork an isolated test: " << posix::StrError(errno);
+
+  if (child_pid == 0) {
+    posix::Close(pipe_fd[0]);
+    IsolatedResultWriter writer(pipe_fd[1],
+                                impl->GetGlobalTestPartResultReporter());
+    impl->SetGlobalTestPartResultReporter(&writer);
+    impl->set_test_property_forwarder(
+        [&writer](const TestProperty& property) {
+          writer.WriteProperty(property);
+        });
+    // The parent reports the results to the listeners once it has them.
+    impl->listeners()->SuppressEventForwarding(true);
 
-  // Notifies the unit test event listeners that a test is about to start.
-  repeater->OnTestStart(*this);
+    run_test();
 
-  const TestPartResult test_part_result =
-      TestPartResult(TestPartResult::kSkip, this->file(), this->line(), "");
-  impl->GetTestPartResultReporterForCurrentThread()->ReportTestPartResult(
-      test_part_result);
+    const TestResult& result = *impl->current_test_result();
+    if (GTEST_FLAG_GET(record_resource_usage)) {
+      writer.WriteResourceUsage(result.resource_usage());
+    }
+    if (result.benchmark_result().samples > 0) {
+      writer.WriteBenchmarkResult(result.benchmark_result());
+    }
+    writer.WriteEnd();
+    fflush(stdout);
+    fflush(stderr);
+    _exit(0);
+  }
 
-  // Notifies the unit test event listener that a test has just finished.
-  repeater->OnTestEnd(*this);
-  impl->set_current_test_info(nullptr);
-}
+  posix::Close(pipe_fd[1]);
+  std::string data;
+  char buffer[4096];
+  for (;;) {
+    const int n = posix::Read(pipe_fd[0], buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    data.append(buffer, static_cast<size_t>(n));
+  }
+  posix::Close(pipe_fd[0]);
 
-// class TestSuite
+  int status = 0;
+  while (waitpid(child_pid, &status, 0) == -1 && errno == EINTR) {
+  }
 
-// Gets the number of successful tests in this test suite.
-int TestSuite::successful_test_count() const {
-  return CountIf(test_info_list_, TestPassed);
-}
+  const bool finished = ReplayIsolatedResult(data);
+  if (finished && WIFEXITED(status) && WEXITSTATUS(status) == 0) return;
 
-// Gets the number of successful tests in this test suite.
-int TestSuite::skipped_test_count() const {
-  return CountIf(test_info_list_, TestSkipped);
+  Message message;
+  message << "The isolated test process ";
+  if (WIFSIGNALED(status)) {
+    message << "was killed by signal " << WTERMSIG(status);
+  } else if (WIFEXITED(status)) {
+    message << "exited with code " << WEXITSTATUS(status);
+  } else {
+    message << "ended with status " << status;
+  }
+  if (!finished) message << " before the test finished";
+  message << ".";
+  impl->GetTestPartResultReporterForCurrentThread()->ReportTestPartResult(
+      TestPartResult(TestPartResult::kFatalFailure, test_info.file(),
+                     test_info.line(), message.GetString().c_str()));
 }
 
-// Gets the number of failed tests in this test suite.
-int TestSuite::failed_test_count() const {
-  return CountIf(test_info_list_, TestFailed);
-}
+}  // namespace internal
+#endif  // GTEST_CAN_ISOLATE_TESTS_
 
-// Gets the number of disabled tests that will be reported in the XML report.
-int TestSuite::reportable_disabled_test_count() const {
-  return CountIf(test_info_list_, TestReportableDisabled);
-}
+namespace internal {
 
-// Gets the number of disabled tests in this test suite.
-int TestSuite::disabled_test_count() const {
-  return CountIf(test_info_list_, TestDisabled);
+// Returns the resources used so far.  peak_rss_delta_kb holds the peak
+// resident set size itself.
+static TestResourceUsage GetResourceUsage() {
+  TestResourceUsage result;
+  const AllocationCounters allocations = GetThreadAllocationCounters();
+  result.allocations = allocations.allocations;
+  result.allocated_bytes = allocations.bytes;
+#if GTEST_CAN_RECORD_RESOURCE_USAGE_
+  struct rusage usage = {};
+  getrusage(RUSAGE_SELF, &usage);
+  const auto to_us = [](const struct timeval& time) {
+    return static_cast<int64_t>(time.tv_sec) * 1000000 + time.tv_usec;
+  };
+  result.user_time_us = to_us(usage.ru_utime);
+  result.system_time_us = to_us(usage.ru_stime);
+#ifdef GTEST_OS_MAC
+  result.peak_rss_delta_kb = usage.ru_maxrss / 1024;  // In bytes on macOS.
+#else
+  result.peak_rss_delta_kb = usage.ru_maxrss;
+#endif  // GTEST_OS_MAC
+  result.voluntary_context_switches = usage.ru_nvcsw;
+  result.involuntary_context_switches = usage.ru_nivcsw;
+  result.minor_page_faults = usage.ru_minflt;
+  result.major_page_faults = usage.ru_majflt;
+#endif  // GTEST_CAN_RECORD_RESOURCE_USAGE_
+  return result;
 }
 
-// Gets the number of tests to be printed in the XML report.
-int TestSuite::reportable_test_count() const {
-  return CountIf(test_info_list_, TestReportable);
+// Returns the resources used since start was taken by GetResourceUsage().
+static TestResourceUsage GetResourceUsageSince(const TestResourceUsage& start) {
+  const TestResourceUsage now = GetResourceUsage();
+  TestResourceUsage result;
+  result.user_time_us = now.user_time_us - start.user_time_us;
+  result.system_time_us = now.system_time_us - start.system_time_us;
+  result.peak_rss_delta_kb = now.peak_rss_delta_kb - start.peak_rss_delta_kb;
+  result.voluntary_context_switches =
+      now.voluntary_context_switches - start.voluntary_context_switches;
+  result.involuntary_context_switches =
+      now.involuntary_context_switches - start.involuntary_context_switches;
+  result.minor_page_faults = now.minor_page_faults - start.minor_page_faults;
+  result.major_page_faults = now.major_page_faults - start.major_page_faults;
+  result.allocations = now.allocations - start.allocations;
+  result.allocated_bytes = now.allocated_bytes - start.allocated_bytes;
+  return result;
 }
 
-// Get the number of tests in this test suite that should run.
-int TestSuite::test_to_run_count() const {
-  return CountIf(test_info_list_, ShouldRunTest);
-}
+}  // namespace internal
 
-// Gets the number of all tests.
-int TestSuite::total_test_count() const {
-  return static_cast<int>(test_info_list_.size());
-}
+namespace internal {
+
+#ifdef GTEST_IS_THREADSAFE
+TestResultsLock::TestResultsLock() { GetUnitTestImpl()->LockTestResults(); }
+
+TestResultsLock::~TestResultsLock() { GetUnitTestImpl()->UnlockTestResults(); }
+#else
+TestResultsLock::TestResultsLock() = default;
+
+TestResultsLock::~TestResultsLock() = default;
+#endif  // GTEST_IS_THREADSAFE
+
+}  // namespace internal
+
+#ifdef GTEST_IS_THREADSAFE
+namespace internal {
+
+TestWatchdog::TestWatchdog(TestInfo* test_info, int timeout_ms)
+    : test_info_(test_info),
+      start_(std::chrono::steady_clock::now()),
+      timeout_ms_(0)
+#if GTEST_HAS_PTHREAD
+      ,
+      test_thread_(pthread_self())
+#endif  // GTEST_HAS_PTHREAD
+{
+  GetUnitTestImpl()->set_test_watchdog(this);
+  SetTimeoutMs(timeout_ms);
+}
+
+TestWatchdog::~TestWatchdog() {
+  GetUnitTestImpl()->set_test_watchdog(nullptr);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  timeout_changed_.notify_one();
+  if (thread_.joinable()) thread_.join();
+}
+
+void TestWatchdog::SetTimeoutMs(int timeout_ms) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeout_ms_ = timeout_ms;
+  }
+  // Most tests never have a limit, so the thread is only started for the
+  // ones that do.
+  if (timeout_ms > 0 && !thread_.joinable()) {
+    thread_ = std::thread(&TestWatchdog::Watch, this);
+  } else {
+    timeout_changed_.notify_one();
+  }
+}
+
+void TestWatchdog::Watch() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!done_) {
+    if (timeout_ms_ <= 0) {
+      timeout_changed_.wait(lock);
+      continue;
+    }
+    const int timeout_ms = timeout_ms_;
+    const bool woken = timeout_changed_.wait_until(
+        lock, start_ + std::chrono::milliseconds(timeout_ms),
+        [&] { return done_ || timeout_ms_ != timeout_ms; });
+    if (!woken) {
+      lock.unlock();
+      Expire(timeout_ms);
+    }
+  }
+}
+
+void TestWatchdog::Expire(int timeout_ms) {
+  UnitTestImpl* const impl = GetUnitTestImpl();
+  // The test is still running.  Unless it is stuck while recording a result,
+  // it is made to stop recording them before the timeout is reported, and
+  // then waits to be aborted the next time it tries.
+  if (!impl->ClaimTestResults(1000)) {
+    fprintf(stderr,
+            "%s.%s timed out while recording a result; aborting without a "
+            "report.\n",
+            test_info_->test_suite_name(), test_info_->name());
+    fflush(stderr);
+    posix::Abort();
+  }
+
+  Message message;
+  message << "The test timed out after " << timeout_ms << " ms.";
+  impl->GetGlobalTestPartResultReporter()->ReportTestPartResult(
+      TestPartResult(TestPartResult::kFatalFailure, test_info_->file(),
+                     test_info_->line(), message.GetString().c_str()));
+
+  // A parent process reports the test if there is one; otherwise the run
+  // ends here, so that the XML and JSON reports are written.
+  bool in_child_process = false;
+#if GTEST_CAN_ISOLATE_TESTS_
+  in_child_process = ShouldIsolateTests();
+#endif  // GTEST_CAN_ISOLATE_TESTS_
+#ifdef GTEST_HAS_DEATH_TEST
+  in_child_process = in_child_process ||
+                     impl->internal_run_death_test_flag() != nullptr;
+#endif  // GTEST_HAS_DEATH_TEST
+  if (!in_child_process) {
+    impl->EndRunAfterTimeout(
+        test_info_, static_cast<TimeInMillis>(
+                        std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now() - start_)
+                            .count()));
+  }
+  fflush(stdout);
+  fflush(stderr);
+
+#if GTEST_HAS_PTHREAD
+  // Aborts in the thread that is stuck, so that a failure signal handler or
+  // a core dump shows its stack.  The signal takes the whole process down
+  // unless a handler gets in the way.
+  pthread_kill(test_thread_, SIGABRT);
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+#endif  // GTEST_HAS_PTHREAD
+  posix::Abort();
+}
+
+}  // namespace internal
+#endif  // GTEST_IS_THREADSAFE
+
+// Creates the test object, runs it, records its result, and then
+// deletes it, or keeps it for reuse if its fixture is a PooledFixture.
+void TestInfo::Run() {
+  TestEventListener* repeater = UnitTest::GetInstance()->listeners().repeater();
+  if (!should_run_) {
+    if (is_disabled_ && matches_filter_) repeater->OnTestDisabled(*this);
+    return;
+  }
+
+  // Tells UnitTest where to store test result.
+  internal::UnitTestImpl* const impl = internal::GetUnitTestImpl();
+  impl->set_current_test_info(this);
+
+  // Notifies the unit test event listeners that a test is about to start.
+  repeater->OnTestStart(*this);
+  result_.set_start_timestamp(internal::GetTimeInMillis());
+  internal::Timer timer;
+  impl->os_stack_trace_getter()->UponLeavingGTest();
+
+  const auto run_test = [this, impl] {
+#ifdef GTEST_IS_THREADSAFE
+    // Times the test from here, in the process that runs it.
+    internal::TestWatchdog watchdog(this, GTEST_FLAG_GET(test_timeout_ms));
+#endif  // GTEST_IS_THREADSAFE
+    const bool record_resource_usage = GTEST_FLAG_GET(record_resource_usage);
+    const TestResourceUsage usage_at_start =
+        record_resource_usage ? internal::GetResourceUsage()
+                              : TestResourceUsage();
+
+    // Reuses the test object that an earlier test of the same class left in
+    // the test suite's fixture pool, if there is one, or creates one.
+    TestSuite* const test_suite = impl->current_test_suite();
+    const internal::TypeId pool_id =
+        test_suite != nullptr ? factory_->GetFixturePoolId() : nullptr;
+    // A pooled test object outlives its test, so the flag saver in it would
+    // only restore the flags at the end of the test suite.  This one
+    // restores them when the test ends, as deleting the object would.
+    std::unique_ptr<GTEST_FLAG_SAVER_> pooled_flag_saver;
+    if (pool_id != nullptr) pooled_flag_saver.reset(new GTEST_FLAG_SAVER_);
+    Test* test =
+        pool_id != nullptr ? test_suite->TakePooledFixture(pool_id) : nullptr;
+    if (test != nullptr) {
+      internal::HandleExceptionsInMethodIfSupported(
+          factory_->PrepareForReuse(test), &PooledFixture::Reset,
+          "the test fixture's Reset()");
+    } else {
+      test = internal::HandleExceptionsInMethodIfSupported(
+          factory_, &internal::TestFactoryBase::CreateTest,
+          "the test fixture's constructor");
+    }
+    // A fixture that couldn't be constructed or reset isn't reused.
+    const bool fixture_failed = Test::HasFatalFailure();
+
+    // Runs the test if the constructor didn't generate a fatal failure or
+    // invoke GTEST_SKIP().
+    // Note that the object will not be null
+    if (!fixture_failed && !Test::IsSkipped()) {
+      // This doesn't throw as all user code that can throw are wrapped into
+      // exception handling code.
+      test->Run();
+    }
+    pooled_flag_saver.reset();
+
+    if (test != nullptr && pool_id != nullptr && !fixture_failed) {
+      test_suite->ReturnPooledFixture(pool_id, test);
+    } else if (test != nullptr) {
+      // Deletes the test object.
+      impl->os_stack_trace_getter()->UponLeavingGTest();
+      internal::HandleExceptionsInMethodIfSupported(
+          test, &Test::DeleteSelf_, "the test fixture's destructor");
+    }
+
+    if (record_resource_usage) {
+      const TestResourceUsage usage =
+          internal::GetResourceUsageSince(usage_at_start);
+      internal::TestResultsLock lock;
+      result_.set_resource_usage(usage);
+    }
+  };
+
+#if GTEST_CAN_ISOLATE_TESTS_
+  if (internal::ShouldIsolateTests()) {
+    internal::RunTestInChildProcess(*this, run_test);
+  } else {
+    run_test();
+  }
+#else
+  run_test();
+#endif  // GTEST_CAN_ISOLATE_TESTS_
+
+  result_.set_elapsed_time(timer.Elapsed());
+
+  // Notifies the unit test event listener that a test has just finished.
+  repeater->OnTestEnd(*this);
+
+  // Tells UnitTest to stop associating assertion results to this
+  // test.
+  impl->set_current_test_info(nullptr);
+}
+
+// Skip and records a skipped test result for this object.
+void TestInfo::Skip() {
+  if (!should_run_) return;
+
+  internal::UnitTestImpl* const impl = internal::GetUnitTestImpl();
+  impl->set_current_test_info(this);
+
+  TestEventListener* repeater = UnitTest::GetInstance()->listeners().repeater();
+
+  // Notifies the unit test event listeners that a test is about to start.
+  repeater->OnTestStart(*this);
+
+  const TestPartResult test_part_result =
+      TestPartResult(TestPartResult::kSkip, this->file(), this->line(), "");
+  impl->GetTestPartResultReporterForCurrentThread()->ReportTestPartResult(
+      test_part_result);
+
+  // Notifies the unit test event listener that a test has just finished.
+  repeater->OnTestEnd(*this);
+  impl->set_current_test_info(nullptr);
+}
+
+// class TestSuite
+
+// Gets the number of successful tests in this test suite.
+int TestSuite::successful_test_count() const {
+  return CountIf(test_info_list_, TestPassed);
+}
+
+// Gets the number of successful tests in this test suite.
+int TestSuite::skipped_test_count() const {
+  return CountIf(test_info_list_, TestSkipped);
+}
+
+// Gets the number of failed tests in this test suite.
+int TestSuite::failed_test_count() const {
+  return CountIf(test_info_list_, TestFailed);
+}
+
+// Gets the number of disabled tests that will be reported in the XML report.
+int TestSuite::reportable_disabled_test_count() const {
+  return CountIf(test_info_list_, TestReportableDisabled);
+}
+
+// Gets the number of disabled tests in this test suite.
+int TestSuite::disabled_test_count() const {
+  return CountIf(test_info_list_, TestDisabled);
+}
+
+// Gets the number of tests to be printed in the XML report.
+int TestSuite::reportable_test_count() const {
+  return CountIf(test_info_list_, TestReportable);
+}
+
+// Get the number of tests in this test suite that should run.
+int TestSuite::test_to_run_count() const {
+  return CountIf(test_info_list_, ShouldRunTest);
+}
+
+// Gets the number of all tests.
+int TestSuite::total_test_count() const {
+  return static_cast<int>(test_info_list_.size());
+}
 
 // Creates a TestSuite with the given name.
 //
@@ -2987,6 +4066,37 @@ void TestSuite::AddTestInfo(TestInfo* test_info) {
   test_indices_.push_back(static_cast<int>(test_indices_.size()));
 }
 
+// Removes the test object with the given fixture pool ID from the pool and
+// returns it, or returns nullptr if there is none.
+Test* TestSuite::TakePooledFixture(internal::TypeId pool_id) {
+  for (auto it = fixture_pool_.begin(); it != fixture_pool_.end(); ++it) {
+    if (it->first == pool_id) {
+      Test* const test = it->second;
+      fixture_pool_.erase(it);
+      return test;
+    }
+  }
+  return nullptr;
+}
+
+// Keeps a test object for reuse by the next test with the same fixture pool
+// ID.
+void TestSuite::ReturnPooledFixture(internal::TypeId pool_id, Test* test) {
+  fixture_pool_.emplace_back(pool_id, test);
+}
+
+// Deletes the test objects kept for reuse.  Failures in their destructors
+// are recorded in the test suite's ad hoc result.
+void TestSuite::DeletePooledFixtures() {
+  internal::UnitTestImpl* const impl = internal::GetUnitTestImpl();
+  for (const auto& entry : fixture_pool_) {
+    impl->os_stack_trace_getter()->UponLeavingGTest();
+    internal::HandleExceptionsInMethodIfSupported(
+        entry.second, &Test::DeleteSelf_, "the test fixture's destructor");
+  }
+  fixture_pool_.clear();
+}
+
 // Runs every test in this TestSuite.
 void TestSuite::Run() {
   if (!should_run_) return;
@@ -3047,6 +4157,9 @@ void TestSuite::Run() {
   }
   elapsed_time_ = timer.Elapsed();
 
+  // The fixtures may use what TearDownTestSuite() tears down.
+  DeletePooledFixtures();
+
   impl->os_stack_trace_getter()->UponLeavingGTest();
   internal::HandleExceptionsInMethodIfSupported(
       this, &TestSuite::RunTearDownTestSuite, "TearDownTestSuite()");
@@ -3513,6 +4626,19 @@ void PrettyUnitTestResultPrinter::OnTestPartResult(
 }
 
 void PrettyUnitTestResultPrinter::OnTestEnd(const TestInfo& test_info) {
+  const BenchmarkResult& benchmark = test_info.result()->benchmark_result();
+  if (benchmark.samples > 0) {
+    ColoredPrintf(GTestColor::kGreen, "[ BENCHMARK] ");
+    printf("median %s ns, MAD %s ns, p90 %s ns, p99 %s ns (%s samples of %s "
+           "iterations)\n",
+           FormatBenchmarkNs(benchmark.median_ns).c_str(),
+           FormatBenchmarkNs(benchmark.mad_ns).c_str(),
+           FormatBenchmarkNs(benchmark.p90_ns).c_str(),
+           FormatBenchmarkNs(benchmark.p99_ns).c_str(),
+           StreamableToString(benchmark.samples).c_str(),
+           StreamableToString(benchmark.iterations_per_sample).c_str());
+  }
+
   if (test_info.result()->Passed()) {
     ColoredPrintf(GTestColor::kGreen, "[       OK ] ");
   } else if (test_info.result()->Skipped()) {
@@ -3523,7 +4649,15 @@ void PrettyUnitTestResultPrinter::OnTestEnd(const TestInfo& test_info) {
   PrintTestName(test_info.test_suite_name(), test_info.name());
   if (test_info.result()->Failed()) PrintFullTestCommentIfPresent(test_info);
 
-  if (GTEST_FLAG_GET(print_time)) {
+  if (GTEST_FLAG_GET(print_time) && GTEST_FLAG_GET(record_resource_usage)) {
+    const TestResourceUsage& usage = test_info.result()->resource_usage();
+    printf(" (%s ms; CPU %s ms user, %s ms system; peak RSS +%s KiB)\n",
+           internal::StreamableToString(test_info.result()->elapsed_time())
+               .c_str(),
+           internal::StreamableToString(usage.user_time_us / 1000).c_str(),
+           internal::StreamableToString(usage.system_time_us / 1000).c_str(),
+           internal::StreamableToString(usage.peak_rss_delta_kb).c_str());
+  } else if (GTEST_FLAG_GET(print_time)) {
     printf(" (%s ms)\n",
            internal::StreamableToString(test_info.result()->elapsed_time())
                .c_str());
@@ -3927,6 +5061,15 @@ class XmlUnitTestResultPrinter : public EmptyTestEventListener {
   static void PrintXmlTestsList(std::ostream* stream,
                                 const std::vector<TestSuite*>& test_suites);
 
+  // Returns an XML-escaped copy of the input string str.  If
+  // is_attribute is true, the text is meant to appear as an attribute
+  // value, and normalizable whitespace is preserved by replacing it
+  // with character references.
+  static std::string EscapeXml(const std::string& str, bool is_attribute);
+
+  // Returns the given string with all characters invalid in XML removed.
+  static std::string RemoveInvalidXmlCharacters(const std::string& str);
+
  private:
   // Is c a whitespace character that is normalized to a space character
   // when it appears in an XML attribute value?
@@ -3940,15 +5083,6 @@ class XmlUnitTestResultPrinter : public EmptyTestEventListener {
     return IsNormalizableWhitespace(c) || c >= 0x20;
   }
 
-  // Returns an XML-escaped copy of the input string str.  If
-  // is_attribute is true, the text is meant to appear as an attribute
-  // value, and normalizable whitespace is preserved by replacing it
-  // with character references.
-  static std::string EscapeXml(const std::string& str, bool is_attribute);
-
-  // Returns the given string with all characters invalid in XML removed.
-  static std::string RemoveInvalidXmlCharacters(const std::string& str);
-
   // Convenience wrapper around EscapeXml when str is an attribute value.
   static std::string EscapeXmlAttribute(const std::string& str) {
     return EscapeXml(str, true);
@@ -4037,6 +5171,67 @@ void XmlUnitTestResultPrinter::ListTestsMatchingFilter(
   fclose(xmlout);
 }
 
+namespace {
+
+// Finds the bytes that an escaping routine has to handle one at a time, so
+// that the runs of bytes between them can be copied in bulk.  Those are the
+// control characters (below 0x20), the bytes in specials and, if
+// high_bytes_are_special is true, the bytes from 0x80 up.  Clean text is
+// skipped eight bytes at a time by testing whole words for such bytes.
+class EscapeScanner {
+ public:
+  EscapeScanner(const char* specials, bool high_bytes_are_special)
+      : high_bytes_are_special_(high_bytes_are_special) {
+    for (int c = 0; c < 256; ++c) {
+      is_special_[c] = c < 0x20 || (high_bytes_are_special && c >= 0x80);
+    }
+    for (; *specials != '\0'; ++specials) {
+      GTEST_CHECK_(special_count_ < kMaxSpecials);
+      const auto c = static_cast<unsigned char>(*specials);
+      is_special_[c] = true;
+      special_words_[special_count_++] = kOnes * c;
+    }
+  }
+
+  // Returns the first byte in [begin, end) that needs handling, or end.
+  const char* Find(const char* begin, const char* end) const {
+    const char* p = begin;
+    for (; end - p >= 8; p += 8) {
+      uint64_t word;
+      memcpy(&word, p, sizeof(word));
+      if (MayHoldSpecial(word)) break;
+    }
+    while (p != end && !is_special_[static_cast<unsigned char>(*p)]) ++p;
+    return p;
+  }
+
+ private:
+  static constexpr uint64_t kOnes = 0x0101010101010101;
+  static constexpr uint64_t kHighBits = 0x8080808080808080;
+  static constexpr size_t kMaxSpecials = 5;
+
+  // Returns true if any byte of word needs handling.  Each term has a high
+  // bit set in some byte exactly when the byte it looks for is present, so
+  // a false positive can't happen and the bytewise scan in Find() always
+  // stops within the word.
+  bool MayHoldSpecial(uint64_t word) const {
+    uint64_t found = (word - kOnes * 0x20) & ~word;  // Bytes below 0x20.
+    if (high_bytes_are_special_) found |= word;
+    for (size_t i = 0; i < special_count_; ++i) {
+      const uint64_t zeroed = word ^ special_words_[i];
+      found |= (zeroed - kOnes) & ~zeroed;
+    }
+    return (found & kHighBits) != 0;
+  }
+
+  bool is_special_[256];
+  const bool high_bytes_are_special_;
+  uint64_t special_words_[kMaxSpecials] = {};
+  size_t special_count_ = 0;
+};
+
+}  // namespace
+
 // Returns an XML-escaped copy of the input string str.  If is_attribute
 // is true, the text is meant to appear as an attribute value, and
 // normalizable whitespace is preserved by replacing it with character
@@ -4049,46 +5244,51 @@ void XmlUnitTestResultPrinter::ListTestsMatchingFilter(
 // most invalid characters can be retained using character references.
 std::string XmlUnitTestResultPrinter::EscapeXml(const std::string& str,
                                                 bool is_attribute) {
-  Message m;
+  static const EscapeScanner text_scanner("<>&", false);
+  static const EscapeScanner attribute_scanner("<>&'\"", false);
+  const EscapeScanner& scanner =
+      is_attribute ? attribute_scanner : text_scanner;
 
-  for (size_t i = 0; i < str.size(); ++i) {
-    const char ch = str[i];
+  std::string output;
+  output.reserve(str.size());
+  const char* const end = str.data() + str.size();
+  for (const char* p = str.data(); p != end;) {
+    const char* const special = scanner.Find(p, end);
+    output.append(p, special);
+    if (special == end) break;
+    const char ch = *special;
+    p = special + 1;
     switch (ch) {
       case '<':
-        m << "&lt;";
+        output += "&lt;";
         break;
       case '>':
-        m << "&gt;";
+        output += "&gt;";
         break;
       case '&':
-        m << "&amp;";
+        output += "&amp;";
         break;
-      case '\'':
-        if (is_attribute)
-          m << "&apos;";
-        else
-          m << '\'';
+      case '\'':  // Only found in attribute values.
+        output += "&apos;";
         break;
-      case '"':
-        if (is_attribute)
-          m << "&quot;";
-        else
-          m << '"';
+      case '"':  // Only found in attribute values.
+        output += "&quot;";
         break;
-      default:
-        if (IsValidXmlCharacter(static_cast<unsigned char>(ch))) {
-          if (is_attribute &&
-              IsNormalizableWhitespace(static_cast<unsigned char>(ch)))
-            m << "&#x" << String::FormatByte(static_cast<unsigned char>(ch))
-              << ";";
-          else
-            m << ch;
+      default:  // A control character.
+        if (IsNormalizableWhitespace(static_cast<unsigned char>(ch))) {
+          if (is_attribute) {
+            output += "&#x";
+            output += String::FormatByte(static_cast<unsigned char>(ch));
+            output += ';';
+          } else {
+            output += ch;
+          }
         }
         break;
     }
   }
 
-  return m.GetString();
+  return output;
 }
 
 // Returns the given string with all characters invalid in XML removed.
@@ -4096,11 +5296,20 @@ std::string XmlUnitTestResultPrinter::EscapeXml(const std::string& str,
 // alternative is to replace them with certain characters such as . or ?.
 std::string XmlUnitTestResultPrinter::RemoveInvalidXmlCharacters(
     const std::string& str) {
+  static const EscapeScanner scanner("", false);
+
   std::string output;
   output.reserve(str.size());
-  for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
-    if (IsValidXmlCharacter(static_cast<unsigned char>(*it)))
-      output.push_back(*it);
+  const char* const end = str.data() + str.size();
+  for (const char* p = str.data(); p != end;) {
+    const char* const special = scanner.Find(p, end);
+    output.append(p, special);
+    if (special == end) break;
+    if (IsValidXmlCharacter(static_cast<unsigned char>(*special))) {
+      output += *special;
+    }
+    p = special + 1;
+  }
 
   return output;
 }
@@ -4283,6 +5492,21 @@ void XmlUnitTestResultPrinter::OutputXmlTestInfo(::std::ostream* stream,
   OutputXmlAttribute(
       stream, kTestsuite, "timestamp",
       FormatEpochTimeInMillisAsIso8601(result.start_timestamp()));
+  if (GTEST_FLAG_GET(record_resource_usage)) {
+    for (const auto& field : ResourceUsageFields(result.resource_usage())) {
+      OutputXmlAttribute(stream, kTestsuite, field.first,
+                         StreamableToString(field.second));
+    }
+  }
+  if (result.benchmark_result().samples > 0) {
+    for (const auto& field : BenchmarkCountFields(result.benchmark_result())) {
+      OutputXmlAttribute(stream, kTestsuite, field.first,
+                         StreamableToString(field.second));
+    }
+    for (const auto& field : BenchmarkTimeFields(result.benchmark_result())) {
+      OutputXmlAttribute(stream, kTestsuite, field.first, field.second);
+    }
+  }
   OutputXmlAttribute(stream, kTestsuite, "classname", test_suite_name);
 
   OutputXmlTestResult(stream, result);
@@ -4469,6 +5693,14 @@ void XmlUnitTestResultPrinter::OutputXmlTestProperties(
 }
 
 // End XmlUnitTestResultPrinter
+
+std::string EscapeXmlForTesting(const std::string& str, bool is_attribute) {
+  return XmlUnitTestResultPrinter::EscapeXml(str, is_attribute);
+}
+
+std::string RemoveInvalidXmlCharactersForTesting(const std::string& str) {
+  return XmlUnitTestResultPrinter::RemoveInvalidXmlCharacters(str);
+}
 #endif  // GTEST_HAS_FILE_SYSTEM
 
 #if GTEST_HAS_FILE_SYSTEM
@@ -4483,10 +5715,11 @@ class JsonUnitTestResultPrinter : public EmptyTestEventListener {
   static void PrintJsonTestList(::std::ostream* stream,
                                 const std::vector<TestSuite*>& test_suites);
 
- private:
   // Returns an JSON-escaped copy of the input string str.
   static std::string EscapeJson(const std::string& str);
 
+ private:
+
   //// Verifies that the given attribute belongs to the given element and
   //// streams the attribute as JSON.
   static void OutputJsonKey(std::ostream* stream,
@@ -4495,7 +5728,7 @@ class JsonUnitTestResultPrinter : public EmptyTestEventListener {
                             const std::string& indent, bool comma = true);
   static void OutputJsonKey(std::ostream* stream,
                             const std::string& element_name,
-                            const std::string& name, int value,
+                            const std::string& name, int64_t value,
                             const std::string& indent, bool comma = true);
 
   // Streams a test suite JSON stanza containing the given test result.
@@ -4553,42 +5786,50 @@ void JsonUnitTestResultPrinter::OnTestIterationEnd(const UnitTest& unit_test,
 
 // Returns an JSON-escaped copy of the input string str.
 std::string JsonUnitTestResultPrinter::EscapeJson(const std::string& str) {
-  Message m;
+  // Where char is signed, the bytes from 0x80 up compare below ' ' and are
+  // escaped as well.
+  static const EscapeScanner scanner("\\\"/",
+                                     std::numeric_limits<char>::is_signed);
 
-  for (size_t i = 0; i < str.size(); ++i) {
-    const char ch = str[i];
+  std::string output;
+  output.reserve(str.size());
+  const char* const end = str.data() + str.size();
+  for (const char* p = str.data(); p != end;) {
+    const char* const special = scanner.Find(p, end);
+    output.append(p, special);
+    if (special == end) break;
+    const char ch = *special;
+    p = special + 1;
     switch (ch) {
       case '\\':
       case '"':
       case '/':
-        m << '\\' << ch;
+        output += '\\';
+        output += ch;
         break;
       case '\b':
-        m << "\\b";
+        output += "\\b";
         break;
       case '\t':
-        m << "\\t";
+        output += "\\t";
         break;
       case '\n':
-        m << "\\n";
+        output += "\\n";
         break;
       case '\f':
-        m << "\\f";
+        output += "\\f";
         break;
       case '\r':
-        m << "\\r";
+        output += "\\r";
         break;
       default:
-        if (ch < ' ') {
-          m << "\\u00" << String::FormatByte(static_cast<unsigned char>(ch));
-        } else {
-          m << ch;
-        }
+        output += "\\u00";
+        output += String::FormatByte(static_cast<unsigned char>(ch));
         break;
     }
   }
 
-  return m.GetString();
+  return output;
 }
 
 // The following routines generate an JSON representation of a UnitTest
@@ -4640,7 +5881,8 @@ void JsonUnitTestResultPrinter::OutputJsonKey(std::ostream* stream,
 
 void JsonUnitTestResultPrinter::OutputJsonKey(
     std::ostream* stream, const std::string& element_name,
-    const std::string& name, int value, const std::string& indent, bool comma) {
+    const std::string& name, int64_t value, const std::string& indent,
+    bool comma) {
   const std::vector<std::string>& allowed_names =
       GetReservedOutputAttributesForElement(element_name);
 
@@ -4736,6 +5978,19 @@ void JsonUnitTestResultPrinter::OutputJsonTestInfo(::std::ostream* stream,
                 kIndent);
   OutputJsonKey(stream, kTestsuite, "time",
                 FormatTimeInMillisAsDuration(result.elapsed_time()), kIndent);
+  if (GTEST_FLAG_GET(record_resource_usage)) {
+    for (const auto& field : ResourceUsageFields(result.resource_usage())) {
+      OutputJsonKey(stream, kTestsuite, field.first, field.second, kIndent);
+    }
+  }
+  if (result.benchmark_result().samples > 0) {
+    for (const auto& field : BenchmarkCountFields(result.benchmark_result())) {
+      OutputJsonKey(stream, kTestsuite, field.first, field.second, kIndent);
+    }
+    for (const auto& field : BenchmarkTimeFields(result.benchmark_result())) {
+      OutputJsonKey(stream, kTestsuite, field.first, field.second, kIndent);
+    }
+  }
   OutputJsonKey(stream, kTestsuite, "classname", test_suite_name, kIndent,
                 false);
   *stream << TestPropertiesAsJson(result, kIndent);
@@ -4881,37 +6136,950 @@ void JsonUnitTestResultPrinter::PrintJsonTestList(
   for (auto test_suite : test_suites) {
     total_tests += test_suite->total_test_count();
   }
-  OutputJsonKey(stream, kTestsuites, "tests", total_tests, kIndent);
-
-  OutputJsonKey(stream, kTestsuites, "name", "AllTests", kIndent);
-  *stream << kIndent << "\"" << kTestsuites << "\": [\n";
+  OutputJsonKey(stream, kTestsuites, "tests", total_tests, kIndent);
+
+  OutputJsonKey(stream, kTestsuites, "name", "AllTests", kIndent);
+  *stream << kIndent << "\"" << kTestsuites << "\": [\n";
+
+  for (size_t i = 0; i < test_suites.size(); ++i) {
+    if (i != 0) {
+      *stream << ",\n";
+    }
+    PrintJsonTestSuite(stream, *test_suites[i]);
+  }
+
+  *stream << "\n"
+          << kIndent << "]\n"
+          << "}\n";
+}
+// Produces a string representing the test properties in a result as
+// a JSON dictionary.
+std::string JsonUnitTestResultPrinter::TestPropertiesAsJson(
+    const TestResult& result, const std::string& indent) {
+  Message attributes;
+  for (int i = 0; i < result.test_property_count(); ++i) {
+    const TestProperty& property = result.GetTestProperty(i);
+    attributes << ",\n"
+               << indent << "\"" << property.key() << "\": "
+               << "\"" << EscapeJson(property.value()) << "\"";
+  }
+  return attributes.GetString();
+}
+
+// End JsonUnitTestResultPrinter
+
+std::string EscapeJsonForTesting(const std::string& str) {
+  return JsonUnitTestResultPrinter::EscapeJson(str);
+}
+#endif  // GTEST_HAS_FILE_SYSTEM
+
+#if GTEST_HAS_FILE_SYSTEM
+// The stream written by --gtest_output=bin starts with kBinaryOutputMagic and
+// a uint32 format version, followed by records.  Each record is a uint32
+// length, then that many bytes: a tag and its payload.  Integers are
+// little-endian, and doubles are stored as the bits of their IEEE 754
+// representation.  Strings are interned: a kBinaryString record gives the
+// next string ID (counting from 0) to its payload, and other records refer to
+// strings by ID, with kBinaryNoString standing for a null string.
+//
+// A kBinaryIterationStart record starts each iteration of the tests.  Every
+// reportable test suite and test is then declared, and they too are numbered
+// from 0 in the order of their declarations.  Results follow as the tests
+// run, and the stream is flushed after each test event, so a reader can
+// follow it live and a program that crashes leaves a readable prefix.
+static const char kBinaryOutputMagic[] = "GTESTBIN";
+static const size_t kBinaryOutputHeaderSize = sizeof(kBinaryOutputMagic) - 1 +
+                                              sizeof(uint32_t);
+static const uint32_t kBinaryOutputVersion = 1;
+static const uint32_t kBinaryNoString = 0xffffffff;
+
+// Record tags, with their payloads.
+static const char kBinaryString = 'S';  // bytes
+// u32 iteration, i64 start timestamp, i32 random seed, u8 flags
+static const char kBinaryIterationStart = 'I';
+static const char kBinaryTestSuite = 'C';  // str name, str type parameter
+// u32 test suite, str name, str type parameter, str value parameter,
+// str file, i32 line, u8 flags
+static const char kBinaryTest = 'T';
+static const char kBinaryTestStart = 's';  // u32 test
+// u8 scope, u32 owner, i32 type, str file, i32 line, str message
+static const char kBinaryPart = 'P';
+static const char kBinaryProperty = 'R';  // u8 scope, u32 owner, str, str
+static const char kBinaryResourceUsage = 'U';  // u32 test, 9 x i64
+static const char kBinaryBenchmark = 'B';  // u32 test, 2 x i64, 6 x double
+// u32 test, i64 start timestamp, i64 elapsed time
+static const char kBinaryTestEnd = 'e';
+// u32 test suite, i64 start timestamp, i64 elapsed time
+static const char kBinaryTestSuiteEnd = 'c';
+static const char kBinaryIterationEnd = 'E';  // i64 elapsed time
+
+// The flags of a kBinaryIterationStart record.
+static const uint8_t kBinaryShuffle = 1;
+static const uint8_t kBinaryRecordResourceUsage = 2;
+
+// The flags of a kBinaryTest record.
+static const uint8_t kBinaryShouldRun = 1;
+
+// The scopes of kBinaryPart and kBinaryProperty records, which say whether
+// their owner is the whole program, a test suite or a test.
+static const uint8_t kBinaryProgramScope = 0;
+static const uint8_t kBinaryTestSuiteScope = 1;
+static const uint8_t kBinaryTestScope = 2;
+
+template <typename T>
+static void AppendLittleEndian(T value, std::string* out) {
+  auto bits = static_cast<typename std::make_unsigned<T>::type>(value);
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    out->push_back(static_cast<char>(bits & 0xff));
+    bits = static_cast<decltype(bits)>(bits >> 8);
+  }
+}
+
+static void AppendLittleEndian(double value, std::string* out) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  AppendLittleEndian(bits, out);
+}
+
+template <typename T>
+static T DecodeLittleEndian(const char* data) {
+  typename std::make_unsigned<T>::type bits = 0;
+  for (size_t i = sizeof(T); i > 0; --i) {
+    bits = static_cast<decltype(bits)>(
+        (bits << 8) | static_cast<unsigned char>(data[i - 1]));
+  }
+  return static_cast<T>(bits);
+}
+
+// Reads the records of a --gtest_output=bin stream.
+class BinaryResultReader {
+ public:
+  // Starts reading at offset pos of data, which must be the start of a record
+  // and must outlive the reader.
+  BinaryResultReader(const std::string& data, size_t pos)
+      : data_(data), record_(pos), pos_(pos), next_(pos) {}
+
+  // Moves to the next record and reads its tag, or returns false if the
+  // stream ends, including in the middle of a record.
+  bool NextRecord(char* tag) {
+    record_ = next_;
+    if (data_.size() - record_ < sizeof(uint32_t)) return false;
+    const auto length = DecodeLittleEndian<uint32_t>(data_.data() + record_);
+    pos_ = record_ + sizeof(uint32_t);
+    if (length == 0 || data_.size() - pos_ < length) return false;
+    next_ = pos_ + length;
+    *tag = data_[pos_++];
+    return true;
+  }
+
+  // Returns the offset of the current record.
+  size_t record_offset() const { return record_; }
+
+  // Reads the next value of the current record, or returns false if the
+  // record has no more room for it.
+  template <typename T>
+  bool Read(T* value) {
+    if (next_ - pos_ < sizeof(T)) return false;
+    *value = DecodeLittleEndian<T>(data_.data() + pos_);
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  bool Read(double* value) {
+    uint64_t bits = 0;
+    if (!Read(&bits)) return false;
+    memcpy(value, &bits, sizeof(bits));
+    return true;
+  }
+
+  // Reads the rest of the current record.
+  std::string ReadRest() {
+    std::string rest(data_, pos_, next_ - pos_);
+    pos_ = next_;
+    return rest;
+  }
+
+ private:
+  const std::string& data_;
+  size_t record_;  // Where the current record starts.
+  size_t pos_;     // What to read next in the current record.
+  size_t next_;    // Where the next record starts.
+};
+
+// Where a BinaryUnitTestResultPrinter sends its stream.
+class BinaryResultSink {
+ public:
+  virtual ~BinaryResultSink() = default;
+
+  // Sends data, which holds whole records, or the stream header followed by
+  // records.
+  virtual void Send(const std::string& data) = 0;
+
+  // Called when the test program ends.
+  virtual void Close() {}
+
+  // Returns true if records may be held back until the next test starts or
+  // reports a result, so that they are sent in batches, or false if each
+  // event's records are sent at once.
+  virtual bool batches() const { return false; }
+};
+
+// Writes the stream to a file, flushing it after each event.
+class BinaryFileSink : public BinaryResultSink {
+ public:
+  explicit BinaryFileSink(const std::string& output_file)
+      : output_file_(output_file) {
+    if (output_file_.empty()) {
+      GTEST_LOG_(FATAL) << "Binary output file may not be null";
+    }
+  }
+
+  ~BinaryFileSink() override {
+    if (file_ != nullptr) fclose(file_);
+  }
+
+  // The file is created when the tests start, not when the flags are parsed.
+  void Send(const std::string& data) override {
+    if (file_ == nullptr) file_ = OpenFileForWriting(output_file_, "wb");
+    fwrite(data.data(), 1, data.size(), file_);
+    fflush(file_);
+  }
+
+ private:
+  const std::string output_file_;
+  FILE* file_ = nullptr;
+
+  BinaryFileSink(const BinaryFileSink&) = delete;
+  BinaryFileSink& operator=(const BinaryFileSink&) = delete;
+};
+
+#if GTEST_CAN_STREAM_RESULTS_
+// Sends the stream to a server listening on a Unix domain socket, for
+// --gtest_stream_result_to=unix:PATH.  Records are sent in batches, so that
+// a program running many short tests makes one system call for each test
+// rather than a few.
+class UnixSocketSink : public BinaryResultSink {
+ public:
+  explicit UnixSocketSink(const std::string& path);
+
+  ~UnixSocketSink() override { Close(); }
+
+  void Send(const std::string& data) override;
+
+  void Close() override {
+    if (sockfd_ != -1) close(sockfd_);
+    sockfd_ = -1;
+  }
+
+  bool batches() const override { return true; }
+
+ private:
+  int sockfd_ = -1;
+  const std::string path_;
+
+  UnixSocketSink(const UnixSocketSink&) = delete;
+  UnixSocketSink& operator=(const UnixSocketSink&) = delete;
+};
+
+UnixSocketSink::UnixSocketSink(const std::string& path) : path_(path) {
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+    GTEST_LOG_(WARNING) << "stream_result_to: invalid socket path \"" << path
+                        << "\"";
+    return;
+  }
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path.c_str(), path.size());
+  sockfd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sockfd_ != -1 &&
+      connect(sockfd_, reinterpret_cast<const sockaddr*>(&addr),
+              sizeof(addr)) == -1) {
+    close(sockfd_);
+    sockfd_ = -1;
+  }
+  if (sockfd_ == -1) {
+    GTEST_LOG_(WARNING) << "stream_result_to: failed to connect to unix:"
+                        << path_;
+    return;
+  }
+#ifdef SO_NOSIGPIPE
+  // Where send() can't be told not to raise SIGPIPE, the socket is.
+  const int no_sigpipe = 1;
+  setsockopt(sockfd_, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe,
+             sizeof(no_sigpipe));
+#endif  // SO_NOSIGPIPE
+}
+
+void UnixSocketSink::Send(const std::string& data) {
+  if (sockfd_ == -1) return;
+#ifdef MSG_NOSIGNAL
+  const int flags = MSG_NOSIGNAL;
+#else
+  const int flags = 0;
+#endif  // MSG_NOSIGNAL
+  for (size_t sent = 0; sent < data.size();) {
+    const ssize_t n =
+        send(sockfd_, data.data() + sent, data.size() - sent, flags);
+    if (n == -1 && errno == EINTR) continue;
+    if (n <= 0) {
+      // The server has gone away, so stop streaming rather than failing on
+      // every event.
+      GTEST_LOG_(WARNING) << "stream_result_to: failed to stream to unix:"
+                          << path_;
+      Close();
+      return;
+    }
+    sent += static_cast<size_t>(n);
+  }
+}
+
+// Copies the stream into a ring buffer in a file that a reader maps too, for
+// --gtest_stream_result_to=shm:PATH.  The reader creates the file with
+// kRingDataOffset + capacity bytes and this header:
+//
+//   offset   0: kRingMagic
+//   offset   8: uint32 kRingVersion
+//   offset  16: uint64 capacity, the size of the data area
+//   offset  64: uint64 write position, advanced by the writer
+//   offset 128: uint64 read position, advanced by the reader
+//   offset 192: uint32 closed flag, set by the writer when the program ends
+//   offset 256: the data area
+//
+// All of them are in native byte order.  The positions count the bytes ever
+// written and read, so the data at position pos is at offset
+// kRingDataOffset + pos % capacity, and the ring holds write - read bytes.
+// The writer publishes data by storing the write position with release
+// semantics, and the reader frees space the same way, so sending an event
+// takes no system call.  A ring has one writer.
+class SharedMemoryRingSink : public BinaryResultSink {
+ public:
+  explicit SharedMemoryRingSink(const std::string& path);
+
+  ~SharedMemoryRingSink() override {
+    if (mapping_ != nullptr) munmap(mapping_, mapping_size_);
+  }
+
+  void Send(const std::string& data) override;
+
+  void Close() override {
+    if (mapping_ != nullptr) closed()->store(1, std::memory_order_release);
+  }
+
+ private:
+  static constexpr char kRingMagic[] = "GTESTRNG";
+  static constexpr uint32_t kRingVersion = 1;
+  static constexpr size_t kWritePositionOffset = 64;
+  static constexpr size_t kReadPositionOffset = 128;
+  static constexpr size_t kClosedOffset = 192;
+  static constexpr size_t kRingDataOffset = 256;
+  // How long Send() waits for the reader to make room before giving up.
+  static constexpr TimeInMillis kStallTimeoutMillis = 10 * 1000;
+
+  template <typename T>
+  std::atomic<T>* AtomicAt(size_t offset) const {
+    return reinterpret_cast<std::atomic<T>*>(static_cast<char*>(mapping_) +
+                                             offset);
+  }
+  std::atomic<uint64_t>* write_position() const {
+    return AtomicAt<uint64_t>(kWritePositionOffset);
+  }
+  std::atomic<uint64_t>* read_position() const {
+    return AtomicAt<uint64_t>(kReadPositionOffset);
+  }
+  std::atomic<uint32_t>* closed() const {
+    return AtomicAt<uint32_t>(kClosedOffset);
+  }
+
+  // Stops streaming, logging why.
+  void Detach(const char* reason);
+
+  const std::string path_;
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  uint64_t capacity_ = 0;
+
+  SharedMemoryRingSink(const SharedMemoryRingSink&) = delete;
+  SharedMemoryRingSink& operator=(const SharedMemoryRingSink&) = delete;
+};
+
+constexpr char SharedMemoryRingSink::kRingMagic[];
+
+SharedMemoryRingSink::SharedMemoryRingSink(const std::string& path)
+    : path_(path) {
+  if (!std::atomic<uint64_t>().is_lock_free()) {
+    GTEST_LOG_(WARNING) << "stream_result_to: shared memory rings aren't "
+                        << "supported on this platform";
+    return;
+  }
+  const int fd = open(path.c_str(), O_RDWR);
+  struct stat file_stat;
+  if (fd == -1 || fstat(fd, &file_stat) == -1 ||
+      static_cast<uint64_t>(file_stat.st_size) <= kRingDataOffset) {
+    if (fd != -1) close(fd);
+    GTEST_LOG_(WARNING) << "stream_result_to: failed to open shm:" << path_;
+    return;
+  }
+  mapping_size_ = static_cast<size_t>(file_stat.st_size);
+  mapping_ =
+      mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping_ == MAP_FAILED) {
+    mapping_ = nullptr;
+    GTEST_LOG_(WARNING) << "stream_result_to: failed to map shm:" << path_;
+    return;
+  }
+
+  const char* const header = static_cast<const char*>(mapping_);
+  uint32_t version = 0;
+  memcpy(&version, header + 8, sizeof(version));
+  memcpy(&capacity_, header + 16, sizeof(capacity_));
+  if (memcmp(header, kRingMagic, sizeof(kRingMagic) - 1) != 0 ||
+      version != kRingVersion ||
+      capacity_ != mapping_size_ - kRingDataOffset) {
+    Detach("is not a result ring");
+  }
+}
+
+void SharedMemoryRingSink::Send(const std::string& data) {
+  if (mapping_ == nullptr) return;
+  char* const ring = static_cast<char*>(mapping_) + kRingDataOffset;
+  uint64_t write = write_position()->load(std::memory_order_relaxed);
+  TimeInMillis stalled_since = 0;
+  for (size_t sent = 0; sent < data.size();) {
+    const uint64_t free_bytes =
+        capacity_ - (write - read_position()->load(std::memory_order_acquire));
+    if (free_bytes == 0) {
+      // The ring is full, so wait for the reader to catch up.
+      const TimeInMillis now = GetTimeInMillis();
+      if (stalled_since == 0) stalled_since = now;
+      if (now - stalled_since > kStallTimeoutMillis) {
+        Detach("is full and its reader has stopped");
+        return;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+    stalled_since = 0;
+    const uint64_t offset = write % capacity_;
+    const auto chunk = static_cast<size_t>(
+        (std::min)({free_bytes, capacity_ - offset,
+                    static_cast<uint64_t>(data.size() - sent)}));
+    memcpy(ring + offset, data.data() + sent, chunk);
+    sent += chunk;
+    write += chunk;
+    write_position()->store(write, std::memory_order_release);
+  }
+}
+
+void SharedMemoryRingSink::Detach(const char* reason) {
+  GTEST_LOG_(WARNING) << "stream_result_to: shm:" << path_ << " " << reason;
+  munmap(mapping_, mapping_size_);
+  mapping_ = nullptr;
+}
+#endif  // GTEST_CAN_STREAM_RESULTS_
+
+// This class writes the --gtest_output=bin stream, which is also what
+// --gtest_stream_result_to sends to a Unix domain socket or a shared memory
+// ring.
+class BinaryUnitTestResultPrinter : public EmptyTestEventListener {
+ public:
+  // Writes the stream to output_file.
+  explicit BinaryUnitTestResultPrinter(const char* output_file)
+      : BinaryUnitTestResultPrinter(new BinaryFileSink(output_file)) {}
+
+  // Sends the stream to sink, taking ownership of it.
+  explicit BinaryUnitTestResultPrinter(BinaryResultSink* sink) : sink_(sink) {}
+
+  void OnTestProgramEnd(const UnitTest& unit_test) override;
+  void OnTestIterationStart(const UnitTest& unit_test, int iteration) override;
+  void OnTestStart(const TestInfo& test_info) override;
+  void OnTestPartResult(const TestPartResult& result) override;
+  void OnTestEnd(const TestInfo& test_info) override;
+  void OnTestSuiteEnd(const TestSuite& test_suite) override;
+  void OnTestIterationEnd(const UnitTest& unit_test, int iteration) override;
+
+ private:
+  // Appends the ID of str to record, first writing a kBinaryString record
+  // for str if it hasn't been seen yet.
+  void AppendString(const char* str, std::string* record);
+
+  // Adds a record with the given tag and payload to the pending records.
+  void WriteRecord(char tag, const std::string& payload);
+
+  // Sends the pending records, unless the sink batches them and they are
+  // fewer than kMaxBatchSize bytes.  If force is true, sends them
+  // regardless.  Records are forced out when a test starts, when a test part
+  // result is reported and when a test suite or iteration ends, so a reader
+  // always sees the test that is running and its failures so far.
+  void SendPending(bool force);
+
+  // Writes the properties of result, and its test part results if with_parts
+  // is true, as belonging to the given owner.
+  void WriteResult(uint8_t scope, uint32_t owner, const TestResult& result,
+                   bool with_parts);
+
+  static constexpr size_t kMaxBatchSize = 64 * 1024;
+
+  const std::unique_ptr<BinaryResultSink> sink_;
+  bool started_ = false;  // Whether the stream header has been written.
+  std::string pending_;   // The records that haven't been sent yet.
+
+  std::unordered_map<std::string, uint32_t> string_ids_;
+  // The IDs of the test suites and tests of the current iteration.
+  std::unordered_map<const TestSuite*, uint32_t> test_suite_ids_;
+  std::unordered_map<const TestInfo*, uint32_t> test_ids_;
+
+  Mutex mutex_;  // Keeps records from different threads whole.
+
+  BinaryUnitTestResultPrinter(const BinaryUnitTestResultPrinter&) = delete;
+  BinaryUnitTestResultPrinter& operator=(const BinaryUnitTestResultPrinter&) =
+      delete;
+};
+
+void BinaryUnitTestResultPrinter::OnTestProgramEnd(
+    const UnitTest& /*unit_test*/) {
+  MutexLock lock(&mutex_);
+  SendPending(true);
+  sink_->Close();
+}
+
+void BinaryUnitTestResultPrinter::OnTestIterationStart(
+    const UnitTest& unit_test, int iteration) {
+  MutexLock lock(&mutex_);
+  if (!started_) {
+    started_ = true;
+    pending_.append(kBinaryOutputMagic, sizeof(kBinaryOutputMagic) - 1);
+    AppendLittleEndian(kBinaryOutputVersion, &pending_);
+  }
+  test_suite_ids_.clear();
+  test_ids_.clear();
+
+  uint8_t flags = 0;
+  if (GTEST_FLAG_GET(shuffle)) flags |= kBinaryShuffle;
+  if (GTEST_FLAG_GET(record_resource_usage)) {
+    flags |= kBinaryRecordResourceUsage;
+  }
+  std::string record;
+  AppendLittleEndian(static_cast<uint32_t>(iteration), &record);
+  AppendLittleEndian(static_cast<int64_t>(unit_test.start_timestamp()),
+                     &record);
+  AppendLittleEndian(static_cast<int32_t>(unit_test.random_seed()), &record);
+  AppendLittleEndian(flags, &record);
+  WriteRecord(kBinaryIterationStart, record);
+
+  for (int i = 0; i < unit_test.total_test_suite_count(); ++i) {
+    const TestSuite& test_suite = *unit_test.GetTestSuite(i);
+    if (test_suite.reportable_test_count() == 0) continue;
+    const auto test_suite_id = static_cast<uint32_t>(test_suite_ids_.size());
+    test_suite_ids_[&test_suite] = test_suite_id;
+    record.clear();
+    AppendString(test_suite.name(), &record);
+    AppendString(test_suite.type_param(), &record);
+    WriteRecord(kBinaryTestSuite, record);
+
+    for (int j = 0; j < test_suite.total_test_count(); ++j) {
+      const TestInfo& test_info = *test_suite.GetTestInfo(j);
+      if (!test_info.is_reportable()) continue;
+      const auto test_id = static_cast<uint32_t>(test_ids_.size());
+      test_ids_[&test_info] = test_id;
+      record.clear();
+      AppendLittleEndian(test_suite_id, &record);
+      AppendString(test_info.name(), &record);
+      AppendString(test_info.type_param(), &record);
+      AppendString(test_info.value_param(), &record);
+      AppendString(test_info.file(), &record);
+      AppendLittleEndian(static_cast<int32_t>(test_info.line()), &record);
+      AppendLittleEndian(test_info.should_run() ? kBinaryShouldRun : uint8_t{0},
+                         &record);
+      WriteRecord(kBinaryTest, record);
+    }
+  }
+  SendPending(false);
+}
+
+void BinaryUnitTestResultPrinter::OnTestStart(const TestInfo& test_info) {
+  MutexLock lock(&mutex_);
+  const auto it = test_ids_.find(&test_info);
+  if (it == test_ids_.end()) return;
+  std::string record;
+  AppendLittleEndian(it->second, &record);
+  WriteRecord(kBinaryTestStart, record);
+  SendPending(true);
+}
+
+// Test part results are written as they are reported, so that they survive
+// a crash later in the test.  Those of test suites and of the whole program
+// are written with the rest of their results.
+void BinaryUnitTestResultPrinter::OnTestPartResult(
+    const TestPartResult& result) {
+  const TestInfo* const test_info = GetUnitTestImpl()->current_test_info();
+  if (test_info == nullptr) return;
+  MutexLock lock(&mutex_);
+  const auto it = test_ids_.find(test_info);
+  if (it == test_ids_.end()) return;
+  std::string record;
+  AppendLittleEndian(kBinaryTestScope, &record);
+  AppendLittleEndian(it->second, &record);
+  AppendLittleEndian(static_cast<int32_t>(result.type()), &record);
+  AppendString(result.file_name(), &record);
+  AppendLittleEndian(static_cast<int32_t>(result.line_number()), &record);
+  AppendString(result.message(), &record);
+  WriteRecord(kBinaryPart, record);
+  SendPending(true);
+}
+
+void BinaryUnitTestResultPrinter::OnTestEnd(const TestInfo& test_info) {
+  MutexLock lock(&mutex_);
+  const auto it = test_ids_.find(&test_info);
+  if (it == test_ids_.end()) return;
+  const TestResult& result = *test_info.result();
+  WriteResult(kBinaryTestScope, it->second, result, false);
+
+  std::string record;
+  if (GTEST_FLAG_GET(record_resource_usage)) {
+    const TestResourceUsage& usage = result.resource_usage();
+    AppendLittleEndian(it->second, &record);
+    AppendLittleEndian(usage.user_time_us, &record);
+    AppendLittleEndian(usage.system_time_us, &record);
+    AppendLittleEndian(usage.peak_rss_delta_kb, &record);
+    AppendLittleEndian(usage.voluntary_context_switches, &record);
+    AppendLittleEndian(usage.involuntary_context_switches, &record);
+    AppendLittleEndian(usage.minor_page_faults, &record);
+    AppendLittleEndian(usage.major_page_faults, &record);
+    AppendLittleEndian(usage.allocations, &record);
+    AppendLittleEndian(usage.allocated_bytes, &record);
+    WriteRecord(kBinaryResourceUsage, record);
+  }
+  const BenchmarkResult& benchmark = result.benchmark_result();
+  if (benchmark.samples > 0) {
+    record.clear();
+    AppendLittleEndian(it->second, &record);
+    AppendLittleEndian(benchmark.samples, &record);
+    AppendLittleEndian(benchmark.iterations_per_sample, &record);
+    AppendLittleEndian(benchmark.min_ns, &record);
+    AppendLittleEndian(benchmark.median_ns, &record);
+    AppendLittleEndian(benchmark.mad_ns, &record);
+    AppendLittleEndian(benchmark.p90_ns, &record);
+    AppendLittleEndian(benchmark.p99_ns, &record);
+    AppendLittleEndian(benchmark.max_ns, &record);
+    WriteRecord(kBinaryBenchmark, record);
+  }
+
+  record.clear();
+  AppendLittleEndian(it->second, &record);
+  AppendLittleEndian(static_cast<int64_t>(result.start_timestamp()), &record);
+  AppendLittleEndian(static_cast<int64_t>(result.elapsed_time()), &record);
+  WriteRecord(kBinaryTestEnd, record);
+  SendPending(false);
+}
+
+void BinaryUnitTestResultPrinter::OnTestSuiteEnd(const TestSuite& test_suite) {
+  MutexLock lock(&mutex_);
+  const auto it = test_suite_ids_.find(&test_suite);
+  if (it == test_suite_ids_.end()) return;
+  WriteResult(kBinaryTestSuiteScope, it->second,
+              test_suite.ad_hoc_test_result(), true);
+
+  std::string record;
+  AppendLittleEndian(it->second, &record);
+  AppendLittleEndian(static_cast<int64_t>(test_suite.start_timestamp()),
+                     &record);
+  AppendLittleEndian(static_cast<int64_t>(test_suite.elapsed_time()), &record);
+  WriteRecord(kBinaryTestSuiteEnd, record);
+  SendPending(true);
+}
+
+void BinaryUnitTestResultPrinter::OnTestIterationEnd(const UnitTest& unit_test,
+                                                     int /*iteration*/) {
+  MutexLock lock(&mutex_);
+  WriteResult(kBinaryProgramScope, 0, unit_test.ad_hoc_test_result(), true);
+
+  std::string record;
+  AppendLittleEndian(static_cast<int64_t>(unit_test.elapsed_time()), &record);
+  WriteRecord(kBinaryIterationEnd, record);
+  SendPending(true);
+}
+
+void BinaryUnitTestResultPrinter::AppendString(const char* str,
+                                               std::string* record) {
+  if (str == nullptr) {
+    AppendLittleEndian(kBinaryNoString, record);
+    return;
+  }
+  const auto inserted = string_ids_.emplace(
+      str, static_cast<uint32_t>(string_ids_.size()));
+  if (inserted.second) WriteRecord(kBinaryString, inserted.first->first);
+  AppendLittleEndian(inserted.first->second, record);
+}
+
+void BinaryUnitTestResultPrinter::WriteRecord(char tag,
+                                              const std::string& payload) {
+  AppendLittleEndian(static_cast<uint32_t>(payload.size() + 1), &pending_);
+  pending_.push_back(tag);
+  pending_.append(payload);
+}
+
+void BinaryUnitTestResultPrinter::SendPending(bool force) {
+  if (pending_.empty()) return;
+  if (!force && sink_->batches() && pending_.size() < kMaxBatchSize) return;
+  sink_->Send(pending_);
+  pending_.clear();
+}
+
+void BinaryUnitTestResultPrinter::WriteResult(uint8_t scope, uint32_t owner,
+                                              const TestResult& result,
+                                              bool with_parts) {
+  std::string record;
+  for (int i = 0; with_parts && i < result.total_part_count(); ++i) {
+    const TestPartResult& part = result.GetTestPartResult(i);
+    record.clear();
+    AppendLittleEndian(scope, &record);
+    AppendLittleEndian(owner, &record);
+    AppendLittleEndian(static_cast<int32_t>(part.type()), &record);
+    AppendString(part.file_name(), &record);
+    AppendLittleEndian(static_cast<int32_t>(part.line_number()), &record);
+    AppendString(part.message(), &record);
+    WriteRecord(kBinaryPart, record);
+  }
+  for (int i = 0; i < result.test_property_count(); ++i) {
+    const TestProperty& property = result.GetTestProperty(i);
+    record.clear();
+    AppendLittleEndian(scope, &record);
+    AppendLittleEndian(owner, &record);
+    AppendString(property.key(), &record);
+    AppendString(property.value(), &record);
+    WriteRecord(kBinaryProperty, record);
+  }
+}
+
+namespace {
+
+// The factory of the tests read back from a --gtest_output=bin stream, which
+// can't be run.
+class RecordedTestFactory : public TestFactoryBase {
+ public:
+  Test* CreateTest() override { return nullptr; }
+};
+
+}  // namespace
+
+void UnitTestImpl::LoadBinaryTestResults(
+    const std::string& data, size_t pos,
+    const std::vector<std::string>& strings) {
+  BinaryResultReader reader(data, pos);
+  const auto read_string = [&](const char** str) {
+    uint32_t id = 0;
+    if (!reader.Read(&id)) return false;
+    if (id == kBinaryNoString) {
+      *str = nullptr;
+      return true;
+    }
+    if (id >= strings.size()) return false;
+    *str = strings[id].c_str();
+    return true;
+  };
+
+  std::vector<TestInfo*> tests;
+  const auto read_test = [&](TestInfo** test_info) {
+    uint32_t id = 0;
+    if (!reader.Read(&id) || id >= tests.size()) return false;
+    *test_info = tests[id];
+    return true;
+  };
+  const auto read_test_suite = [&](TestSuite** test_suite) {
+    uint32_t id = 0;
+    if (!reader.Read(&id) || id >= test_suites_.size()) return false;
+    *test_suite = test_suites_[id];
+    return true;
+  };
+  // Reads the owner of a part or property record, and the XML element that
+  // the owner's properties are validated for.
+  const auto read_owner = [&](TestResult** result, const char** element) {
+    uint8_t scope = 0;
+    if (!reader.Read(&scope)) return false;
+    TestSuite* test_suite = nullptr;
+    TestInfo* test_info = nullptr;
+    uint32_t unused_owner = 0;
+    if (scope == kBinaryProgramScope && reader.Read(&unused_owner)) {
+      *result = &ad_hoc_test_result_;
+      *element = "testsuites";
+    } else if (scope == kBinaryTestSuiteScope && read_test_suite(&test_suite)) {
+      *result = &test_suite->ad_hoc_test_result_;
+      *element = "testsuite";
+    } else if (scope == kBinaryTestScope && read_test(&test_info)) {
+      *result = &test_info->result_;
+      *element = "testcase";
+    } else {
+      return false;
+    }
+    return true;
+  };
+
+  const UnitTestFilter disable_test_filter(kDisableTestFilter);
+  std::unordered_set<const TestInfo*> started_tests;
+  TestInfo* running_test = nullptr;
+  bool iteration_ended = false;
+  char tag = 0;
+  // Records that are malformed, or have tags from a later format version,
+  // are skipped.
+  while (reader.NextRecord(&tag)) {
+    if (tag == kBinaryIterationStart) {
+      uint32_t iteration = 0;
+      int64_t start_timestamp = 0;
+      uint8_t flags = 0;
+      if (!reader.Read(&iteration) || !reader.Read(&start_timestamp) ||
+          !reader.Read(&random_seed_) || !reader.Read(&flags)) {
+        continue;
+      }
+      start_timestamp_ = start_timestamp;
+      GTEST_FLAG_SET(shuffle, (flags & kBinaryShuffle) != 0);
+      GTEST_FLAG_SET(record_resource_usage,
+                     (flags & kBinaryRecordResourceUsage) != 0);
+    } else if (tag == kBinaryTestSuite) {
+      const char* name = nullptr;
+      const char* type_param = nullptr;
+      if (!read_string(&name) || !read_string(&type_param) ||
+          name == nullptr) {
+        continue;
+      }
+      test_suites_.push_back(new TestSuite(name, type_param, nullptr, nullptr));
+      test_suite_indices_.push_back(
+          static_cast<int>(test_suite_indices_.size()));
+    } else if (tag == kBinaryTest) {
+      TestSuite* test_suite = nullptr;
+      const char* name = nullptr;
+      const char* type_param = nullptr;
+      const char* value_param = nullptr;
+      const char* file = nullptr;
+      int32_t line = 0;
+      uint8_t flags = 0;
+      if (!read_test_suite(&test_suite) || !read_string(&name) ||
+          !read_string(&type_param) || !read_string(&value_param) ||
+          !read_string(&file) || !reader.Read(&line) || !reader.Read(&flags) ||
+          name == nullptr) {
+        continue;
+      }
+      TestInfo* const test_info =
+          new TestInfo(test_suite->name(), name, type_param, value_param,
+                       CodeLocation(file == nullptr ? "" : file, line),
+                       nullptr, new RecordedTestFactory);
+      test_info->is_disabled_ =
+          disable_test_filter.MatchesName(test_suite->name()) ||
+          disable_test_filter.MatchesName(name);
+      test_info->matches_filter_ = true;
+      test_info->should_run_ = (flags & kBinaryShouldRun) != 0;
+      test_suite->set_should_run(test_suite->should_run() ||
+                                 test_info->should_run_);
+      test_suite->AddTestInfo(test_info);
+      tests.push_back(test_info);
+    } else if (tag == kBinaryTestStart) {
+      if (read_test(&running_test)) started_tests.insert(running_test);
+    } else if (tag == kBinaryPart) {
+      TestResult* result = nullptr;
+      const char* element = nullptr;
+      int32_t type = 0;
+      const char* file = nullptr;
+      int32_t line = 0;
+      const char* message = nullptr;
+      if (!read_owner(&result, &element) || !reader.Read(&type) ||
+          !read_string(&file) || !reader.Read(&line) ||
+          !read_string(&message) || type < TestPartResult::kSuccess ||
+          type > TestPartResult::kSkip) {
+        continue;
+      }
+      result->AddTestPartResult(
+          TestPartResult(static_cast<TestPartResult::Type>(type), file, line,
+                         message == nullptr ? "" : message));
+    } else if (tag == kBinaryProperty) {
+      TestResult* result = nullptr;
+      const char* element = nullptr;
+      const char* key = nullptr;
+      const char* value = nullptr;
+      if (!read_owner(&result, &element) || !read_string(&key) ||
+          !read_string(&value) || key == nullptr || value == nullptr) {
+        continue;
+      }
+      result->RecordProperty(element, TestProperty(key, value));
+    } else if (tag == kBinaryResourceUsage) {
+      TestInfo* test_info = nullptr;
+      TestResourceUsage usage;
+      if (!read_test(&test_info) || !reader.Read(&usage.user_time_us) ||
+          !reader.Read(&usage.system_time_us) ||
+          !reader.Read(&usage.peak_rss_delta_kb) ||
+          !reader.Read(&usage.voluntary_context_switches) ||
+          !reader.Read(&usage.involuntary_context_switches) ||
+          !reader.Read(&usage.minor_page_faults) ||
+          !reader.Read(&usage.major_page_faults) ||
+          !reader.Read(&usage.allocations) ||
+          !reader.Read(&usage.allocated_bytes)) {
+        continue;
+      }
+      test_info->result_.set_resource_usage(usage);
+    } else if (tag == kBinaryBenchmark) {
+      TestInfo* test_info = nullptr;
+      BenchmarkResult benchmark;
+      if (!read_test(&test_info) || !reader.Read(&benchmark.samples) ||
+          !reader.Read(&benchmark.iterations_per_sample) ||
+          !reader.Read(&benchmark.min_ns) ||
+          !reader.Read(&benchmark.median_ns) ||
+          !reader.Read(&benchmark.mad_ns) || !reader.Read(&benchmark.p90_ns) ||
+          !reader.Read(&benchmark.p99_ns) || !reader.Read(&benchmark.max_ns)) {
+        continue;
+      }
+      test_info->result_.set_benchmark_result(benchmark);
+    } else if (tag == kBinaryTestEnd) {
+      TestInfo* test_info = nullptr;
+      int64_t start_timestamp = 0;
+      int64_t elapsed_time = 0;
+      if (!read_test(&test_info) || !reader.Read(&start_timestamp) ||
+          !reader.Read(&elapsed_time)) {
+        continue;
+      }
+      test_info->result_.set_start_timestamp(start_timestamp);
+      test_info->result_.set_elapsed_time(elapsed_time);
+      if (test_info == running_test) running_test = nullptr;
+    } else if (tag == kBinaryTestSuiteEnd) {
+      TestSuite* test_suite = nullptr;
+      int64_t start_timestamp = 0;
+      int64_t elapsed_time = 0;
+      if (!read_test_suite(&test_suite) || !reader.Read(&start_timestamp) ||
+          !reader.Read(&elapsed_time)) {
+        continue;
+      }
+      test_suite->start_timestamp_ = start_timestamp;
+      test_suite->elapsed_time_ = elapsed_time;
+    } else if (tag == kBinaryIterationEnd) {
+      int64_t elapsed_time = 0;
+      if (reader.Read(&elapsed_time)) elapsed_time_ = elapsed_time;
+      iteration_ended = true;
+    }
+  }
 
-  for (size_t i = 0; i < test_suites.size(); ++i) {
-    if (i != 0) {
-      *stream << ",\n";
+  // A test that the stream never started didn't run, whatever its
+  // declaration says, as when a timeout ends the run.
+  for (auto* test_suite : test_suites_) {
+    bool should_run = false;
+    for (auto* test_info : test_suite->test_info_list()) {
+      if (started_tests.count(test_info) == 0) test_info->should_run_ = false;
+      should_run = should_run || test_info->should_run_;
     }
-    PrintJsonTestSuite(stream, *test_suites[i]);
+    test_suite->set_should_run(should_run);
   }
 
-  *stream << "\n"
-          << kIndent << "]\n"
-          << "}\n";
-}
-// Produces a string representing the test properties in a result as
-// a JSON dictionary.
-std::string JsonUnitTestResultPrinter::TestPropertiesAsJson(
-    const TestResult& result, const std::string& indent) {
-  Message attributes;
-  for (int i = 0; i < result.test_property_count(); ++i) {
-    const TestProperty& property = result.GetTestProperty(i);
-    attributes << ",\n"
-               << indent << "\"" << property.key() << "\": "
-               << "\"" << EscapeJson(property.value()) << "\"";
+  if (running_test != nullptr) {
+    running_test->result_.AddTestPartResult(TestPartResult(
+        TestPartResult::kFatalFailure, nullptr, -1,
+        "The result stream ends while this test is running; the test "
+        "program may have crashed."));
+  } else if (!iteration_ended) {
+    ad_hoc_test_result_.AddTestPartResult(TestPartResult(
+        TestPartResult::kFatalFailure, nullptr, -1,
+        "The result stream ends before the tests have finished; the test "
+        "program may have crashed."));
   }
-  return attributes.GetString();
 }
-
-// End JsonUnitTestResultPrinter
+// End BinaryUnitTestResultPrinter
 #endif  // GTEST_HAS_FILE_SYSTEM
 
 #if GTEST_CAN_STREAM_RESULTS_
@@ -4985,6 +7153,21 @@ void StreamingListener::SocketWriter::MakeConnection() {
 // End of class Streaming Listener
 #endif  // GTEST_CAN_STREAM_RESULTS__
 
+// class SymbolCache
+
+const std::string& SymbolCache::Lookup(const void* pc) {
+  auto it = symbols_.find(pc);
+  if (it == symbols_.end()) {
+    char tmp[1024];
+    const char* symbol = "(unknown)";
+    if (symbolizer_(pc, tmp, sizeof(tmp))) {
+      symbol = tmp;
+    }
+    it = symbols_.emplace(pc, symbol).first;
+  }
+  return it->second;
+}
+
 // class OsStackTraceGetter
 
 const char* const OsStackTraceGetterInterface::kElidedFramesMarker =
@@ -5006,29 +7189,18 @@ std::string OsStackTraceGetter::CurrentStackTrace(int max_depth, int skip_count)
   const int raw_stack_size =
       absl::GetStackTrace(&raw_stack[0], max_depth, skip_count + 1);
 
-  void* caller_frame = nullptr;
-  {
-    MutexLock lock(&mutex_);
-    caller_frame = caller_frame_;
-  }
-
+  MutexLock lock(&mutex_);
   for (int i = 0; i < raw_stack_size; ++i) {
-    if (raw_stack[i] == caller_frame &&
+    if (raw_stack[i] == caller_frame_ &&
         !GTEST_FLAG_GET(show_internal_stack_frames)) {
       // Add a marker to the trace and stop adding frames.
       absl::StrAppend(&result, kElidedFramesMarker, "\n");
       break;
     }
 
-    char tmp[1024];
-    const char* symbol = "(unknown)";
-    if (absl::Symbolize(raw_stack[i], tmp, sizeof(tmp))) {
-      symbol = tmp;
-    }
-
-    char line[1024];
-    snprintf(line, sizeof(line), "  %p: %s\n", raw_stack[i], symbol);
-    result += line;
+    char pc[32];
+    snprintf(pc, sizeof(pc), "  %p: ", raw_stack[i]);
+    absl::StrAppend(&result, pc, symbol_cache_.Lookup(raw_stack[i]), "\n");
   }
 
   return result;
@@ -5040,6 +7212,12 @@ std::string OsStackTraceGetter::CurrentStackTrace(int max_depth, int skip_count)
 #endif  // GTEST_HAS_ABSL
 }
 
+#ifdef GTEST_HAS_ABSL
+bool OsStackTraceGetter::Symbolize(const void* pc, char* out, int out_size) {
+  return absl::Symbolize(pc, out, out_size);
+}
+#endif  // GTEST_HAS_ABSL
+
 void OsStackTraceGetter::UponLeavingGTest() GTEST_LOCK_EXCLUDED_(mutex_) {
 #ifdef GTEST_HAS_ABSL
   void* caller_frame = nullptr;
@@ -5327,6 +7505,19 @@ Environment* UnitTest::AddEnvironment(Environment* env) {
   return env;
 }
 
+// Registers and returns a global test environment that may be set up and
+// torn down concurrently with the independent environments registered next
+// to it.
+//
+// We don't protect this under mutex_, as we only support calling it
+// from the main thread.
+Environment* UnitTest::AddIndependentEnvironment(Environment* env) {
+  if (AddEnvironment(env) != nullptr) {
+    impl_->independent_environments().insert(env);
+  }
+  return env;
+}
+
 // Adds a TestPartResult to the current TestResult object.  All Google Test
 // assertion macros (e.g. ASSERT_TRUE, EXPECT_EQ, etc) eventually call
 // this to report their results.  The user code should use the
@@ -5339,18 +7530,31 @@ void UnitTest::AddTestPartResult(TestPartResult::Type result_type,
   Message msg;
   msg << message;
 
-  internal::MutexLock lock(&mutex_);
-  if (!impl_->gtest_trace_stack().empty()) {
+  // Lazy trace messages run user code, so they are formatted without
+  // holding mutex_.
+  std::vector<internal::TraceInfo> traces;
+  {
+    internal::MutexLock lock(&mutex_);
+    traces = impl_->gtest_trace_stack();
+  }
+  if (!traces.empty()) {
     msg << "\n" << GTEST_NAME_ << " trace:";
 
-    for (size_t i = impl_->gtest_trace_stack().size(); i > 0; --i) {
-      const internal::TraceInfo& trace = impl_->gtest_trace_stack()[i - 1];
+    for (size_t i = traces.size(); i > 0; --i) {
+      const internal::TraceInfo& trace = traces[i - 1];
       msg << "\n"
-          << internal::FormatFileLocation(trace.file, trace.line) << " "
-          << trace.message;
+          << internal::FormatFileLocation(trace.file, trace.line) << " ";
+      if (trace.lazy_message.format != nullptr) {
+        trace.lazy_message.format(trace.lazy_message.values, &msg);
+      } else {
+        msg << trace.message;
+      }
     }
   }
 
+  internal::TestResultsLock results_lock;
+  internal::MutexLock lock(&mutex_);
+
   if (os_stack_trace.c_str() != nullptr && !os_stack_trace.empty()) {
     msg << internal::kStackTraceMarker << os_stack_trace;
   } else {
@@ -5410,6 +7614,7 @@ void UnitTest::AddTestPartResult(TestPartResult::Type result_type,
 // the same key, the value will be updated.
 void UnitTest::RecordProperty(const std::string& key,
                               const std::string& value) {
+  internal::TestResultsLock lock;
   impl_->RecordProperty(TestProperty(key, value));
 }
 
@@ -5587,8 +7792,13 @@ UnitTestImpl::UnitTestImpl(UnitTest* parent)
       parameterized_test_registry_(),
       parameterized_tests_registered_(false),
       last_death_test_suite_(-1),
+      run_only_failed_tests_(false),
       current_test_suite_(nullptr),
       current_test_info_(nullptr),
+      current_iteration_(0),
+#ifdef GTEST_IS_THREADSAFE
+      test_watchdog_(nullptr),
+#endif  // GTEST_IS_THREADSAFE
       ad_hoc_test_result_(),
       os_stack_trace_getter_(nullptr),
       post_flag_parse_init_performed_(false),
@@ -5633,7 +7843,10 @@ void UnitTestImpl::RecordProperty(const TestProperty& test_property) {
     xml_element = "testsuites";
     test_result = &ad_hoc_test_result_;
   }
-  test_result->RecordProperty(xml_element, test_property);
+  if (test_result->RecordProperty(xml_element, test_property) &&
+      current_test_info_ != nullptr && test_property_forwarder_) {
+    test_property_forwarder_(test_property);
+  }
 }
 
 #ifdef GTEST_HAS_DEATH_TEST
@@ -5656,6 +7869,9 @@ void UnitTestImpl::ConfigureXmlOutput() {
   } else if (output_format == "json") {
     listeners()->SetDefaultXmlGenerator(new JsonUnitTestResultPrinter(
         UnitTestOptions::GetAbsolutePathToOutputFile().c_str()));
+  } else if (output_format == "bin") {
+    listeners()->SetDefaultXmlGenerator(new BinaryUnitTestResultPrinter(
+        UnitTestOptions::GetAbsolutePathToOutputFile().c_str()));
   } else if (!output_format.empty()) {
     GTEST_LOG_(WARNING) << "WARNING: unrecognized output format \""
                         << output_format << "\" ignored.";
@@ -5668,11 +7884,146 @@ void UnitTestImpl::ConfigureXmlOutput() {
 #endif  // GTEST_HAS_FILE_SYSTEM
 }
 
+#if GTEST_CAN_COUNT_PERF_EVENTS_
+// An event that PerfCounterListener counts, and the test property that it is
+// recorded as.
+struct PerfEvent {
+  const char* property;
+  uint32_t type;
+  uint64_t config;
+};
+
+static const PerfEvent kPerfEvents[] = {
+    {"perf_instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"perf_cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"perf_cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"perf_branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    // These are counted by the kernel, so they are available where the
+    // hardware counters aren't, e.g. in most containers and VMs.
+    {"perf_task_clock_ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+    {"perf_page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    {"perf_context_switches", PERF_TYPE_SOFTWARE,
+     PERF_COUNT_SW_CONTEXT_SWITCHES}};
+
+// Opens a counter for the event in this process and the threads and processes
+// it starts, and returns its file descriptor, or -1.
+static int OpenPerfCounter(const PerfEvent& event) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = event.type;
+  attr.config = event.config;
+  attr.disabled = 1;
+  attr.inherit = 1;
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // Hardware events are only counted in user space, which is what the test
+  // controls and what unprivileged users may count.  Software events like
+  // context switches happen in the kernel, so that is tried first for them.
+  attr.exclude_kernel = event.type == PERF_TYPE_HARDWARE ? 1 : 0;
+  int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                                    PERF_FLAG_FD_CLOEXEC));
+  if (fd < 0 && !attr.exclude_kernel) {
+    attr.exclude_kernel = 1;
+    fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                                  PERF_FLAG_FD_CLOEXEC));
+  }
+  return fd;
+}
+
+// Counts events with perf_event_open() from the start to the end of each
+// test, and records them as properties of the test.  Events that the kernel
+// or the hardware can't count are left out.
+class PerfCounterListener : public EmptyTestEventListener {
+ public:
+  PerfCounterListener() = default;
+  ~PerfCounterListener() override { CloseCounters(); }
+
+  void OnTestStart(const TestInfo& /* test_info */) override {
+    int open_errno = 0;
+    for (const PerfEvent& event : kPerfEvents) {
+      const int fd = OpenPerfCounter(event);
+      if (fd < 0) {
+        open_errno = errno;
+      } else {
+        counters_.push_back({&event, fd});
+      }
+    }
+    if (counters_.empty() && !warned_) {
+      warned_ = true;
+      GTEST_LOG_(WARNING) << "--" GTEST_FLAG_PREFIX_
+                             "perf_counters: perf_event_open() failed ("
+                          << posix::StrError(open_errno)
+                          << "); no events will be counted.";
+    }
+    for (const Counter& counter : counters_) {
+      ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  void OnTestEnd(const TestInfo& /* test_info */) override {
+    for (const Counter& counter : counters_) {
+      ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (const Counter& counter : counters_) {
+      // The value, and how long the counter was enabled and running.
+      uint64_t values[3] = {0, 0, 0};
+      if (read(counter.fd, values, sizeof(values)) !=
+              static_cast<ssize_t>(sizeof(values)) ||
+          values[2] == 0) {
+        continue;
+      }
+      // Scales the value up if the kernel had to share the hardware
+      // counters with other events.
+      double value = static_cast<double>(values[0]);
+      if (values[2] < values[1]) {
+        value = value * static_cast<double>(values[1]) /
+                static_cast<double>(values[2]);
+      }
+      Test::RecordProperty(counter.event->property,
+                           StreamableToString(static_cast<uint64_t>(value)));
+    }
+    CloseCounters();
+  }
+
+ private:
+  struct Counter {
+    const PerfEvent* event;
+    int fd;
+  };
+
+  void CloseCounters() {
+    for (const Counter& counter : counters_) close(counter.fd);
+    counters_.clear();
+  }
+
+  std::vector<Counter> counters_;
+  bool warned_ = false;
+
+  PerfCounterListener(const PerfCounterListener&) = delete;
+  PerfCounterListener& operator=(const PerfCounterListener&) = delete;
+};
+#endif  // GTEST_CAN_COUNT_PERF_EVENTS_
+
 #if GTEST_CAN_STREAM_RESULTS_
-// Initializes event listeners for streaming test results in string form.
-// Must not be called before InitGoogleTest.
+// Initializes event listeners for streaming test results in string form,
+// or in the --gtest_output=bin format to a local reader.  Must not be called
+// before InitGoogleTest.
 void UnitTestImpl::ConfigureStreamingOutput() {
   const std::string& target = GTEST_FLAG_GET(stream_result_to);
+#if GTEST_HAS_FILE_SYSTEM
+  if (target.compare(0, 5, "unix:") == 0) {
+    listeners()->Append(new BinaryUnitTestResultPrinter(
+        new UnixSocketSink(target.substr(5))));
+    return;
+  }
+  if (target.compare(0, 4, "shm:") == 0) {
+    listeners()->Append(new BinaryUnitTestResultPrinter(
+        new SharedMemoryRingSink(target.substr(4))));
+    return;
+  }
+#endif  // GTEST_HAS_FILE_SYSTEM
   if (!target.empty()) {
     const size_t pos = target.find(':');
     if (pos != std::string::npos) {
@@ -5719,11 +8070,29 @@ void UnitTestImpl::PostFlagParsingInit() {
       listeners()->SetDefaultResultPrinter(new BriefUnitTestResultPrinter);
     }
 
+#if !GTEST_CAN_ISOLATE_TESTS_
+    bool in_death_test_child_process = false;
+#ifdef GTEST_HAS_DEATH_TEST
+    in_death_test_child_process = internal_run_death_test_flag_ != nullptr;
+#endif  // GTEST_HAS_DEATH_TEST
+    if (GTEST_FLAG_GET(isolate_tests) && !in_death_test_child_process) {
+      GTEST_LOG_(WARNING) << "WARNING: --" GTEST_FLAG_PREFIX_
+                             "isolate_tests isn't supported on this "
+                             "platform; the tests run in this process.";
+    }
+#endif  // !GTEST_CAN_ISOLATE_TESTS_
+
 #if GTEST_CAN_STREAM_RESULTS_
     // Configures listeners for streaming test results to the specified server.
     ConfigureStreamingOutput();
 #endif  // GTEST_CAN_STREAM_RESULTS_
 
+#if GTEST_CAN_COUNT_PERF_EVENTS_
+    if (GTEST_FLAG_GET(perf_counters)) {
+      listeners()->Append(new PerfCounterListener);
+    }
+#endif  // GTEST_CAN_COUNT_PERF_EVENTS_
+
 #ifdef GTEST_HAS_ABSL
     if (GTEST_FLAG_GET(install_failure_signal_handler)) {
       absl::FailureSignalHandlerOptions options;
@@ -5802,10 +8171,82 @@ TestSuite* UnitTestImpl::GetTestSuite(
   return new_test_suite;
 }
 
-// Helpers for setting up / tearing down the given environment.  They
-// are for use in the ForEach() function.
-static void SetUpEnvironment(Environment* env) { env->SetUp(); }
-static void TearDownEnvironment(Environment* env) { env->TearDown(); }
+#ifdef GTEST_IS_THREADSAFE
+// Calls method on each of the count environments concurrently, each on a
+// thread of its own.  The failures they generate are reported in the order
+// of the environments once all of them are done, followed by the first
+// exception that escaped one of them.
+static void RunEnvironmentsConcurrently(Environment* const* environments,
+                                        size_t count,
+                                        void (Environment::*method)()) {
+  struct Outcome {
+    TestPartResultArray results;
+#if GTEST_HAS_EXCEPTIONS
+    std::exception_ptr exception;
+#endif  // GTEST_HAS_EXCEPTIONS
+  };
+  std::vector<Outcome> outcomes(count);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < count; ++i) {
+    threads.emplace_back([environments, method, &outcomes, i] {
+      ScopedFakeTestPartResultReporter reporter(
+          ScopedFakeTestPartResultReporter::INTERCEPT_ONLY_CURRENT_THREAD,
+          &outcomes[i].results);
+#if GTEST_HAS_EXCEPTIONS
+      try {
+        (environments[i]->*method)();
+      } catch (...) {
+        outcomes[i].exception = std::current_exception();
+      }
+#else
+      (environments[i]->*method)();
+#endif  // GTEST_HAS_EXCEPTIONS
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  TestPartResultReporterInterface* const reporter =
+      GetUnitTestImpl()->GetTestPartResultReporterForCurrentThread();
+  for (const Outcome& outcome : outcomes) {
+    for (int i = 0; i < outcome.results.size(); ++i) {
+      reporter->ReportTestPartResult(outcome.results.GetTestPartResult(i));
+    }
+  }
+#if GTEST_HAS_EXCEPTIONS
+  for (const Outcome& outcome : outcomes) {
+    if (outcome.exception) std::rethrow_exception(outcome.exception);
+  }
+#endif  // GTEST_HAS_EXCEPTIONS
+}
+#endif  // GTEST_IS_THREADSAFE
+
+// Calls method on each of the environments in order, except that consecutive
+// environments that were all registered as independent are called
+// concurrently where Google Test is thread-safe.
+static void RunEnvironments(const std::vector<Environment*>& environments,
+                            const std::set<const Environment*>& independent,
+                            void (Environment::*method)()) {
+  for (size_t i = 0; i < environments.size();) {
+    size_t end = i + 1;
+#ifdef GTEST_IS_THREADSAFE
+    if (independent.count(environments[i]) != 0) {
+      while (end < environments.size() &&
+             independent.count(environments[end]) != 0) {
+        ++end;
+      }
+    }
+    if (end - i > 1) {
+      RunEnvironmentsConcurrently(&environments[i], end - i, method);
+      i = end;
+      continue;
+    }
+#else
+    static_cast<void>(independent);
+#endif  // GTEST_IS_THREADSAFE
+    (environments[i]->*method)();
+    i = end;
+  }
+}
 
 // Runs all tests in this UnitTest object, prints the result, and
 // returns true if all tests are successful.  If any exception is
@@ -5851,6 +8292,14 @@ bool UnitTestImpl::RunAllTests() {
   const bool should_shard = ShouldShard(kTestTotalShards, kTestShardIndex,
                                         in_subprocess_for_death_test);
 
+  // Brings the manifest up to date with every registered test, before the
+  // filter narrows them down.
+  if (!in_subprocess_for_death_test) WriteManifestIfStale();
+
+  // Reads the previous report, if one is wanted, before the report of this
+  // run overwrites it.
+  LoadPreviouslyFailedTests();
+
   // Compares the full test names with the filter to decide which
   // tests to run.
   const bool has_tests_to_run =
@@ -5907,7 +8356,12 @@ bool UnitTestImpl::RunAllTests() {
       ShuffleTests();
     }
 
+    if (has_tests_to_run && GTEST_FLAG_GET(failed_first)) {
+      MoveFailedTestsFirst();
+    }
+
     // Tells the unit test event listeners that the tests are about to start.
+    current_iteration_ = i;
     repeater->OnTestIterationStart(*parent_, i);
 
     // Runs each test suite if there is at least one test to run.
@@ -5916,7 +8370,8 @@ bool UnitTestImpl::RunAllTests() {
       // recreated for each iteration, only do so on the first iteration.
       if (i == 0 || recreate_environments_when_repeating) {
         repeater->OnEnvironmentsSetUpStart(*parent_);
-        ForEach(environments_, SetUpEnvironment);
+        RunEnvironments(environments_, independent_environments_,
+                        &Environment::SetUp);
         repeater->OnEnvironmentsSetUpEnd(*parent_);
       }
 
@@ -5963,8 +8418,10 @@ bool UnitTestImpl::RunAllTests() {
       // last iteration.
       if (i == repeat - 1 || recreate_environments_when_repeating) {
         repeater->OnEnvironmentsTearDownStart(*parent_);
-        std::for_each(environments_.rbegin(), environments_.rend(),
-                      TearDownEnvironment);
+        RunEnvironments(
+            std::vector<Environment*>(environments_.rbegin(),
+                                      environments_.rend()),
+            independent_environments_, &Environment::TearDown);
         repeater->OnEnvironmentsTearDownEnd(*parent_);
       }
     }
@@ -5999,6 +8456,7 @@ bool UnitTestImpl::RunAllTests() {
   if (delete_environment_on_teardown) {
     ForEach(environments_, internal::Delete<Environment>);
     environments_.clear();
+    independent_environments_.clear();
   }
 
   if (!gtest_is_initialized_before_run_all_tests) {
@@ -6108,6 +8566,241 @@ bool ShouldRunTestOnShard(int total_shards, int shard_index, int test_id) {
   return (test_id % total_shards) == shard_index;
 }
 
+// Decodes the entities XmlUnitTestResultPrinter writes in attribute values.
+static std::string UnescapeXmlAttribute(const std::string& value) {
+  std::string result;
+  for (size_t i = 0; i < value.size(); ++i) {
+    const size_t semicolon =
+        value[i] == '&' ? value.find(';', i) : std::string::npos;
+    if (semicolon == std::string::npos) {
+      result += value[i];
+      continue;
+    }
+    const std::string entity = value.substr(i + 1, semicolon - i - 1);
+    if (entity == "lt") {
+      result += '<';
+    } else if (entity == "gt") {
+      result += '>';
+    } else if (entity == "amp") {
+      result += '&';
+    } else if (entity == "quot") {
+      result += '"';
+    } else if (entity == "apos") {
+      result += '\'';
+    } else if (entity.size() > 1 && entity[0] == '#') {
+      const bool hex = entity[1] == 'x' || entity[1] == 'X';
+      const uint32_t code_point = static_cast<uint32_t>(
+          strtoul(entity.c_str() + (hex ? 2 : 1), nullptr, hex ? 16 : 10));
+      result += CodePointToUtf8(code_point);
+    } else {
+      result.append(value, i, semicolon - i + 1);
+    }
+    i = semicolon;
+  }
+  return result;
+}
+
+// Returns the unescaped value of the attribute called name in the given
+// start tag, or "" if the tag has no such attribute.
+static std::string GetXmlAttribute(const std::string& tag,
+                                   const std::string& name) {
+  const std::string prefix = " " + name + "=\"";
+  const size_t start = tag.find(prefix);
+  if (start == std::string::npos) return "";
+  const size_t value_start = start + prefix.size();
+  const size_t value_end = tag.find('"', value_start);
+  if (value_end == std::string::npos) return "";
+  return UnescapeXmlAttribute(
+      tag.substr(value_start, value_end - value_start));
+}
+
+// Collects the tests with a <failure> element.  Failure messages are in
+// CDATA sections, which are skipped so that their text is never mistaken
+// for markup.
+static void ParseFailedTestsFromXml(const std::string& report,
+                                    std::set<std::string>* failed) {
+  std::string current_test;
+  size_t pos = report.find('<');
+  while (pos != std::string::npos) {
+    if (report.compare(pos, 9, "<![CDATA[") == 0) {
+      pos = report.find("]]>", pos);
+      if (pos == std::string::npos) break;
+    } else if (report.compare(pos, 10, "<testcase ") == 0) {
+      const size_t end = report.find('>', pos);
+      if (end == std::string::npos) break;
+      const std::string tag = report.substr(pos, end - pos);
+      current_test.clear();
+      if (report[end - 1] != '/') {
+        current_test = GetXmlAttribute(tag, "classname") + "." +
+                       GetXmlAttribute(tag, "name");
+      }
+      pos = end;
+    } else if (report.compare(pos, 11, "</testcase>") == 0) {
+      current_test.clear();
+    } else if (report.compare(pos, 9, "<failure ") == 0 &&
+               !current_test.empty()) {
+      failed->insert(current_test);
+    }
+    pos = report.find('<', pos + 1);
+  }
+}
+
+// Reads the JSON string starting at the quote at report[*pos], leaving *pos
+// just past its closing quote.
+static std::string ReadJsonString(const std::string& report, size_t* pos) {
+  std::string result;
+  size_t i = *pos + 1;
+  for (; i < report.size() && report[i] != '"'; ++i) {
+    if (report[i] != '\\' || i + 1 == report.size()) {
+      result += report[i];
+      continue;
+    }
+    const char escaped = report[++i];
+    switch (escaped) {
+      case 'b':
+        result += '\b';
+        break;
+      case 'f':
+        result += '\f';
+        break;
+      case 'n':
+        result += '\n';
+        break;
+      case 'r':
+        result += '\r';
+        break;
+      case 't':
+        result += '\t';
+        break;
+      case 'u':
+        result += CodePointToUtf8(static_cast<uint32_t>(
+            strtoul(report.substr(i + 1, 4).c_str(), nullptr, 16)));
+        i += 4;
+        break;
+      default:
+        result += escaped;
+        break;
+    }
+  }
+  *pos = i + 1;
+  return result;
+}
+
+// Collects the tests that have a "failures" array.  Within a test object
+// JsonUnitTestResultPrinter writes "name" first and "classname" last before
+// "failures"; suites and the whole run have numeric "failures" fields.
+static void ParseFailedTestsFromJson(const std::string& report,
+                                     std::set<std::string>* failed) {
+  std::string key;
+  std::string name;
+  std::string last_test;
+  size_t pos = report.find('"');
+  while (pos != std::string::npos && pos < report.size()) {
+    const std::string str = ReadJsonString(report, &pos);
+    const size_t next = report.find_first_not_of(" \t\r\n", pos);
+    if (next != std::string::npos && report[next] == ':') {
+      key = str;
+      const size_t value = report.find_first_not_of(" \t\r\n", next + 1);
+      if (key == "failures" && value != std::string::npos &&
+          report[value] == '[' && !last_test.empty()) {
+        failed->insert(last_test);
+      }
+    } else if (key == "name") {
+      name = str;
+    } else if (key == "classname") {
+      last_test = str + "." + name;
+    }
+    pos = report.find('"', pos);
+  }
+}
+
+bool ParseFailedTestsFromReport(const std::string& report,
+                                std::set<std::string>* failed) {
+  const size_t start = report.find_first_not_of(" \t\r\n");
+  if (start == std::string::npos) return false;
+  if (report[start] == '<') {
+    ParseFailedTestsFromXml(report, failed);
+  } else if (report[start] == '{') {
+    ParseFailedTestsFromJson(report, failed);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void UnitTestImpl::LoadPreviouslyFailedTests() {
+  previously_failed_tests_.clear();
+  run_only_failed_tests_ = false;
+
+  const std::string& rerun_failed = GTEST_FLAG_GET(rerun_failed);
+  if (rerun_failed.empty() && !GTEST_FLAG_GET(failed_first)) return;
+#if GTEST_HAS_FILE_SYSTEM
+  std::string path = rerun_failed;
+  if (path.empty()) {
+    const std::string format = UnitTestOptions::GetOutputFormat();
+    if (format != "xml" && format != "json") {
+      GTEST_LOG_(WARNING) << "WARNING: --" GTEST_FLAG_PREFIX_
+                             "failed_first needs a previous report; give "
+                             "--" GTEST_FLAG_PREFIX_
+                             "rerun_failed or --" GTEST_FLAG_PREFIX_
+                             "output.";
+      return;
+    }
+    path = UnitTestOptions::GetAbsolutePathToOutputFile();
+  }
+
+  FILE* const file = posix::FOpen(path.c_str(), "r");
+  if (file == nullptr) {
+    // A missing report is expected the first time round, so everything runs.
+    GTEST_LOG_(WARNING) << "WARNING: unable to read test report \"" << path
+                        << "\"; running all tests.";
+    return;
+  }
+  const std::string report = ReadEntireFile(file);
+  posix::FClose(file);
+  if (!ParseFailedTestsFromReport(report, &previously_failed_tests_)) {
+    GTEST_LOG_(WARNING) << "WARNING: \"" << path
+                        << "\" is not an XML or JSON test report; running all "
+                           "tests.";
+    return;
+  }
+  run_only_failed_tests_ =
+      !rerun_failed.empty() && !GTEST_FLAG_GET(failed_first);
+#else
+  GTEST_LOG_(ERROR) << "ERROR: reading previous test reports requires "
+                    << "GTEST_HAS_FILE_SYSTEM to be enabled";
+#endif  // GTEST_HAS_FILE_SYSTEM
+}
+
+void UnitTestImpl::MoveFailedTestsFirst() {
+  if (previously_failed_tests_.empty()) return;
+
+  std::vector<bool> suite_has_failure(test_suites_.size());
+  for (size_t i = 0; i < test_suites_.size(); ++i) {
+    TestSuite* const test_suite = test_suites_[i];
+    const std::string prefix = std::string(test_suite->name()) + ".";
+    const auto failed_before = [&](int index) {
+      return previously_failed_tests_.count(
+                 prefix + test_suite->test_info_list()[static_cast<size_t>(
+                              index)]->name()) != 0;
+    };
+    const auto first_passed =
+        std::stable_partition(test_suite->test_indices_.begin(),
+                              test_suite->test_indices_.end(), failed_before);
+    suite_has_failure[i] = first_passed != test_suite->test_indices_.begin();
+  }
+
+  const auto has_failure = [&](int index) {
+    return suite_has_failure[static_cast<size_t>(index)];
+  };
+  const auto first_non_death_suite =
+      test_suite_indices_.begin() + (last_death_test_suite_ + 1);
+  std::stable_partition(test_suite_indices_.begin(), first_non_death_suite,
+                        has_failure);
+  std::stable_partition(first_non_death_suite, test_suite_indices_.end(),
+                        has_failure);
+}
+
 // Compares the name of each test with the user-specified filter to
 // decide whether the test should be run, then records the result in
 // each TestSuite and TestInfo object.
@@ -6146,8 +8839,14 @@ int UnitTestImpl::FilterTests(ReactionToSharding shard_tests) {
           disable_test_filter.MatchesName(test_name);
       test_info->is_disabled_ = is_disabled;
 
+      // Benchmarks are left out of the run, and of the reports, unless
+      // --gtest_run_benchmarks is given.
       const bool matches_filter =
-          gtest_flag_filter.MatchesTest(test_suite_name, test_name);
+          gtest_flag_filter.MatchesTest(test_suite_name, test_name) &&
+          (!run_only_failed_tests_ ||
+           previously_failed_tests_.count(test_suite_name + "." + test_name) !=
+               0) &&
+          (!test_info->is_benchmark() || GTEST_FLAG_GET(run_benchmarks));
       test_info->matches_filter_ = matches_filter;
 
       const bool is_runnable =
@@ -6247,6 +8946,137 @@ void UnitTestImpl::ListTestsMatchingFilter() {
 #endif  // GTEST_HAS_FILE_SYSTEM
 }
 
+#ifdef GTEST_IS_THREADSAFE
+// Finishes the events of the run for a test that has timed out, as if it had
+// been the last test, so that the listeners write their reports.
+void UnitTestImpl::EndRunAfterTimeout(TestInfo* test_info,
+                                      TimeInMillis elapsed_time) {
+  test_info->result_.set_elapsed_time(elapsed_time);
+  // The tests that haven't started yet won't run, so they are reported as
+  // not run rather than as passed.
+  for (auto* test_suite : test_suites_) {
+    for (auto* other : test_suite->test_info_list()) {
+      if (other != test_info && other->result_.start_timestamp() == 0) {
+        other->should_run_ = false;
+      }
+    }
+  }
+  TestEventListener* const repeater = listeners()->repeater();
+  repeater->OnTestEnd(*test_info);
+  repeater->OnTestSuiteEnd(*current_test_suite_);
+  elapsed_time_ = GetTimeInMillis() - start_timestamp_;
+  repeater->OnTestIterationEnd(*parent_, current_iteration_);
+  repeater->OnTestProgramEnd(*parent_);
+}
+
+void UnitTestImpl::LockTestResults() {
+  if (test_results_claimed_.load(std::memory_order_acquire) &&
+      test_results_claimant_ != std::this_thread::get_id()) {
+    // A watchdog is reporting the test as timed out and will abort it.
+    // Competing for the lock could starve the watchdog, so this thread
+    // just waits.
+    for (;;) std::this_thread::sleep_for(std::chrono::seconds(1));
+  }
+  test_results_mutex_.lock();
+}
+
+bool UnitTestImpl::ClaimTestResults(int timeout_ms) {
+  test_results_claimant_ = std::this_thread::get_id();
+  test_results_claimed_.store(true, std::memory_order_release);
+  // From here on, the test's thread can only finish the result it may be
+  // recording now.
+  return test_results_mutex_.try_lock_for(
+      std::chrono::milliseconds(timeout_ms));
+}
+#endif  // GTEST_IS_THREADSAFE
+
+#if GTEST_HAS_FILE_SYSTEM
+// Returns the file named by --gtest_manifest: the flag's value, or
+// <program name>.json in it if it names a directory.
+static std::string GetManifestPath() {
+  const FilePath manifest(GTEST_FLAG_GET(manifest));
+  if (!manifest.IsDirectory()) return manifest.string();
+  return FilePath::MakeFileName(manifest, GetCurrentExecutableName(), 0,
+                                "json")
+      .string();
+}
+
+// Writes contents to path by way of a temporary file in the same directory,
+// so that a crash, or another process writing the same file at the same
+// time, never leaves it half written.  Returns false on failure.
+static bool ReplaceFileContents(const std::string& path,
+                                const std::string& contents) {
+#ifdef GTEST_OS_WINDOWS
+  const unsigned long pid = ::GetCurrentProcessId();  // NOLINT
+#else
+  const long pid = static_cast<long>(getpid());  // NOLINT
+#endif  // GTEST_OS_WINDOWS
+  const std::string temp_path = path + ".tmp" + StreamableToString(pid);
+
+  if (!FilePath(path).RemoveFileName().CreateDirectoriesRecursively()) {
+    return false;
+  }
+  FILE* const fileout = posix::FOpen(temp_path.c_str(), "w");
+  if (fileout == nullptr) return false;
+  bool written = fwrite(contents.data(), 1, contents.size(), fileout) ==
+                 contents.size();
+  written = posix::FClose(fileout) == 0 && written;
+#ifdef GTEST_OS_WINDOWS
+  written = written && ::MoveFileExA(temp_path.c_str(), path.c_str(),
+                                     MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  written = written && rename(temp_path.c_str(), path.c_str()) == 0;
+#endif  // GTEST_OS_WINDOWS
+  if (!written) remove(temp_path.c_str());
+  return written;
+}
+#endif  // GTEST_HAS_FILE_SYSTEM
+
+// Writes the list of all tests to the --gtest_manifest file if it is missing
+// or older than the test program.
+void UnitTestImpl::WriteManifestIfStale() {
+  if (GTEST_FLAG_GET(manifest).empty()) return;
+#if GTEST_HAS_FILE_SYSTEM
+  const std::string manifest = GetManifestPath();
+  // If argv[0] can't be found, e.g. because the program was found through
+  // PATH, the manifest is always rewritten.
+  posix::StatStruct manifest_stat;
+  posix::StatStruct program_stat;
+  if (posix::Stat(manifest.c_str(), &manifest_stat) == 0 &&
+      !GetArgvs().empty() &&
+      posix::Stat(GetArgvs()[0].c_str(), &program_stat) == 0 &&
+      manifest_stat.st_mtime > program_stat.st_mtime) {
+    return;
+  }
+
+  // Every test goes in the manifest.  FilterTests() decides afresh which
+  // ones are reported for this run.
+  for (auto* test_suite : test_suites_) {
+    for (auto* test_info : test_suite->test_info_list()) {
+      test_info->matches_filter_ = true;
+      test_info->is_in_another_shard_ = false;
+    }
+  }
+
+  // The JSON printer leaves out the results while tests are being listed.
+  const bool list_tests = GTEST_FLAG_GET(list_tests);
+  GTEST_FLAG_SET(list_tests, true);
+  std::stringstream stream;
+  JsonUnitTestResultPrinter::PrintJsonTestList(&stream, test_suites_);
+  GTEST_FLAG_SET(list_tests, list_tests);
+
+  // A manifest is only a convenience for other tools, so failing to write
+  // it mustn't fail the tests.
+  if (!ReplaceFileContents(manifest, StringStreamToString(&stream))) {
+    GTEST_LOG_(WARNING) << "Unable to write the test manifest \"" << manifest
+                        << "\"";
+  }
+#else
+  GTEST_LOG_(ERROR) << "ERROR: writing a test manifest requires "
+                    << "GTEST_HAS_FILE_SYSTEM to be enabled";
+#endif  // GTEST_HAS_FILE_SYSTEM
+}
+
 // Sets the OS stack trace getter.
 //
 // Does nothing if the input and the current OS stack trace getter are
@@ -6524,6 +9354,12 @@ static const char kColorEncodedHelpMessage[] =
     "  @G--" GTEST_FLAG_PREFIX_
     "also_run_disabled_tests@D\n"
     "      Run all disabled tests too.\n"
+    "  @G--" GTEST_FLAG_PREFIX_
+    "run_benchmarks@D\n"
+    "      Run the benchmarks defined with BENCHMARK_TEST() too.\n"
+    "  @G--" GTEST_FLAG_PREFIX_
+    "rerun_failed=@YREPORT_PATH@D\n"
+    "      Run only the tests that failed in the given XML or JSON report.\n"
     "\n"
     "Test Execution:\n"
     "  @G--" GTEST_FLAG_PREFIX_
@@ -6533,6 +9369,11 @@ static const char kColorEncodedHelpMessage[] =
     "shuffle@D\n"
     "      Randomize tests' orders on every iteration.\n"
     "  @G--" GTEST_FLAG_PREFIX_
+    "failed_first@D\n"
+    "      Run the tests that failed in the previous report first. The report\n"
+    "      is the @G--" GTEST_FLAG_PREFIX_ "rerun_failed@D one if given, or else "
+    "the @G--" GTEST_FLAG_PREFIX_ "output@D file.\n"
+    "  @G--" GTEST_FLAG_PREFIX_
     "random_seed=@Y[NUMBER]@D\n"
     "      Random number seed to use for shuffling test orders (between 1 and\n"
     "      99999, or 0 to use a seed based on the current time).\n"
@@ -6540,6 +9381,19 @@ static const char kColorEncodedHelpMessage[] =
     "recreate_environments_when_repeating@D\n"
     "      Sets up and tears down the global test environment on each repeat\n"
     "      of the test.\n"
+#if GTEST_CAN_ISOLATE_TESTS_
+    "  @G--" GTEST_FLAG_PREFIX_
+    "isolate_tests@D\n"
+    "      Run each test in a child process forked after the set-up of its\n"
+    "      test suite.\n"
+#endif  // GTEST_CAN_ISOLATE_TESTS_
+#ifdef GTEST_IS_THREADSAFE
+    "  @G--" GTEST_FLAG_PREFIX_
+    "test_timeout_ms=@Y[MILLISECONDS]@D\n"
+    "      Fail a test that runs for longer than this and abort the program,\n"
+    "      or only the test's process with @G--" GTEST_FLAG_PREFIX_
+    "isolate_tests@D.\n"
+#endif  // GTEST_IS_THREADSAFE
     "\n"
     "Test Output:\n"
     "  @G--" GTEST_FLAG_PREFIX_
@@ -6552,15 +9406,34 @@ static const char kColorEncodedHelpMessage[] =
     "print_time=0@D\n"
     "      Don't print the elapsed time of each test.\n"
     "  @G--" GTEST_FLAG_PREFIX_
-    "output=@Y(@Gjson@Y|@Gxml@Y)[@G:@YDIRECTORY_PATH@G" GTEST_PATH_SEP_
+    "output=@Y(@Gjson@Y|@Gxml@Y|@Gbin@Y)[@G:@YDIRECTORY_PATH@G" GTEST_PATH_SEP_
     "@Y|@G:@YFILE_PATH]@D\n"
-    "      Generate a JSON or XML report in the given directory or with the "
+    "      Generate a JSON or XML report, or a binary result stream, in the "
     "given\n"
-    "      file name. @YFILE_PATH@D defaults to @Gtest_detail.xml@D.\n"
+    "      directory or with the given file name. @YFILE_PATH@D defaults to\n"
+    "      @Gtest_detail.xml@D.\n"
+    "  @G--" GTEST_FLAG_PREFIX_
+    "record_resource_usage@D\n"
+    "      Report the CPU time, peak RSS growth, context switches and page\n"
+    "      faults of each test.\n"
+#if GTEST_CAN_COUNT_PERF_EVENTS_
+    "  @G--" GTEST_FLAG_PREFIX_
+    "perf_counters@D\n"
+    "      Record the instructions, cycles, cache and branch misses, task\n"
+    "      clock, page faults and context switches of each test as test\n"
+    "      properties.\n"
+#endif  // GTEST_CAN_COUNT_PERF_EVENTS_
+    "  @G--" GTEST_FLAG_PREFIX_
+    "manifest=@YDIRECTORY_PATH@G" GTEST_PATH_SEP_ "@Y|@YFILE_PATH@D\n"
+    "      Keep a JSON list of all tests in the given file, or in the file\n"
+    "      named after this program in the given directory, rewriting it when\n"
+    "      it is older than this program.\n"
 #if GTEST_CAN_STREAM_RESULTS_
     "  @G--" GTEST_FLAG_PREFIX_
-    "stream_result_to=@YHOST@G:@YPORT@D\n"
-    "      Stream test results to the given server.\n"
+    "stream_result_to=@Y(@YHOST@G:@YPORT@Y|@Gunix:@YSOCKET_PATH@Y|"
+    "@Gshm:@YRING_PATH@Y)@D\n"
+    "      Stream test results to the given server, or in binary form to a\n"
+    "      local reader.\n"
 #endif  // GTEST_CAN_STREAM_RESULTS_
     "\n"
     "Assertion Behavior:\n"
@@ -6616,19 +9489,27 @@ static bool ParseGoogleTestFlag(const char* const arg) {
   GTEST_INTERNAL_PARSE_FLAG(death_test_style);
   GTEST_INTERNAL_PARSE_FLAG(death_test_use_fork);
   GTEST_INTERNAL_PARSE_FLAG(fail_fast);
+  GTEST_INTERNAL_PARSE_FLAG(failed_first);
   GTEST_INTERNAL_PARSE_FLAG(filter);
   GTEST_INTERNAL_PARSE_FLAG(internal_run_death_test);
+  GTEST_INTERNAL_PARSE_FLAG(isolate_tests);
   GTEST_INTERNAL_PARSE_FLAG(list_tests);
+  GTEST_INTERNAL_PARSE_FLAG(manifest);
   GTEST_INTERNAL_PARSE_FLAG(output);
+  GTEST_INTERNAL_PARSE_FLAG(perf_counters);
   GTEST_INTERNAL_PARSE_FLAG(brief);
   GTEST_INTERNAL_PARSE_FLAG(print_time);
   GTEST_INTERNAL_PARSE_FLAG(print_utf8);
   GTEST_INTERNAL_PARSE_FLAG(random_seed);
+  GTEST_INTERNAL_PARSE_FLAG(record_resource_usage);
   GTEST_INTERNAL_PARSE_FLAG(repeat);
+  GTEST_INTERNAL_PARSE_FLAG(rerun_failed);
   GTEST_INTERNAL_PARSE_FLAG(recreate_environments_when_repeating);
+  GTEST_INTERNAL_PARSE_FLAG(run_benchmarks);
   GTEST_INTERNAL_PARSE_FLAG(shuffle);
   GTEST_INTERNAL_PARSE_FLAG(stack_trace_depth);
   GTEST_INTERNAL_PARSE_FLAG(stream_result_to);
+  GTEST_INTERNAL_PARSE_FLAG(test_timeout_ms);
   GTEST_INTERNAL_PARSE_FLAG(throw_on_failure);
   return false;
 }
@@ -6855,6 +9736,61 @@ void InitGoogleTest() {
 #endif  // defined(GTEST_CUSTOM_INIT_GOOGLE_TEST_FUNCTION_)
 }
 
+bool ConvertBinaryTestResults(const std::string& input_path,
+                              const std::string& output) {
+#if GTEST_HAS_FILE_SYSTEM
+  const size_t colon = output.find(':');
+  if (colon == std::string::npos || colon + 1 == output.size()) return false;
+  const std::string format = output.substr(0, colon);
+  const std::string output_path = output.substr(colon + 1);
+  if (format != "xml" && format != "json") return false;
+
+  FILE* const file = internal::posix::FOpen(input_path.c_str(), "rb");
+  if (file == nullptr) return false;
+  const std::string data = internal::ReadEntireFile(file);
+  fclose(file);
+  const size_t magic_size = sizeof(internal::kBinaryOutputMagic) - 1;
+  if (data.size() < internal::kBinaryOutputHeaderSize ||
+      data.compare(0, magic_size, internal::kBinaryOutputMagic) != 0 ||
+      internal::DecodeLittleEndian<uint32_t>(data.data() + magic_size) !=
+          internal::kBinaryOutputVersion) {
+    return false;
+  }
+
+  // Strings may be interned in an earlier iteration than the last one, which
+  // is the one converted.
+  std::vector<std::string> strings;
+  size_t last_iteration = data.size();
+  internal::BinaryResultReader reader(data,
+                                      internal::kBinaryOutputHeaderSize);
+  char tag = 0;
+  while (reader.NextRecord(&tag)) {
+    if (tag == internal::kBinaryString) {
+      strings.push_back(reader.ReadRest());
+    } else if (tag == internal::kBinaryIterationStart) {
+      last_iteration = reader.record_offset();
+    }
+  }
+
+  internal::GTestFlagSaver flag_saver;
+  GTEST_FLAG_SET(list_tests, false);
+  UnitTest unit_test;
+  unit_test.impl()->LoadBinaryTestResults(data, last_iteration, strings);
+  if (format == "xml") {
+    internal::XmlUnitTestResultPrinter(output_path.c_str())
+        .OnTestIterationEnd(unit_test, 0);
+  } else {
+    internal::JsonUnitTestResultPrinter(output_path.c_str())
+        .OnTestIterationEnd(unit_test, 0);
+  }
+  return true;
+#else
+  static_cast<void>(input_path);
+  static_cast<void>(output);
+  return false;
+#endif  // GTEST_HAS_FILE_SYSTEM
+}
+
 #if !defined(GTEST_CUSTOM_TEMPDIR_FUNCTION_) || \
     !defined(GTEST_CUSTOM_SRCDIR_FUNCTION_)
 // Returns the value of the first environment variable that is set and contains
@@ -6928,6 +9864,18 @@ void ScopedTrace::PushTrace(const char* file, int line, std::string message) {
   UnitTest::GetInstance()->PushGTestTrace(trace);
 }
 
+// Pushes the given source file location and a message that will only be
+// formatted if a failure is reported.
+void ScopedTrace::PushTrace(const char* file, int line,
+                            const internal::LazyTraceMessage& message) {
+  internal::TraceInfo trace;
+  trace.file = file;
+  trace.line = line;
+  trace.lazy_message = message;
+
+  UnitTest::GetInstance()->PushGTestTrace(trace);
+}
+
 // Pops the info pushed by the c'tor.
 ScopedTrace::~ScopedTrace() GTEST_LOCK_EXCLUDED_(&UnitTest::mutex_) {
   UnitTest::GetInstance()->PopGTestTrace();
@@ -0,0 +1,158 @@
+// Copyright 2024, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+//
+// The Google C++ Testing and Mocking Framework (Google Test)
+//
+// Linking a test program with this file (the gtest_alloc library) replaces
+// the global operator new and operator delete with versions that count
+// each thread's heap allocations, for EXPECT_ALLOCATIONS_AT_MOST() and the
+// per-test allocation counts.  Memory still comes from malloc().
+
+#include <cstdlib>
+#include <new>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+struct AllocationCountingEnabler {
+  AllocationCountingEnabler() {
+    testing::internal::EnableAllocationCounting();
+  }
+} g_allocation_counting_enabler;
+
+void* Allocate(size_t size) {
+  testing::internal::CountAllocation(size);
+  // malloc(0) may return nullptr, but operator new(0) must not.
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void* AllocateOrThrow(size_t size) {
+  void* const p = Allocate(size);
+  if (p == nullptr) {
+#if GTEST_HAS_EXCEPTIONS
+    throw std::bad_alloc();
+#else
+    std::abort();
+#endif  // GTEST_HAS_EXCEPTIONS
+  }
+  return p;
+}
+
+#ifdef __cpp_aligned_new
+void* AllocateAligned(size_t size, std::align_val_t alignment) {
+  testing::internal::CountAllocation(size);
+  if (size == 0) size = 1;
+#ifdef GTEST_OS_WINDOWS
+  return _aligned_malloc(size, static_cast<size_t>(alignment));
+#else
+  void* p = nullptr;
+  if (posix_memalign(&p, static_cast<size_t>(alignment), size) != 0) {
+    return nullptr;
+  }
+  return p;
+#endif  // GTEST_OS_WINDOWS
+}
+
+void* AllocateAlignedOrThrow(size_t size, std::align_val_t alignment) {
+  void* const p = AllocateAligned(size, alignment);
+  if (p == nullptr) {
+#if GTEST_HAS_EXCEPTIONS
+    throw std::bad_alloc();
+#else
+    std::abort();
+#endif  // GTEST_HAS_EXCEPTIONS
+  }
+  return p;
+}
+
+void FreeAligned(void* p) {
+#ifdef GTEST_OS_WINDOWS
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif  // GTEST_OS_WINDOWS
+}
+#endif  // __cpp_aligned_new
+
+}  // namespace
+
+void* operator new(size_t size) { return AllocateOrThrow(size); }
+void* operator new[](size_t size) { return AllocateOrThrow(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  std::free(p);
+}
+
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment) {
+  return AllocateAlignedOrThrow(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return AllocateAlignedOrThrow(size, alignment);
+}
+void* operator new(size_t size, std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept {
+  return AllocateAligned(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept {
+  return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+  FreeAligned(p);
+}
+void operator delete[](void* p, size_t, std::align_val_t) noexcept {
+  FreeAligned(p);
+}
+void operator delete(void* p, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+  FreeAligned(p);
+}
+void operator delete[](void* p, std::align_val_t,
+                       const std::nothrow_t&) noexcept {
+  FreeAligned(p);
+}
+#endif  // __cpp_aligned_new
@@ -0,0 +1,126 @@
+#!/usr/bin/env python
+#
+# Copyright 2024, Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+"""Unit test for Google Test's BENCHMARK_TEST() and --gtest_run_benchmarks."""
+
+import json
+import os
+from googletest.test import gtest_test_utils
+
+COMMAND = gtest_test_utils.GetTestExecutablePath(
+    'googletest-benchmark-unittest_'
+)
+RUN_BENCHMARKS_FLAG = '--gtest_run_benchmarks'
+PASSING_FILTER = '--gtest_filter=-BenchmarkTest.Fails*'
+
+
+def Run(args):
+  """Runs the test program with the given flags and returns its output."""
+
+  return gtest_test_utils.Subprocess([COMMAND] + args, env=os.environ)
+
+
+class GTestBenchmarkUnitTest(gtest_test_utils.TestCase):
+  """Tests BENCHMARK_TEST() and the --gtest_run_benchmarks flag."""
+
+  def testBenchmarksAreLeftOutByDefault(self):
+    p = Run([])
+    self.assertTrue(p.exited, msg=p.output)
+    self.assertEqual(0, p.exit_code, msg=p.output)
+    self.assertIn('[       OK ] BenchmarkTest.IsATest', p.output)
+    self.assertNotIn('AddsNumbers', p.output)
+    self.assertNotIn('[ BENCHMARK]', p.output)
+
+  def testBenchmarksRunWithFlag(self):
+    p = Run([RUN_BENCHMARKS_FLAG, PASSING_FILTER])
+    self.assertTrue(p.exited, msg=p.output)
+    self.assertEqual(0, p.exit_code, msg=p.output)
+    self.assertIn('[       OK ] BenchmarkTest.IsATest', p.output)
+    self.assertIn('[       OK ] BenchmarkTest.AddsNumbers', p.output)
+    self.assertIn('[       OK ] StringBenchmarkTest.Concatenates', p.output)
+    self.assertEqual(2, p.output.count('[ BENCHMARK] median '))
+
+  def testFilterSelectsBenchmarks(self):
+    p = Run([RUN_BENCHMARKS_FLAG, '--gtest_filter=StringBenchmarkTest.*'])
+    self.assertTrue(p.exited, msg=p.output)
+    self.assertEqual(0, p.exit_code, msg=p.output)
+    self.assertIn('[       OK ] StringBenchmarkTest.Concatenates', p.output)
+    self.assertNotIn('AddsNumbers', p.output)
+    self.assertNotIn('IsATest', p.output)
+
+  def testFailureStopsBenchmark(self):
+    p = Run([RUN_BENCHMARKS_FLAG, '--gtest_filter=BenchmarkTest.Fails'])
+    self.assertTrue(p.exited, msg=p.output)
+    self.assertEqual(1, p.exit_code, msg=p.output)
+    self.assertIn('Expected failure.', p.output)
+    self.assertEqual(1, p.output.count('Expected failure.'))
+    self.assertNotIn('[ BENCHMARK]', p.output)
+
+  def testNonfatalFailureStopsBenchmark(self):
+    p = Run([
+        RUN_BENCHMARKS_FLAG,
+        '--gtest_filter=BenchmarkTest.FailsNonfatally',
+    ])
+    self.assertTrue(p.exited, msg=p.output)
+    self.assertEqual(1, p.exit_code, msg=p.output)
+    self.assertEqual(1, p.output.count('Expected nonfatal failure.'))
+    self.assertNotIn('[ BENCHMARK]', p.output)
+
+  def testJsonReportHasStatistics(self):
+    json_path = os.path.join(gtest_test_utils.GetTempDir(), 'benchmark.json')
+    p = Run([
+        RUN_BENCHMARKS_FLAG,
+        '--gtest_filter=BenchmarkTest.AddsNumbers',
+        '--gtest_output=json:' + json_path,
+    ])
+    self.assertTrue(p.exited, msg=p.output)
+    self.assertEqual(0, p.exit_code, msg=p.output)
+    with open(json_path) as f:
+      report = json.load(f)
+    os.remove(json_path)
+    test = report['testsuites'][0]['testsuite'][0]
+    self.assertEqual('AddsNumbers', test['name'])
+    self.assertIsInstance(test['benchmark_samples'], int)
+    self.assertGreaterEqual(test['benchmark_samples'], 10)
+    self.assertIsInstance(test['benchmark_iterations_per_sample'], int)
+    self.assertGreater(test['benchmark_iterations_per_sample'], 0)
+    min_ns = float(test['benchmark_min_ns'])
+    median_ns = float(test['benchmark_median_ns'])
+    max_ns = float(test['benchmark_max_ns'])
+    self.assertLessEqual(min_ns, median_ns)
+    self.assertLessEqual(median_ns, float(test['benchmark_p90_ns']))
+    self.assertLessEqual(float(test['benchmark_p99_ns']), max_ns)
+    self.assertGreaterEqual(float(test['benchmark_mad_ns']), 0)
+
+
+if __name__ == '__main__':
+  gtest_test_utils.Main()
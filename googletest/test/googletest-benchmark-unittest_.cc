@@ -0,0 +1,68 @@
+// Copyright 2024, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Unit test for Google Test's BENCHMARK_TEST() and --gtest_run_benchmarks.
+//
+// This program will be invoked from a Python unit test.  Don't run it
+// directly.
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(BenchmarkTest, IsATest) {}
+
+BENCHMARK_TEST(BenchmarkTest, AddsNumbers) {
+  int sum = 0;
+  for (int i = 0; i < 100; ++i) sum += i;
+  testing::DoNotOptimize(sum);
+}
+
+class StringBenchmarkTest : public testing::Test {
+ protected:
+  void SetUp() override { suffix_ = std::string(100, 'x'); }
+
+  std::string prefix_ = "prefix";
+  std::string suffix_;
+};
+
+BENCHMARK_TEST_F(StringBenchmarkTest, Concatenates) {
+  testing::DoNotOptimize(prefix_ + suffix_);
+}
+
+BENCHMARK_TEST(BenchmarkTest, Fails) { FAIL() << "Expected failure."; }
+
+BENCHMARK_TEST(BenchmarkTest, FailsNonfatally) {
+  ADD_FAILURE() << "Expected nonfatal failure.";
+}
+
+}  // namespace
@@ -0,0 +1,127 @@
+#!/usr/bin/env python
+#
+# Copyright 2024, Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Unit test for Google Test's --gtest_isolate_tests flag."""
+
+import os
+import time
+from googletest.test import gtest_test_utils
+
+COMMAND = gtest_test_utils.GetTestExecutablePath(
+    'googletest-isolation-unittest_'
+)
+ISOLATE_TESTS_FLAG = '--gtest_isolate_tests'
+ISOLATION_TESTS_FILTER = '--gtest_filter=IsolationTest.*'
+
+
+def Run(args):
+  """Runs the test program with the given flags and returns its output."""
+
+  return gtest_test_utils.Subprocess([COMMAND] + args, env=os.environ)
+
+
+class GTestIsolationUnitTest(gtest_test_utils.TestCase):
+  """Tests the --gtest_isolate_tests flag."""
+
+  def testWithoutIsolationStateIsShared(self):
+    p = Run(['--gtest_filter=IsolationTest.*State'])
+    self.assertNotEqual(0, p.exit_code)
+    self.assertIn('[  FAILED  ] IsolationTest.SeesPristineGlobalState', p.output)
+
+  def testStateIsNotShared(self):
+    p = Run([ISOLATE_TESTS_FLAG, '--gtest_filter=IsolationTest.*State'])
+    self.assertEqual(0, p.exit_code, msg=p.output)
+    self.assertIn('[  PASSED  ] 2 tests.', p.output)
+
+  def testCrashIsReportedAsFailure(self):
+    p = Run([ISOLATE_TESTS_FLAG, ISOLATION_TESTS_FILTER])
+    self.assertNotEqual(0, p.exit_code)
+    self.assertIn(
+        'The isolated test process was killed by signal', p.output
+    )
+    self.assertIn('before the test finished.', p.output)
+    self.assertIn('[  FAILED  ] IsolationTest.Crashes', p.output)
+    self.assertIn('[       OK ] IsolationTest.RunsAfterCrash', p.output)
+
+  def testResultsAreReportedByParent(self):
+    p = Run([ISOLATE_TESTS_FLAG, ISOLATION_TESTS_FILTER])
+    self.assertIn('Expected failure in the child', p.output)
+    self.assertIn('[  FAILED  ] IsolationTest.Fails', p.output)
+    self.assertIn('Skipped in the child', p.output)
+    self.assertIn('[  SKIPPED ] IsolationTest.Skips', p.output)
+    self.assertIn('[  FAILED  ] 2 tests, listed below:', p.output)
+    # Each test is announced once, by the parent.
+    self.assertEqual(1, p.output.count('[ RUN      ] IsolationTest.Fails\n'))
+
+  def testPropertyIsRecorded(self):
+    xml_path = os.path.join(
+        gtest_test_utils.GetTempDir(), 'isolation_test.xml'
+    )
+    Run([
+        ISOLATE_TESTS_FLAG,
+        '--gtest_filter=IsolationTest.RecordsProperty',
+        '--gtest_output=xml:' + xml_path,
+    ])
+    with open(xml_path) as f:
+      xml = f.read()
+    os.remove(xml_path)
+    self.assertIn('isolated_key', xml)
+    self.assertIn('isolated_value', xml)
+
+  def testPropertyIsRecordedBeforeCrash(self):
+    xml_path = os.path.join(
+        gtest_test_utils.GetTempDir(), 'isolation_crash_test.xml'
+    )
+    p = Run([
+        ISOLATE_TESTS_FLAG,
+        '--gtest_filter=IsolatedChildTest.RecordsPropertyThenCrashes',
+        '--gtest_output=xml:' + xml_path,
+    ])
+    self.assertNotEqual(0, p.exit_code)
+    with open(xml_path) as f:
+      xml = f.read()
+    os.remove(xml_path)
+    self.assertIn(
+        '<property name="recorded_before_crash" value="sent"/>', xml
+    )
+
+  def testProcessStartedByTestDoesNotHoldUpParent(self):
+    start = time.time()
+    p = Run([
+        ISOLATE_TESTS_FLAG,
+        '--gtest_filter=IsolatedChildTest.StartsLongLivedProcess',
+    ])
+    self.assertEqual(0, p.exit_code, msg=p.output)
+    self.assertLess(time.time() - start, 20)
+
+
+if __name__ == '__main__':
+  gtest_test_utils.Main()
@@ -0,0 +1,87 @@
+// Copyright 2024, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Unit test for Google Test's --gtest_isolate_tests flag.
+//
+// A user can ask Google Test to run each test in its own child process by
+// specifying the --gtest_isolate_tests flag.  This file is used for testing
+// such functionality.
+//
+// This program will be invoked from a Python unit test.  Don't run it
+// directly.
+
+#include <cstdlib>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+// Set by whichever test runs; the next test expects to see it untouched.
+int g_counter = 0;
+
+TEST(IsolationTest, ModifiesGlobalState) {
+  EXPECT_EQ(0, g_counter);
+  g_counter = 42;
+}
+
+TEST(IsolationTest, SeesPristineGlobalState) {
+  EXPECT_EQ(0, g_counter);
+  g_counter = 42;
+}
+
+TEST(IsolationTest, Crashes) { std::abort(); }
+
+TEST(IsolationTest, RecordsProperty) {
+  RecordProperty("isolated_key", "isolated_value");
+}
+
+TEST(IsolationTest, Skips) { GTEST_SKIP() << "Skipped in the child"; }
+
+TEST(IsolationTest, Fails) { FAIL() << "Expected failure in the child"; }
+
+TEST(IsolationTest, RunsAfterCrash) { EXPECT_EQ(0, g_counter); }
+
+TEST(IsolatedChildTest, RecordsPropertyThenCrashes) {
+  RecordProperty("recorded_before_crash", "sent");
+  std::abort();
+}
+
+// The background process outlives the child by far, but doesn't inherit the
+// pipe that the child reports through.
+TEST(IsolatedChildTest, StartsLongLivedProcess) {
+  ASSERT_EQ(0, std::system("sleep 30 >/dev/null 2>&1 </dev/null &"));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,199 @@
+// Copyright 2024, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// A stand-in for a test orchestrator that follows a test program's results
+// through --gtest_stream_result_to=unix:PATH or shm:PATH.  It sets up the
+// socket or the ring at PATH, prints "ready", and then copies everything the
+// test program sends to OUTPUT_FILE, flushing it as data arrives, until the
+// program is done:
+//
+//   googletest-local-stream-server_ (unix|shm):PATH OUTPUT_FILE [CAPACITY]
+//
+// CAPACITY is the size of the ring's data area.  A small one makes the test
+// program wait for this reader and wrap around the ring.
+//
+// This program will be invoked from a Python unit test.  Don't run it
+// directly.
+
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+
+#if GTEST_CAN_STREAM_RESULTS_
+#include <fcntl.h>       // NOLINT
+#include <sys/mman.h>    // NOLINT
+#include <sys/socket.h>  // NOLINT
+#include <sys/un.h>      // NOLINT
+#include <unistd.h>      // NOLINT
+#endif  // GTEST_CAN_STREAM_RESULTS_
+
+namespace {
+
+#if GTEST_CAN_STREAM_RESULTS_
+
+// The layout of a result ring, as documented with --gtest_stream_result_to.
+constexpr char kRingMagic[] = "GTESTRNG";
+constexpr uint32_t kRingVersion = 1;
+constexpr size_t kCapacityOffset = 16;
+constexpr size_t kWritePositionOffset = 64;
+constexpr size_t kReadPositionOffset = 128;
+constexpr size_t kClosedOffset = 192;
+constexpr size_t kRingDataOffset = 256;
+
+// How long to wait for the test program to finish.
+constexpr auto kTimeout = std::chrono::seconds(60);
+
+void Ready() {
+  printf("ready\n");
+  fflush(stdout);
+}
+
+bool ServeUnixSocket(const std::string& path, FILE* output) {
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  if (path.size() >= sizeof(addr.sun_path)) return false;
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path.c_str(), path.size());
+  unlink(path.c_str());
+  const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener == -1 ||
+      bind(listener, reinterpret_cast<const sockaddr*>(&addr),
+           sizeof(addr)) == -1 ||
+      listen(listener, 1) == -1) {
+    return false;
+  }
+  Ready();
+  const int connection = accept(listener, nullptr, nullptr);
+  if (connection == -1) return false;
+  char buffer[4096];
+  for (;;) {
+    const ssize_t n = read(connection, buffer, sizeof(buffer));
+    if (n == 0) break;
+    if (n < 0) return false;
+    fwrite(buffer, 1, static_cast<size_t>(n), output);
+    fflush(output);
+  }
+  close(connection);
+  close(listener);
+  unlink(path.c_str());
+  return true;
+}
+
+template <typename T>
+std::atomic<T>* AtomicAt(char* mapping, size_t offset) {
+  return reinterpret_cast<std::atomic<T>*>(mapping + offset);
+}
+
+bool ServeRing(const std::string& path, uint64_t capacity, FILE* output) {
+  const size_t size = kRingDataOffset + static_cast<size_t>(capacity);
+  const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (fd == -1 || ftruncate(fd, static_cast<off_t>(size)) == -1) return false;
+  void* const mapping =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) return false;
+  char* const header = static_cast<char*>(mapping);
+  memcpy(header, kRingMagic, sizeof(kRingMagic) - 1);
+  memcpy(header + 8, &kRingVersion, sizeof(kRingVersion));
+  memcpy(header + kCapacityOffset, &capacity, sizeof(capacity));
+  std::atomic<uint64_t>* const write_position =
+      AtomicAt<uint64_t>(header, kWritePositionOffset);
+  std::atomic<uint64_t>* const read_position =
+      AtomicAt<uint64_t>(header, kReadPositionOffset);
+  std::atomic<uint32_t>* const closed =
+      AtomicAt<uint32_t>(header, kClosedOffset);
+  Ready();
+
+  const char* const ring = header + kRingDataOffset;
+  const auto deadline = std::chrono::steady_clock::now() + kTimeout;
+  uint64_t read = 0;
+  for (;;) {
+    // The closed flag is checked first, so that no data written before the
+    // flag was set can be missed.
+    const bool done = closed->load(std::memory_order_acquire) != 0;
+    const uint64_t write = write_position->load(std::memory_order_acquire);
+    while (read != write) {
+      const uint64_t offset = read % capacity;
+      const uint64_t chunk = std::min(write - read, capacity - offset);
+      fwrite(ring + offset, 1, static_cast<size_t>(chunk), output);
+      read += chunk;
+      read_position->store(read, std::memory_order_release);
+    }
+    fflush(output);
+    if (done) break;
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  munmap(mapping, size);
+  unlink(path.c_str());
+  return true;
+}
+
+#endif  // GTEST_CAN_STREAM_RESULTS_
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3 && argc != 4) {
+    fprintf(stderr, "Usage: %s (unix|shm):PATH OUTPUT_FILE [CAPACITY]\n",
+            argv[0]);
+    return 1;
+  }
+#if GTEST_CAN_STREAM_RESULTS_
+  const std::string target = argv[1];
+  FILE* const output = fopen(argv[2], "wb");
+  if (output == nullptr) return 1;
+  bool ok = false;
+  if (target.compare(0, 5, "unix:") == 0) {
+    ok = ServeUnixSocket(target.substr(5), output);
+  } else if (target.compare(0, 4, "shm:") == 0) {
+    ok = ServeRing(target.substr(4),
+                   argc == 4 ? strtoull(argv[3], nullptr, 10) : 1 << 20,
+                   output);
+  }
+  fclose(output);
+  if (!ok) {
+    fprintf(stderr, "%s: failed to serve %s\n", argv[0], argv[1]);
+    return 1;
+  }
+  return 0;
+#else
+  fprintf(stderr, "%s: local streaming isn't supported here\n", argv[0]);
+  return 1;
+#endif  // GTEST_CAN_STREAM_RESULTS_
+}
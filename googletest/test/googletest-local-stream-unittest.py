@@ -0,0 +1,169 @@
+#!/usr/bin/env python
+#
+# Copyright 2024, Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Tests streaming results to a local reader with --gtest_stream_result_to."""
+
+import os
+import struct
+import subprocess
+import time
+from googletest.test import gtest_test_utils
+
+IS_WINDOWS = os.name == 'nt'
+
+SERVER = gtest_test_utils.GetTestExecutablePath(
+    'googletest-local-stream-server_'
+)
+PROGRAM = gtest_test_utils.GetTestExecutablePath('gtest_xml_output_unittest_')
+WAITING_PROGRAM = gtest_test_utils.GetTestExecutablePath(
+    'googletest-local-stream-unittest_'
+)
+
+# The size of the stream header: 'GTESTBIN' and a 32-bit version.
+HEADER_SIZE = 12
+
+
+def RecordTags(stream):
+  """Returns the tags of the whole records in stream, in order."""
+
+  tags = []
+  pos = HEADER_SIZE
+  while len(stream) - pos >= 4:
+    (length,) = struct.unpack_from('<I', stream, pos)
+    if len(stream) - pos - 4 < length:
+      break
+    tags.append(stream[pos + 4 : pos + 5])
+    pos += 4 + length
+  return tags
+
+
+class GTestLocalStreamUnitTest(gtest_test_utils.TestCase):
+  """Tests the unix: and shm: targets of --gtest_stream_result_to."""
+
+  def _StreamAndCompare(self, target, *server_args):
+    """Checks that the stream sent to target matches --gtest_output=bin."""
+
+    temp_dir = gtest_test_utils.GetTempDir()
+    kind = target.split(':')[0]
+    streamed_path = os.path.join(temp_dir, 'streamed_%s.bin' % kind)
+    file_path = os.path.join(temp_dir, 'written_%s.bin' % kind)
+    server = subprocess.Popen(
+        [SERVER, target, streamed_path] + list(server_args),
+        stdout=subprocess.PIPE,
+    )
+    self.assertEqual(b'ready\n', server.stdout.readline())
+
+    p = gtest_test_utils.Subprocess([
+        PROGRAM,
+        '--gtest_stream_result_to=' + target,
+        '--gtest_output=bin:' + file_path,
+    ])
+    self.assertTrue(p.exited)
+    self.assertEqual(1, p.exit_code)
+    self.assertNotIn('stream_result_to', p.output)
+    self.assertEqual(0, server.wait())
+    server.stdout.close()
+
+    with open(streamed_path, 'rb') as f:
+      streamed = f.read()
+    with open(file_path, 'rb') as f:
+      written = f.read()
+    self.assertTrue(streamed.startswith(b'GTESTBIN'))
+    self.assertEqual(written, streamed)
+
+  if not IS_WINDOWS:
+
+    def testUnixSocket(self):
+      self._StreamAndCompare(
+          'unix:' + os.path.join(gtest_test_utils.GetTempDir(), 'gtest.sock')
+      )
+
+    def testSharedMemoryRing(self):
+      self._StreamAndCompare(
+          'shm:' + os.path.join(gtest_test_utils.GetTempDir(), 'gtest.ring')
+      )
+
+    def testSharedMemoryRingWrapsAround(self):
+      # The stream is several times the size of this ring.
+      self._StreamAndCompare(
+          'shm:' + os.path.join(gtest_test_utils.GetTempDir(), 'small.ring'),
+          '256',
+      )
+
+    def testReaderSeesRunningTest(self):
+      temp_dir = gtest_test_utils.GetTempDir()
+      streamed_path = os.path.join(temp_dir, 'running.bin')
+      go_path = os.path.join(temp_dir, 'running.go')
+      if os.path.exists(go_path):
+        os.remove(go_path)
+      target = 'unix:' + os.path.join(temp_dir, 'running.sock')
+      server = subprocess.Popen(
+          [SERVER, target, streamed_path], stdout=subprocess.PIPE
+      )
+      self.assertEqual(b'ready\n', server.stdout.readline())
+      env = os.environ.copy()
+      env['GTEST_LOCAL_STREAM_GO'] = go_path
+      program = subprocess.Popen(
+          [WAITING_PROGRAM, '--gtest_stream_result_to=' + target],
+          stdout=subprocess.DEVNULL,
+          env=env,
+      )
+
+      # The test waits for go_path, so whatever arrives until then was sent
+      # while it was running.
+      tags = []
+      deadline = time.time() + 60
+      while b'P' not in tags and time.time() < deadline:
+        time.sleep(0.01)
+        with open(streamed_path, 'rb') as f:
+          tags = RecordTags(f.read())
+      with open(go_path, 'w'):
+        pass
+      self.assertEqual(1, program.wait())
+      self.assertEqual(0, server.wait())
+      server.stdout.close()
+
+      self.assertIn(b's', tags)
+      self.assertIn(b'P', tags)
+      self.assertNotIn(b'e', tags)
+
+    def testMissingReaderIsReported(self):
+      p = gtest_test_utils.Subprocess([
+          PROGRAM,
+          '--gtest_stream_result_to=unix:'
+          + os.path.join(gtest_test_utils.GetTempDir(), 'no.sock'),
+      ])
+      self.assertEqual(1, p.exit_code)
+      self.assertIn('stream_result_to: failed to connect to unix:', p.output)
+
+
+if __name__ == '__main__':
+  gtest_test_utils.Main()
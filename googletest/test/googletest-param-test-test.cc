@@ -54,6 +54,7 @@ using ::testing::Bool;
 using ::testing::Combine;
 using ::testing::ConvertGenerator;
 using ::testing::Message;
+using ::testing::PooledFixture;
 using ::testing::Range;
 using ::testing::TestWithParam;
 using ::testing::Values;
@@ -828,6 +829,85 @@ TEST_P(SeparateInstanceTest, TestsRunInSeparateInstances) {
 }
 INSTANTIATE_TEST_SUITE_P(FourElemSequence, SeparateInstanceTest, Range(1, 4));
 
+// Tests that the iterations of a parameterized test whose fixture is a
+// PooledFixture reuse one test object, which is reset in between and deleted
+// at the end of the test suite.
+class PooledInstanceTest : public TestWithParam<int>, public PooledFixture {
+ public:
+  PooledInstanceTest() : count_(0) { constructed_count_++; }
+  ~PooledInstanceTest() override { destroyed_count_++; }
+
+  static void SetUpTestSuite() {
+    constructed_count_ = 0;
+    destroyed_count_ = 0;
+    reset_count_ = 0;
+    run_count_ = 0;
+  }
+
+  static void TearDownTestSuite() {
+    EXPECT_EQ(1, constructed_count_);
+    EXPECT_EQ(1, destroyed_count_);
+    EXPECT_EQ(run_count_ - 1, reset_count_);
+  }
+
+  void Reset() override {
+    count_ = 0;
+    reset_count_++;
+  }
+
+ protected:
+  int count_;
+  static int constructed_count_;
+  static int destroyed_count_;
+  static int reset_count_;
+  static int run_count_;
+};
+int PooledInstanceTest::constructed_count_ = 0;
+int PooledInstanceTest::destroyed_count_ = 0;
+int PooledInstanceTest::reset_count_ = 0;
+int PooledInstanceTest::run_count_ = 0;
+
+TEST_P(PooledInstanceTest, TestsReuseOneResetInstance) {
+  EXPECT_EQ(0, count_++);
+  EXPECT_EQ(1, constructed_count_);
+  EXPECT_EQ(0, destroyed_count_);
+  EXPECT_EQ(run_count_, reset_count_);
+  // GetParam() returns the current test's parameter.
+  EXPECT_EQ(PrintValue(GetParam()), ::testing::UnitTest::GetInstance()
+                                        ->current_test_info()
+                                        ->value_param());
+  run_count_++;
+}
+INSTANTIATE_TEST_SUITE_P(FourElemSequence, PooledInstanceTest,
+                         Values(10, 20, 30, 40));
+
+// Tests that flags set by a test in a pooled fixture are restored before the
+// next test of the same class runs.
+class PooledFlagTest : public TestWithParam<int>, public PooledFixture {
+ public:
+  static void SetUpTestSuite() {
+    initial_brief_ = GTEST_FLAG_GET(brief);
+    initial_repeat_ = GTEST_FLAG_GET(repeat);
+  }
+
+ protected:
+  void Reset() override {}
+
+  static bool initial_brief_;
+  static int initial_repeat_;
+};
+bool PooledFlagTest::initial_brief_ = false;
+int PooledFlagTest::initial_repeat_ = 0;
+
+TEST_P(PooledFlagTest, FlagsAreRestoredBetweenTests) {
+  EXPECT_EQ(initial_brief_, GTEST_FLAG_GET(brief));
+  EXPECT_EQ(initial_repeat_, GTEST_FLAG_GET(repeat));
+  GTEST_FLAG_SET(brief, !initial_brief_);
+  GTEST_FLAG_SET(repeat, initial_repeat_ + GetParam());
+}
+INSTANTIATE_TEST_SUITE_P(ThreeElemSequence, PooledFlagTest,
+                         Values(2, 3, 4));
+
 // Tests that all instantiations of a test have named appropriately. Test
 // defined with TEST_P(TestSuiteName, TestName) and instantiated with
 // INSTANTIATE_TEST_SUITE_P(SequenceName, TestSuiteName, generator) must be
@@ -427,6 +427,22 @@ TYPED_TEST(RETest, RejectsInvalidRegex) {
   EXPECT_NONFATAL_FAILURE(
       { const RE invalid(TypeParam("?")); },
       "\"?\" is not a valid POSIX Extended regular expression.");
+  // A trailing backslash must be rejected without reading past the pattern.
+  EXPECT_NONFATAL_FAILURE(
+      { const RE invalid(TypeParam("\\")); },
+      "\"\\\" is not a valid POSIX Extended regular expression.");
+  EXPECT_NONFATAL_FAILURE(
+      { const RE invalid(TypeParam("a\\")); },
+      "\"a\\\" is not a valid POSIX Extended regular expression.");
+  EXPECT_NONFATAL_FAILURE(
+      { const RE invalid(TypeParam("(a|b)\\")); },
+      "\"(a|b)\\\" is not a valid POSIX Extended regular expression.");
+  // Long enough for a std::string to keep it on the heap, where a sanitizer
+  // catches an overread.
+  const ::std::string long_pattern = ::std::string(32, 'a') + "\\";
+  EXPECT_NONFATAL_FAILURE(
+      { const RE invalid(TypeParam(long_pattern.c_str())); },
+      "is not a valid POSIX Extended regular expression.");
 }
 
 // Tests RE::FullMatch().
@@ -456,6 +472,59 @@ TYPED_TEST(RETest, PartialMatchWorks) {
   EXPECT_FALSE(RE::PartialMatch(TypeParam("zza"), re));
 }
 
+// Tests the POSIX Extended constructs handled by the built-in engine.
+TYPED_TEST(RETest, MatchesExtendedSyntax) {
+  EXPECT_TRUE(RE::FullMatch(TypeParam("abcabc"), RE(TypeParam("(a|b|c)+"))));
+  EXPECT_TRUE(RE::FullMatch(TypeParam("ab"), RE(TypeParam("(ab|a)(bc|c)?"))));
+  EXPECT_TRUE(RE::FullMatch(TypeParam("xxy"), RE(TypeParam("x{1,3}y"))));
+  EXPECT_FALSE(RE::FullMatch(TypeParam("xxxxy"), RE(TypeParam("x{1,3}y"))));
+  EXPECT_TRUE(RE::FullMatch(TypeParam("y"), RE(TypeParam("x{0}y"))));
+  EXPECT_TRUE(RE::FullMatch(TypeParam("a-]"), RE(TypeParam("[]a-]+"))));
+  EXPECT_TRUE(RE::FullMatch(TypeParam("\\d"), RE(TypeParam("[\\d]+"))));
+  EXPECT_TRUE(RE::FullMatch(TypeParam("Ab1 "),
+                            RE(TypeParam("[[:upper:]][a-z][[:digit:]]\\s"))));
+  EXPECT_TRUE(RE::PartialMatch(TypeParam("foo_1 -"), RE(TypeParam("\\w+\\W"))));
+  EXPECT_FALSE(RE::PartialMatch(TypeParam("ab"), RE(TypeParam("a^b"))));
+  EXPECT_TRUE(RE::PartialMatch(TypeParam("bc"), RE(TypeParam("(^a|b)c"))));
+  // Without REG_NEWLINE, '.' and negated brackets match newlines and the
+  // anchors only match at the ends of the string.
+  EXPECT_TRUE(RE::FullMatch(TypeParam("a\nb"), RE(TypeParam("a.[^x]?b"))));
+  EXPECT_FALSE(RE::PartialMatch(TypeParam("a\nb"), RE(TypeParam("^b"))));
+}
+
+// Tests constructs the built-in engine leaves to <regex.h>.
+TYPED_TEST(RETest, FallsBackForUnsupportedSyntax) {
+  EXPECT_TRUE(RE::PartialMatch(TypeParam("a"), RE(TypeParam("[[.a.]]"))));
+  EXPECT_TRUE(RE::PartialMatch(TypeParam("a"), RE(TypeParam("b|"))));
+  EXPECT_NONFATAL_FAILURE(
+      { const RE invalid(TypeParam("a{2,1}")); },
+      "\"a{2,1}\" is not a valid POSIX Extended regular expression.");
+}
+
+// Tests that patterns which make backtracking matchers take exponential
+// time are matched quickly.
+TYPED_TEST(RETest, MatchesInLinearTime) {
+  const ::std::string text(1 << 16, 'a');
+  EXPECT_FALSE(RE::PartialMatch(TypeParam(text.c_str()),
+                                RE(TypeParam("(a|aa)*(a*)*b"))));
+  EXPECT_TRUE(RE::FullMatch(TypeParam(text.c_str()),
+                            RE(TypeParam("(a|aa)*(a*)*"))));
+  EXPECT_TRUE(RE::PartialMatch(TypeParam((text + "ERROR: x").c_str()),
+                               RE(TypeParam("ERROR: [a-z]$"))));
+}
+
+// Tests that REs built from the same text share a compiled pattern without
+// changing how invalid patterns are reported.
+TYPED_TEST(RETest, CachesCompiledPatterns) {
+  for (int i = 0; i < 3; ++i) {
+    const RE re(TypeParam("c(a|o)t"));
+    EXPECT_TRUE(RE::FullMatch(TypeParam("cot"), re));
+    EXPECT_FALSE(RE::FullMatch(TypeParam("cut"), re));
+    EXPECT_NONFATAL_FAILURE({ const RE invalid(TypeParam("(")); },
+                            "is not a valid POSIX Extended regular expression");
+  }
+}
+
 #elif defined(GTEST_USES_SIMPLE_RE)
 
 TEST(IsInSetTest, NulCharIsNotInAnySet) {
@@ -916,6 +985,16 @@ TEST(RETest, PartialMatchWorks) {
   EXPECT_FALSE(RE::PartialMatch("zza", re));
 }
 
+// Tests that patterns which make the backtracking matcher take exponential
+// time are matched quickly.
+TEST(RETest, MatchesInLinearTime) {
+  const ::std::string text(1 << 16, 'a');
+  EXPECT_FALSE(RE::PartialMatch(text, RE("a*a*a*a*a*a*b")));
+  EXPECT_TRUE(RE::FullMatch(text, RE("^a*a*a*a*a*a*$")));
+  EXPECT_TRUE(RE::PartialMatch(text + "\n3", RE("\\s\\d$")));
+  EXPECT_FALSE(RE::PartialMatch("a\nb", RE("a.b")));
+}
+
 #endif  // GTEST_USES_POSIX_RE
 
 #ifndef GTEST_OS_WINDOWS_MOBILE
@@ -33,13 +33,16 @@
 
 #include <algorithm>
 #include <cctype>
+#include <clocale>
 #include <cstdint>
 #include <cstring>
 #include <deque>
 #include <forward_list>
 #include <functional>
+#include <iomanip>
 #include <limits>
 #include <list>
+#include <locale>
 #include <map>
 #include <memory>
 #include <ostream>
@@ -498,6 +501,94 @@ TEST(PrintBuiltInTypeTest, FloatingPoints) {
   EXPECT_EQ("-2.5", Print(-2.5));  // double
 }
 
+// Numbers are formatted without the stream's num_put facet only when the
+// stream uses the default format; otherwise its settings are honoured.
+TEST(PrintBuiltInTypeTest, NumbersHonourStreamFormat) {
+  ::std::stringstream ss;
+  ss << ::std::hex << ::std::showbase;
+  UniversalPrint(255, &ss);
+  ss << ' ';
+  UniversalPrint(255u, &ss);
+  EXPECT_EQ("0xff 0xff", ss.str());
+
+  // Negative numbers keep their own width in hex and oct.
+  ::std::stringstream hex;
+  hex << ::std::hex;
+  UniversalPrint(static_cast<short>(-1), &hex);  // NOLINT
+  hex << ' ';
+  UniversalPrint(-1, &hex);
+  hex << ' ';
+  UniversalPrint(-1LL, &hex);
+  EXPECT_EQ("ffff ffffffff ffffffffffffffff", hex.str());
+
+  ::std::stringstream oct;
+  oct << ::std::oct;
+  UniversalPrint(static_cast<short>(-1), &oct);  // NOLINT
+  oct << ' ';
+  UniversalPrint(-1, &oct);
+  EXPECT_EQ("177777 37777777777", oct.str());
+
+  ::std::stringstream ss2;
+  ss2 << ::std::setw(5);
+  UniversalPrint(-42L, &ss2);
+  ss2 << ' ' << ::std::fixed;
+  UniversalPrint(1.5, &ss2);
+  EXPECT_EQ("  -42 1.500000", ss2.str());
+}
+
+// A decimal comma, whichever locales are installed.
+class DecimalCommaPunct : public ::std::numpunct<char> {
+ protected:
+  char do_decimal_point() const override { return ','; }
+};
+
+TEST(PrintBuiltInTypeTest, NumbersFollowImbuedLocale) {
+  ::std::stringstream ss;
+  UniversalPrint(1.5, &ss);
+  ss.imbue(::std::locale(::std::locale::classic(), new DecimalCommaPunct));
+  ss << ' ';
+  UniversalPrint(1.5, &ss);
+  ss.imbue(::std::locale::classic());
+  ss << ' ';
+  UniversalPrint(1.5, &ss);
+  EXPECT_EQ("1.5 1,5 1.5", ss.str());
+
+  // A copied format carries the locale along.
+  ::std::stringstream ss2;
+  UniversalPrint(2.5, &ss2);
+  ss2.copyfmt(ss);
+  ss.imbue(::std::locale(::std::locale::classic(), new DecimalCommaPunct));
+  ss2.copyfmt(ss);
+  ss2 << ' ';
+  UniversalPrint(2.5, &ss2);
+  EXPECT_EQ("2.5 2,5", ss2.str());
+}
+
+// Like operator<<, printing ignores the C library's LC_NUMERIC locale.
+TEST(PrintBuiltInTypeTest, NumbersIgnoreCNumericLocale) {
+  const ::std::string old_locale = setlocale(LC_NUMERIC, nullptr);
+  if (setlocale(LC_NUMERIC, "de_DE.UTF-8") == nullptr &&
+      setlocale(LC_NUMERIC, "de_DE") == nullptr) {
+    GTEST_SKIP() << "No German locale is installed.";
+  }
+  const ::std::string printed = Print(1.5);
+  const ::std::string printed_to_string = PrintToString(2.5);
+  setlocale(LC_NUMERIC, old_locale.c_str());
+  EXPECT_EQ("1.5", printed);
+  EXPECT_EQ("2.5", printed_to_string);
+}
+
+TEST(PrintBuiltInTypeTest, FloatingPointSpecialValues) {
+  EXPECT_EQ("0", Print(0.0));
+  EXPECT_EQ("-0", Print(-0.0));
+  EXPECT_EQ("inf", Print(std::numeric_limits<double>::infinity()));
+  EXPECT_EQ("-inf", Print(-std::numeric_limits<float>::infinity()));
+  EXPECT_EQ("1.7976931348623157e+308",
+            Print(std::numeric_limits<double>::max()));
+  EXPECT_EQ("-2.2250738585072014e-308",
+            Print(-std::numeric_limits<double>::min()));
+}
+
 #if GTEST_HAS_RTTI
 TEST(PrintBuiltInTypeTest, TypeInfo) {
   struct MyStruct {};
@@ -1605,6 +1696,22 @@ TEST(FormatForComparisonFailureMessageTest, WorksForWCharArrayVsStdWString) {
 
 TEST(PrintToStringTest, WorksForScalar) { EXPECT_PRINT_TO_STRING_(123, "123"); }
 
+TEST(PrintToStringTest, NumbersMatchStreamedOutput) {
+  EXPECT_PRINT_TO_STRING_(0, "0");
+  EXPECT_PRINT_TO_STRING_(static_cast<int16_t>(-7), "-7");
+  EXPECT_PRINT_TO_STRING_(std::numeric_limits<int64_t>::min(),
+                          "-9223372036854775808");
+  EXPECT_PRINT_TO_STRING_(std::numeric_limits<uint64_t>::max(),
+                          "18446744073709551615");
+  EXPECT_PRINT_TO_STRING_(99u, "99");
+  EXPECT_PRINT_TO_STRING_(100u, "100");
+  EXPECT_PRINT_TO_STRING_(1.10000014f, "1.10000014");
+  EXPECT_PRINT_TO_STRING_(-2.5, "-2.5");
+  EXPECT_PRINT_TO_STRING_(9e9f, "9e+09");
+  EXPECT_PRINT_TO_STRING_(true, "true");
+  EXPECT_PRINT_TO_STRING_('a', "'a' (97, 0x61)");
+}
+
 TEST(PrintToStringTest, WorksForPointerToConstChar) {
   const char* p = "hello";
   EXPECT_PRINT_TO_STRING_(p, "\"hello\"");
@@ -0,0 +1,139 @@
+#!/usr/bin/env python
+#
+# Copyright 2024, Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Unit test for Google Test's --gtest_rerun_failed and --gtest_failed_first."""
+
+import os
+import re
+from googletest.test import gtest_test_utils
+
+COMMAND = gtest_test_utils.GetTestExecutablePath(
+    'googletest-rerun-failed-unittest_'
+)
+RERUN_FAILED_FLAG = '--gtest_rerun_failed'
+FAILED_FIRST_FLAG = '--gtest_failed_first'
+
+ALL_TESTS = [
+    'FirstSuiteTest.Passes',
+    'PassingSuiteTest.Passes',
+    'FailingSuiteTest.Passes',
+    'FailingSuiteTest.Fails',
+    'FailingSuiteTest.AlsoPasses',
+    'FailingSuiteTest.FailsNonfatally',
+]
+FAILED_TESTS = ['FailingSuiteTest.Fails', 'FailingSuiteTest.FailsNonfatally']
+
+
+def Run(args):
+  """Runs the test program with the given flags and returns its output."""
+
+  return gtest_test_utils.Subprocess([COMMAND] + args, env=os.environ)
+
+
+def RanTests(output):
+  """Returns the names of the tests that output shows running, in order."""
+
+  return re.findall(r'^\[ RUN      \] (.*)$', output, re.MULTILINE)
+
+
+class GTestRerunFailedUnitTest(gtest_test_utils.TestCase):
+  """Tests --gtest_rerun_failed and --gtest_failed_first with real reports."""
+
+  def _WriteReport(self, output_format):
+    """Runs every test and returns the path of the report it writes."""
+
+    path = os.path.join(
+        gtest_test_utils.GetTempDir(), 'rerun_failed.' + output_format
+    )
+    if os.path.exists(path):
+      os.remove(path)
+    p = Run(['--gtest_output=%s:%s' % (output_format, path)])
+    self.assertEqual(1, p.exit_code, msg=p.output)
+    self.assertEqual(ALL_TESTS, RanTests(p.output))
+    return path
+
+  def _TestRerunFailed(self, output_format):
+    path = self._WriteReport(output_format)
+    p = Run([RERUN_FAILED_FLAG + '=' + path])
+    os.remove(path)
+    self.assertEqual(1, p.exit_code, msg=p.output)
+    self.assertEqual(FAILED_TESTS, RanTests(p.output))
+
+  def testRerunFailedFromXmlReport(self):
+    self._TestRerunFailed('xml')
+
+  def testRerunFailedFromJsonReport(self):
+    self._TestRerunFailed('json')
+
+  def testRerunFailedCombinesWithFilter(self):
+    path = self._WriteReport('xml')
+    p = Run([RERUN_FAILED_FLAG + '=' + path, '--gtest_filter=*Nonfatally'])
+    os.remove(path)
+    self.assertEqual(['FailingSuiteTest.FailsNonfatally'], RanTests(p.output))
+
+  def testRerunFailedWithoutReportRunsEverything(self):
+    path = os.path.join(gtest_test_utils.GetTempDir(), 'no_such_report.xml')
+    p = Run([RERUN_FAILED_FLAG + '=' + path])
+    self.assertEqual(ALL_TESTS, RanTests(p.output))
+
+  def _TestFailedFirst(self, output_format):
+    path = self._WriteReport(output_format)
+    # The report given by --gtest_output is read before it is overwritten.
+    p = Run([
+        FAILED_FIRST_FLAG,
+        '--gtest_output=%s:%s' % (output_format, path),
+    ])
+    self.assertEqual(1, p.exit_code, msg=p.output)
+    self.assertEqual(
+        [
+            'FailingSuiteTest.Fails',
+            'FailingSuiteTest.FailsNonfatally',
+            'FailingSuiteTest.Passes',
+            'FailingSuiteTest.AlsoPasses',
+            'FirstSuiteTest.Passes',
+            'PassingSuiteTest.Passes',
+        ],
+        RanTests(p.output),
+    )
+    # The new report is complete, so it can drive the next run.
+    p = Run([RERUN_FAILED_FLAG + '=' + path])
+    os.remove(path)
+    self.assertEqual(FAILED_TESTS, RanTests(p.output))
+
+  def testFailedFirstFromXmlReport(self):
+    self._TestFailedFirst('xml')
+
+  def testFailedFirstFromJsonReport(self):
+    self._TestFailedFirst('json')
+
+
+if __name__ == '__main__':
+  gtest_test_utils.Main()
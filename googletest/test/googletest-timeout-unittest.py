@@ -0,0 +1,129 @@
+#!/usr/bin/env python
+#
+# Copyright 2024, Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Unit test for Google Test's --gtest_test_timeout_ms flag."""
+
+import json
+import os
+from xml.dom import minidom
+from googletest.test import gtest_test_utils
+
+COMMAND = gtest_test_utils.GetTestExecutablePath('googletest-timeout-unittest_')
+TIMEOUT_FLAG = '--gtest_test_timeout_ms'
+
+
+def Run(args):
+  """Runs the test program with the given flags and returns its output."""
+
+  return gtest_test_utils.Subprocess([COMMAND] + args, env=os.environ)
+
+
+class GTestTimeoutUnitTest(gtest_test_utils.TestCase):
+  """Tests the --gtest_test_timeout_ms flag."""
+
+  def testTimeoutAbortsAndWritesReport(self):
+    xml_path = os.path.join(gtest_test_utils.GetTempDir(), 'timeout_test.xml')
+    p = Run([
+        TIMEOUT_FLAG + '=200',
+        '--gtest_filter=TimeoutTest.Hangs:TimeoutTest.RunsAfterHang',
+        '--gtest_output=xml:' + xml_path,
+    ])
+    self.assertTrue(p.terminated_by_signal, msg=p.output)
+    self.assertIn('The test timed out after 200 ms.', p.output)
+    self.assertIn('[  FAILED  ] TimeoutTest.Hangs', p.output)
+    with open(xml_path) as f:
+      xml = f.read()
+    os.remove(xml_path)
+    self.assertIn('The test timed out after 200 ms.', xml)
+
+  def testTimeoutOfTestStillRecordingResults(self):
+    # The test keeps recording properties and results until the watchdog
+    # reports it; from then on its result mustn't change.
+    for run in range(3):
+      for out_format in ('xml', 'json'):
+        path = os.path.join(
+            gtest_test_utils.GetTempDir(),
+            'timeout_recording_%d.%s' % (run, out_format),
+        )
+        p = Run([
+            TIMEOUT_FLAG + '=100',
+            '--gtest_filter=TimeoutTest.KeepsRecordingResults',
+            '--gtest_output=%s:%s' % (out_format, path),
+        ])
+        self.assertTrue(p.terminated_by_signal, msg=p.output)
+        self.assertIn(
+            '[  FAILED  ] TimeoutTest.KeepsRecordingResults', p.output
+        )
+        self.assertIn(
+            "The result didn't change while being reported.", p.output
+        )
+        with open(path) as f:
+          report = f.read()
+        os.remove(path)
+        self.assertIn('The test timed out after 100 ms.', report)
+        if out_format == 'xml':
+          testcase = minidom.parseString(report).getElementsByTagName(
+              'testcase'
+          )[0]
+          self.assertEqual(
+              'KeepsRecordingResults', testcase.getAttribute('name')
+          )
+          self.assertTrue(testcase.getElementsByTagName('property'))
+        else:
+          testcase = json.loads(report)['testsuites'][0]['testsuite'][0]
+          self.assertEqual('KeepsRecordingResults', testcase['name'])
+          self.assertIn('key0', testcase)
+
+  def testTimeoutWithIsolationGoesOn(self):
+    p = Run([
+        TIMEOUT_FLAG + '=200',
+        '--gtest_isolate_tests',
+        '--gtest_filter=TimeoutTest.Hangs:TimeoutTest.RunsAfterHang',
+    ])
+    self.assertTrue(p.exited, msg=p.output)
+    self.assertNotEqual(0, p.exit_code)
+    self.assertIn('The test timed out after 200 ms.', p.output)
+    self.assertIn('[  FAILED  ] TimeoutTest.Hangs', p.output)
+    self.assertIn('[       OK ] TimeoutTest.RunsAfterHang', p.output)
+
+  def testTestCanSetItsOwnTimeout(self):
+    p = Run(['--gtest_filter=TimeoutTest.SetsOwnTimeout'])
+    self.assertTrue(p.terminated_by_signal, msg=p.output)
+    self.assertIn('The test timed out after 100 ms.', p.output)
+
+  def testTestCanLiftTheTimeout(self):
+    p = Run([TIMEOUT_FLAG + '=100', '--gtest_filter=TimeoutTest.LiftsTimeout'])
+    self.assertTrue(p.exited, msg=p.output)
+    self.assertEqual(0, p.exit_code, msg=p.output)
+
+
+if __name__ == '__main__':
+  gtest_test_utils.Main()
@@ -0,0 +1,113 @@
+// Copyright 2024, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Unit test for Google Test's --gtest_test_timeout_ms flag.
+//
+// A user can give each test a time limit with the --gtest_test_timeout_ms
+// flag or Test::SetTestTimeoutMs().  This file is used for testing such
+// functionality.
+//
+// This program will be invoked from a Python unit test.  Don't run it
+// directly.
+
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+
+namespace {
+
+void SleepForMs(int ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+TEST(TimeoutTest, Hangs) {
+  for (;;) SleepForMs(1000);
+}
+
+TEST(TimeoutTest, RunsAfterHang) {}
+
+// Keeps changing its result as fast as it can, so that it is still doing so
+// while the timeout is reported.
+TEST(TimeoutTest, KeepsRecordingResults) {
+  for (int i = 0;; ++i) {
+    RecordProperty("iteration", i);
+    RecordProperty("key" + std::to_string(i % 16),
+                   std::string(static_cast<size_t>(i % 64), 'x'));
+    if (i % 256 == 0) SUCCEED();
+    EXPECT_FALSE(HasFailure());
+  }
+}
+
+// Prints whether the result of TimeoutTest.KeepsRecordingResults changes
+// while the watchdog reports it.
+class ResultChangeChecker : public testing::EmptyTestEventListener {
+  static std::string GetIteration(const testing::TestResult& result) {
+    for (int i = 0; i < result.test_property_count(); ++i) {
+      const testing::TestProperty& property = result.GetTestProperty(i);
+      if (std::string(property.key()) == "iteration") return property.value();
+    }
+    return "";
+  }
+
+  void OnTestEnd(const testing::TestInfo& test_info) override {
+    if (std::string(test_info.name()) != "KeepsRecordingResults") return;
+    const testing::TestResult& result = *test_info.result();
+    const int part_count = result.total_part_count();
+    const std::string iteration = GetIteration(result);
+    SleepForMs(100);
+    if (result.total_part_count() == part_count &&
+        GetIteration(result) == iteration) {
+      printf("The result didn't change while being reported.\n");
+    } else {
+      printf("The result changed while being reported.\n");
+    }
+  }
+};
+
+TEST(TimeoutTest, SetsOwnTimeout) {
+  SetTestTimeoutMs(100);
+  for (;;) SleepForMs(1000);
+}
+
+TEST(TimeoutTest, LiftsTimeout) {
+  SetTestTimeoutMs(0);
+  SleepForMs(500);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::UnitTest::GetInstance()->listeners().Append(
+      new ResultChangeChecker);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,142 @@
+// Copyright 2024, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+//
+// Tests for EXPECT_ALLOCATIONS_AT_MOST() and the allocation counts the
+// gtest_alloc library adds to test results.
+
+#include <cstddef>
+#include <new>
+
+#include "gtest/gtest-spi.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+using ::testing::TestResourceUsage;
+using ::testing::UnitTest;
+using ::testing::internal::AllocationCounters;
+using ::testing::internal::GetThreadAllocationCounters;
+
+// Calls operator new directly, as a new-expression may be optimized away.
+void AllocateAndFree(size_t size) { ::operator delete(::operator new(size)); }
+
+TEST(AllocationCountingTest, IsEnabledByGTestAlloc) {
+  EXPECT_TRUE(::testing::internal::AllocationCountingEnabled());
+}
+
+TEST(AllocationCountingTest, CountsOperatorNew) {
+  const AllocationCounters before = GetThreadAllocationCounters();
+  AllocateAndFree(24);
+  const AllocationCounters after = GetThreadAllocationCounters();
+  EXPECT_EQ(1, after.allocations - before.allocations);
+  EXPECT_EQ(24, after.bytes - before.bytes);
+}
+
+TEST(AllocationCountingTest, CountsNothrowOperatorNew) {
+  const AllocationCounters before = GetThreadAllocationCounters();
+  ::operator delete[](::operator new[](8, std::nothrow));
+  const AllocationCounters after = GetThreadAllocationCounters();
+  EXPECT_EQ(1, after.allocations - before.allocations);
+}
+
+TEST(ExpectNoAllocationsTest, PassesWithoutAllocations) {
+  int n = 0;
+  EXPECT_NO_ALLOCATIONS { ++n; }
+  EXPECT_EQ(1, n);
+}
+
+TEST(ExpectNoAllocationsTest, FailsOnAllocation) {
+  EXPECT_NONFATAL_FAILURE(
+      {
+        EXPECT_NO_ALLOCATIONS { AllocateAndFree(16); }
+      },
+      "Expected: the block makes at most 0 heap allocation(s)\n"
+      "  Actual: it made 1, totalling 16 bytes");
+}
+
+TEST(ExpectNoAllocationsTest, ChecksBlockLeftEarly) {
+  EXPECT_NONFATAL_FAILURE(
+      {
+        EXPECT_NO_ALLOCATIONS {
+          AllocateAndFree(8);
+          break;
+        }
+      },
+      "it made 1");
+}
+
+TEST(ExpectAllocationsAtMostTest, PassesWithinBudget) {
+  EXPECT_ALLOCATIONS_AT_MOST(2) {
+    AllocateAndFree(1);
+    AllocateAndFree(1);
+  }
+}
+
+TEST(ExpectAllocationsAtMostTest, FailsOverBudget) {
+  EXPECT_NONFATAL_FAILURE(
+      {
+        EXPECT_ALLOCATIONS_AT_MOST(2) {
+          AllocateAndFree(4);
+          AllocateAndFree(4);
+          AllocateAndFree(4);
+        }
+      },
+      "it made 3, totalling 12 bytes");
+}
+
+TEST(ExpectAllocationsAtMostTest, CountsOnlyTheBlock) {
+  AllocateAndFree(1);
+  EXPECT_NO_ALLOCATIONS {}
+  AllocateAndFree(1);
+}
+
+TEST(AllocationResultTest, Allocates) {
+  for (int i = 0; i < 3; ++i) AllocateAndFree(100);
+}
+
+// Checks the result of the test above, which runs first.
+TEST(AllocationResultTest, RecordsAllocationsOfEachTest) {
+  const TestResourceUsage& usage = UnitTest::GetInstance()
+                                       ->current_test_suite()
+                                       ->GetTestInfo(0)
+                                       ->result()
+                                       ->resource_usage();
+  EXPECT_GE(usage.allocations, 3);
+  EXPECT_GE(usage.allocated_bytes, 300);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  GTEST_FLAG_SET(record_resource_usage, true);
+  return RUN_ALL_TESTS();
+}
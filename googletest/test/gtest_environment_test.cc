@@ -33,6 +33,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
 #include "gtest/gtest.h"
 #include "src/gtest-internal-inl.h"
 
@@ -172,6 +177,88 @@ void TestNoTestsSkipsSetUp() {
         "as the global set-up was not run.");
 }
 
+#ifdef GTEST_IS_THREADSAFE
+
+// The number of RendezvousEnvironments that have arrived in SetUp() and in
+// TearDown(), and the number of times one of them met the other.
+std::atomic<int> set_up_arrivals;
+std::atomic<int> tear_down_arrivals;
+std::atomic<int> meetings;
+
+// An independent environment whose SetUp() and TearDown() wait for the other
+// one's, which they can only meet if they run concurrently, and then
+// generate a failure naming the environment.
+class RendezvousEnvironment : public testing::Environment {
+ public:
+  RendezvousEnvironment(const char* name, int delay_ms)
+      : name_(name), delay_ms_(delay_ms) {}
+
+  void SetUp() override { Meet(&set_up_arrivals, "set-up"); }
+  void TearDown() override { Meet(&tear_down_arrivals, "tear-down"); }
+
+ private:
+  // Waits up to ten seconds for both environments to arrive, then waits
+  // delay_ms_ more, so that the environments fail in the reverse order of
+  // the ones they are reported in.
+  void Meet(std::atomic<int>* arrivals, const char* phase) {
+    ++*arrivals;
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (*arrivals < 2 && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (*arrivals == 2) ++meetings;
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms_));
+    ADD_FAILURE() << "Expected failure in " << phase << " of " << name_ << ".";
+  }
+
+  const std::string name_;
+  const int delay_ms_;
+};
+
+// Returns the index of the first part of the ad hoc test result whose
+// message contains the given text, or -1.
+int FindAdHocFailure(const std::string& text) {
+  const testing::TestResult& result =
+      testing::UnitTest::GetInstance()->ad_hoc_test_result();
+  for (int i = 0; i < result.total_part_count(); ++i) {
+    if (std::string(result.GetTestPartResult(i).message()).find(text) !=
+        std::string::npos) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Verifies that consecutive independent environments are set up and torn
+// down concurrently, and that their failures are reported in the order the
+// environments were registered.
+void TestIndependentEnvironmentsRunConcurrently() {
+  testing::AddIndependentGlobalTestEnvironment(
+      new RendezvousEnvironment("First", 100));
+  testing::AddIndependentGlobalTestEnvironment(
+      new RendezvousEnvironment("Second", 0));
+  GTEST_FLAG_SET(filter, "*");
+  testing::internal::GetUnitTestImpl()->ClearAdHocTestResult();
+  Check(RUN_ALL_TESTS() != 0,
+        "RUN_ALL_TESTS() should return non-zero, as the environments should "
+        "generate failures.");
+  Check(meetings == 4,
+        "The independent environments should be set up and torn down "
+        "concurrently.");
+
+  const int first_set_up = FindAdHocFailure("set-up of First.");
+  const int second_set_up = FindAdHocFailure("set-up of Second.");
+  const int first_tear_down = FindAdHocFailure("tear-down of First.");
+  const int second_tear_down = FindAdHocFailure("tear-down of Second.");
+  Check(first_set_up >= 0 && second_set_up == first_set_up + 1,
+        "The set-up failures should be reported in registration order.");
+  Check(second_tear_down >= 0 && first_tear_down == second_tear_down + 1,
+        "The tear-down failures should be reported in the reverse order.");
+}
+
+#endif  // GTEST_IS_THREADSAFE
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -181,6 +268,9 @@ int main(int argc, char** argv) {
   TestTestsRun();
   TestNoTestsRunSetUpFailure();
   TestNoTestsSkipsSetUp();
+#ifdef GTEST_IS_THREADSAFE
+  TestIndependentEnvironmentsRunConcurrently();
+#endif  // GTEST_IS_THREADSAFE
 
   printf("PASS\n");
   return 0;
@@ -242,6 +242,100 @@ class GTestListTestsOutputUnitTest(gtest_test_utils.TestCase):
     """
     self._TestOutput('json', EXPECTED_JSON)
 
+  def testManifest(self):
+    """Verifies that --gtest_manifest lists all tests when it is stale."""
+    manifest_path = os.path.join(
+        gtest_test_utils.GetTempDir(), 'test_manifest.json'
+    )
+    gtest_prog_path = gtest_test_utils.GetTestExecutablePath(
+        'gtest_list_output_unittest_'
+    )
+    command = [
+        gtest_prog_path,
+        '--gtest_manifest=' + manifest_path,
+        '--gtest_filter=FooTest.Test1',
+    ]
+    if os.path.exists(manifest_path):
+      os.remove(manifest_path)
+
+    # A missing manifest is written, listing every test despite the filter.
+    p = gtest_test_utils.Subprocess(command, env=os.environ.copy())
+    self.assertEqual(0, p.exit_code)
+    with open(manifest_path) as f:
+      self._AssertOutputMatches(f.read(), EXPECTED_JSON)
+
+    # A manifest newer than the program is left alone.
+    with open(manifest_path, 'w') as f:
+      f.write('up to date')
+    program_mtime = os.path.getmtime(gtest_prog_path)
+    os.utime(manifest_path, (program_mtime + 10, program_mtime + 10))
+    gtest_test_utils.Subprocess(command, env=os.environ.copy())
+    with open(manifest_path) as f:
+      self.assertEqual('up to date', f.read())
+
+    # A manifest older than the program is rewritten.
+    os.utime(manifest_path, (program_mtime - 10, program_mtime - 10))
+    gtest_test_utils.Subprocess(command, env=os.environ.copy())
+    with open(manifest_path) as f:
+      self._AssertOutputMatches(f.read(), EXPECTED_JSON)
+    os.remove(manifest_path)
+
+    # The temporary file the manifest is written through is gone.
+    self.assertEqual(
+        [],
+        [
+            name
+            for name in os.listdir(gtest_test_utils.GetTempDir())
+            if name.startswith('test_manifest.json.tmp')
+        ],
+    )
+
+  def testManifestDirectory(self):
+    """Verifies that a --gtest_manifest directory gets one file per program."""
+    manifest_dir = os.path.join(
+        gtest_test_utils.GetTempDir(), 'test_manifests'
+    )
+    manifest_path = os.path.join(
+        manifest_dir, 'gtest_list_output_unittest_.json'
+    )
+    if os.path.exists(manifest_path):
+      os.remove(manifest_path)
+
+    p = gtest_test_utils.Subprocess(
+        [
+            gtest_test_utils.GetTestExecutablePath(
+                'gtest_list_output_unittest_'
+            ),
+            '--gtest_manifest=' + manifest_dir + os.sep,
+        ],
+        env=os.environ.copy(),
+    )
+    self.assertEqual(0, p.exit_code)
+    with open(manifest_path) as f:
+      self._AssertOutputMatches(f.read(), EXPECTED_JSON)
+    os.remove(manifest_path)
+
+  def testUnwritableManifestOnlyWarns(self):
+    """Verifies that failing to write the manifest doesn't fail the tests."""
+    # A regular file can't hold the manifest's directory.
+    blocker = os.path.join(gtest_test_utils.GetTempDir(), 'manifest_blocker')
+    with open(blocker, 'w') as f:
+      f.write('not a directory')
+
+    p = gtest_test_utils.Subprocess(
+        [
+            gtest_test_utils.GetTestExecutablePath(
+                'gtest_list_output_unittest_'
+            ),
+            '--gtest_manifest=' + os.path.join(blocker, 'tests.json'),
+        ],
+        env=os.environ.copy(),
+    )
+    os.remove(blocker)
+    self.assertTrue(p.exited)
+    self.assertEqual(0, p.exit_code)
+    self.assertIn('Unable to write the test manifest', p.output)
+
   def _GetOutput(self, out_format):
     file_path = os.path.join(
         gtest_test_utils.GetTempDir(), 'test_out.' + out_format
@@ -268,7 +362,9 @@ class GTestListTestsOutputUnitTest(gtest_test_utils.TestCase):
     return result
 
   def _TestOutput(self, test_format, expected_output):
-    actual = self._GetOutput(test_format)
+    self._AssertOutputMatches(self._GetOutput(test_format), expected_output)
+
+  def _AssertOutputMatches(self, actual, expected_output):
     actual_lines = actual.splitlines()
     expected_lines = expected_output.splitlines()
     line_count = 0
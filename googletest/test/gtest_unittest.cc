@@ -41,14 +41,20 @@ TEST(CommandLineFlagsTest, CanBeAccessedInCodeOnceGTestHIsIncluded) {
       GTEST_FLAG_GET(also_run_disabled_tests) ||
       GTEST_FLAG_GET(break_on_failure) || GTEST_FLAG_GET(catch_exceptions) ||
       GTEST_FLAG_GET(color) != "unknown" || GTEST_FLAG_GET(fail_fast) ||
-      GTEST_FLAG_GET(filter) != "unknown" || GTEST_FLAG_GET(list_tests) ||
-      GTEST_FLAG_GET(output) != "unknown" || GTEST_FLAG_GET(brief) ||
+      GTEST_FLAG_GET(failed_first) || GTEST_FLAG_GET(filter) != "unknown" ||
+      GTEST_FLAG_GET(isolate_tests) || GTEST_FLAG_GET(list_tests) ||
+      GTEST_FLAG_GET(manifest) != "unknown" ||
+      GTEST_FLAG_GET(output) != "unknown" ||
+      GTEST_FLAG_GET(perf_counters) || GTEST_FLAG_GET(brief) ||
       GTEST_FLAG_GET(print_time) || GTEST_FLAG_GET(random_seed) ||
-      GTEST_FLAG_GET(repeat) > 0 ||
+      GTEST_FLAG_GET(record_resource_usage) || GTEST_FLAG_GET(repeat) > 0 ||
+      GTEST_FLAG_GET(rerun_failed) != "unknown" ||
       GTEST_FLAG_GET(recreate_environments_when_repeating) ||
+      GTEST_FLAG_GET(run_benchmarks) ||
       GTEST_FLAG_GET(show_internal_stack_frames) || GTEST_FLAG_GET(shuffle) ||
       GTEST_FLAG_GET(stack_trace_depth) > 0 ||
       GTEST_FLAG_GET(stream_result_to) != "unknown" ||
+      GTEST_FLAG_GET(test_timeout_ms) > 0 ||
       GTEST_FLAG_GET(throw_on_failure);
   EXPECT_TRUE(dummy || !dummy);  // Suppresses warning that dummy is unused.
 }
@@ -239,6 +245,8 @@ using testing::internal::CodePointToUtf8;
 using testing::internal::CopyArray;
 using testing::internal::CountIf;
 using testing::internal::EqFailure;
+using testing::internal::EscapeJsonForTesting;
+using testing::internal::EscapeXmlForTesting;
 using testing::internal::FloatingPoint;
 using testing::internal::ForEach;
 using testing::internal::FormatEpochTimeInMillisAsIso8601;
@@ -259,9 +267,11 @@ using testing::internal::IsNotContainer;
 using testing::internal::kMaxRandomSeed;
 using testing::internal::kTestTypeIdInGoogleTest;
 using testing::internal::NativeArray;
+using testing::internal::ParseFailedTestsFromReport;
 using testing::internal::ParseFlag;
 using testing::internal::RelationToSourceCopy;
 using testing::internal::RelationToSourceReference;
+using testing::internal::RemoveInvalidXmlCharactersForTesting;
 using testing::internal::ShouldRunTestOnShard;
 using testing::internal::ShouldShard;
 using testing::internal::ShouldUseColor;
@@ -270,9 +280,11 @@ using testing::internal::ShuffleRange;
 using testing::internal::SkipPrefix;
 using testing::internal::StreamableToString;
 using testing::internal::String;
+using testing::internal::SymbolCache;
 using testing::internal::TestEventListenersAccessor;
 using testing::internal::TestResultAccessor;
 using testing::internal::WideStringToUtf8;
+using testing::internal::edit_distance::CalculateMyersEdits;
 using testing::internal::edit_distance::CalculateOptimalEdits;
 using testing::internal::edit_distance::CreateUnifiedDiff;
 using testing::internal::edit_distance::EditType;
@@ -1380,6 +1392,51 @@ TEST_F(ExpectFailureWithThreadsTest, ExpectNonFatalFailureOnAllThreads) {
 
 #endif  // GTEST_IS_THREADSAFE
 
+// Tests SCOPED_TRACE_LAZY.
+
+// Counts how many times it has been streamed.
+struct CountsStreaming {
+  int* count;
+};
+
+std::ostream& operator<<(std::ostream& os, const CountsStreaming& value) {
+  ++*value.count;
+  return os << "streamed";
+}
+
+TEST(ScopedTraceLazyTest, FormatsOnlyWhenAFailureIsReported) {
+  int count = 0;
+  for (int i = 0; i < 3; ++i) {
+    SCOPED_TRACE_LAZY("i = ", i, ", ", CountsStreaming{&count});
+    EXPECT_EQ(i, i);
+  }
+  EXPECT_EQ(0, count);
+
+  SCOPED_TRACE_LAZY("i = ", 42, ", ", CountsStreaming{&count});
+  EXPECT_NONFATAL_FAILURE(ADD_FAILURE() << "Expected failure.",
+                          "i = 42, streamed");
+  EXPECT_EQ(1, count);
+}
+
+TEST(ScopedTraceLazyTest, CopiesValuesAtTracePoint) {
+  int n = 1;
+  std::string s = "before";
+  SCOPED_TRACE_LAZY("n = ", n, " s = ", s);
+  n = 2;
+  s = "after";
+  EXPECT_NONFATAL_FAILURE(ADD_FAILURE(), "n = 1 s = before");
+}
+
+TEST(ScopedTraceLazyTest, NestsWithEagerTraces) {
+  SCOPED_TRACE("outer");
+  SCOPED_TRACE_LAZY("inner ", 7);
+  const char* null_value = nullptr;
+  SCOPED_TRACE_LAZY(null_value);
+  EXPECT_NONFATAL_FAILURE(ADD_FAILURE(), "(null)\n");
+  EXPECT_NONFATAL_FAILURE(ADD_FAILURE(), "inner 7\n");
+  EXPECT_NONFATAL_FAILURE(ADD_FAILURE(), "outer");
+}
+
 // Tests the TestProperty class.
 
 TEST(TestPropertyTest, ConstructorWorks) {
@@ -1608,17 +1665,25 @@ class GTestFlagSaverTest : public Test {
     GTEST_FLAG_SET(death_test_use_fork, false);
     GTEST_FLAG_SET(color, "auto");
     GTEST_FLAG_SET(fail_fast, false);
+    GTEST_FLAG_SET(failed_first, false);
     GTEST_FLAG_SET(filter, "");
+    GTEST_FLAG_SET(isolate_tests, false);
     GTEST_FLAG_SET(list_tests, false);
+    GTEST_FLAG_SET(manifest, "");
     GTEST_FLAG_SET(output, "");
+    GTEST_FLAG_SET(perf_counters, false);
     GTEST_FLAG_SET(brief, false);
     GTEST_FLAG_SET(print_time, true);
     GTEST_FLAG_SET(random_seed, 0);
+    GTEST_FLAG_SET(record_resource_usage, false);
     GTEST_FLAG_SET(repeat, 1);
+    GTEST_FLAG_SET(rerun_failed, "");
     GTEST_FLAG_SET(recreate_environments_when_repeating, true);
+    GTEST_FLAG_SET(run_benchmarks, false);
     GTEST_FLAG_SET(shuffle, false);
     GTEST_FLAG_SET(stack_trace_depth, kMaxStackTraceDepth);
     GTEST_FLAG_SET(stream_result_to, "");
+    GTEST_FLAG_SET(test_timeout_ms, 0);
     GTEST_FLAG_SET(throw_on_failure, false);
   }
 
@@ -1638,17 +1703,25 @@ class GTestFlagSaverTest : public Test {
     EXPECT_STREQ("auto", GTEST_FLAG_GET(color).c_str());
     EXPECT_FALSE(GTEST_FLAG_GET(death_test_use_fork));
     EXPECT_FALSE(GTEST_FLAG_GET(fail_fast));
+    EXPECT_FALSE(GTEST_FLAG_GET(failed_first));
     EXPECT_STREQ("", GTEST_FLAG_GET(filter).c_str());
+    EXPECT_FALSE(GTEST_FLAG_GET(isolate_tests));
     EXPECT_FALSE(GTEST_FLAG_GET(list_tests));
+    EXPECT_STREQ("", GTEST_FLAG_GET(manifest).c_str());
     EXPECT_STREQ("", GTEST_FLAG_GET(output).c_str());
+    EXPECT_FALSE(GTEST_FLAG_GET(perf_counters));
     EXPECT_FALSE(GTEST_FLAG_GET(brief));
     EXPECT_TRUE(GTEST_FLAG_GET(print_time));
     EXPECT_EQ(0, GTEST_FLAG_GET(random_seed));
+    EXPECT_FALSE(GTEST_FLAG_GET(record_resource_usage));
     EXPECT_EQ(1, GTEST_FLAG_GET(repeat));
+    EXPECT_STREQ("", GTEST_FLAG_GET(rerun_failed).c_str());
     EXPECT_TRUE(GTEST_FLAG_GET(recreate_environments_when_repeating));
+    EXPECT_FALSE(GTEST_FLAG_GET(run_benchmarks));
     EXPECT_FALSE(GTEST_FLAG_GET(shuffle));
     EXPECT_EQ(kMaxStackTraceDepth, GTEST_FLAG_GET(stack_trace_depth));
     EXPECT_STREQ("", GTEST_FLAG_GET(stream_result_to).c_str());
+    EXPECT_EQ(0, GTEST_FLAG_GET(test_timeout_ms));
     EXPECT_FALSE(GTEST_FLAG_GET(throw_on_failure));
 
     GTEST_FLAG_SET(also_run_disabled_tests, true);
@@ -1657,17 +1730,25 @@ class GTestFlagSaverTest : public Test {
     GTEST_FLAG_SET(color, "no");
     GTEST_FLAG_SET(death_test_use_fork, true);
     GTEST_FLAG_SET(fail_fast, true);
+    GTEST_FLAG_SET(failed_first, true);
     GTEST_FLAG_SET(filter, "abc");
+    GTEST_FLAG_SET(isolate_tests, true);
     GTEST_FLAG_SET(list_tests, true);
+    GTEST_FLAG_SET(manifest, "tests.json");
     GTEST_FLAG_SET(output, "xml:foo.xml");
+    GTEST_FLAG_SET(perf_counters, true);
     GTEST_FLAG_SET(brief, true);
     GTEST_FLAG_SET(print_time, false);
     GTEST_FLAG_SET(random_seed, 1);
+    GTEST_FLAG_SET(record_resource_usage, true);
     GTEST_FLAG_SET(repeat, 100);
+    GTEST_FLAG_SET(rerun_failed, "previous.xml");
     GTEST_FLAG_SET(recreate_environments_when_repeating, false);
+    GTEST_FLAG_SET(run_benchmarks, true);
     GTEST_FLAG_SET(shuffle, true);
     GTEST_FLAG_SET(stack_trace_depth, 1);
     GTEST_FLAG_SET(stream_result_to, "localhost:1234");
+    GTEST_FLAG_SET(test_timeout_ms, 1000);
     GTEST_FLAG_SET(throw_on_failure, true);
   }
 
@@ -1871,6 +1952,278 @@ TEST(ShouldRunTestOnShardTest, IsPartitionWhenThereIsOneShard) {
   EXPECT_TRUE(ShouldRunTestOnShard(1, 0, 4));
 }
 
+// Tests reading the failed tests from a previous XML report.
+TEST(ParseFailedTestsFromReportTest, ReadsXml) {
+  const std::string report =
+      "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      "<testsuites tests=\"4\" failures=\"2\" name=\"AllTests\">\n"
+      "  <testsuite name=\"A\" tests=\"2\" failures=\"1\">\n"
+      "    <testcase name=\"Pass\" status=\"run\" classname=\"A\" />\n"
+      "    <testcase name=\"Skip\" status=\"run\" classname=\"A\">\n"
+      "      <skipped message=\"\"><![CDATA[<failure x=\"\">]]></skipped>\n"
+      "    </testcase>\n"
+      "    <testcase name=\"Fail\" status=\"run\" classname=\"A\">\n"
+      "      <failure message=\"x\" type=\"\"><![CDATA[</testcase>]]>"
+      "</failure>\n"
+      "    </testcase>\n"
+      "  </testsuite>\n"
+      "  <testsuite name=\"I/P\" tests=\"1\" failures=\"1\">\n"
+      "    <testcase name=\"T/1\" value_param=\"&quot;a&quot;\" "
+      "classname=\"I&#x2F;P\">\n"
+      "      <failure message=\"y\" type=\"\"><![CDATA[]]></failure>\n"
+      "    </testcase>\n"
+      "  </testsuite>\n"
+      "</testsuites>\n";
+  std::set<std::string> failed;
+  EXPECT_TRUE(ParseFailedTestsFromReport(report, &failed));
+  EXPECT_EQ((std::set<std::string>{"A.Fail", "I/P.T/1"}), failed);
+}
+
+// Tests reading the failed tests from a previous JSON report.
+TEST(ParseFailedTestsFromReportTest, ReadsJson) {
+  const std::string report =
+      "{\n"
+      "  \"tests\": 3,\n"
+      "  \"failures\": 1,\n"
+      "  \"testsuites\": [\n"
+      "    {\n"
+      "      \"name\": \"A\",\n"
+      "      \"failures\": 1,\n"
+      "      \"testsuite\": [\n"
+      "        {\n"
+      "          \"name\": \"Fail\",\n"
+      "          \"classname\": \"A\",\n"
+      "          \"failures\": [\n"
+      "            {\n"
+      "              \"failure\": \"\\\"name\\\": \\\"x\\\"\",\n"
+      "              \"type\": \"\"\n"
+      "            }\n"
+      "          ]\n"
+      "        },\n"
+      "        {\n"
+      "          \"name\": \"Pass\",\n"
+      "          \"classname\": \"A\"\n"
+      "        }\n"
+      "      ]\n"
+      "    },\n"
+      "    {\n"
+      "      \"name\": \"I\\/P\",\n"
+      "      \"failures\": 0,\n"
+      "      \"testsuite\": [\n"
+      "        {\n"
+      "          \"name\": \"T\\/0\",\n"
+      "          \"classname\": \"I\\/P\"\n"
+      "        }\n"
+      "      ]\n"
+      "    }\n"
+      "  ]\n"
+      "}\n";
+  std::set<std::string> failed;
+  EXPECT_TRUE(ParseFailedTestsFromReport(report, &failed));
+  EXPECT_EQ((std::set<std::string>{"A.Fail"}), failed);
+}
+
+TEST(ParseFailedTestsFromReportTest, RejectsOtherFormats) {
+  std::set<std::string> failed;
+  EXPECT_FALSE(ParseFailedTestsFromReport("", &failed));
+  EXPECT_FALSE(ParseFailedTestsFromReport("A.Fail\n", &failed));
+  EXPECT_TRUE(failed.empty());
+}
+
+#if GTEST_HAS_FILE_SYSTEM
+
+// Tests the escaping done for the XML and JSON reports against the
+// byte-at-a-time escapers it replaced.
+
+static bool IsNormalizableWhitespaceByte(unsigned char c) {
+  return c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool IsValidXmlByte(unsigned char c) {
+  return IsNormalizableWhitespaceByte(c) || c >= 0x20;
+}
+
+static std::string ByteLoopEscapeXml(const std::string& str,
+                                     bool is_attribute) {
+  std::string output;
+  for (const char ch : str) {
+    const auto byte = static_cast<unsigned char>(ch);
+    switch (ch) {
+      case '<':
+        output += "&lt;";
+        break;
+      case '>':
+        output += "&gt;";
+        break;
+      case '&':
+        output += "&amp;";
+        break;
+      case '\'':
+        output += is_attribute ? "&apos;" : "'";
+        break;
+      case '"':
+        output += is_attribute ? "&quot;" : "\"";
+        break;
+      default:
+        if (IsValidXmlByte(byte)) {
+          if (is_attribute && IsNormalizableWhitespaceByte(byte)) {
+            output += "&#x" + String::FormatByte(byte) + ";";
+          } else {
+            output += ch;
+          }
+        }
+        break;
+    }
+  }
+  return output;
+}
+
+static std::string ByteLoopRemoveInvalidXmlCharacters(const std::string& str) {
+  std::string output;
+  for (const char ch : str) {
+    if (IsValidXmlByte(static_cast<unsigned char>(ch))) output += ch;
+  }
+  return output;
+}
+
+static std::string ByteLoopEscapeJson(const std::string& str) {
+  std::string output;
+  for (const char ch : str) {
+    switch (ch) {
+      case '\\':
+      case '"':
+      case '/':
+        output += '\\';
+        output += ch;
+        break;
+      case '\b':
+        output += "\\b";
+        break;
+      case '\t':
+        output += "\\t";
+        break;
+      case '\n':
+        output += "\\n";
+        break;
+      case '\f':
+        output += "\\f";
+        break;
+      case '\r':
+        output += "\\r";
+        break;
+      default:
+        if (ch < ' ') {
+          output += "\\u00" + String::FormatByte(static_cast<unsigned char>(ch));
+        } else {
+          output += ch;
+        }
+        break;
+    }
+  }
+  return output;
+}
+
+static void ExpectEscapersAgree(const std::string& str) {
+  EXPECT_EQ(ByteLoopEscapeXml(str, false), EscapeXmlForTesting(str, false))
+      << "for " << testing::PrintToString(str);
+  EXPECT_EQ(ByteLoopEscapeXml(str, true), EscapeXmlForTesting(str, true))
+      << "for " << testing::PrintToString(str);
+  EXPECT_EQ(ByteLoopRemoveInvalidXmlCharacters(str),
+            RemoveInvalidXmlCharactersForTesting(str))
+      << "for " << testing::PrintToString(str);
+  EXPECT_EQ(ByteLoopEscapeJson(str), EscapeJsonForTesting(str))
+      << "for " << testing::PrintToString(str);
+}
+
+// The bytes the escapers treat specially, plus their neighbours, which the
+// word-at-a-time test must not mistake for them.
+static const char kEscaperProbeBytes[] = {
+    '<',  '>',    '&',    '\'',   '"',    '\\',   '/',    '\b',   '\t',
+    '\n', '\f',   '\r',   '\0',   '\x01', '\x1F', '\x20', '\x7E', '\x7F',
+    '\x80', '\x9F', '\xA0', '\xBF', '\xFE', '\xFF', ';',    '=',    '?'};
+
+TEST(EscapeForReportTest, MatchesByteLoopWithOneSpecialAtEachOffset) {
+  for (size_t length = 1; length <= 40; ++length) {
+    for (size_t offset = 0; offset < length; ++offset) {
+      for (const char byte : kEscaperProbeBytes) {
+        std::string str(length, 'a');
+        str[offset] = byte;
+        ExpectEscapersAgree(str);
+      }
+    }
+  }
+}
+
+TEST(EscapeForReportTest, MatchesByteLoopWithTwoSpecials) {
+  // Two specials in the same or in adjacent words, including the tail.
+  const size_t kLength = 27;
+  for (size_t first = 0; first < kLength; ++first) {
+    for (size_t second = first + 1; second < kLength; ++second) {
+      std::string str(kLength, 'x');
+      str[first] = '\x85';
+      str[second] = '&';
+      ExpectEscapersAgree(str);
+      str[first] = '\n';
+      str[second] = '"';
+      ExpectEscapersAgree(str);
+    }
+  }
+}
+
+TEST(EscapeForReportTest, MatchesByteLoopOnRandomStrings) {
+  testing::internal::Random random(1234);
+  for (int i = 0; i < 2000; ++i) {
+    std::string str(random.Generate(64), ' ');
+    for (char& ch : str) {
+      // Mostly printable ASCII, which is the common case in reports.
+      ch = random.Generate(4) == 0
+               ? static_cast<char>(random.Generate(256))
+               : static_cast<char>(' ' + random.Generate(95));
+    }
+    ExpectEscapersAgree(str);
+  }
+}
+
+#endif  // GTEST_HAS_FILE_SYSTEM
+
+// Tests SymbolCache.
+
+// A symbolizer that counts its calls and names each PC after its value.
+static int symbolize_calls = 0;
+
+static bool FakeSymbolize(const void* pc, char* out, int out_size) {
+  ++symbolize_calls;
+  if (pc == nullptr) return false;
+  snprintf(out, static_cast<size_t>(out_size), "sym%p", pc);
+  return true;
+}
+
+TEST(SymbolCacheTest, SymbolizesEachPcOnce) {
+  symbolize_calls = 0;
+  SymbolCache cache(&FakeSymbolize);
+  int a = 0;
+  int b = 0;
+
+  const std::string symbol_a = cache.Lookup(&a);
+  EXPECT_EQ(1, symbolize_calls);
+  EXPECT_EQ(symbol_a, cache.Lookup(&a));
+  EXPECT_EQ(1, symbolize_calls);
+
+  EXPECT_NE(symbol_a, cache.Lookup(&b));
+  EXPECT_EQ(2, symbolize_calls);
+  EXPECT_EQ(symbol_a, cache.Lookup(&a));
+  EXPECT_EQ(2, symbolize_calls);
+}
+
+TEST(SymbolCacheTest, CachesUnknownPcs) {
+  symbolize_calls = 0;
+  SymbolCache cache(&FakeSymbolize);
+
+  EXPECT_EQ("(unknown)", cache.Lookup(nullptr));
+  EXPECT_EQ("(unknown)", cache.Lookup(nullptr));
+  EXPECT_EQ(1, symbolize_calls);
+}
+
 class ShouldShardTest : public testing::Test {
  protected:
   void SetUp() override {
@@ -3131,6 +3484,78 @@ TEST_F(DoubleTest, DoubleLEFails) {
       "(values_.nan1) <= (values_.nan1)");
 }
 
+// Tests the {ASSERT|EXPECT}_RANGE_* assertions.
+
+enum class RangeColor { kRed, kGreen };
+
+TEST(RangeAssertionTest, RangeEqSucceeds) {
+  const int array[] = {1, 2, 3};
+  const std::vector<int> vector = {1, 2, 3};
+  EXPECT_RANGE_EQ(array, vector);
+  ASSERT_RANGE_EQ(vector, array);
+  EXPECT_RANGE_EQ(std::string("abc"), std::string("abc"));
+  EXPECT_RANGE_EQ(std::vector<RangeColor>({RangeColor::kRed}),
+                  std::vector<RangeColor>({RangeColor::kRed}));
+  EXPECT_RANGE_EQ(std::vector<std::string>({"a", "b"}),
+                  std::vector<std::string>({"a", "b"}));
+  EXPECT_RANGE_EQ(std::vector<int>(), std::vector<int>());
+}
+
+TEST(RangeAssertionTest, RangeEqReportsSizeMismatch) {
+  const std::vector<int> short_vector = {1, 2};
+  const std::vector<int> long_vector = {1, 2, 3};
+  EXPECT_NONFATAL_FAILURE(EXPECT_RANGE_EQ(short_vector, long_vector),
+                          "short_vector\n    Which has 2 elements\n"
+                          "  long_vector\n    Which has 3 elements");
+  EXPECT_FATAL_FAILURE(ASSERT_RANGE_EQ(std::vector<int>({1, 2}),
+                                       std::vector<int>({1, 2, 3})),
+                       "Expected ranges of the same size");
+}
+
+TEST(RangeAssertionTest, RangeEqReportsFirstMismatches) {
+  std::vector<int> expected(100000, 7);
+  std::vector<int> actual = expected;
+  for (size_t i = 1000; i < 1020; ++i) actual[i] = 8;
+  actual[99999] = 9;
+  EXPECT_NONFATAL_FAILURE(EXPECT_RANGE_EQ(expected, actual),
+                          "21 of 100000 elements differ, the first 10 being:\n"
+                          "  [1000]: 7 vs 8\n  [1001]: 7 vs 8");
+
+  std::vector<std::string> strings = {"a", "b", "c"};
+  std::vector<std::string> other_strings = {"a", "x", "c"};
+  EXPECT_NONFATAL_FAILURE(EXPECT_RANGE_EQ(strings, other_strings),
+                          "1 of 3 elements differ:\n"
+                          "  [1]: \"b\" vs \"x\"");
+}
+
+TEST(RangeAssertionTest, RangeFloatingPointEq) {
+  const float close_to_one = 1.0f + std::numeric_limits<float>::epsilon();
+  EXPECT_RANGE_FLOAT_EQ(std::vector<float>({0.0f, 1.0f}),
+                        std::vector<float>({-0.0f, close_to_one}));
+  EXPECT_RANGE_DOUBLE_EQ(std::vector<double>({1.0, 2.0}),
+                         std::vector<double>({1.0, 2.0}));
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_NONFATAL_FAILURE(
+      EXPECT_RANGE_DOUBLE_EQ(std::vector<double>({1.0, nan, 3.0}),
+                             std::vector<double>({1.0, nan, 3.5})),
+      "2 of 3 elements differ:\n  [1]: nan vs nan\n  [2]: 3 vs 3.5");
+  EXPECT_FATAL_FAILURE(ASSERT_RANGE_FLOAT_EQ(std::vector<float>({1.0f}),
+                                             std::vector<float>({1.5f})),
+                       "within 4 ULPs");
+}
+
+TEST(RangeAssertionTest, RangeNear) {
+  std::vector<float> expected(4096, 0.5f);
+  std::vector<float> actual(4096, 0.5001f);
+  EXPECT_RANGE_NEAR(expected, actual, 0.001);
+  ASSERT_RANGE_NEAR(expected, actual, 0.001);
+  actual[17] = 0.75f;
+  EXPECT_NONFATAL_FAILURE(EXPECT_RANGE_NEAR(expected, actual, 0.001),
+                          "differ by at most 0.001 (0.001):\n"
+                          "  expected\n  actual\n"
+                          "1 of 4096 elements differ:\n  [17]: 0.5 vs 0.75");
+}
+
 // Verifies that a test or test case whose name starts with DISABLED_ is
 // not run.
 
@@ -3566,6 +3991,102 @@ TEST(EditDistance, TestSuites) {
   }
 }
 
+// Applies 'edits' to 'left', taking added elements from 'right', and
+// returns the number of adds and removes performed through 'cost'.
+std::vector<size_t> ApplyEdits(const std::vector<size_t>& left,
+                               const std::vector<size_t>& right,
+                               const std::vector<EditType>& edits,
+                               size_t* cost) {
+  std::vector<size_t> out;
+  size_t l_i = 0, r_i = 0;
+  *cost = 0;
+  for (size_t i = 0; i < edits.size(); ++i) {
+    switch (edits[i]) {
+      case testing::internal::edit_distance::kMatch:
+        EXPECT_EQ(left.at(l_i), right.at(r_i));
+        out.push_back(left[l_i++]);
+        ++r_i;
+        break;
+      case testing::internal::edit_distance::kRemove:
+        ++l_i;
+        ++*cost;
+        break;
+      case testing::internal::edit_distance::kAdd:
+        out.push_back(right.at(r_i++));
+        ++*cost;
+        break;
+      case testing::internal::edit_distance::kReplace:
+        ADD_FAILURE() << "Unexpected replace at " << i;
+        break;
+    }
+  }
+  EXPECT_EQ(left.size(), l_i);
+  return out;
+}
+
+TEST(EditDistance, MyersFindsShortestScript) {
+  struct Case {
+    const char* left;
+    const char* right;
+    size_t expected_cost;
+  };
+  static const Case kCases[] = {{"", "", 0},
+                                {"A", "A", 0},
+                                {"", "ABC", 3},
+                                {"ABC", "", 3},
+                                {"X", "XABCD", 4},
+                                {"ABCD", "abcd", 8},
+                                {"ABCDEFGH", "ABXEGH1", 5},
+                                {"AAAABCCCC", "ABABCDCDC", 6},
+                                {"ABCABBA", "CBABAC", 5},
+                                {"ABCDEFGHIJKL", "BCDCDEFGJKLJK", 7},
+                                {}};
+  for (const Case* c = kCases; c->left; ++c) {
+    const std::vector<size_t> left = CharsToIndices(c->left);
+    const std::vector<size_t> right = CharsToIndices(c->right);
+    size_t cost;
+    EXPECT_EQ(right, ApplyEdits(left, right, CalculateMyersEdits(left, right),
+                                &cost))
+        << "Left <" << c->left << "> Right <" << c->right << ">";
+    EXPECT_EQ(c->expected_cost, cost)
+        << "Left <" << c->left << "> Right <" << c->right << ">";
+  }
+}
+
+TEST(EditDistance, MyersBoundedCostStillProducesValidScript) {
+  std::vector<size_t> left, right;
+  unsigned int state = 12345;
+  for (int i = 0; i < 2000; ++i) {
+    state = state * 1103515245u + 12345u;
+    left.push_back((state >> 16) % 7);
+    state = state * 1103515245u + 12345u;
+    right.push_back((state >> 16) % 7);
+  }
+  size_t optimal_cost, bounded_cost;
+  EXPECT_EQ(right, ApplyEdits(left, right, CalculateMyersEdits(left, right),
+                              &optimal_cost));
+  EXPECT_EQ(right, ApplyEdits(left, right, CalculateMyersEdits(left, right, 2),
+                              &bounded_cost));
+  EXPECT_LE(optimal_cost, bounded_cost);
+}
+
+TEST(EditDistance, UnifiedDiffOfLargeInputs) {
+  std::vector<std::string> left, right;
+  for (int i = 0; i < 50000; ++i) {
+    left.push_back("line " + std::to_string(i));
+  }
+  right = left;
+  right[20000] = "changed";
+  right.erase(right.begin() + 40000);
+
+  EXPECT_EQ(
+      "@@ -19999,5 +19999,5 @@\n line 19998\n line 19999\n-line 20000\n"
+      "+changed\n line 20001\n line 20002\n"
+      "@@ -39999,5 @@\n line 39998\n line 39999\n-line 40000\n"
+      " line 40001\n line 40002\n",
+      CreateUnifiedDiff(left, right));
+}
+
 // Tests EqFailure(), used for implementing *EQ* assertions.
 TEST(AssertionTest, EqFailure) {
   const std::string foo_val("5"), bar_val("6");
@@ -5478,17 +5999,25 @@ struct Flags {
         catch_exceptions(false),
         death_test_use_fork(false),
         fail_fast(false),
+        failed_first(false),
         filter(""),
+        isolate_tests(false),
         list_tests(false),
+        manifest(""),
         output(""),
+        perf_counters(false),
         brief(false),
         print_time(true),
         random_seed(0),
+        record_resource_usage(false),
         repeat(1),
+        rerun_failed(""),
         recreate_environments_when_repeating(true),
+        run_benchmarks(false),
         shuffle(false),
         stack_trace_depth(kMaxStackTraceDepth),
         stream_result_to(""),
+        test_timeout_ms(0),
         throw_on_failure(false) {}
 
   // Factory methods.
@@ -5533,6 +6062,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_failed_first flag has
+  // the given value.
+  static Flags FailedFirst(bool failed_first) {
+    Flags flags;
+    flags.failed_first = failed_first;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_filter flag has the given
   // value.
   static Flags Filter(const char* filter) {
@@ -5541,6 +6078,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_isolate_tests flag has the
+  // given value.
+  static Flags IsolateTests(bool isolate_tests) {
+    Flags flags;
+    flags.isolate_tests = isolate_tests;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_list_tests flag has the
   // given value.
   static Flags ListTests(bool list_tests) {
@@ -5549,6 +6094,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_manifest flag has the given
+  // value.
+  static Flags Manifest(const char* manifest) {
+    Flags flags;
+    flags.manifest = manifest;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_output flag has the given
   // value.
   static Flags Output(const char* output) {
@@ -5557,6 +6110,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_perf_counters flag has the given
+  // value.
+  static Flags PerfCounters(bool perf_counters) {
+    Flags flags;
+    flags.perf_counters = perf_counters;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_brief flag has the given
   // value.
   static Flags Brief(bool brief) {
@@ -5581,6 +6142,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_record_resource_usage flag has
+  // the given value.
+  static Flags RecordResourceUsage(bool record_resource_usage) {
+    Flags flags;
+    flags.record_resource_usage = record_resource_usage;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_repeat flag has the given
   // value.
   static Flags Repeat(int32_t repeat) {
@@ -5589,6 +6158,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_rerun_failed flag has the given
+  // value.
+  static Flags RerunFailed(const char* rerun_failed) {
+    Flags flags;
+    flags.rerun_failed = rerun_failed;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_recreate_environments_when_repeating
   // flag has the given value.
   static Flags RecreateEnvironmentsWhenRepeating(
@@ -5599,6 +6176,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_run_benchmarks flag has the given
+  // value.
+  static Flags RunBenchmarks(bool run_benchmarks) {
+    Flags flags;
+    flags.run_benchmarks = run_benchmarks;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_shuffle flag has the given
   // value.
   static Flags Shuffle(bool shuffle) {
@@ -5623,6 +6208,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_test_timeout_ms flag has the
+  // given value.
+  static Flags TestTimeoutMs(int32_t test_timeout_ms) {
+    Flags flags;
+    flags.test_timeout_ms = test_timeout_ms;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_throw_on_failure flag has
   // the given value.
   static Flags ThrowOnFailure(bool throw_on_failure) {
@@ -5637,17 +6230,25 @@ struct Flags {
   bool catch_exceptions;
   bool death_test_use_fork;
   bool fail_fast;
+  bool failed_first;
   const char* filter;
+  bool isolate_tests;
   bool list_tests;
+  const char* manifest;
   const char* output;
+  bool perf_counters;
   bool brief;
   bool print_time;
   int32_t random_seed;
+  bool record_resource_usage;
   int32_t repeat;
+  const char* rerun_failed;
   bool recreate_environments_when_repeating;
+  bool run_benchmarks;
   bool shuffle;
   int32_t stack_trace_depth;
   const char* stream_result_to;
+  int32_t test_timeout_ms;
   bool throw_on_failure;
 };
 
@@ -5661,17 +6262,25 @@ class ParseFlagsTest : public Test {
     GTEST_FLAG_SET(catch_exceptions, false);
     GTEST_FLAG_SET(death_test_use_fork, false);
     GTEST_FLAG_SET(fail_fast, false);
+    GTEST_FLAG_SET(failed_first, false);
     GTEST_FLAG_SET(filter, "");
+    GTEST_FLAG_SET(isolate_tests, false);
     GTEST_FLAG_SET(list_tests, false);
+    GTEST_FLAG_SET(manifest, "");
     GTEST_FLAG_SET(output, "");
+    GTEST_FLAG_SET(perf_counters, false);
     GTEST_FLAG_SET(brief, false);
     GTEST_FLAG_SET(print_time, true);
     GTEST_FLAG_SET(random_seed, 0);
+    GTEST_FLAG_SET(record_resource_usage, false);
     GTEST_FLAG_SET(repeat, 1);
+    GTEST_FLAG_SET(rerun_failed, "");
     GTEST_FLAG_SET(recreate_environments_when_repeating, true);
+    GTEST_FLAG_SET(run_benchmarks, false);
     GTEST_FLAG_SET(shuffle, false);
     GTEST_FLAG_SET(stack_trace_depth, kMaxStackTraceDepth);
     GTEST_FLAG_SET(stream_result_to, "");
+    GTEST_FLAG_SET(test_timeout_ms, 0);
     GTEST_FLAG_SET(throw_on_failure, false);
   }
 
@@ -5695,19 +6304,28 @@ class ParseFlagsTest : public Test {
     EXPECT_EQ(expected.death_test_use_fork,
               GTEST_FLAG_GET(death_test_use_fork));
     EXPECT_EQ(expected.fail_fast, GTEST_FLAG_GET(fail_fast));
+    EXPECT_EQ(expected.failed_first, GTEST_FLAG_GET(failed_first));
     EXPECT_STREQ(expected.filter, GTEST_FLAG_GET(filter).c_str());
+    EXPECT_EQ(expected.isolate_tests, GTEST_FLAG_GET(isolate_tests));
     EXPECT_EQ(expected.list_tests, GTEST_FLAG_GET(list_tests));
+    EXPECT_STREQ(expected.manifest, GTEST_FLAG_GET(manifest).c_str());
     EXPECT_STREQ(expected.output, GTEST_FLAG_GET(output).c_str());
+    EXPECT_EQ(expected.perf_counters, GTEST_FLAG_GET(perf_counters));
     EXPECT_EQ(expected.brief, GTEST_FLAG_GET(brief));
     EXPECT_EQ(expected.print_time, GTEST_FLAG_GET(print_time));
     EXPECT_EQ(expected.random_seed, GTEST_FLAG_GET(random_seed));
+    EXPECT_EQ(expected.record_resource_usage,
+              GTEST_FLAG_GET(record_resource_usage));
     EXPECT_EQ(expected.repeat, GTEST_FLAG_GET(repeat));
+    EXPECT_STREQ(expected.rerun_failed, GTEST_FLAG_GET(rerun_failed).c_str());
     EXPECT_EQ(expected.recreate_environments_when_repeating,
               GTEST_FLAG_GET(recreate_environments_when_repeating));
+    EXPECT_EQ(expected.run_benchmarks, GTEST_FLAG_GET(run_benchmarks));
     EXPECT_EQ(expected.shuffle, GTEST_FLAG_GET(shuffle));
     EXPECT_EQ(expected.stack_trace_depth, GTEST_FLAG_GET(stack_trace_depth));
     EXPECT_STREQ(expected.stream_result_to,
                  GTEST_FLAG_GET(stream_result_to).c_str());
+    EXPECT_EQ(expected.test_timeout_ms, GTEST_FLAG_GET(test_timeout_ms));
     EXPECT_EQ(expected.throw_on_failure, GTEST_FLAG_GET(throw_on_failure));
   }
 
@@ -5793,6 +6411,15 @@ TEST_F(ParseFlagsTest, FailFast) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::FailFast(true), false);
 }
 
+// Tests parsing --gtest_failed_first.
+TEST_F(ParseFlagsTest, FailedFirst) {
+  const char* argv[] = {"foo.exe", "--gtest_failed_first", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::FailedFirst(true), false);
+}
+
 // Tests parsing an empty --gtest_filter flag.
 TEST_F(ParseFlagsTest, FilterEmpty) {
   const char* argv[] = {"foo.exe", "--gtest_filter=", nullptr};
@@ -5900,6 +6527,15 @@ TEST_F(ParseFlagsTest, UnrecognizedFlag) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, flags, false);
 }
 
+// Tests parsing --gtest_isolate_tests.
+TEST_F(ParseFlagsTest, IsolateTests) {
+  const char* argv[] = {"foo.exe", "--gtest_isolate_tests", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::IsolateTests(true), false);
+}
+
 // Tests having a --gtest_list_tests flag
 TEST_F(ParseFlagsTest, ListTestsFlag) {
   const char* argv[] = {"foo.exe", "--gtest_list_tests", nullptr};
@@ -5945,6 +6581,15 @@ TEST_F(ParseFlagsTest, ListTestsFalse_F) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::ListTests(false), false);
 }
 
+// Tests parsing --gtest_manifest=path
+TEST_F(ParseFlagsTest, Manifest) {
+  const char* argv[] = {"foo.exe", "--gtest_manifest=tests.json", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::Manifest("tests.json"), false);
+}
+
 // Tests parsing --gtest_output=xml
 TEST_F(ParseFlagsTest, OutputXml) {
   const char* argv[] = {"foo.exe", "--gtest_output=xml", nullptr};
@@ -6055,6 +6700,35 @@ TEST_F(ParseFlagsTest, RandomSeed) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::RandomSeed(1000), false);
 }
 
+// Tests parsing --gtest_record_resource_usage.
+TEST_F(ParseFlagsTest, RecordResourceUsageWithoutValue) {
+  const char* argv[] = {"foo.exe", "--gtest_record_resource_usage", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::RecordResourceUsage(true),
+                            false);
+}
+
+// Tests parsing --gtest_record_resource_usage=0.
+TEST_F(ParseFlagsTest, RecordResourceUsageFalse) {
+  const char* argv[] = {"foo.exe", "--gtest_record_resource_usage=0", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::RecordResourceUsage(false),
+                            false);
+}
+
+// Tests parsing --gtest_perf_counters.
+TEST_F(ParseFlagsTest, PerfCounters) {
+  const char* argv[] = {"foo.exe", "--gtest_perf_counters", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::PerfCounters(true), false);
+}
+
 // Tests parsing --gtest_repeat=number
 TEST_F(ParseFlagsTest, Repeat) {
   const char* argv[] = {"foo.exe", "--gtest_repeat=1000", nullptr};
@@ -6064,6 +6738,17 @@ TEST_F(ParseFlagsTest, Repeat) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::Repeat(1000), false);
 }
 
+// Tests parsing --gtest_rerun_failed=path
+TEST_F(ParseFlagsTest, RerunFailed) {
+  const char* argv[] = {"foo.exe", "--gtest_rerun_failed=previous.json",
+                        nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::RerunFailed("previous.json"),
+                            false);
+}
+
 // Tests parsing --gtest_recreate_environments_when_repeating
 TEST_F(ParseFlagsTest, RecreateEnvironmentsWhenRepeating) {
   const char* argv[] = {
@@ -6110,6 +6795,15 @@ TEST_F(ParseFlagsTest, AlsoRunDisabledTestsFalse) {
                             false);
 }
 
+// Tests parsing --gtest_run_benchmarks.
+TEST_F(ParseFlagsTest, RunBenchmarks) {
+  const char* argv[] = {"foo.exe", "--gtest_run_benchmarks", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::RunBenchmarks(true), false);
+}
+
 // Tests parsing --gtest_shuffle.
 TEST_F(ParseFlagsTest, ShuffleWithoutValue) {
   const char* argv[] = {"foo.exe", "--gtest_shuffle", nullptr};
@@ -6156,6 +6850,15 @@ TEST_F(ParseFlagsTest, StreamResultTo) {
                             Flags::StreamResultTo("localhost:1234"), false);
 }
 
+// Tests parsing --gtest_test_timeout_ms=number.
+TEST_F(ParseFlagsTest, TestTimeoutMs) {
+  const char* argv[] = {"foo.exe", "--gtest_test_timeout_ms=250", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::TestTimeoutMs(250), false);
+}
+
 // Tests parsing --gtest_throw_on_failure.
 TEST_F(ParseFlagsTest, ThrowOnFailureWithoutValue) {
   const char* argv[] = {"foo.exe", "--gtest_throw_on_failure", nullptr};
@@ -263,6 +263,95 @@ class GTestXMLOutputUnitTest(gtest_xml_test_utils.GTestXMLTestCase):
       """
       self._TestXmlOutput(GTEST_PROGRAM_NAME, EXPECTED_NON_EMPTY_XML, 1)
 
+    def testBinaryOutputConvertsToXml(self):
+      """Verifies that the converted binary result stream matches the XML."""
+
+      bin_path = self._GetBinaryOutput(GTEST_PROGRAM_NAME, [], 1)
+      actual = self._ConvertBinaryOutput(bin_path)
+      expected = minidom.parseString(EXPECTED_NON_EMPTY_XML)
+      self.NormalizeXml(actual.documentElement)
+      self.AssertEquivalentNodes(
+          expected.documentElement, actual.documentElement
+      )
+      expected.unlink()
+      actual.unlink()
+
+  def testTruncatedBinaryOutput(self):
+    """Verifies that a test left running by the stream's end has failed."""
+
+    actual = self._ConvertTruncatedBinaryOutput(before_end=True)
+    testcases = self._TestCasesByName(actual)
+    self.assertEqual(3, len(testcases))
+    succeeds = testcases['Succeeds']
+    self.assertEqual('run', succeeds.getAttribute('status'))
+    failures = succeeds.getElementsByTagName('failure')
+    self.assertEqual(1, len(failures))
+    self.assertIn(
+        'The result stream ends while this test is running',
+        failures[0].getAttribute('message'),
+    )
+    for name in ('Fails', 'Skipped'):
+      self.assertEqual('notrun', testcases[name].getAttribute('status'))
+      self.assertEqual([], testcases[name].getElementsByTagName('failure'))
+    actual.unlink()
+
+  def testBinaryOutputTruncatedBetweenTests(self):
+    """Verifies that tests the stream never started are reported not run."""
+
+    actual = self._ConvertTruncatedBinaryOutput(before_end=False)
+    testcases = self._TestCasesByName(actual)
+    succeeds = testcases['Succeeds']
+    self.assertEqual('run', succeeds.getAttribute('status'))
+    self.assertEqual('completed', succeeds.getAttribute('result'))
+    self.assertEqual([], succeeds.getElementsByTagName('failure'))
+    for name in ('Fails', 'Skipped'):
+      self.assertEqual('notrun', testcases[name].getAttribute('status'))
+      self.assertEqual([], testcases[name].getElementsByTagName('failure'))
+    # The run as a whole has failed, since it never finished.
+    failures = testcases[''].getElementsByTagName('failure')
+    self.assertEqual(1, len(failures))
+    self.assertIn(
+        'The result stream ends before the tests have finished',
+        failures[0].getAttribute('message'),
+    )
+    actual.unlink()
+
+  def _ConvertTruncatedBinaryOutput(self, before_end):
+    """Converts the stream of three tests, cut as the first one ends.
+
+    The stream is cut just before the record that ends the first test if
+    before_end is true, or just after it otherwise.
+    """
+
+    bin_path = self._GetBinaryOutput(
+        GTEST_PROGRAM_NAME,
+        [
+            '%s=SuccessfulTest.Succeeds:FailedTest.Fails:SkippedTest.Skipped'
+            % GTEST_FILTER_FLAG
+        ],
+        1,
+    )
+    with open(bin_path, 'rb') as f:
+      data = f.read()
+    # Each record is a little-endian uint32 length followed by a tag and its
+    # payload.
+    pos = len(b'GTESTBIN') + 4
+    while data[pos + 4 : pos + 5] != b'e':
+      pos += 4 + int.from_bytes(data[pos : pos + 4], 'little')
+    if not before_end:
+      pos += 4 + int.from_bytes(data[pos : pos + 4], 'little')
+    with open(bin_path, 'wb') as f:
+      f.write(data[:pos])
+    return self._ConvertBinaryOutput(bin_path)
+
+  def _TestCasesByName(self, document):
+    """Returns the testcase elements of document, keyed by their names."""
+
+    return {
+        testcase.getAttribute('name'): testcase
+        for testcase in document.getElementsByTagName('testcase')
+    }
+
   def testNoTestXmlOutput(self):
     """Verifies XML output for a Google Test binary without actual tests.
 
@@ -300,6 +389,69 @@ class GTestXMLOutputUnitTest(gtest_xml_test_utils.GTestXMLTestCase):
     self.assertLess(time_delta, datetime.timedelta(seconds=600))
     actual.unlink()
 
+  def testResourceUsageAttributes(self):
+    """Checks the resource usage attributes in the XML output.
+
+    Runs a test program with --gtest_record_resource_usage and checks that
+    each testcase element carries non-negative resource usage attributes.
+    """
+    actual = self._GetXmlOutput(
+        GTEST_PROGRAM_NAME,
+        [
+            '%s=SuccessfulTest.*' % GTEST_FILTER_FLAG,
+            '--gtest_record_resource_usage',
+        ],
+        {},
+        0,
+    )
+    testcases = actual.getElementsByTagName('testcase')
+    self.assertTrue(testcases)
+    for testcase in testcases:
+      for name in (
+          'user_time_us',
+          'system_time_us',
+          'peak_rss_delta_kb',
+          'voluntary_context_switches',
+          'involuntary_context_switches',
+          'minor_page_faults',
+          'major_page_faults',
+          'allocations',
+          'allocated_bytes',
+      ):
+        self.assertTrue(testcase.hasAttribute(name), name)
+        self.assertGreaterEqual(int(testcase.getAttribute(name)), 0)
+    actual.unlink()
+
+  def testPerfCounterProperties(self):
+    """Checks the perf_event_open() counts recorded as test properties.
+
+    Runs a test program with --gtest_perf_counters and checks that each
+    recorded count is a non-negative integer.  Which events can be counted
+    depends on the kernel and the hardware, so the test is skipped where none
+    can be.
+    """
+    if not sys.platform.startswith('linux'):
+      self.skipTest('perf_event_open() is only available on Linux')
+    actual = self._GetXmlOutput(
+        GTEST_PROGRAM_NAME,
+        [
+            '%s=SuccessfulTest.*' % GTEST_FILTER_FLAG,
+            '--gtest_perf_counters',
+        ],
+        {},
+        0,
+    )
+    properties = actual.getElementsByTagName('property')
+    if not properties:
+      actual.unlink()
+      self.skipTest('no events can be counted here')
+    for prop in properties:
+      self.assertTrue(prop.getAttribute('name').startswith('perf_'))
+      self.assertGreaterEqual(int(prop.getAttribute('value')), 0)
+    names = set(prop.getAttribute('name') for prop in properties)
+    self.assertIn('perf_task_clock_ns', names)
+    actual.unlink()
+
   def testDefaultOutputFile(self):
     """Tests XML file with default name is created when name is not specified.
 
@@ -434,6 +586,34 @@ class GTestXMLOutputUnitTest(gtest_xml_test_utils.GTestXMLTestCase):
     actual = minidom.parse(xml_path)
     return actual
 
+  def _GetBinaryOutput(self, gtest_prog_name, extra_args, expected_exit_code):
+    """Runs gtest_prog_name with --gtest_output=bin and returns the stream."""
+
+    bin_path = os.path.join(
+        gtest_test_utils.GetTempDir(), gtest_prog_name + 'out.bin'
+    )
+    command = [
+        gtest_test_utils.GetTestExecutablePath(gtest_prog_name),
+        '%s=bin:%s' % (GTEST_OUTPUT_FLAG, bin_path),
+    ] + extra_args
+    p = gtest_test_utils.Subprocess(command)
+    self.assertTrue(p.exited)
+    self.assertEqual(expected_exit_code, p.exit_code)
+    return bin_path
+
+  def _ConvertBinaryOutput(self, bin_path):
+    """Converts a binary result stream to XML and returns the document."""
+
+    xml_path = bin_path + '.xml'
+    p = gtest_test_utils.Subprocess([
+        gtest_test_utils.GetTestExecutablePath('gtest_convert_results'),
+        bin_path,
+        'xml:' + xml_path,
+    ])
+    self.assertTrue(p.exited)
+    self.assertEqual(0, p.exit_code, p.output)
+    return minidom.parse(xml_path)
+
   def _TestXmlOutput(
       self,
       gtest_prog_name,